@@ -21,8 +21,7 @@
   wayland,
   libpulseaudio,
   alsa-lib,
-  upower,
-  brightnessctl
+  upower
 }:
   let
     dep-gtk4-layer-shell = fetchFromGitHub {
@@ -55,7 +54,7 @@
     '';
 
     nativeBuildInputs = [ makeWrapper git meson ninja vala sassc pkg-config gobject-introspection wayland-scanner ];
-    buildInputs = [ glib gtk4 json-glib gmp librsvg networkmanager wayland libpulseaudio alsa-lib upower brightnessctl ];
+    buildInputs = [ glib gtk4 json-glib gmp librsvg networkmanager wayland libpulseaudio alsa-lib upower ];
 
     meta = with lib; {
       homepage = "https://github.com/hannesschulze/foobar";
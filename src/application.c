@@ -3,9 +3,11 @@
 #include "launcher.h"
 #include "control-center.h"
 #include "notification-area.h"
+#include "trace.h"
 #include "dbus/server.h"
 #include "services/battery-service.h"
 #include "services/clock-service.h"
+#include "services/scheduler-service.h"
 #include "services/brightness-service.h"
 #include "services/quick-answer-service.h"
 #include "services/workspace-service.h"
@@ -30,6 +32,7 @@
 struct _FoobarApplication
 {
 	GtkApplication              parent_instance;
+	FoobarSchedulerService*     scheduler_service;
 	FoobarBatteryService*       battery_service;
 	FoobarClockService*         clock_service;
 	FoobarBrightnessService*    brightness_service;
@@ -44,6 +47,13 @@ struct _FoobarApplication
 	gulong                      config_handler_id;
 	FoobarServer*               server_skeleton;
 	GtkCssProvider*             style_provider;
+	gchar*                      stylesheet_uri;
+	gchar*                      stylesheet_checksum;
+	char*                       stylesheet_actual_path;
+	GFileMonitor*               stylesheet_monitor;
+	GFileMonitor*               stylesheet_actual_monitor;
+	gulong                      stylesheet_handler_id;
+	gulong                      stylesheet_actual_handler_id;
 	guint                       bus_owner_id;
 	GArray*                     panel_window_ids;
 	gboolean                    panel_is_multi_monitor;
@@ -56,41 +66,58 @@ struct _FoobarApplication
 	gboolean                    option_quit;
 	gboolean                    option_toggle_launcher;
 	gboolean                    option_toggle_control_center;
+	gboolean                    option_wakeups;
 };
 
-static void     foobar_application_class_init                  ( FoobarApplicationClass*  klass );
-static void     foobar_application_init                        ( FoobarApplication*       self );
-static void     foobar_application_activate                    ( GApplication*            app );
-static int      foobar_application_command_line                ( GApplication*            app,
-                                                                 GApplicationCommandLine* cmdline );
-static void     foobar_application_finalize                    ( GObject*                 object );
-static void     foobar_application_handle_bus_acquired         ( GDBusConnection*         connection,
-                                                                 gchar const*             name,
-                                                                 gpointer                 userdata );
-static gboolean foobar_application_handle_inspector            ( FoobarServer*            server,
-                                                                 GDBusMethodInvocation*   invocation,
-                                                                 gpointer                 userdata );
-static gboolean foobar_application_handle_quit                 ( FoobarServer*            server,
-                                                                 GDBusMethodInvocation*   invocation,
-                                                                 gpointer                 userdata );
-static gboolean foobar_application_handle_toggle_launcher      ( FoobarServer*            server,
-                                                                 GDBusMethodInvocation*   invocation,
-                                                                 gpointer                 userdata );
-static gboolean foobar_application_handle_toggle_control_center( FoobarServer*            server,
-                                                                 GDBusMethodInvocation*   invocation,
-                                                                 gpointer                 userdata );
-static void     foobar_application_handle_config_changed       ( GObject*                 object,
-                                                                 GParamSpec*              pspec,
-                                                                 gpointer                 userdata );
-static void     foobar_application_handle_monitors_changed     ( GListModel*              list,
-                                                                 guint                    position,
-                                                                 guint                    removed,
-                                                                 guint                    added,
-                                                                 gpointer                 userdata );
-static void     foobar_application_destroy_panels              ( FoobarApplication*       self );
-static void     foobar_application_create_panels               ( FoobarApplication*       self );
-static guint    foobar_application_create_panel                ( FoobarApplication*       self,
-                                                                 GdkMonitor*              monitor );
+static void          foobar_application_class_init                  ( FoobarApplicationClass*                klass );
+static void          foobar_application_init                        ( FoobarApplication*                     self );
+static void          foobar_application_activate                    ( GApplication*                          app );
+static int           foobar_application_command_line                ( GApplication*                          app,
+                                                                      GApplicationCommandLine*               cmdline );
+static void          foobar_application_finalize                    ( GObject*                               object );
+static void          foobar_application_handle_bus_acquired         ( GDBusConnection*                       connection,
+                                                                      gchar const*                           name,
+                                                                      gpointer                               userdata );
+static gboolean      foobar_application_handle_inspector            ( FoobarServer*                          server,
+                                                                      GDBusMethodInvocation*                 invocation,
+                                                                      gpointer                               userdata );
+static gboolean      foobar_application_handle_quit                 ( FoobarServer*                          server,
+                                                                      GDBusMethodInvocation*                 invocation,
+                                                                      gpointer                               userdata );
+static gboolean      foobar_application_handle_toggle_launcher      ( FoobarServer*                          server,
+                                                                      GDBusMethodInvocation*                 invocation,
+                                                                      gpointer                               userdata );
+static gboolean      foobar_application_handle_toggle_control_center( FoobarServer*                          server,
+                                                                      GDBusMethodInvocation*                 invocation,
+                                                                      gpointer                               userdata );
+static gboolean      foobar_application_handle_get_wakeups          ( FoobarServer*                          server,
+                                                                      GDBusMethodInvocation*                 invocation,
+                                                                      gpointer                               userdata );
+static void          foobar_application_apply_history_limits        ( FoobarApplication*                     self,
+                                                                      FoobarNotificationConfiguration const* config );
+static void          foobar_application_start_services              ( FoobarApplication*                     self,
+                                                                      FoobarConfiguration const*             config );
+static void          foobar_application_handle_config_changed       ( FoobarConfigurationService*            service,
+                                                                      FoobarConfigurationSection             section,
+                                                                      gpointer                               userdata );
+static void          foobar_application_handle_monitors_changed     ( GListModel*                            list,
+                                                                      guint                                  position,
+                                                                      guint                                  removed,
+                                                                      guint                                  added,
+                                                                      gpointer                               userdata );
+static void          foobar_application_handle_stylesheet_changed   ( GFileMonitor*                          monitor,
+                                                                      GFile*                                 file,
+                                                                      GFile*                                 other_file,
+                                                                      GFileMonitorEvent                      event_type,
+                                                                      gpointer                               userdata );
+static void          foobar_application_load_stylesheet             ( FoobarApplication*                     self );
+static void          foobar_application_watch_stylesheet            ( FoobarApplication*                     self );
+static void          foobar_application_watch_actual_stylesheet     ( FoobarApplication*                     self );
+static GFileMonitor* foobar_application_create_stylesheet_monitor   ( gchar const*                           path );
+static void          foobar_application_destroy_panels              ( FoobarApplication*                     self );
+static void          foobar_application_create_panels               ( FoobarApplication*                     self );
+static guint         foobar_application_create_panel                ( FoobarApplication*                     self,
+                                                                      GdkMonitor*                            monitor );
 
 G_DEFINE_FINAL_TYPE( FoobarApplication, foobar_application, GTK_TYPE_APPLICATION )
 
@@ -157,6 +184,15 @@ void foobar_application_init( FoobarApplication* self )
 				.description = "Toggle the control center visibility for the active bar instance.",
 				.arg_description = NULL,
 			},
+			{
+				.long_name = "wakeups",
+				.short_name = 'w',
+				.flags = G_OPTION_FLAG_NONE,
+				.arg = G_OPTION_ARG_NONE,
+				.arg_data = &self->option_wakeups,
+				.description = "Print how often the active bar instance has woken up for timed work.",
+				.arg_description = NULL,
+			},
 			{ 0 },
 		};
 	g_application_add_main_option_entries( G_APPLICATION( self ), options );
@@ -165,25 +201,37 @@ void foobar_application_init( FoobarApplication* self )
 //
 // Called by GTK when the application is activated (only for a single instance of the application).
 //
-// This is where the services are created and the windows are presented.
+// This is where the services are created and the windows are presented. The network and bluetooth services are only
+// started if a configured widget uses them (see foobar_application_start_services).
 //
 void foobar_application_activate( GApplication* app )
 {
 	FoobarApplication* self = (FoobarApplication*)app;
 
+	// Only the primary instance is traced -- this is not reached for client invocations.
+
+	foobar_trace_init( );
+
 	// Initialize services.
 
-	self->battery_service = foobar_battery_service_new( );
-	self->clock_service = foobar_clock_service_new( );
-	self->brightness_service = foobar_brightness_service_new( );
-	self->workspace_service = foobar_workspace_service_new( );
-	self->notification_service = foobar_notification_service_new( );
-	self->audio_service = foobar_audio_service_new( );
-	self->network_service = foobar_network_service_new( );
-	self->bluetooth_service = foobar_bluetooth_service_new( );
-	self->application_service = foobar_application_service_new( );
-	self->quick_answer_service = foobar_quick_answer_service_new( );
-	self->configuration_service = foobar_configuration_service_new( );
+	FOOBAR_TRACE_SPAN( "scheduler service", self->scheduler_service = foobar_scheduler_service_new( ) );
+	FOOBAR_TRACE_SPAN( "battery service", self->battery_service = foobar_battery_service_new( ) );
+	FOOBAR_TRACE_SPAN( "clock service", self->clock_service = foobar_clock_service_new( ) );
+	FOOBAR_TRACE_SPAN( "brightness service", self->brightness_service = foobar_brightness_service_new( ) );
+	FOOBAR_TRACE_SPAN( "workspace service", self->workspace_service = foobar_workspace_service_new( ) );
+	FOOBAR_TRACE_SPAN(
+		"notification service",
+		self->notification_service = foobar_notification_service_new( self->scheduler_service ) );
+	FOOBAR_TRACE_SPAN( "audio service", self->audio_service = foobar_audio_service_new( ) );
+	FOOBAR_TRACE_SPAN(
+		"network service",
+		self->network_service = foobar_network_service_new( self->scheduler_service ) );
+	FOOBAR_TRACE_SPAN( "bluetooth service", self->bluetooth_service = foobar_bluetooth_service_new( ) );
+	FOOBAR_TRACE_SPAN( "application service", self->application_service = foobar_application_service_new( ) );
+	FOOBAR_TRACE_SPAN( "quick answer service", self->quick_answer_service = foobar_quick_answer_service_new( ) );
+	FOOBAR_TRACE_SPAN(
+		"configuration service",
+		self->configuration_service = foobar_configuration_service_new( self->scheduler_service ) );
 
 	// Enforce a uniform style by forcing Adwaita and shipping our own icons.
 
@@ -210,10 +258,12 @@ void foobar_application_activate( GApplication* app )
 
 	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
 	foobar_application_apply_configuration( self, foobar_configuration_get_general( config ) );
+	foobar_application_apply_history_limits( self, foobar_configuration_get_notifications( config ) );
+	foobar_application_start_services( self, config );
 	self->panel_is_multi_monitor = foobar_panel_configuration_get_multi_monitor( foobar_configuration_get_panel( config ) );
 	self->config_handler_id = g_signal_connect(
 		self->configuration_service,
-		"notify::current",
+		"changed",
 		G_CALLBACK( foobar_application_handle_config_changed ),
 		self );
 
@@ -230,27 +280,36 @@ void foobar_application_activate( GApplication* app )
 
 	// Create all the windows.
 
-	foobar_application_create_panels( self );
+	FOOBAR_TRACE_SPAN( "panels", foobar_application_create_panels( self ) );
 
-	self->launcher = foobar_launcher_new(
-		self->application_service,
-		self->quick_answer_service,
-		self->configuration_service );
+	FOOBAR_TRACE_SPAN(
+		"launcher",
+		self->launcher = foobar_launcher_new(
+			self->application_service,
+			self->quick_answer_service,
+			self->configuration_service ) );
 	g_object_ref( self->launcher );
-
-	self->control_center = foobar_control_center_new(
-		self->brightness_service,
-		self->audio_service,
-		self->network_service,
-		self->bluetooth_service,
-		self->notification_service,
-		self->configuration_service );
+	foobar_trace_first_frame( GTK_WIDGET( self->launcher ), "launcher first frame" );
+
+	FOOBAR_TRACE_SPAN(
+		"control center",
+		self->control_center = foobar_control_center_new(
+			self->brightness_service,
+			self->audio_service,
+			self->network_service,
+			self->bluetooth_service,
+			self->notification_service,
+			self->configuration_service ) );
 	g_object_ref( self->control_center );
+	foobar_trace_first_frame( GTK_WIDGET( self->control_center ), "control center first frame" );
 
-	self->notification_area = foobar_notification_area_new(
-		self->notification_service,
-		self->configuration_service );
+	FOOBAR_TRACE_SPAN(
+		"notification area",
+		self->notification_area = foobar_notification_area_new(
+			self->notification_service,
+			self->configuration_service ) );
 	g_object_ref( self->notification_area );
+	foobar_trace_first_frame( GTK_WIDGET( self->notification_area ), "notification area first frame" );
 
 	// Only present the notification area, all other windows start out as hidden windows.
 
@@ -312,6 +371,24 @@ int foobar_application_command_line(
 			return 2;
 		}
 
+		if ( self->option_wakeups )
+		{
+			guint total;
+			g_autoptr( GVariant ) tasks = NULL;
+			if ( !foobar_server_call_get_wakeups_sync( proxy, &total, &tasks, NULL, &error ) )
+			{
+				g_printerr( "Unable to get wakeups: %s\n", error->message );
+				return 2;
+			}
+
+			g_print( "total: %u\n", total );
+			GVariantIter iter;
+			gchar const* name;
+			guint count;
+			g_variant_iter_init( &iter, tasks );
+			while ( g_variant_iter_next( &iter, "{&su}", &name, &count ) ) { g_print( "%s: %u\n", name, count ); }
+		}
+
 		if ( self->option_quit && !foobar_server_call_quit_sync( proxy, NULL, &error ) )
 		{
 			g_printerr( "Unable to quit server: %s\n", error->message );
@@ -353,6 +430,8 @@ void foobar_application_finalize( GObject* object )
 	g_clear_handle_id( &self->bus_owner_id, g_bus_unown_name );
 	g_clear_signal_handler( &self->config_handler_id, self->configuration_service );
 	g_clear_signal_handler( &self->monitors_handler_id, self->monitors );
+	g_clear_signal_handler( &self->stylesheet_handler_id, self->stylesheet_monitor );
+	g_clear_signal_handler( &self->stylesheet_actual_handler_id, self->stylesheet_actual_monitor );
 	g_clear_object( &self->battery_service );
 	g_clear_object( &self->clock_service );
 	g_clear_object( &self->brightness_service );
@@ -364,8 +443,14 @@ void foobar_application_finalize( GObject* object )
 	g_clear_object( &self->application_service );
 	g_clear_object( &self->quick_answer_service );
 	g_clear_object( &self->configuration_service );
+	g_clear_object( &self->scheduler_service );
 	g_clear_object( &self->style_provider );
 	g_clear_object( &self->server_skeleton );
+	g_clear_object( &self->stylesheet_monitor );
+	g_clear_object( &self->stylesheet_actual_monitor );
+	g_clear_pointer( &self->stylesheet_uri, g_free );
+	g_clear_pointer( &self->stylesheet_checksum, g_free );
+	g_clear_pointer( &self->stylesheet_actual_path, free );
 	g_clear_object( &self->launcher );
 	g_clear_object( &self->control_center );
 	g_clear_object( &self->notification_area );
@@ -425,25 +510,19 @@ void foobar_application_apply_configuration(
 	g_return_if_fail( FOOBAR_IS_APPLICATION( self ) );
 	g_return_if_fail( config != NULL );
 
-	GdkDisplay* display = gdk_display_get_default( );
-
-	// Remove the old stylesheet from the application.
+	// Start watching the stylesheet if it has been replaced by another file.
 
-	if ( self->style_provider )
+	gchar const* stylesheet_uri = foobar_general_configuration_get_stylesheet( config );
+	if ( g_strcmp0( self->stylesheet_uri, stylesheet_uri ) )
 	{
-		gtk_style_context_remove_provider_for_display( display, GTK_STYLE_PROVIDER( self->style_provider ) );
-		g_clear_object( &self->style_provider );
+		g_free( self->stylesheet_uri );
+		self->stylesheet_uri = g_strdup( stylesheet_uri );
+		foobar_application_watch_stylesheet( self );
 	}
 
-	// Add the new stylesheet.
+	// Load the stylesheet, which is skipped if its content has not changed.
 
-	g_autoptr( GFile ) file = g_file_new_for_uri( foobar_general_configuration_get_stylesheet( config ) );
-	self->style_provider = gtk_css_provider_new( );
-	gtk_css_provider_load_from_file( self->style_provider, file );
-	gtk_style_context_add_provider_for_display(
-		display,
-		GTK_STYLE_PROVIDER( self->style_provider ),
-		GTK_STYLE_PROVIDER_PRIORITY_APPLICATION );
+	foobar_application_load_stylesheet( self );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -484,6 +563,11 @@ void foobar_application_handle_bus_acquired(
 		"handle-toggle-control-center",
 		G_CALLBACK( foobar_application_handle_toggle_control_center ),
 		self );
+	g_signal_connect(
+		self->server_skeleton,
+		"handle-get-wakeups",
+		G_CALLBACK( foobar_application_handle_get_wakeups ),
+		self );
 
 	g_autoptr( GError ) error = NULL;
 	if ( !g_dbus_interface_skeleton_export(
@@ -561,42 +645,162 @@ gboolean foobar_application_handle_toggle_control_center(
 }
 
 //
-// Signal handler called when the global configuration file has changed.
+// DBus skeleton callback for the "GetWakeups" method.
 //
-void foobar_application_handle_config_changed(
-	GObject*    object,
-	GParamSpec* pspec,
-	gpointer    userdata )
+gboolean foobar_application_handle_get_wakeups(
+	FoobarServer*          server,
+	GDBusMethodInvocation* invocation,
+	gpointer               userdata )
 {
-	(void)object;
-	(void)pspec;
 	FoobarApplication* self = (FoobarApplication*)userdata;
 
-	// Apply general settings.
+	GVariantBuilder builder;
+	g_variant_builder_init( &builder, G_VARIANT_TYPE( "a{su}" ) );
 
-	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
-	foobar_application_apply_configuration( self, foobar_configuration_get_general( config ) );
+	GHashTableIter iter;
+	gpointer name;
+	gpointer count;
+	g_hash_table_iter_init( &iter, foobar_scheduler_service_get_task_wakeups( self->scheduler_service ) );
+	while ( g_hash_table_iter_next( &iter, &name, &count ) )
+	{
+		g_variant_builder_add( &builder, "{su}", name, GPOINTER_TO_UINT( count ) );
+	}
 
-	// Update panel instances depending on whether multi-monitor mode is enabled.
+	foobar_server_complete_get_wakeups(
+		server,
+		invocation,
+		foobar_scheduler_service_get_wakeups( self->scheduler_service ),
+		g_variant_builder_end( &builder ) );
+	return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
 
-	FoobarPanelConfiguration const* panel_config = foobar_configuration_get_panel( config );
-	gboolean panel_is_multi_monitor = foobar_panel_configuration_get_multi_monitor( panel_config );
-	if ( self->panel_is_multi_monitor != panel_is_multi_monitor )
+//
+// Apply the limits for the notification history from the notification configuration.
+//
+void foobar_application_apply_history_limits(
+	FoobarApplication*                     self,
+	FoobarNotificationConfiguration const* config )
+{
+	foobar_notification_service_set_history_limits(
+		self->notification_service,
+		foobar_notification_configuration_get_history_limit( config ),
+		foobar_notification_configuration_get_history_max_age( config ) * G_TIME_SPAN_DAY,
+		(guint64)foobar_notification_configuration_get_history_max_size( config ) * 1024 * 1024 );
+}
+
+//
+// Start the services which are used by a configured widget, i.e. by a status item of the panel or a row of the control
+// center. The network and bluetooth services are not started at all while no widget references them, so e.g. there is
+// no connection to Bluez without a bluetooth status item or connectivity row.
+//
+// Services are not stopped again once the configuration no longer references them, because they are only expensive to
+// start.
+//
+void foobar_application_start_services(
+	FoobarApplication*         self,
+	FoobarConfiguration const* config )
+{
+	gboolean needs_network = FALSE;
+	gboolean needs_bluetooth = FALSE;
+
+	gsize items_count;
+	FoobarPanelItemConfiguration const* const* items = foobar_panel_configuration_get_items(
+		foobar_configuration_get_panel( config ),
+		&items_count );
+	for ( gsize i = 0; i < items_count; ++i )
 	{
-		self->panel_is_multi_monitor = panel_is_multi_monitor;
+		if ( foobar_panel_item_configuration_get_kind( items[i] ) != FOOBAR_PANEL_ITEM_KIND_STATUS ) { continue; }
 
-		// Panel windows keep the application alive, so we need to "hold" it while we re-create the panel windows.
+		gsize status_count;
+		FoobarStatusItem const* status_items = foobar_panel_item_status_configuration_get_items( items[i], &status_count );
+		for ( gsize j = 0; j < status_count; ++j )
+		{
+			if ( status_items[j] == FOOBAR_STATUS_ITEM_NETWORK ) { needs_network = TRUE; }
+			if ( status_items[j] == FOOBAR_STATUS_ITEM_BLUETOOTH ) { needs_bluetooth = TRUE; }
+		}
+	}
 
-		g_application_hold( G_APPLICATION( self ) );
-		foobar_application_destroy_panels( self );
-		foobar_application_create_panels( self );
-		g_application_release( G_APPLICATION( self ) );
+	gsize rows_count;
+	FoobarControlCenterRow const* rows = foobar_control_center_configuration_get_rows(
+		foobar_configuration_get_control_center( config ),
+		&rows_count );
+	for ( gsize i = 0; i < rows_count; ++i )
+	{
+		if ( rows[i] == FOOBAR_CONTROL_CENTER_ROW_CONNECTIVITY )
+		{
+			needs_network = TRUE;
+			needs_bluetooth = TRUE;
+		}
 	}
+
+	if ( needs_network ) { foobar_network_service_start( self->network_service ); }
+	if ( needs_bluetooth ) { foobar_bluetooth_service_start( self->bluetooth_service ); }
 }
 
 //
-// Signal handler called when the list of GdkMonitor objects has changed, possibly requiring us to re-create the panel
-// windows.
+// Signal handler called once for each section of the configuration file that has changed.
+//
+// The application only uses the general settings, the history limits from the notification settings, the multi-monitor
+// mode from the panel settings and the widgets configured for the panel and the control center (to start the services
+// they use). The components handle their own sections.
+//
+void foobar_application_handle_config_changed(
+	FoobarConfigurationService* service,
+	FoobarConfigurationSection  section,
+	gpointer                    userdata )
+{
+	(void)service;
+	FoobarApplication* self = (FoobarApplication*)userdata;
+
+	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
+	switch ( section )
+	{
+		case FOOBAR_CONFIGURATION_SECTION_GENERAL:
+			foobar_application_apply_configuration( self, foobar_configuration_get_general( config ) );
+			break;
+		case FOOBAR_CONFIGURATION_SECTION_NOTIFICATIONS:
+			foobar_application_apply_history_limits( self, foobar_configuration_get_notifications( config ) );
+			break;
+		case FOOBAR_CONFIGURATION_SECTION_PANEL:
+		{
+			foobar_application_start_services( self, config );
+
+			// Update panel instances depending on whether multi-monitor mode is enabled.
+
+			FoobarPanelConfiguration const* panel_config = foobar_configuration_get_panel( config );
+			gboolean panel_is_multi_monitor = foobar_panel_configuration_get_multi_monitor( panel_config );
+			if ( self->panel_is_multi_monitor != panel_is_multi_monitor )
+			{
+				self->panel_is_multi_monitor = panel_is_multi_monitor;
+
+				// Panel windows keep the application alive, so we need to "hold" it while we re-create the panel
+				// windows.
+
+				g_application_hold( G_APPLICATION( self ) );
+				foobar_application_destroy_panels( self );
+				foobar_application_create_panels( self );
+				g_application_release( G_APPLICATION( self ) );
+			}
+			break;
+		}
+		case FOOBAR_CONFIGURATION_SECTION_CONTROL_CENTER:
+			foobar_application_start_services( self, config );
+			break;
+		case FOOBAR_CONFIGURATION_SECTION_LAUNCHER:
+			break;
+		default:
+			g_warn_if_reached( );
+			break;
+	}
+}
+
+//
+// Signal handler called when the list of GdkMonitor objects has changed, possibly requiring us to create or destroy
+// panel windows.
+//
+// In multi-monitor mode, self->panel_window_ids contains one panel per monitor, in the same order as the monitor list,
+// so the change can be applied as a diff: only panels for removed monitors are destroyed and only panels for added
+// monitors are created, while the panels on all other monitors are kept.
 //
 void foobar_application_handle_monitors_changed(
 	GListModel* list,
@@ -605,27 +809,186 @@ void foobar_application_handle_monitors_changed(
 	guint       added,
 	gpointer    userdata )
 {
-	(void)list;
-	(void)position;
-	(void)removed;
-	(void)added;
 	FoobarApplication* self = (FoobarApplication*)userdata;
 
 	if ( self->panel_is_multi_monitor )
 	{
-		// Panel windows keep the application alive, so we need to "hold" it while we re-create the panel windows.
+		// Panel windows keep the application alive, so we need to "hold" it in case all panels are replaced.
 
 		g_application_hold( G_APPLICATION( self ) );
-		foobar_application_destroy_panels( self );
-		foobar_application_create_panels( self );
+
+		for ( guint i = position; i < position + removed; ++i )
+		{
+			guint window_id = g_array_index( self->panel_window_ids, guint, i );
+			GtkWindow* window = gtk_application_get_window_by_id( GTK_APPLICATION( self ), window_id );
+			if ( window ) { gtk_window_destroy( window ); }
+		}
+		g_array_remove_range( self->panel_window_ids, position, removed );
+
+		for ( guint i = position; i < position + added; ++i )
+		{
+			g_autoptr( GdkMonitor ) monitor = g_list_model_get_item( list, i );
+			guint id = foobar_application_create_panel( self, monitor );
+			g_array_insert_val( self->panel_window_ids, i, id );
+		}
+
 		g_application_release( G_APPLICATION( self ) );
 	}
 }
 
+//
+// Called when the stylesheet file or the actual file behind it (if the stylesheet is symlinked) has changed.
+//
+// Only the stylesheet is reloaded -- the rest of the configuration is not re-applied.
+//
+void foobar_application_handle_stylesheet_changed(
+	GFileMonitor*     monitor,
+	GFile*            file,
+	GFile*            other_file,
+	GFileMonitorEvent event_type,
+	gpointer          userdata )
+{
+	(void)monitor;
+	(void)file;
+	(void)other_file;
+	FoobarApplication* self = (FoobarApplication*)userdata;
+
+	// If the stylesheet is a symlink, the actual path might have changed.
+
+	foobar_application_watch_actual_stylesheet( self );
+
+	// Reload once the file has been written completely, instead of once for every chunk written by the editor.
+
+	if ( event_type == G_FILE_MONITOR_EVENT_CREATED || event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT )
+	{
+		foobar_application_load_stylesheet( self );
+	}
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Helper Methods
 // ---------------------------------------------------------------------------------------------------------------------
 
+//
+// Load the stylesheet at self->stylesheet_uri into the application's style provider.
+//
+// Parsing the stylesheet invalidates the style of every widget, so this is only done if the content of the stylesheet
+// has actually changed. If the stylesheet can't be read, the previous one is kept.
+//
+void foobar_application_load_stylesheet( FoobarApplication* self )
+{
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GFile ) file = g_file_new_for_uri( self->stylesheet_uri );
+	g_autoptr( GBytes ) contents = g_file_load_bytes( file, NULL, NULL, &error );
+	if ( !contents )
+	{
+		g_warning( "Unable to load stylesheet: %s", error->message );
+		return;
+	}
+
+	g_autofree gchar* checksum = g_compute_checksum_for_bytes( G_CHECKSUM_SHA256, contents );
+	if ( !g_strcmp0( self->stylesheet_checksum, checksum ) ) { return; }
+
+	g_free( self->stylesheet_checksum );
+	self->stylesheet_checksum = g_steal_pointer( &checksum );
+
+	// The provider is only added once and then kept, loading new content into it replaces the previous stylesheet.
+
+	if ( !self->style_provider )
+	{
+		self->style_provider = gtk_css_provider_new( );
+		gtk_style_context_add_provider_for_display(
+			gdk_display_get_default( ),
+			GTK_STYLE_PROVIDER( self->style_provider ),
+			GTK_STYLE_PROVIDER_PRIORITY_APPLICATION );
+	}
+
+	FOOBAR_TRACE_SPAN( "stylesheet", gtk_css_provider_load_from_bytes( self->style_provider, contents ) );
+}
+
+//
+// Watch the stylesheet at self->stylesheet_uri for changes.
+//
+// Only local files are watched -- stylesheets bundled as resources can't change.
+//
+void foobar_application_watch_stylesheet( FoobarApplication* self )
+{
+	g_clear_signal_handler( &self->stylesheet_handler_id, self->stylesheet_monitor );
+	g_clear_object( &self->stylesheet_monitor );
+
+	g_autoptr( GFile ) file = g_file_new_for_uri( self->stylesheet_uri );
+	g_autofree gchar* path = g_file_get_path( file );
+	if ( path )
+	{
+		self->stylesheet_monitor = foobar_application_create_stylesheet_monitor( path );
+		if ( self->stylesheet_monitor )
+		{
+			self->stylesheet_handler_id = g_signal_connect(
+				self->stylesheet_monitor,
+				"changed",
+				G_CALLBACK( foobar_application_handle_stylesheet_changed ),
+				self );
+		}
+	}
+
+	// In case the stylesheet is symlinked, also watch the actual file for content changes.
+
+	foobar_application_watch_actual_stylesheet( self );
+}
+
+//
+// Watch the actual file behind the stylesheet if it is symlinked, re-creating the file monitor if the actual path has
+// changed.
+//
+void foobar_application_watch_actual_stylesheet( FoobarApplication* self )
+{
+	g_autoptr( GFile ) file = g_file_new_for_uri( self->stylesheet_uri );
+	g_autofree gchar* path = g_file_get_path( file );
+	char* actual_path = path ? realpath( path, NULL ) : NULL;
+	if ( !g_strcmp0( self->stylesheet_actual_path, actual_path ) )
+	{
+		free( actual_path );
+		return;
+	}
+
+	free( self->stylesheet_actual_path );
+	self->stylesheet_actual_path = actual_path;
+
+	// Recreate the file monitor.
+
+	g_clear_signal_handler( &self->stylesheet_actual_handler_id, self->stylesheet_actual_monitor );
+	g_clear_object( &self->stylesheet_actual_monitor );
+
+	if ( self->stylesheet_actual_path && g_strcmp0( self->stylesheet_actual_path, path ) )
+	{
+		self->stylesheet_actual_monitor = foobar_application_create_stylesheet_monitor( self->stylesheet_actual_path );
+		if ( self->stylesheet_actual_monitor )
+		{
+			self->stylesheet_actual_handler_id = g_signal_connect(
+				self->stylesheet_actual_monitor,
+				"changed",
+				G_CALLBACK( foobar_application_handle_stylesheet_changed ),
+				self );
+		}
+	}
+}
+
+//
+// Create a new file monitor for the stylesheet, logging a warning on error.
+//
+GFileMonitor* foobar_application_create_stylesheet_monitor( gchar const* path )
+{
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GFile ) file = g_file_new_for_path( path );
+	GFileMonitor* monitor = g_file_monitor( file, G_FILE_MONITOR_NONE, NULL, &error );
+	if ( !monitor )
+	{
+		g_warning( "Unable to monitor stylesheet: %s", error->message );
+	}
+
+	return monitor;
+}
+
 //
 // Destroy all currently active panel windows.
 //
@@ -685,6 +1048,7 @@ guint foobar_application_create_panel(
 		self->bluetooth_service,
 		self->notification_service,
 		self->configuration_service );
+	foobar_trace_first_frame( GTK_WIDGET( panel ), "panel first frame" );
 	gtk_window_present( GTK_WINDOW( panel ) );
 
 	return gtk_application_window_get_id( GTK_APPLICATION_WINDOW( panel ) );
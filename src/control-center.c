@@ -4,6 +4,7 @@
 #include "widgets/control-center/control-details.h"
 #include "widgets/control-center/control-details-item.h"
 #include "widgets/inset-container.h"
+#include "widgets/notification-group-widget.h"
 #include "widgets/notification-widget.h"
 #include <gtk4-layer-shell.h>
 
@@ -16,7 +17,8 @@
 // The control center is made up of two sections:
 // - The "controls" section for configuring wi-fi, volume, brightness, etc.
 // - The "notifications" section showing all notifications (including dismissed ones) and allowing the user to close
-//   them.
+//   them. Notifications are grouped by application, with each group collapsed into a single row until it is expanded.
+//   While searching, the matching notifications are listed individually instead.
 //
 
 struct _FoobarControlCenter
@@ -24,10 +26,13 @@ struct _FoobarControlCenter
 	GtkWindow                   parent_instance;
 	GtkWidget*                  control_container;
 	GtkWidget*                  notification_list;
+	GtkWidget*                  notification_search;
 	GtkWidget*                  notification_container;
 	GtkWidget*                  notification_placeholder;
 	GtkWidget*                  notification_stack;
 	GtkWidget*                  layout;
+	GtkSelectionModel*          notification_group_model;
+	GtkSelectionModel*          notification_search_model;
 	FoobarBrightnessService*    brightness_service;
 	FoobarAudioService*         audio_service;
 	FoobarNetworkService*       network_service;
@@ -35,43 +40,56 @@ struct _FoobarControlCenter
 	FoobarNotificationService*  notification_service;
 	FoobarConfigurationService* configuration_service;
 	gchar*                      notification_time_format;
+	gboolean                    notification_relative_time;
 	gint                        notification_min_height;
 	gint                        notification_close_button_inset;
 	gint                        padding;
 	gint                        spacing;
 	gulong                      config_handler_id;
+	gulong                      wifi_handler_id;
+	gulong                      network_loading_handler_id;
+	gulong                      bluetooth_loading_handler_id;
 };
 
-static void                          foobar_control_center_class_init                             ( FoobarControlCenterClass*  klass );
-static void                          foobar_control_center_init                                   ( FoobarControlCenter*       self );
-static void                          foobar_control_center_finalize                               ( GObject*                   object );
-static void                          foobar_control_center_handle_notification_setup              ( GtkListItemFactory*        factory,
-                                                                                                    GtkListItem*               list_item,
-                                                                                                    gpointer                   userdata );
-static void                          foobar_control_center_handle_network_setup                   ( GtkListItemFactory*        factory,
-                                                                                                    GtkListItem*               list_item,
-                                                                                                    gpointer                   userdata );
-static void                          foobar_control_center_handle_bluetooth_device_setup          ( GtkListItemFactory*        factory,
-                                                                                                    GtkListItem*               list_item,
-                                                                                                    gpointer                   userdata );
-static void                          foobar_control_center_handle_bluetooth_device_activate       ( GtkListView*               view,
-                                                                                                    guint                      position,
-                                                                                                    gpointer                   userdata );
-static void                          foobar_control_center_handle_audio_device_setup              ( GtkListItemFactory*        factory,
-                                                                                                    GtkListItem*               list_item,
-                                                                                                    gpointer                   userdata );
-static void                          foobar_control_center_handle_audio_device_activate           ( GtkListView*               view,
-                                                                                                    guint                      position,
-                                                                                                    gpointer                   userdata );
-static void                          foobar_control_center_handle_config_change                   ( GObject*                   object,
-                                                                                                    GParamSpec*                pspec,
-                                                                                                    gpointer                   userdata );
-static FoobarControlDetailsAccessory foobar_control_center_compute_bluetooth_device_accessory     ( GtkExpression*             expression,
-                                                                                                    FoobarBluetoothDeviceState state,
-                                                                                                    gpointer                   userdata );
-static gchar*                        foobar_control_center_compute_visible_notification_child_name( GtkExpression*             expression,
-                                                                                                    guint                      count,
-                                                                                                    gpointer                   userdata );
+static void                          foobar_control_center_class_init                             ( FoobarControlCenterClass*              klass );
+static void                          foobar_control_center_init                                   ( FoobarControlCenter*                   self );
+static void                          foobar_control_center_finalize                               ( GObject*                               object );
+static void                          foobar_control_center_handle_notification_setup              ( GtkListItemFactory*                    factory,
+                                                                                                    GtkListItem*                           list_item,
+                                                                                                    gpointer                               userdata );
+static GListModel*                   foobar_control_center_create_notification_group_model        ( gpointer                               item,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_notification_search_changed     ( GtkSearchEntry*                        entry,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_network_setup                   ( GtkListItemFactory*                    factory,
+                                                                                                    GtkListItem*                           list_item,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_bluetooth_device_setup          ( GtkListItemFactory*                    factory,
+                                                                                                    GtkListItem*                           list_item,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_bluetooth_device_activate       ( GtkListView*                           view,
+                                                                                                    guint                                  position,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_audio_device_setup              ( GtkListItemFactory*                    factory,
+                                                                                                    GtkListItem*                           list_item,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_audio_device_activate           ( GtkListView*                           view,
+                                                                                                    guint                                  position,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_apply_notification_configuration       ( FoobarControlCenter*                   self,
+                                                                                                    FoobarNotificationConfiguration const* config );
+static void                          foobar_control_center_handle_connectivity_change             ( GObject*                               service,
+                                                                                                    GParamSpec*                            pspec,
+                                                                                                    gpointer                               userdata );
+static void                          foobar_control_center_handle_config_change                   ( FoobarConfigurationService*            service,
+                                                                                                    FoobarConfigurationSection             section,
+                                                                                                    gpointer                               userdata );
+static FoobarControlDetailsAccessory foobar_control_center_compute_bluetooth_device_accessory     ( GtkExpression*                         expression,
+                                                                                                    FoobarBluetoothDeviceState             state,
+                                                                                                    gpointer                               userdata );
+static gchar*                        foobar_control_center_compute_visible_notification_child_name( GtkExpression*                         expression,
+                                                                                                    guint                                  count,
+                                                                                                    gpointer                               userdata );
 
 G_DEFINE_FINAL_TYPE( FoobarControlCenter, foobar_control_center, GTK_TYPE_WINDOW )
 
@@ -114,6 +132,20 @@ void foobar_control_center_init( FoobarControlCenter* self )
 	GtkWidget* scrolled_window = gtk_scrolled_window_new( );
 	gtk_scrolled_window_set_child( GTK_SCROLLED_WINDOW( scrolled_window ), self->notification_container );
 	gtk_scrolled_window_set_policy( GTK_SCROLLED_WINDOW( scrolled_window ), GTK_POLICY_NEVER, GTK_POLICY_EXTERNAL );
+	gtk_widget_set_vexpand( scrolled_window, TRUE );
+
+	self->notification_search = gtk_search_entry_new( );
+	gtk_widget_add_css_class( self->notification_search, "search" );
+	gtk_search_entry_set_placeholder_text( GTK_SEARCH_ENTRY( self->notification_search ), "Search Notifications" );
+	g_signal_connect(
+		self->notification_search,
+		"search-changed",
+		G_CALLBACK( foobar_control_center_handle_notification_search_changed ),
+		self );
+
+	GtkWidget* notification_page = gtk_box_new( GTK_ORIENTATION_VERTICAL, 0 );
+	gtk_box_append( GTK_BOX( notification_page ), self->notification_search );
+	gtk_box_append( GTK_BOX( notification_page ), scrolled_window );
 
 	self->notification_placeholder = gtk_label_new( "No Notifications" );
 	gtk_widget_add_css_class( self->notification_placeholder, "placeholder" );
@@ -121,7 +153,7 @@ void foobar_control_center_init( FoobarControlCenter* self )
 	gtk_label_set_wrap( GTK_LABEL( self->notification_placeholder ), FALSE );
 
 	self->notification_stack = gtk_stack_new( );
-	gtk_stack_add_named( GTK_STACK( self->notification_stack ), scrolled_window, STACK_ITEM_LIST );
+	gtk_stack_add_named( GTK_STACK( self->notification_stack ), notification_page, STACK_ITEM_LIST );
 	gtk_stack_add_named( GTK_STACK( self->notification_stack ), self->notification_placeholder, STACK_ITEM_PLACEHOLDER );
 	gtk_widget_set_vexpand( self->notification_stack, TRUE );
 	gtk_widget_set_hexpand( self->notification_stack, TRUE );
@@ -150,12 +182,17 @@ void foobar_control_center_finalize( GObject* object )
 	FoobarControlCenter* self = (FoobarControlCenter*)object;
 
 	g_clear_signal_handler( &self->config_handler_id, self->configuration_service );
+	g_clear_signal_handler( &self->wifi_handler_id, self->network_service );
+	g_clear_signal_handler( &self->network_loading_handler_id, self->network_service );
+	g_clear_signal_handler( &self->bluetooth_loading_handler_id, self->bluetooth_service );
 	g_clear_object( &self->brightness_service );
 	g_clear_object( &self->audio_service );
 	g_clear_object( &self->network_service );
 	g_clear_object( &self->bluetooth_service );
 	g_clear_object( &self->configuration_service );
 	g_clear_object( &self->notification_service );
+	g_clear_object( &self->notification_group_model );
+	g_clear_object( &self->notification_search_model );
 	g_clear_pointer( &self->notification_time_format, g_free );
 
 	G_OBJECT_CLASS( foobar_control_center_parent_class )->finalize( object );
@@ -200,15 +237,56 @@ FoobarControlCenter* foobar_control_center_new(
 		foobar_configuration_get_notifications( config ) );
 	self->config_handler_id = g_signal_connect(
 		self->configuration_service,
-		"notify::current",
+		"changed",
 		G_CALLBACK( foobar_control_center_handle_config_change ),
 		self );
 
+	// The connectivity row depends on whether there is a wi-fi adapter, which may only be known once the network service
+	// has connected to NetworkManager. Until then, both buttons are shown in a loading state.
+
+	self->wifi_handler_id = g_signal_connect(
+		self->network_service,
+		"notify::wifi",
+		G_CALLBACK( foobar_control_center_handle_connectivity_change ),
+		self );
+	self->network_loading_handler_id = g_signal_connect(
+		self->network_service,
+		"notify::is-loading",
+		G_CALLBACK( foobar_control_center_handle_connectivity_change ),
+		self );
+	self->bluetooth_loading_handler_id = g_signal_connect(
+		self->bluetooth_service,
+		"notify::is-loading",
+		G_CALLBACK( foobar_control_center_handle_connectivity_change ),
+		self );
+
 	// Set up the notifications list view.
 
+	// The list shows one row per application, whose notifications are only added as child rows when it is expanded.
+	// While searching, it shows the search results instead, which are notifications and thus never have child rows.
+
 	GListModel* source_model = foobar_notification_service_get_notifications( self->notification_service );
-	GtkNoSelection* selection_model = gtk_no_selection_new( g_object_ref( source_model ) );
-	gtk_list_view_set_model( GTK_LIST_VIEW( self->notification_list ), GTK_SELECTION_MODEL( selection_model ) );
+	GListModel* group_model = foobar_notification_service_get_groups( self->notification_service );
+	GtkTreeListModel* group_tree_model = gtk_tree_list_model_new(
+		g_object_ref( group_model ),
+		FALSE,
+		FALSE,
+		foobar_control_center_create_notification_group_model,
+		NULL,
+		NULL );
+	self->notification_group_model = GTK_SELECTION_MODEL( gtk_no_selection_new( G_LIST_MODEL( group_tree_model ) ) );
+
+	GListModel* search_model = foobar_notification_service_get_search_results( self->notification_service );
+	GtkTreeListModel* search_tree_model = gtk_tree_list_model_new(
+		g_object_ref( search_model ),
+		FALSE,
+		FALSE,
+		foobar_control_center_create_notification_group_model,
+		NULL,
+		NULL );
+	self->notification_search_model = GTK_SELECTION_MODEL( gtk_no_selection_new( G_LIST_MODEL( search_tree_model ) ) );
+
+	gtk_list_view_set_model( GTK_LIST_VIEW( self->notification_list ), self->notification_group_model );
 
 	// Set up bindings.
 
@@ -244,10 +322,6 @@ void foobar_control_center_apply_configuration(
 
 	// Copy configuration into member variables.
 
-	g_clear_pointer( &self->notification_time_format, g_free );
-	self->notification_time_format = g_strdup( foobar_notification_configuration_get_time_format( notification_config ) );
-	self->notification_min_height = foobar_notification_configuration_get_min_height( notification_config );
-	self->notification_close_button_inset = foobar_notification_configuration_get_close_button_inset( notification_config );
 	self->padding = foobar_control_center_configuration_get_padding( config );
 	self->spacing = foobar_control_center_configuration_get_spacing( config );
 
@@ -327,17 +401,17 @@ void foobar_control_center_apply_configuration(
 	gtk_widget_set_margin_top( self->notification_placeholder, self->padding );
 	gtk_widget_set_margin_bottom( self->notification_placeholder, self->padding );
 
+	gtk_widget_set_margin_start( self->notification_search, self->padding );
+	gtk_widget_set_margin_end( self->notification_search, self->padding );
+	gtk_widget_set_margin_top( self->notification_search, self->padding );
+
 	gtk_box_set_spacing( GTK_BOX( self->control_container ), self->spacing );
 	gtk_widget_set_margin_top( self->control_container, self->padding );
 	gtk_widget_set_margin_bottom( self->control_container, self->padding );
 
-	// Re-create list items by resetting the factory.
+	// Apply the notification settings, which also re-creates the notification list items for the new spacing.
 
-	GtkListItemFactory* factory = gtk_list_view_get_factory( GTK_LIST_VIEW( self->notification_list ) );
-	g_object_ref( factory );
-	gtk_list_view_set_factory( GTK_LIST_VIEW( self->notification_list ), NULL );
-	gtk_list_view_set_factory( GTK_LIST_VIEW( self->notification_list ), factory );
-	g_object_unref( factory );
+	foobar_control_center_apply_notification_configuration( self, notification_config );
 
 	// Re-create control rows.
 
@@ -365,6 +439,10 @@ void foobar_control_center_apply_configuration(
 				GtkWidget* bluetooth_button = foobar_control_button_new( );
 				foobar_control_button_set_icon_name( FOOBAR_CONTROL_BUTTON( bluetooth_button ), "fluent-bluetooth-symbolic" );
 				foobar_control_button_set_label( FOOBAR_CONTROL_BUTTON( bluetooth_button ), "Bluetooth" );
+				if ( foobar_bluetooth_service_is_loading( self->bluetooth_service ) )
+				{
+					gtk_widget_add_css_class( bluetooth_button, "loading" );
+				}
 
 				GtkWidget* button_container = gtk_box_new( GTK_ORIENTATION_HORIZONTAL, self->spacing );
 				gtk_box_set_homogeneous( GTK_BOX( button_container ), TRUE );
@@ -376,7 +454,8 @@ void foobar_control_center_apply_configuration(
 				GtkWidget* row = gtk_box_new( GTK_ORIENTATION_VERTICAL, 0 );
 				gtk_box_append( GTK_BOX( row ), button_container );
 
-				// Show either a button for managing Wi-Fi or a static element for ethernet.
+				// Show either a button for managing Wi-Fi or a static element for ethernet. While the network service is still
+				// loading, it is not known yet which of the two applies.
 
 				FoobarNetworkAdapterWifi* wifi_adapter = foobar_network_service_get_wifi( self->network_service );
 				if ( wifi_adapter )
@@ -428,6 +507,14 @@ void foobar_control_center_apply_configuration(
 
 					gtk_box_append( GTK_BOX( row ), wifi_details );
 				}
+				else if ( foobar_network_service_is_loading( self->network_service ) )
+				{
+					gtk_widget_add_css_class( network_button, "loading" );
+					foobar_control_button_set_icon_name( FOOBAR_CONTROL_BUTTON( network_button ), "fluent-virtual-network-symbolic" );
+					foobar_control_button_set_label( FOOBAR_CONTROL_BUTTON( network_button ), "Network" );
+					foobar_control_button_set_can_expand( FOOBAR_CONTROL_BUTTON( network_button ), FALSE );
+					foobar_control_button_set_can_toggle( FOOBAR_CONTROL_BUTTON( network_button ), FALSE );
+				}
 				else
 				{
 					foobar_control_button_set_icon_name( FOOBAR_CONTROL_BUTTON( network_button ), "fluent-virtual-network-symbolic" );
@@ -596,12 +683,37 @@ void foobar_control_center_apply_configuration(
 	}
 }
 
+//
+// Apply the notification configuration used by the notification list, without touching the rest of the control center.
+//
+void foobar_control_center_apply_notification_configuration(
+	FoobarControlCenter*                   self,
+	FoobarNotificationConfiguration const* config )
+{
+	// Copy configuration into member variables.
+
+	g_clear_pointer( &self->notification_time_format, g_free );
+	self->notification_time_format = g_strdup( foobar_notification_configuration_get_time_format( config ) );
+	self->notification_relative_time = foobar_notification_configuration_get_relative_time( config );
+	self->notification_min_height = foobar_notification_configuration_get_min_height( config );
+	self->notification_close_button_inset = foobar_notification_configuration_get_close_button_inset( config );
+
+	// Re-create list items by resetting the factory.
+
+	GtkListItemFactory* factory = gtk_list_view_get_factory( GTK_LIST_VIEW( self->notification_list ) );
+	g_object_ref( factory );
+	gtk_list_view_set_factory( GTK_LIST_VIEW( self->notification_list ), NULL );
+	gtk_list_view_set_factory( GTK_LIST_VIEW( self->notification_list ), factory );
+	g_object_unref( factory );
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Signal Handlers
 // ---------------------------------------------------------------------------------------------------------------------
 
 //
-// Called by the notification list view to create a widget for displaying a notification.
+// Called by the notification list view to create a widget for displaying a notification group or a notification within
+// an expanded group.
 //
 void foobar_control_center_handle_notification_setup(
 	GtkListItemFactory* factory,
@@ -611,20 +723,62 @@ void foobar_control_center_handle_notification_setup(
 	(void)factory;
 	FoobarControlCenter* self = (FoobarControlCenter*)userdata;
 
-	GtkWidget* widget = foobar_notification_widget_new( );
+	GtkWidget* group_widget = foobar_notification_group_widget_new( );
+	GtkWidget* widget = GTK_WIDGET(
+		foobar_notification_group_widget_get_notification_widget( FOOBAR_NOTIFICATION_GROUP_WIDGET( group_widget ) ) );
 	foobar_notification_widget_set_close_action( FOOBAR_NOTIFICATION_WIDGET( widget ), FOOBAR_TYPE_NOTIFICATION_CLOSE_ACTION_REMOVE );
 	foobar_notification_widget_set_time_format( FOOBAR_NOTIFICATION_WIDGET( widget ), self->notification_time_format );
+	foobar_notification_widget_set_relative_time( FOOBAR_NOTIFICATION_WIDGET( widget ), self->notification_relative_time );
+	foobar_notification_widget_set_service( FOOBAR_NOTIFICATION_WIDGET( widget ), self->notification_service );
 	foobar_notification_widget_set_min_height( FOOBAR_NOTIFICATION_WIDGET( widget ), self->notification_min_height );
 	foobar_notification_widget_set_close_button_inset( FOOBAR_NOTIFICATION_WIDGET( widget ), self->notification_close_button_inset );
 	foobar_notification_widget_set_inset_start( FOOBAR_NOTIFICATION_WIDGET( widget ), self->padding );
 	foobar_notification_widget_set_inset_end( FOOBAR_NOTIFICATION_WIDGET( widget ), self->padding );
 	foobar_notification_widget_set_inset_top( FOOBAR_NOTIFICATION_WIDGET( widget ), self->spacing / 2 );
 	foobar_notification_widget_set_inset_bottom( FOOBAR_NOTIFICATION_WIDGET( widget ), self->spacing / 2 );
-	gtk_list_item_set_child( list_item, widget );
+	gtk_list_item_set_child( list_item, group_widget );
 
 	{
 		GtkExpression* item_expr = gtk_property_expression_new( GTK_TYPE_LIST_ITEM, NULL, "item" );
-		gtk_expression_bind( item_expr, widget, "notification", list_item );
+		gtk_expression_bind( item_expr, group_widget, "row", list_item );
+	}
+}
+
+//
+// Called by the tree list model of the notification list to get the notifications within a group.
+//
+// Notifications themselves have no children.
+//
+GListModel* foobar_control_center_create_notification_group_model(
+	gpointer item,
+	gpointer userdata )
+{
+	(void)userdata;
+
+	if ( !FOOBAR_IS_NOTIFICATION_GROUP( item ) ) { return NULL; }
+
+	return g_object_ref( foobar_notification_group_get_notifications( FOOBAR_NOTIFICATION_GROUP( item ) ) );
+}
+
+//
+// Called when the query in the notification search entry changed.
+//
+// The notifications matching a non-empty query are listed individually, while the list goes back to showing groups
+// once the query is cleared.
+//
+void foobar_control_center_handle_notification_search_changed(
+	GtkSearchEntry* entry,
+	gpointer        userdata )
+{
+	FoobarControlCenter* self = (FoobarControlCenter*)userdata;
+
+	gchar const* query = gtk_editable_get_text( GTK_EDITABLE( entry ) );
+	foobar_notification_service_set_search_query( self->notification_service, query );
+
+	GtkSelectionModel* model = *query ? self->notification_search_model : self->notification_group_model;
+	if ( gtk_list_view_get_model( GTK_LIST_VIEW( self->notification_list ) ) != model )
+	{
+		gtk_list_view_set_model( GTK_LIST_VIEW( self->notification_list ), model );
 	}
 }
 
@@ -757,14 +911,17 @@ void foobar_control_center_handle_audio_device_activate(
 }
 
 //
-// Signal handler called when the global configuration file has changed.
+// Signal handler called when the wi-fi adapter of the network service has changed or when the network or bluetooth
+// service has finished loading.
 //
-void foobar_control_center_handle_config_change(
-	GObject*    object,
+// This re-creates the control rows, so the connectivity row shows the correct button for the available adapter.
+//
+void foobar_control_center_handle_connectivity_change(
+	GObject*    service,
 	GParamSpec* pspec,
 	gpointer    userdata )
 {
-	(void)object;
+	(void)service;
 	(void)pspec;
 	FoobarControlCenter* self = (FoobarControlCenter*)userdata;
 
@@ -775,6 +932,41 @@ void foobar_control_center_handle_config_change(
 		foobar_configuration_get_notifications( config ) );
 }
 
+//
+// Signal handler called once for each section of the configuration file that has changed.
+//
+// A change to the notification settings only requires the notification list items to be re-created.
+//
+void foobar_control_center_handle_config_change(
+	FoobarConfigurationService* service,
+	FoobarConfigurationSection  section,
+	gpointer                    userdata )
+{
+	(void)service;
+	FoobarControlCenter* self = (FoobarControlCenter*)userdata;
+
+	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
+	switch ( section )
+	{
+		case FOOBAR_CONFIGURATION_SECTION_CONTROL_CENTER:
+			foobar_control_center_apply_configuration(
+				self,
+				foobar_configuration_get_control_center( config ),
+				foobar_configuration_get_notifications( config ) );
+			break;
+		case FOOBAR_CONFIGURATION_SECTION_NOTIFICATIONS:
+			foobar_control_center_apply_notification_configuration( self, foobar_configuration_get_notifications( config ) );
+			break;
+		case FOOBAR_CONFIGURATION_SECTION_GENERAL:
+		case FOOBAR_CONFIGURATION_SECTION_PANEL:
+		case FOOBAR_CONFIGURATION_SECTION_LAUNCHER:
+			break;
+		default:
+			g_warn_if_reached( );
+			break;
+	}
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Value Converters
 // ---------------------------------------------------------------------------------------------------------------------
@@ -1,6 +1,7 @@
 #include "launcher.h"
 #include "launcher-item.h"
 #include "widgets/limit-container.h"
+#include "widgets/sparkline.h"
 #include <gtk4-layer-shell.h>
 #include <gdk/gdkkeysyms.h>
 #include <string.h>
@@ -31,51 +32,57 @@ struct _FoobarLauncher
 	gulong                      config_handler_id;
 };
 
-static void     foobar_launcher_class_init               ( FoobarLauncherClass*   klass );
-static void     foobar_launcher_init                     ( FoobarLauncher*        self );
-static void     foobar_launcher_finalize                 ( GObject*               object );
-static void     foobar_launcher_handle_search_changed    ( GtkEditable*           editable,
-                                                           gpointer               userdata );
-static void     foobar_launcher_handle_search_activate   ( GtkText*               text,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_handle_search_key        ( GtkEventControllerKey* controller,
-                                                           guint                  keyval,
-                                                           guint                  keycode,
-                                                           GdkModifierType        state,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_handle_list_key          ( GtkEventControllerKey* controller,
-                                                           guint                  keyval,
-                                                           guint                  keycode,
-                                                           GdkModifierType        state,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_handle_window_key        ( GtkEventControllerKey* controller,
-                                                           guint                  keyval,
-                                                           guint                  keycode,
-                                                           GdkModifierType        state,
-                                                           gpointer               userdata );
-static void     foobar_launcher_handle_item_setup        ( GtkListItemFactory*    factory,
-                                                           GtkListItem*           list_item,
-                                                           gpointer               userdata );
-static void     foobar_launcher_handle_item_activate     ( GtkListView*           view,
-                                                           guint                  position,
-                                                           gpointer               userdata );
-static void     foobar_launcher_handle_config_change     ( GObject*               object,
-                                                           GParamSpec*            pspec,
-                                                           gpointer               userdata );
-static void     foobar_launcher_handle_show              ( GtkWidget*             widget,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_compute_icon_visible     ( GtkExpression*         expression,
-                                                           GIcon*                 icon,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_compute_label_visible    ( GtkExpression*         expression,
-                                                           gchar const*           label,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_compute_separator_visible( GtkExpression*         expression,
-                                                           guint                  item_count,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_filter_func              ( gpointer               item,
-                                                           gpointer               userdata );
-static gboolean foobar_launcher_is_navigation_key        ( guint                  keyval );
+static void     foobar_launcher_class_init               ( FoobarLauncherClass*        klass );
+static void     foobar_launcher_init                     ( FoobarLauncher*             self );
+static void     foobar_launcher_finalize                 ( GObject*                    object );
+static void     foobar_launcher_handle_search_changed    ( GtkEditable*                editable,
+                                                           gpointer                    userdata );
+static void     foobar_launcher_handle_search_activate   ( GtkText*                    text,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_handle_search_key        ( GtkEventControllerKey*      controller,
+                                                           guint                       keyval,
+                                                           guint                       keycode,
+                                                           GdkModifierType             state,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_handle_list_key          ( GtkEventControllerKey*      controller,
+                                                           guint                       keyval,
+                                                           guint                       keycode,
+                                                           GdkModifierType             state,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_handle_window_key        ( GtkEventControllerKey*      controller,
+                                                           guint                       keyval,
+                                                           guint                       keycode,
+                                                           GdkModifierType             state,
+                                                           gpointer                    userdata );
+static void     foobar_launcher_handle_item_setup        ( GtkListItemFactory*         factory,
+                                                           GtkListItem*                list_item,
+                                                           gpointer                    userdata );
+static void     foobar_launcher_handle_item_activate     ( GtkListView*                view,
+                                                           guint                       position,
+                                                           gpointer                    userdata );
+static void     foobar_launcher_handle_config_change     ( FoobarConfigurationService* service,
+                                                           FoobarConfigurationSection  section,
+                                                           gpointer                    userdata );
+static void     foobar_launcher_handle_show              ( GtkWidget*                  widget,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_compute_icon_visible     ( GtkExpression*              expression,
+                                                           GIcon*                      icon,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_compute_label_visible    ( GtkExpression*              expression,
+                                                           gchar const*                label,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_compute_separator_visible( GtkExpression*              expression,
+                                                           guint                       item_count,
+                                                           gpointer                    userdata );
+static GBytes*  foobar_launcher_compute_samples          ( GtkExpression*              expression,
+                                                           GObject*                    item,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_compute_samples_visible  ( GtkExpression*              expression,
+                                                           GBytes*                     samples,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_filter_func              ( gpointer                    item,
+                                                           gpointer                    userdata );
+static gboolean foobar_launcher_is_navigation_key        ( guint                       keyval );
 
 G_DEFINE_FINAL_TYPE( FoobarLauncher, foobar_launcher, GTK_TYPE_WINDOW )
 
@@ -256,7 +263,7 @@ FoobarLauncher* foobar_launcher_new(
 	foobar_launcher_apply_configuration( self, foobar_configuration_get_launcher( config ) );
 	self->config_handler_id = g_signal_connect(
 		self->configuration_service,
-		"notify::current",
+		"changed::launcher",
 		G_CALLBACK( foobar_launcher_handle_config_change ),
 		self );
 
@@ -465,10 +472,15 @@ void foobar_launcher_handle_item_setup(
 	gtk_box_append( GTK_BOX( column ), title );
 	gtk_box_append( GTK_BOX( column ), description );
 
+	GtkWidget* plot = foobar_sparkline_new( );
+	gtk_widget_set_valign( plot, GTK_ALIGN_CENTER );
+	gtk_widget_add_css_class( plot, "plot" );
+
 	GtkWidget* row = gtk_box_new( GTK_ORIENTATION_HORIZONTAL, 0 );
 	gtk_widget_add_css_class( row, "item" );
 	gtk_box_append( GTK_BOX( row ), icon );
 	gtk_box_append( GTK_BOX( row ), column );
+	gtk_box_append( GTK_BOX( row ), plot );
 
 	gtk_list_item_set_child( list_item, row );
 
@@ -511,6 +523,30 @@ void foobar_launcher_handle_item_setup(
 			NULL );
 		gtk_expression_bind( visible_expr, description, "visible", list_item );
 	}
+
+	{
+		GtkExpression* item_expr = gtk_property_expression_new( GTK_TYPE_LIST_ITEM, NULL, "item" );
+		GtkExpression* samples_params[] = { item_expr };
+		GtkExpression* samples_expr = gtk_cclosure_expression_new(
+			G_TYPE_BYTES,
+			NULL,
+			G_N_ELEMENTS( samples_params ),
+			samples_params,
+			G_CALLBACK( foobar_launcher_compute_samples ),
+			NULL,
+			NULL );
+		gtk_expression_bind( gtk_expression_ref( samples_expr ), plot, "samples", list_item );
+		GtkExpression* visible_params[] = { samples_expr };
+		GtkExpression* visible_expr = gtk_cclosure_expression_new(
+			G_TYPE_BOOLEAN,
+			NULL,
+			G_N_ELEMENTS( visible_params ),
+			visible_params,
+			G_CALLBACK( foobar_launcher_compute_samples_visible ),
+			NULL,
+			NULL );
+		gtk_expression_bind( visible_expr, plot, "visible", list_item );
+	}
 }
 
 //
@@ -531,15 +567,15 @@ void foobar_launcher_handle_item_activate(
 }
 
 //
-// Signal handler called when the global configuration file has changed.
+// Signal handler called when the launcher section of the configuration file has changed.
 //
 void foobar_launcher_handle_config_change(
-	GObject*    object,
-	GParamSpec* pspec,
-	gpointer    userdata )
+	FoobarConfigurationService* service,
+	FoobarConfigurationSection  section,
+	gpointer                    userdata )
 {
-	(void)object;
-	(void)pspec;
+	(void)service;
+	(void)section;
 	FoobarLauncher* self = (FoobarLauncher*)userdata;
 
 	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
@@ -615,6 +651,37 @@ gboolean foobar_launcher_compute_separator_visible(
 	return item_count > 0;
 }
 
+//
+// Get the samples to plot for a result item, only available for quick answers to expressions in "x".
+//
+GBytes* foobar_launcher_compute_samples(
+	GtkExpression* expression,
+	GObject*       item,
+	gpointer       userdata )
+{
+	(void)expression;
+	(void)userdata;
+
+	if ( !FOOBAR_IS_QUICK_ANSWER( item ) ) { return NULL; }
+
+	GBytes* samples = foobar_quick_answer_get_samples( FOOBAR_QUICK_ANSWER( item ) );
+	return samples ? g_bytes_ref( samples ) : NULL;
+}
+
+//
+// Derive the visibility of a result item's plot from its samples.
+//
+gboolean foobar_launcher_compute_samples_visible(
+	GtkExpression* expression,
+	GBytes*        samples,
+	gpointer       userdata )
+{
+	(void)expression;
+	(void)userdata;
+
+	return samples != NULL;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Helper Methods
 // ---------------------------------------------------------------------------------------------------------------------
@@ -1,4 +1,5 @@
 #include "application.h"
+#include "trace.h"
 
 //
 // Entry point of the application, runs the GTK app.
@@ -8,5 +9,8 @@ int main(
 	char** argv )
 {
 	g_autoptr( FoobarApplication ) app = foobar_application_new( );
-	return g_application_run( G_APPLICATION( app ), argc, argv );
+	int status = g_application_run( G_APPLICATION( app ), argc, argv );
+
+	foobar_trace_flush( );
+	return status;
 }
@@ -8,25 +8,29 @@
 // A (usually invisible) window in the corner of the screen, displaying incoming notifications before they are either
 // dismissed or a timeout has passed.
 //
+// Only the newest popups up to the configured limit are shown. Older popups appear once newer ones are dismissed.
+//
 
 struct _FoobarNotificationArea
 {
 	GtkWindow                   parent_instance;
 	GtkWidget*                  notification_list;
+	GtkSliceListModel*          visible_notifications;
 	FoobarNotificationService*  notification_service;
 	FoobarConfigurationService* configuration_service;
 	gint                        min_height;
 	gint                        spacing;
 	gint                        close_button_inset;
 	gchar*                      time_format;
+	gboolean                    relative_time;
 	gulong                      config_handler_id;
 };
 
 static void foobar_notification_area_class_init          ( FoobarNotificationAreaClass* klass );
 static void foobar_notification_area_init                ( FoobarNotificationArea*      self );
 static void foobar_notification_area_finalize            ( GObject*                     object );
-static void foobar_notification_area_handle_config_change( GObject*                     object,
-                                                           GParamSpec*                  pspec,
+static void foobar_notification_area_handle_config_change( FoobarConfigurationService*  service,
+                                                           FoobarConfigurationSection   section,
                                                            gpointer                     userdata );
 static void foobar_notification_area_handle_item_setup   ( GtkListItemFactory*          factory,
                                                            GtkListItem*                 list_item,
@@ -54,7 +58,9 @@ void foobar_notification_area_init( FoobarNotificationArea* self )
 {
 	GtkListItemFactory* notification_factory = gtk_signal_list_item_factory_new( );
 	g_signal_connect( notification_factory, "setup", G_CALLBACK( foobar_notification_area_handle_item_setup ), self );
-	self->notification_list = gtk_list_view_new( NULL, notification_factory );
+	self->visible_notifications = gtk_slice_list_model_new( NULL, 0, G_MAXUINT );
+	GtkNoSelection* selection_model = gtk_no_selection_new( G_LIST_MODEL( g_object_ref( self->visible_notifications ) ) );
+	self->notification_list = gtk_list_view_new( GTK_SELECTION_MODEL( selection_model ), notification_factory );
 
 	gtk_window_set_child( GTK_WINDOW( self ), self->notification_list );
 	gtk_window_set_title( GTK_WINDOW( self ), "Foobar Notification Area" );
@@ -75,6 +81,7 @@ void foobar_notification_area_finalize( GObject* object )
 	g_clear_signal_handler( &self->config_handler_id, self->configuration_service );
 	g_clear_object( &self->notification_service );
 	g_clear_object( &self->configuration_service );
+	g_clear_object( &self->visible_notifications );
 	g_clear_pointer( &self->time_format, g_free );
 
 	G_OBJECT_CLASS( foobar_notification_area_parent_class )->finalize( object );
@@ -104,15 +111,14 @@ FoobarNotificationArea* foobar_notification_area_new(
 	foobar_notification_area_apply_configuration( self, foobar_configuration_get_notifications( config ) );
 	self->config_handler_id = g_signal_connect(
 		self->configuration_service,
-		"notify::current",
+		"changed::notifications",
 		G_CALLBACK( foobar_notification_area_handle_config_change ),
 		self );
 
 	// Set up the notifications list view.
 
 	GListModel* source_model = foobar_notification_service_get_popup_notifications( self->notification_service );
-	GtkNoSelection* selection_model = gtk_no_selection_new( g_object_ref( source_model ) );
-	gtk_list_view_set_model( GTK_LIST_VIEW( self->notification_list ), GTK_SELECTION_MODEL( selection_model ) );
+	gtk_slice_list_model_set_model( self->visible_notifications, source_model );
 
 	return self;
 }
@@ -135,6 +141,10 @@ void foobar_notification_area_apply_configuration(
 	self->close_button_inset = foobar_notification_configuration_get_close_button_inset( config );
 	g_clear_pointer( &self->time_format, g_free );
 	self->time_format = g_strdup( foobar_notification_configuration_get_time_format( config ) );
+	self->relative_time = foobar_notification_configuration_get_relative_time( config );
+
+	gint max_popups = foobar_notification_configuration_get_max_popups( config );
+	gtk_slice_list_model_set_size( self->visible_notifications, max_popups > 0 ? (guint)max_popups : G_MAXUINT );
 
 	// Recreate list items by resetting the factory.
 
@@ -154,15 +164,15 @@ void foobar_notification_area_apply_configuration(
 // ---------------------------------------------------------------------------------------------------------------------
 
 //
-// Signal handler called when the global configuration file has changed.
+// Signal handler called when the notifications section of the configuration file has changed.
 //
 void foobar_notification_area_handle_config_change(
-	GObject*    object,
-	GParamSpec* pspec,
-	gpointer    userdata )
+	FoobarConfigurationService* service,
+	FoobarConfigurationSection  section,
+	gpointer                    userdata )
 {
-	(void)object;
-	(void)pspec;
+	(void)service;
+	(void)section;
 	FoobarNotificationArea* self = (FoobarNotificationArea*)userdata;
 
 	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
@@ -183,6 +193,8 @@ void foobar_notification_area_handle_item_setup(
 	GtkWidget* widget = foobar_notification_widget_new( );
 	foobar_notification_widget_set_close_action( FOOBAR_NOTIFICATION_WIDGET( widget ), FOOBAR_TYPE_NOTIFICATION_CLOSE_ACTION_DISMISS );
 	foobar_notification_widget_set_time_format( FOOBAR_NOTIFICATION_WIDGET( widget ), self->time_format );
+	foobar_notification_widget_set_relative_time( FOOBAR_NOTIFICATION_WIDGET( widget ), self->relative_time );
+	foobar_notification_widget_set_service( FOOBAR_NOTIFICATION_WIDGET( widget ), self->notification_service );
 	foobar_notification_widget_set_min_height( FOOBAR_NOTIFICATION_WIDGET( widget ), self->min_height );
 	foobar_notification_widget_set_close_button_inset( FOOBAR_NOTIFICATION_WIDGET( widget ), self->close_button_inset );
 	foobar_notification_widget_set_inset_end( FOOBAR_NOTIFICATION_WIDGET( widget ), self->spacing );
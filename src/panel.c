@@ -20,6 +20,7 @@ struct _FoobarPanel
 	GtkWidget*                  center_items;
 	GtkWidget*                  end_items;
 	GPtrArray*                  item_widgets;
+	GPtrArray*                  item_configs;
 	GdkMonitor*                 monitor;
 	FoobarBatteryService*       battery_service;
 	FoobarClockService*         clock_service;
@@ -33,12 +34,16 @@ struct _FoobarPanel
 	gulong                      config_handler_id;
 };
 
-static void foobar_panel_class_init          ( FoobarPanelClass* klass );
-static void foobar_panel_init                ( FoobarPanel*      self );
-static void foobar_panel_finalize            ( GObject*          object );
-static void foobar_panel_handle_config_change( GObject*          object,
-                                               GParamSpec*       pspec,
-                                               gpointer          userdata );
+static void       foobar_panel_class_init          ( FoobarPanelClass*                   klass );
+static void       foobar_panel_init                ( FoobarPanel*                        self );
+static void       foobar_panel_finalize            ( GObject*                            object );
+static void       foobar_panel_handle_config_change( FoobarConfigurationService*         service,
+                                                     FoobarConfigurationSection          section,
+                                                     gpointer                            userdata );
+static GtkWidget* foobar_panel_create_item         ( FoobarPanel*                        self,
+                                                     FoobarPanelItemConfiguration const* config );
+static GtkWidget* foobar_panel_take_item           ( FoobarPanel*                        self,
+                                                     FoobarPanelItemConfiguration const* config );
 
 G_DEFINE_FINAL_TYPE( FoobarPanel, foobar_panel, GTK_TYPE_APPLICATION_WINDOW )
 
@@ -96,6 +101,7 @@ void foobar_panel_finalize( GObject* object )
 	g_clear_object( &self->notification_service );
 	g_clear_object( &self->configuration_service );
 	g_clear_pointer( &self->item_widgets, g_ptr_array_unref );
+	g_clear_pointer( &self->item_configs, g_ptr_array_unref );
 
 	G_OBJECT_CLASS( foobar_panel_parent_class )->finalize( object );
 }
@@ -159,7 +165,7 @@ FoobarPanel* foobar_panel_new(
 	foobar_panel_apply_configuration( self, foobar_configuration_get_panel( config ) );
 	self->config_handler_id = g_signal_connect(
 		self->configuration_service,
-		"notify::current",
+		"changed::panel",
 		G_CALLBACK( foobar_panel_handle_config_change ),
 		self );
 
@@ -245,57 +251,54 @@ void foobar_panel_apply_configuration(
 	gtk_orientable_set_orientation( GTK_ORIENTABLE( self->center_items ), orientation );
 	gtk_orientable_set_orientation( GTK_ORIENTABLE( self->end_items ), orientation );
 
-	// Re-create panel items.
-
-	if ( self->item_widgets )
-	{
-		for ( guint i = 0; i < self->item_widgets->len; ++i )
-		{
-			gtk_widget_unparent( g_ptr_array_index( self->item_widgets, i ) );
-		}
-		g_clear_pointer( &self->item_widgets, g_ptr_array_unref );
-	}
+	// Reconcile the panel items with the new configuration.
+	//
+	// Existing items are matched by their kind and name. Unchanged items are kept -- and only moved to another section if
+	// their position has changed -- so their service subscriptions and bindings survive the reload. Only new or modified
+	// items are created.
 
 	gsize items_count;
 	FoobarPanelItemConfiguration const* const* items = foobar_panel_configuration_get_items( config, &items_count );
-	self->item_widgets = g_ptr_array_sized_new( items_count );
+	GPtrArray* item_widgets = g_ptr_array_sized_new( items_count );
+	GPtrArray* item_configs = g_ptr_array_new_full( items_count, (GDestroyNotify)foobar_panel_item_configuration_free );
+	GtkWidget* start_previous = NULL;
+	GtkWidget* center_previous = NULL;
+	GtkWidget* end_previous = NULL;
 	for ( gsize i = 0; i < items_count; ++i )
 	{
-		// Create an item for the specified type and configuration.
+		// Find the correct container for the item, depending on its configured position.
 
 		FoobarPanelItemConfiguration const* item = items[i];
-		FoobarPanelItem* item_widget;
-		switch ( foobar_panel_item_configuration_get_kind( item ) )
+		GtkWidget* container;
+		GtkWidget** previous;
+		switch ( foobar_panel_item_configuration_get_position( item ) )
 		{
-			case FOOBAR_PANEL_ITEM_KIND_ICON:
-				item_widget = foobar_panel_item_icon_new( item );
-				break;
-			case FOOBAR_PANEL_ITEM_KIND_CLOCK:
-				item_widget = foobar_panel_item_clock_new(
-					item,
-					self->clock_service );
+			case FOOBAR_PANEL_ITEM_POSITION_START:
+				container = self->start_items;
+				previous = &start_previous;
 				break;
-			case FOOBAR_PANEL_ITEM_KIND_WORKSPACES:
-				item_widget = foobar_panel_item_workspaces_new(
-					item,
-					self->monitor,
-					self->workspace_service );
+			case FOOBAR_PANEL_ITEM_POSITION_CENTER:
+				container = self->center_items;
+				previous = &center_previous;
 				break;
-			case FOOBAR_PANEL_ITEM_KIND_STATUS:
-				item_widget = foobar_panel_item_status_new(
-					item,
-					self->battery_service,
-					self->brightness_service,
-					self->audio_service,
-					self->network_service,
-					self->bluetooth_service,
-					self->notification_service );
+			case FOOBAR_PANEL_ITEM_POSITION_END:
+				container = self->end_items;
+				previous = &end_previous;
 				break;
 			default:
 				g_warn_if_reached( );
 				continue;
 		}
 
+		// Reuse the existing item if it is unchanged, or create a new one for the specified type and configuration.
+
+		GtkWidget* item_widget = foobar_panel_take_item( self, item );
+		if ( !item_widget )
+		{
+			item_widget = foobar_panel_create_item( self, item );
+			if ( !item_widget ) { continue; }
+		}
+
 		// Propagate the panel's orientation if the item supports it.
 
 		if ( GTK_IS_ORIENTABLE( item_widget ) )
@@ -303,28 +306,122 @@ void foobar_panel_apply_configuration(
 			gtk_orientable_set_orientation( GTK_ORIENTABLE( item_widget ), orientation );
 		}
 
-		// Add the item to the correct container, depending on its configured position.
+		// Place the item directly after the previous item in its container, moving it there if needed.
 
-		switch ( foobar_panel_item_configuration_get_position( item ) )
+		GtkWidget* parent = gtk_widget_get_parent( item_widget );
+		if ( parent == container )
 		{
-			case FOOBAR_PANEL_ITEM_POSITION_START:
-				gtk_box_append( GTK_BOX( self->start_items ), GTK_WIDGET( item_widget ) );
-				break;
-			case FOOBAR_PANEL_ITEM_POSITION_CENTER:
-				gtk_box_append( GTK_BOX( self->center_items ), GTK_WIDGET( item_widget ) );
-				break;
-			case FOOBAR_PANEL_ITEM_POSITION_END:
-				gtk_box_append( GTK_BOX( self->end_items ), GTK_WIDGET( item_widget ) );
-				break;
-			default:
-				g_warn_if_reached( );
-				break;
+			gtk_box_reorder_child_after( GTK_BOX( container ), item_widget, *previous );
+		}
+		else
+		{
+			g_object_ref( item_widget );
+			if ( parent ) { gtk_box_remove( GTK_BOX( parent ), item_widget ); }
+			gtk_box_insert_child_after( GTK_BOX( container ), item_widget, *previous );
+			g_object_unref( item_widget );
 		}
+		*previous = item_widget;
 
-		// Add the item to the pointer array for easier cleanup.
+		// Remember the item and its configuration for the next reconciliation.
 
-		g_ptr_array_add( self->item_widgets, GTK_WIDGET( item_widget ) );
+		g_ptr_array_add( item_widgets, item_widget );
+		g_ptr_array_add( item_configs, foobar_panel_item_configuration_copy( item ) );
 	}
+
+	// Remove all previous items that were not reused.
+
+	if ( self->item_widgets )
+	{
+		for ( guint i = 0; i < self->item_widgets->len; ++i )
+		{
+			GtkWidget* item_widget = g_ptr_array_index( self->item_widgets, i );
+			if ( item_widget ) { gtk_widget_unparent( item_widget ); }
+		}
+	}
+
+	g_clear_pointer( &self->item_widgets, g_ptr_array_unref );
+	g_clear_pointer( &self->item_configs, g_ptr_array_unref );
+	self->item_widgets = item_widgets;
+	self->item_configs = item_configs;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Create a new panel item widget for the specified type and configuration.
+//
+GtkWidget* foobar_panel_create_item(
+	FoobarPanel*                        self,
+	FoobarPanelItemConfiguration const* config )
+{
+	switch ( foobar_panel_item_configuration_get_kind( config ) )
+	{
+		case FOOBAR_PANEL_ITEM_KIND_ICON:
+			return GTK_WIDGET( foobar_panel_item_icon_new( config ) );
+		case FOOBAR_PANEL_ITEM_KIND_CLOCK:
+			return GTK_WIDGET( foobar_panel_item_clock_new(
+				config,
+				self->clock_service ) );
+		case FOOBAR_PANEL_ITEM_KIND_WORKSPACES:
+			return GTK_WIDGET( foobar_panel_item_workspaces_new(
+				config,
+				self->monitor,
+				self->workspace_service ) );
+		case FOOBAR_PANEL_ITEM_KIND_STATUS:
+			return GTK_WIDGET( foobar_panel_item_status_new(
+				config,
+				self->battery_service,
+				self->brightness_service,
+				self->audio_service,
+				self->network_service,
+				self->bluetooth_service,
+				self->notification_service ) );
+		default:
+			g_warn_if_reached( );
+			return NULL;
+	}
+}
+
+//
+// Find a current item with the same kind and name as the specified configuration which can be kept as it is, and take
+// it out of the list of current items so it is not removed.
+//
+// An item can be kept if only its position has changed. Returns NULL if the item is new or has been modified.
+//
+GtkWidget* foobar_panel_take_item(
+	FoobarPanel*                        self,
+	FoobarPanelItemConfiguration const* config )
+{
+	if ( !self->item_widgets ) { return NULL; }
+
+	FoobarPanelItemKind kind = foobar_panel_item_configuration_get_kind( config );
+	gchar const* name = foobar_panel_item_configuration_get_name( config );
+	for ( guint i = 0; i < self->item_widgets->len; ++i )
+	{
+		GtkWidget* item_widget = g_ptr_array_index( self->item_widgets, i );
+		FoobarPanelItemConfiguration const* current = g_ptr_array_index( self->item_configs, i );
+		if ( !item_widget ) { continue; }
+
+		// Items are matched by their kind and name.
+
+		if ( foobar_panel_item_configuration_get_kind( current ) != kind ) { continue; }
+		if ( g_strcmp0( foobar_panel_item_configuration_get_name( current ), name ) ) { continue; }
+
+		// Compare the configurations while ignoring the position, since moving an item does not require re-creating it.
+
+		FoobarPanelItemConfiguration* moved = foobar_panel_item_configuration_copy( current );
+		foobar_panel_item_configuration_set_position( moved, foobar_panel_item_configuration_get_position( config ) );
+		gboolean is_unchanged = foobar_panel_item_configuration_equal( moved, config );
+		foobar_panel_item_configuration_free( moved );
+		if ( !is_unchanged ) { continue; }
+
+		g_ptr_array_index( self->item_widgets, i ) = NULL;
+		return item_widget;
+	}
+
+	return NULL;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -332,15 +429,15 @@ void foobar_panel_apply_configuration(
 // ---------------------------------------------------------------------------------------------------------------------
 
 //
-// Signal handler called when the global configuration file has changed.
+// Signal handler called when the panel section of the configuration file has changed.
 //
 void foobar_panel_handle_config_change(
-	GObject*    object,
-	GParamSpec* pspec,
-	gpointer    userdata )
+	FoobarConfigurationService* service,
+	FoobarConfigurationSection  section,
+	gpointer                    userdata )
 {
-	(void)object;
-	(void)pspec;
+	(void)service;
+	(void)section;
 	FoobarPanel* self = (FoobarPanel*)userdata;
 
 	FoobarConfiguration const* config = foobar_configuration_service_get_current( self->configuration_service );
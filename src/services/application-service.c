@@ -1,5 +1,6 @@
 #include "services/application-service.h"
 #include "launcher-item.h"
+#include "trace.h"
 #include "utils.h"
 #include <gtk/gtk.h>
 #include <gio/gdesktopappinfo.h>
@@ -72,6 +73,7 @@ struct _FoobarApplicationService
 	GMutex            write_cache_mutex;
 	gchar*            cache_path;
 	gulong            changed_handler_id;
+	guint             load_id;
 };
 
 enum
@@ -91,6 +93,7 @@ static void     foobar_application_service_get_property          ( GObject*
 static void     foobar_application_service_finalize              ( GObject*                       object );
 static void     foobar_application_service_handle_changed        ( GAppInfoMonitor*               monitor,
                                                                    gpointer                       userdata );
+static gboolean foobar_application_service_handle_load           ( gpointer                       userdata );
 static void     foobar_application_service_update                ( FoobarApplicationService*      self );
 static void     foobar_application_service_read_cache            ( FoobarApplicationService*      self );
 static void     foobar_application_service_read_cache_foreach_cb ( JsonObject*                    object,
@@ -442,15 +445,10 @@ void foobar_application_service_init( FoobarApplicationService* self )
 	g_mutex_init( &self->frequencies_mutex );
 	g_mutex_init( &self->write_cache_mutex );
 
-	foobar_application_service_read_cache( self );
-	foobar_application_service_update( self );
+	// Reading the cache and enumerating all applications is deferred until the main loop is idle, so it does not delay
+	// presenting the panel. The launcher can't be opened before that anyway.
 
-	self->monitor = g_app_info_monitor_get( );
-	self->changed_handler_id = g_signal_connect(
-		self->monitor,
-		"changed",
-		G_CALLBACK( foobar_application_service_handle_changed ),
-		self );
+	self->load_id = g_idle_add_full( G_PRIORITY_LOW, foobar_application_service_handle_load, self, NULL );
 }
 
 //
@@ -488,6 +486,7 @@ void foobar_application_service_finalize( GObject* object )
 		item->service = NULL;
 		g_object_notify_by_pspec( G_OBJECT( item ), app_props[APP_PROP_FREQUENCY] );
 	}
+	g_clear_handle_id( &self->load_id, g_source_remove );
 	g_clear_signal_handler( &self->changed_handler_id, self->monitor );
 	g_clear_object( &self->sorted_items );
 	g_clear_object( &self->items );
@@ -540,6 +539,29 @@ void foobar_application_service_handle_changed(
 	foobar_application_service_update( self );
 }
 
+//
+// Called once the main loop is idle after creating the service to load the list of applications.
+//
+// This also starts monitoring the list of applications for changes.
+//
+gboolean foobar_application_service_handle_load( gpointer userdata )
+{
+	FoobarApplicationService* self = (FoobarApplicationService*)userdata;
+
+	self->load_id = 0;
+	FOOBAR_TRACE_SPAN( "application frequency cache", foobar_application_service_read_cache( self ) );
+	FOOBAR_TRACE_SPAN( "application list", foobar_application_service_update( self ) );
+
+	self->monitor = g_app_info_monitor_get( );
+	self->changed_handler_id = g_signal_connect(
+		self->monitor,
+		"changed",
+		G_CALLBACK( foobar_application_service_handle_changed ),
+		self );
+
+	return G_SOURCE_REMOVE;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Helper Methods
 // ---------------------------------------------------------------------------------------------------------------------
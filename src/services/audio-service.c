@@ -8,6 +8,11 @@
 
 #define DEFAULT_VOLUME 25
 
+// Volume changes are pushed to the server at most once per interval (roughly one frame at 60 Hz), and the local value
+// is shown until the server has reported it back or the timeout has passed.
+#define VOLUME_PUSH_INTERVAL   16
+#define VOLUME_CONFIRM_TIMEOUT 500
+
 //
 // FoobarAudioDeviceKind:
 //
@@ -35,6 +40,12 @@ struct _FoobarAudioDevice
 	GvcMixerStream*       stream;
 	gboolean              is_default;
 	gulong                notify_handler_id;
+	gint                  pending_volume;
+	gint                  pushed_volume;
+	gboolean              is_push_pending;
+	gboolean              is_pushing;
+	guint                 push_id;
+	guint                 confirm_id;
 };
 
 enum
@@ -52,26 +63,32 @@ enum
 
 static GParamSpec* device_props[N_DEVICE_PROPS] = { 0 };
 
-static void               foobar_audio_device_class_init   ( FoobarAudioDeviceClass* klass );
-static void               foobar_audio_device_init         ( FoobarAudioDevice*      self );
-static void               foobar_audio_device_get_property ( GObject*                object,
-                                                             guint                   prop_id,
-                                                             GValue*                 value,
-                                                             GParamSpec*             pspec );
-static void               foobar_audio_device_set_property ( GObject*                object,
-                                                             guint                   prop_id,
-                                                             GValue const*           value,
-                                                             GParamSpec*             pspec );
-static void               foobar_audio_device_finalize     ( GObject*                object );
-static FoobarAudioDevice* foobar_audio_device_new          ( FoobarAudioService*     service,
-                                                             FoobarAudioDeviceKind   kind );
-static void               foobar_audio_device_set_stream   ( FoobarAudioDevice*      self,
-                                                             GvcMixerStream*         value );
-static void               foobar_audio_device_set_default  ( FoobarAudioDevice*      self,
-                                                             gboolean                value );
-static void               foobar_audio_device_handle_notify( GObject*                object,
-                                                             GParamSpec*             pspec,
-                                                             gpointer                userdata );
+static void               foobar_audio_device_class_init            ( FoobarAudioDeviceClass* klass );
+static void               foobar_audio_device_init                  ( FoobarAudioDevice*      self );
+static void               foobar_audio_device_get_property          ( GObject*                object,
+                                                                      guint                   prop_id,
+                                                                      GValue*                 value,
+                                                                      GParamSpec*             pspec );
+static void               foobar_audio_device_set_property          ( GObject*                object,
+                                                                      guint                   prop_id,
+                                                                      GValue const*           value,
+                                                                      GParamSpec*             pspec );
+static void               foobar_audio_device_finalize              ( GObject*                object );
+static FoobarAudioDevice* foobar_audio_device_new                   ( FoobarAudioService*     service,
+                                                                      FoobarAudioDeviceKind   kind );
+static void               foobar_audio_device_set_stream            ( FoobarAudioDevice*      self,
+                                                                      GvcMixerStream*         value );
+static void               foobar_audio_device_set_default           ( FoobarAudioDevice*      self,
+                                                                      gboolean                value );
+static void               foobar_audio_device_handle_notify         ( GObject*                object,
+                                                                      GParamSpec*             pspec,
+                                                                      gpointer                userdata );
+static gboolean           foobar_audio_device_handle_push           ( gpointer                userdata );
+static gboolean           foobar_audio_device_handle_confirm_timeout( gpointer                userdata );
+static gint               foobar_audio_device_get_stream_volume     ( FoobarAudioDevice*      self );
+static void               foobar_audio_device_push_volume           ( FoobarAudioDevice*      self );
+static void               foobar_audio_device_flush_volume          ( FoobarAudioDevice*      self );
+static void               foobar_audio_device_clear_pending_volume  ( FoobarAudioDevice*      self );
 
 G_DEFINE_FINAL_TYPE( FoobarAudioDevice, foobar_audio_device, G_TYPE_OBJECT )
 
@@ -219,7 +236,8 @@ void foobar_audio_device_class_init( FoobarAudioDeviceClass* klass )
 //
 void foobar_audio_device_init( FoobarAudioDevice* self )
 {
-	(void)self;
+	self->pending_volume = -1;
+	self->pushed_volume = -1;
 }
 
 //
@@ -297,6 +315,8 @@ void foobar_audio_device_finalize( GObject* object )
 {
 	FoobarAudioDevice* self = (FoobarAudioDevice*)object;
 
+	g_clear_handle_id( &self->push_id, g_source_remove );
+	g_clear_handle_id( &self->confirm_id, g_source_remove );
 	g_clear_signal_handler( &self->notify_handler_id, self->stream );
 	g_clear_object( &self->stream );
 
@@ -355,16 +375,15 @@ gchar const* foobar_audio_device_get_description( FoobarAudioDevice* self )
 //
 // Get the current volume as a percentage value. If muted, this is 0.
 //
+// While a change made using foobar_audio_device_set_volume has not been confirmed by the server yet, this is the new
+// value.
+//
 gint foobar_audio_device_get_volume( FoobarAudioDevice* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_AUDIO_DEVICE( self ), 0 );
 
-	if ( !self->service ) { return 0; }
-	if ( self->stream && gvc_mixer_stream_get_is_muted( self->stream ) ) { return 0; }
-	gdouble max_volume = gvc_mixer_control_get_vol_max_norm( self->service->control );
-	gdouble cur_volume = self->stream ? gvc_mixer_stream_get_volume( self->stream ) : 0;
-	gint percentage = (gint)round( 100. * cur_volume / max_volume );
-	return CLAMP( percentage, 0, 100 );
+	if ( self->pending_volume >= 0 ) { return self->pending_volume; }
+	return foobar_audio_device_get_stream_volume( self );
 }
 
 //
@@ -407,6 +426,7 @@ void foobar_audio_device_set_stream(
 
 	if ( self->stream != value )
 	{
+		foobar_audio_device_flush_volume( self );
 		g_clear_signal_handler( &self->notify_handler_id, self->stream );
 		g_clear_object( &self->stream );
 
@@ -449,6 +469,10 @@ void foobar_audio_device_set_default(
 //
 // Update the device's volume as a percentage value.
 //
+// The new value is reported by foobar_audio_device_get_volume right away, but it is only pushed to the server at most
+// once per VOLUME_PUSH_INTERVAL. Values set in between replace each other, so while dragging a slider, only the latest
+// one is sent once the interval has passed.
+//
 void foobar_audio_device_set_volume(
 	FoobarAudioDevice* self,
 	gint               value )
@@ -460,12 +484,16 @@ void foobar_audio_device_set_volume(
 	value = CLAMP( value, 0, 100 );
 	if ( foobar_audio_device_get_volume( self ) != value )
 	{
-		gdouble max_volume = gvc_mixer_control_get_vol_max_norm( self->service->control );
-		gdouble new_volume = value * max_volume / 100.;
-		gvc_mixer_stream_set_volume( self->stream, (guint32)new_volume );
-		gvc_mixer_stream_push_volume( self->stream );
-		gvc_mixer_stream_set_is_muted( self->stream, value == 0 );
-		gvc_mixer_stream_change_is_muted( self->stream, value == 0 );
+		self->pending_volume = value;
+		self->is_push_pending = TRUE;
+		g_object_notify_by_pspec( G_OBJECT( self ), device_props[DEVICE_PROP_VOLUME] );
+		g_object_notify_by_pspec( G_OBJECT( self ), device_props[DEVICE_PROP_IS_MUTED] );
+
+		if ( !self->push_id )
+		{
+			foobar_audio_device_push_volume( self );
+			self->push_id = g_timeout_add( VOLUME_PUSH_INTERVAL, foobar_audio_device_handle_push, self );
+		}
 	}
 }
 
@@ -480,6 +508,8 @@ void foobar_audio_device_set_muted(
 {
 	g_return_if_fail( FOOBAR_IS_AUDIO_DEVICE( self ) );
 
+	foobar_audio_device_flush_volume( self );
+
 	if ( foobar_audio_device_is_muted( self ) != value )
 	{
 		if ( self->stream )
@@ -546,11 +576,124 @@ void foobar_audio_device_handle_notify(
 	}
 	else if ( !g_strcmp0( property, "volume" ) || !g_strcmp0( property, "is-muted" ) )
 	{
+		// While a local change is pending, the server may still report values from earlier pushes, which are hidden. Only
+		// an update arriving after the last push that matches the pushed value confirms it. Updates caused by pushing
+		// itself (which only change the stream's cached volume) are ignored.
+
+		if ( self->pending_volume >= 0 )
+		{
+			gboolean is_confirmed = !self->is_pushing
+				&& !self->is_push_pending
+				&& foobar_audio_device_get_stream_volume( self ) == self->pushed_volume;
+			if ( is_confirmed ) { foobar_audio_device_clear_pending_volume( self ); }
+			return;
+		}
+
 		g_object_notify_by_pspec( G_OBJECT( self ), device_props[DEVICE_PROP_VOLUME] );
 		g_object_notify_by_pspec( G_OBJECT( self ), device_props[DEVICE_PROP_IS_MUTED] );
 	}
 }
 
+//
+// Called once VOLUME_PUSH_INTERVAL has passed since the last push, pushing the latest value if it has changed since.
+//
+gboolean foobar_audio_device_handle_push( gpointer userdata )
+{
+	FoobarAudioDevice* self = (FoobarAudioDevice*)userdata;
+
+	if ( self->is_push_pending )
+	{
+		foobar_audio_device_push_volume( self );
+		return G_SOURCE_CONTINUE;
+	}
+
+	self->push_id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Called if the server has not confirmed the last pushed value within VOLUME_CONFIRM_TIMEOUT, falling back to the
+// stream's volume.
+//
+// The server does not report a value back if it matches the stream's cached volume (which is updated when pushing), so
+// this is also the common case when no other pushes were made before.
+//
+gboolean foobar_audio_device_handle_confirm_timeout( gpointer userdata )
+{
+	FoobarAudioDevice* self = (FoobarAudioDevice*)userdata;
+
+	self->confirm_id = 0;
+	if ( !self->is_push_pending ) { foobar_audio_device_clear_pending_volume( self ); }
+
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Get the volume of the underlying stream as a percentage value, ignoring any pending change. If muted, this is 0.
+//
+gint foobar_audio_device_get_stream_volume( FoobarAudioDevice* self )
+{
+	if ( !self->service ) { return 0; }
+	if ( self->stream && gvc_mixer_stream_get_is_muted( self->stream ) ) { return 0; }
+	gdouble max_volume = gvc_mixer_control_get_vol_max_norm( self->service->control );
+	gdouble cur_volume = self->stream ? gvc_mixer_stream_get_volume( self->stream ) : 0;
+	gint percentage = (gint)round( 100. * cur_volume / max_volume );
+	return CLAMP( percentage, 0, 100 );
+}
+
+//
+// Send the pending volume to the server.
+//
+// The muted state is only changed if necessary, so most pushes only cause a single request.
+//
+void foobar_audio_device_push_volume( FoobarAudioDevice* self )
+{
+	self->is_pushing = TRUE;
+
+	gdouble max_volume = gvc_mixer_control_get_vol_max_norm( self->service->control );
+	gdouble new_volume = self->pending_volume * max_volume / 100.;
+	gvc_mixer_stream_set_volume( self->stream, (guint32)new_volume );
+	gvc_mixer_stream_push_volume( self->stream );
+
+	gboolean is_muted = self->pending_volume == 0;
+	if ( gvc_mixer_stream_get_is_muted( self->stream ) != is_muted )
+	{
+		gvc_mixer_stream_set_is_muted( self->stream, is_muted );
+		gvc_mixer_stream_change_is_muted( self->stream, is_muted );
+	}
+
+	self->is_pushing = FALSE;
+	self->is_push_pending = FALSE;
+	self->pushed_volume = self->pending_volume;
+
+	g_clear_handle_id( &self->confirm_id, g_source_remove );
+	self->confirm_id = g_timeout_add( VOLUME_CONFIRM_TIMEOUT, foobar_audio_device_handle_confirm_timeout, self );
+}
+
+//
+// Push a volume change that has not been sent yet right away and stop waiting for confirmation, e.g. before the stream
+// is replaced.
+//
+void foobar_audio_device_flush_volume( FoobarAudioDevice* self )
+{
+	if ( self->pending_volume < 0 ) { return; }
+
+	if ( self->is_push_pending ) { foobar_audio_device_push_volume( self ); }
+	g_clear_handle_id( &self->push_id, g_source_remove );
+	foobar_audio_device_clear_pending_volume( self );
+}
+
+//
+// Stop showing the pending volume, reporting the stream's volume again.
+//
+void foobar_audio_device_clear_pending_volume( FoobarAudioDevice* self )
+{
+	g_clear_handle_id( &self->confirm_id, g_source_remove );
+	self->pending_volume = -1;
+	g_object_notify_by_pspec( G_OBJECT( self ), device_props[DEVICE_PROP_VOLUME] );
+	g_object_notify_by_pspec( G_OBJECT( self ), device_props[DEVICE_PROP_IS_MUTED] );
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Service Implementation
 // ---------------------------------------------------------------------------------------------------------------------
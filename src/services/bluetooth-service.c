@@ -78,6 +78,8 @@ struct _FoobarBluetoothService
 	GtkFilterListModel* connected_devices;
 	GPtrArray*          adapters; // First adapter is the default one.
 	FoobarBluezAdapter* default_adapter;
+	gboolean            is_started;
+	gboolean            is_loading;
 	gulong              interface_added_handler_id;
 	gulong              interface_removed_handler_id;
 	gulong              object_added_handler_id;
@@ -92,6 +94,7 @@ enum
 	PROP_IS_AVAILABLE,
 	PROP_IS_ENABLED,
 	PROP_IS_SCANNING,
+	PROP_IS_LOADING,
 	N_PROPS,
 };
 
@@ -108,6 +111,9 @@ static void           foobar_bluetooth_service_set_property            ( GObject
                                                                          GValue const*                value,
                                                                          GParamSpec*                  pspec );
 static void           foobar_bluetooth_service_finalize                ( GObject*                     object );
+static void           foobar_bluetooth_service_handle_connect          ( GObject*                     object,
+                                                                         GAsyncResult*                result,
+                                                                         gpointer                     userdata );
 static void           foobar_bluetooth_service_handle_interface_added  ( GDBusObjectManager*          manager,
                                                                          GDBusObject*                 object,
                                                                          GDBusInterface*              interface,
@@ -436,6 +442,12 @@ void foobar_bluetooth_service_class_init( FoobarBluetoothServiceClass* klass )
 		"Indicates whether the bluetooth adapter is currently scanning for devices.",
 		FALSE,
 		G_PARAM_READWRITE );
+	props[PROP_IS_LOADING] = g_param_spec_boolean(
+		"is-loading",
+		"Is Loading",
+		"Indicates whether the connection to Bluez is still being established.",
+		TRUE,
+		G_PARAM_READABLE );
 	g_object_class_install_properties( object_klass, N_PROPS, props );
 }
 
@@ -463,51 +475,10 @@ void foobar_bluetooth_service_init( FoobarBluetoothService* self )
 	
 	self->adapters = g_ptr_array_new_with_free_func( g_object_unref );
 
-	g_autoptr( GError ) error = NULL;
-	self->object_manager = g_dbus_object_manager_client_new_for_bus_sync(
-		G_BUS_TYPE_SYSTEM,
-		G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_DO_NOT_AUTO_START,
-		"org.bluez",
-		"/",
-		foobar_bluetooth_service_dbus_proxy_type_cb,
-		NULL,
-		NULL,
-		NULL,
-		&error );
+	// The service does not connect to Bluez until it is started (see foobar_bluetooth_service_start). Until the object
+	// manager is ready, bluetooth is reported as unavailable and the service is marked as loading.
 
-	if ( self->object_manager )
-	{
-		self->interface_added_handler_id = g_signal_connect(
-			self->object_manager,
-			"interface-added",
-			G_CALLBACK( foobar_bluetooth_service_handle_interface_added ),
-			self );
-		self->interface_removed_handler_id = g_signal_connect(
-			self->object_manager,
-			"interface-removed",
-			G_CALLBACK( foobar_bluetooth_service_handle_interface_removed ),
-			self );
-		self->object_added_handler_id = g_signal_connect(
-			self->object_manager,
-			"object-added",
-			G_CALLBACK( foobar_bluetooth_service_handle_object_added ),
-			self );
-		self->object_removed_handler_id = g_signal_connect(
-			self->object_manager,
-			"object-removed",
-			G_CALLBACK( foobar_bluetooth_service_handle_object_removed ),
-			self );
-		
-		g_autolist( GDBusObject ) objects = g_dbus_object_manager_get_objects( self->object_manager );
-		for ( GList* it = objects; it; it = it->next )
-		{
-			foobar_bluetooth_service_handle_object_added( self->object_manager, it->data, self );
-		}
-	}
-	else
-	{
-		g_warning( "Unable to create a DBus object manager for communication with Bluez: %s", error->message );
-	}
+	self->is_loading = TRUE;
 }
 
 //
@@ -538,6 +509,9 @@ void foobar_bluetooth_service_get_property(
 		case PROP_IS_SCANNING:
 			g_value_set_boolean( value, foobar_bluetooth_service_is_scanning( self ) );
 			break;
+		case PROP_IS_LOADING:
+			g_value_set_boolean( value, foobar_bluetooth_service_is_loading( self ) );
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
 			break;
@@ -610,6 +584,32 @@ FoobarBluetoothService* foobar_bluetooth_service_new( void )
 	return g_object_new( FOOBAR_TYPE_BLUETOOTH_SERVICE, NULL );
 }
 
+//
+// Start connecting to Bluez, unless this already happened.
+//
+// The object manager is created asynchronously, so this does not block. The service is only started once a configured
+// widget uses it.
+//
+void foobar_bluetooth_service_start( FoobarBluetoothService* self )
+{
+	g_return_if_fail( FOOBAR_IS_BLUETOOTH_SERVICE( self ) );
+
+	if ( self->is_started ) { return; }
+
+	self->is_started = TRUE;
+	g_dbus_object_manager_client_new_for_bus(
+		G_BUS_TYPE_SYSTEM,
+		G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_DO_NOT_AUTO_START,
+		"org.bluez",
+		"/",
+		foobar_bluetooth_service_dbus_proxy_type_cb,
+		NULL,
+		NULL,
+		NULL,
+		foobar_bluetooth_service_handle_connect,
+		g_object_ref( self ) );
+}
+
 //
 // Get the sorted list of available bluetooth devices.
 //
@@ -637,6 +637,17 @@ gboolean foobar_bluetooth_service_is_available( FoobarBluetoothService* self )
 	return self->default_adapter != NULL;
 }
 
+//
+// Check whether the connection to Bluez is still being established.
+//
+// While this is the case, the service being unavailable does not mean that there is no bluetooth adapter.
+//
+gboolean foobar_bluetooth_service_is_loading( FoobarBluetoothService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_BLUETOOTH_SERVICE( self ), FALSE );
+	return self->is_loading;
+}
+
 //
 // Check whether the bluetooth adapter is currently enabled.
 //
@@ -715,6 +726,57 @@ void foobar_bluetooth_service_set_scanning(
 // Signal Handlers
 // ---------------------------------------------------------------------------------------------------------------------
 
+//
+// Called after asynchronous initialization of the DBus object manager for Bluez.
+//
+void foobar_bluetooth_service_handle_connect(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	(void)object;
+	g_autoptr( FoobarBluetoothService ) self = (FoobarBluetoothService*)userdata;
+
+	g_autoptr( GError ) error = NULL;
+	self->object_manager = g_dbus_object_manager_client_new_for_bus_finish( result, &error );
+	if ( self->object_manager )
+	{
+		self->interface_added_handler_id = g_signal_connect(
+			self->object_manager,
+			"interface-added",
+			G_CALLBACK( foobar_bluetooth_service_handle_interface_added ),
+			self );
+		self->interface_removed_handler_id = g_signal_connect(
+			self->object_manager,
+			"interface-removed",
+			G_CALLBACK( foobar_bluetooth_service_handle_interface_removed ),
+			self );
+		self->object_added_handler_id = g_signal_connect(
+			self->object_manager,
+			"object-added",
+			G_CALLBACK( foobar_bluetooth_service_handle_object_added ),
+			self );
+		self->object_removed_handler_id = g_signal_connect(
+			self->object_manager,
+			"object-removed",
+			G_CALLBACK( foobar_bluetooth_service_handle_object_removed ),
+			self );
+		
+		g_autolist( GDBusObject ) objects = g_dbus_object_manager_get_objects( self->object_manager );
+		for ( GList* it = objects; it; it = it->next )
+		{
+			foobar_bluetooth_service_handle_object_added( self->object_manager, it->data, self );
+		}
+	}
+	else
+	{
+		g_warning( "Unable to create a DBus object manager for communication with Bluez: %s", error->message );
+	}
+
+	self->is_loading = FALSE;
+	g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_IS_LOADING] );
+}
+
 //
 // Called when an interface was added to an existing DBus object (either adapter or device).
 //
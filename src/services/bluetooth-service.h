@@ -28,11 +28,13 @@ void                       foobar_bluetooth_device_toggle_connection( FoobarBlue
 G_DECLARE_FINAL_TYPE( FoobarBluetoothService, foobar_bluetooth_service, FOOBAR, BLUETOOTH_SERVICE, GObject )
 
 FoobarBluetoothService* foobar_bluetooth_service_new                  ( void );
+void                    foobar_bluetooth_service_start                ( FoobarBluetoothService* self );
 GListModel*             foobar_bluetooth_service_get_devices          ( FoobarBluetoothService* self );
 GListModel*             foobar_bluetooth_service_get_connected_devices( FoobarBluetoothService* self );
 gboolean                foobar_bluetooth_service_is_available         ( FoobarBluetoothService* self );
 gboolean                foobar_bluetooth_service_is_enabled           ( FoobarBluetoothService* self );
 gboolean                foobar_bluetooth_service_is_scanning          ( FoobarBluetoothService* self );
+gboolean                foobar_bluetooth_service_is_loading           ( FoobarBluetoothService* self );
 void                    foobar_bluetooth_service_set_enabled          ( FoobarBluetoothService* self,
                                                                         gboolean                value );
 void                    foobar_bluetooth_service_set_scanning         ( FoobarBluetoothService* self,
@@ -1,24 +1,37 @@
 #include "services/brightness-service.h"
 #include <gio/gio.h>
+#include <fcntl.h>
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
 
 //
 // FoobarBrightnessService:
 //
 // Service managing the brightness level. This is implemented by
 // - for read access: monitoring the "brightness" file in a "/sys/class/backlight" subdirectory,
-// - for write access: invoking the "brightnessctl" command.
+// - for write access: writing to the same file if it is writable for the user, or otherwise calling SetBrightness on
+//   the logind session (which requires the system bus connection to be established first).
+//
+// Only one write is in flight at a time. Changes made while a write is still running (e.g. while dragging a slider) are
+// coalesced, and only the latest percentage is written once the previous write has finished. Changes to the file are
+// ignored during that time, so the value read back from an older write does not override the newer percentage.
 //
 
 struct _FoobarBrightnessService
 {
-	GObject       parent_instance;
-	gint          percentage;
-	GFileMonitor* file_monitor;
-	gulong        file_monitor_handler_id;
-	gchar*        device_name;
-	gchar*        file_path;
-	gint          max_brightness;
+	GObject          parent_instance;
+	gint             percentage;
+	GFileMonitor*    file_monitor;
+	gulong           file_monitor_handler_id;
+	gchar*           device_name;
+	gchar*           file_path;
+	gint             max_brightness;
+	gboolean         is_writable;
+	GDBusConnection* system_bus;
+	gboolean         is_bus_unavailable;
+	gboolean         is_writing;
+	gboolean         is_write_pending;
 };
 
 enum
@@ -45,15 +58,20 @@ static void          foobar_brightness_service_handle_changed           ( GFileM
                                                                           GFile*                        other_file,
                                                                           GFileMonitorEvent             event_type,
                                                                           gpointer                      userdata );
+static void          foobar_brightness_service_handle_connect           ( GObject*                      object,
+                                                                          GAsyncResult*                 result,
+                                                                          gpointer                      userdata );
+static void          foobar_brightness_service_handle_written           ( GObject*                      object,
+                                                                          GAsyncResult*                 result,
+                                                                          gpointer                      userdata );
 static gint          foobar_brightness_service_load_percentage          ( FoobarBrightnessService*      self );
 static void          foobar_brightness_service_write_percentage         ( FoobarBrightnessService*      self );
-static void          foobar_brightness_service_write_percentage_watch_cb( GPid                          pid,
-                                                                          gint                          status,
-                                                                          gpointer                      userdata );
 static void          foobar_brightness_service_get_info                 ( gchar**                       out_device_name,
                                                                           gchar**                       out_file_path,
                                                                           gint*                         out_max_brightness );
 static gint          foobar_brightness_service_read_value               ( gchar const*                  path );
+static void          foobar_brightness_service_write_value              ( gchar const*                  path,
+                                                                          gint                          value );
 static GFileMonitor* foobar_brightness_service_monitor                  ( gchar const*                  path );
 
 G_DEFINE_FINAL_TYPE( FoobarBrightnessService, foobar_brightness_service, G_TYPE_OBJECT )
@@ -106,6 +124,14 @@ void foobar_brightness_service_init( FoobarBrightnessService* self )
 	{
 		self->file_monitor_handler_id = 0;
 	}
+
+	// If the brightness file can't be written directly, logind is used, which is only connected to when needed.
+
+	self->is_writable = self->file_path && access( self->file_path, W_OK ) == 0;
+	if ( self->device_name && !self->is_writable )
+	{
+		g_bus_get( G_BUS_TYPE_SYSTEM, NULL, foobar_brightness_service_handle_connect, g_object_ref( self ) );
+	}
 }
 
 //
@@ -163,6 +189,7 @@ void foobar_brightness_service_finalize( GObject* object )
 	g_clear_object( &self->file_monitor );
 	g_clear_pointer( &self->device_name, g_free );
 	g_clear_pointer( &self->file_path, g_free );
+	g_clear_object( &self->system_bus );
 
 	G_OBJECT_CLASS( foobar_brightness_service_parent_class )->finalize( object );
 }
@@ -227,6 +254,8 @@ void foobar_brightness_service_handle_changed(
 	(void)event_type;
 	FoobarBrightnessService* self = (FoobarBrightnessService*)userdata;
 
+	if ( self->is_writing || self->is_write_pending ) { return; }
+
 	gint new_percentage = foobar_brightness_service_load_percentage( self );
 	if ( self->percentage != new_percentage )
 	{
@@ -235,6 +264,60 @@ void foobar_brightness_service_handle_changed(
 	}
 }
 
+//
+// Called after asynchronously connecting to the system bus, which is used to change the brightness through logind.
+//
+void foobar_brightness_service_handle_connect(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	(void)object;
+	g_autoptr( FoobarBrightnessService ) self = (FoobarBrightnessService*)userdata;
+
+	g_autoptr( GError ) error = NULL;
+	self->system_bus = g_bus_get_finish( result, &error );
+	if ( !self->system_bus )
+	{
+		// Without logind, the brightness can't be changed at all. Pending and future writes are dropped, so changes to the
+		// file (e.g. by hardware keys) are still picked up.
+
+		g_warning( "Unable to connect to the system bus: %s", error->message );
+		self->is_bus_unavailable = TRUE;
+		self->is_write_pending = FALSE;
+		return;
+	}
+
+	if ( self->is_write_pending )
+	{
+		self->is_write_pending = FALSE;
+		foobar_brightness_service_write_percentage( self );
+	}
+}
+
+//
+// Called when logind has finished changing the brightness, starting the next write if the percentage has changed in
+// the meantime.
+//
+void foobar_brightness_service_handle_written(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	g_autoptr( FoobarBrightnessService ) self = (FoobarBrightnessService*)userdata;
+
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GVariant ) reply = g_dbus_connection_call_finish( G_DBUS_CONNECTION( object ), result, &error );
+	if ( !reply ) { g_warning( "Unable to set brightness: %s", error->message ); }
+
+	self->is_writing = FALSE;
+	if ( self->is_write_pending )
+	{
+		self->is_write_pending = FALSE;
+		foobar_brightness_service_write_percentage( self );
+	}
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Helper Methods
 // ---------------------------------------------------------------------------------------------------------------------
@@ -257,57 +340,44 @@ gint foobar_brightness_service_load_percentage( FoobarBrightnessService* self )
 }
 
 //
-// Asynchronously update the current percentage value by invoking brightnessctl.
+// Write the current percentage value, either directly to the file at self->file_path or through logind.
 //
-// This requires device_name to be initialized.
+// This requires device_name and max_brightness to be initialized.
 //
 void foobar_brightness_service_write_percentage( FoobarBrightnessService* self )
 {
-	if ( !self->device_name ) { return; }
+	if ( !self->device_name || self->max_brightness <= 0 ) { return; }
+	if ( !self->is_writable && self->is_bus_unavailable ) { return; }
 
-	g_autofree gchar* percentage_string = g_strdup_printf( "%d%%", self->percentage );
-	gchar* args[] = { "brightnessctl", "-d", self->device_name, "s", percentage_string, NULL };
+	// A write through logind is also deferred while the system bus connection is not yet established.
 
-	g_autoptr( GError ) error = NULL;
-	GPid child_pid;
-	if ( !g_spawn_async(
-		NULL,
-		args,
-		NULL,
-		G_SPAWN_DO_NOT_REAP_CHILD
-			| G_SPAWN_SEARCH_PATH
-			| G_SPAWN_STDIN_FROM_DEV_NULL
-			| G_SPAWN_STDOUT_TO_DEV_NULL
-			| G_SPAWN_STDERR_TO_DEV_NULL,
-		NULL,
-		NULL,
-		&child_pid,
-		&error ) )
+	if ( self->is_writing || ( !self->is_writable && !self->system_bus ) )
 	{
-		g_warning( "Unable to spawn brightnessctl: %s", error->message );
+		self->is_write_pending = TRUE;
 		return;
 	}
 
-	g_child_watch_add( child_pid, foobar_brightness_service_write_percentage_watch_cb, NULL );
-}
-
-//
-// Called when the brightnessctl child process has finished.
-//
-void foobar_brightness_service_write_percentage_watch_cb(
-	GPid     pid,
-	gint     status,
-	gpointer userdata )
-{
-	(void)userdata;
-
-	g_autoptr( GError ) error = NULL;
-	if ( !g_spawn_check_wait_status( status, &error ) )
+	gint value = (gint)round( self->percentage / 100. * self->max_brightness );
+	if ( self->is_writable )
 	{
-		g_warning( "Unable to set brightness with brightnessctl: %s", error->message );
+		foobar_brightness_service_write_value( self->file_path, value );
+		return;
 	}
 
-	g_spawn_close_pid( pid );
+	self->is_writing = TRUE;
+	g_dbus_connection_call(
+		self->system_bus,
+		"org.freedesktop.login1",
+		"/org/freedesktop/login1/session/auto",
+		"org.freedesktop.login1.Session",
+		"SetBrightness",
+		g_variant_new( "(ssu)", "backlight", self->device_name, (guint32)value ),
+		NULL,
+		G_DBUS_CALL_FLAGS_NONE,
+		-1,
+		NULL,
+		foobar_brightness_service_handle_written,
+		g_object_ref( self ) );
 }
 
 //
@@ -375,6 +445,31 @@ gint foobar_brightness_service_read_value( gchar const* path )
 	return (gint)result;
 }
 
+//
+// Write a brightness integer (not percentage) to the given file path.
+//
+// Writes to sysfs files complete immediately, so this is done synchronously.
+//
+void foobar_brightness_service_write_value(
+	gchar const* path,
+	gint         value )
+{
+	gint fd = open( path, O_WRONLY | O_CLOEXEC );
+	if ( fd < 0 )
+	{
+		g_warning( "Unable to open %s: %s", path, g_strerror( errno ) );
+		return;
+	}
+
+	g_autofree gchar* contents = g_strdup_printf( "%d", value );
+	if ( write( fd, contents, strlen( contents ) ) < 0 )
+	{
+		g_warning( "Unable to write %s: %s", path, g_strerror( errno ) );
+	}
+
+	close( fd );
+}
+
 //
 // Set up a file monitor for the given path.
 //
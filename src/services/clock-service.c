@@ -1,16 +1,43 @@
 #include "services/clock-service.h"
+#include <errno.h>
+#include <glib-unix.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+//
+// FoobarClockGranularity:
+//
+// The smallest unit of time which is relevant for a consumer of the clock service.
+//
+
+G_DEFINE_ENUM_TYPE(
+	FoobarClockGranularity,
+	foobar_clock_granularity,
+	G_DEFINE_ENUM_VALUE( FOOBAR_CLOCK_GRANULARITY_SECOND, "second" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CLOCK_GRANULARITY_MINUTE, "minute" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CLOCK_GRANULARITY_HOUR, "hour" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CLOCK_GRANULARITY_DAY, "day" ) )
 
 //
 // FoobarClockService:
 //
 // Service providing an auto-updating timestamp value which can be used to display the current time.
 //
+// Consumers hold the granularity they need, and the timestamp is only updated at the boundaries of the finest unit
+// that is currently held (e.g. once per minute at hh:mm:00 if no consumer shows seconds). The wakeups are scheduled
+// using a timerfd on the realtime clock which is canceled whenever the clock is set, so the timestamp is also updated
+// immediately after the system time was changed or the system was resumed from suspend.
+//
 
 struct _FoobarClockService
 {
-	GObject    parent_instance;
-	GDateTime* time;
-	guint      source_id;
+	GObject                parent_instance;
+	GDateTime*             time;
+	gint                   timer_fd;
+	guint                  source_id;
+	FoobarClockGranularity granularity;
+	guint                  holds[FOOBAR_CLOCK_GRANULARITY_DAY + 1];
 };
 
 enum
@@ -21,14 +48,21 @@ enum
 
 static GParamSpec* props[N_PROPS] = { 0 };
 
-static void     foobar_clock_service_class_init  ( FoobarClockServiceClass* klass );
-static void     foobar_clock_service_init        ( FoobarClockService*      self );
-static void     foobar_clock_service_get_property( GObject*                 object,
-                                                   guint                    prop_id,
-                                                   GValue*                  value,
-                                                   GParamSpec*              pspec );
-static void     foobar_clock_service_finalize    ( GObject*                 object );
-static gboolean foobar_clock_service_handle_tick ( gpointer                 userdata );
+static void     foobar_clock_service_class_init       ( FoobarClockServiceClass* klass );
+static void     foobar_clock_service_init             ( FoobarClockService*      self );
+static void     foobar_clock_service_get_property     ( GObject*                 object,
+                                                        guint                    prop_id,
+                                                        GValue*                  value,
+                                                        GParamSpec*              pspec );
+static void     foobar_clock_service_finalize         ( GObject*                 object );
+static gboolean foobar_clock_service_handle_timer     ( gint                     fd,
+                                                        GIOCondition             condition,
+                                                        gpointer                 userdata );
+static gboolean foobar_clock_service_handle_timeout   ( gpointer                 userdata );
+static void     foobar_clock_service_update           ( FoobarClockService*      self );
+static void     foobar_clock_service_update_hold      ( FoobarClockService*      self );
+static void     foobar_clock_service_schedule         ( FoobarClockService*      self );
+static gint64   foobar_clock_service_get_next_boundary( FoobarClockService*      self );
 
 G_DEFINE_FINAL_TYPE( FoobarClockService, foobar_clock_service, G_TYPE_OBJECT )
 
@@ -60,7 +94,22 @@ void foobar_clock_service_class_init( FoobarClockServiceClass* klass )
 void foobar_clock_service_init( FoobarClockService* self )
 {
 	self->time = g_date_time_new_now_local( );
-	self->source_id = g_timeout_add_seconds( 1, foobar_clock_service_handle_tick, self );
+	self->granularity = FOOBAR_CLOCK_GRANULARITY_DAY;
+
+	// If no timerfd is available, fall back to a regular timeout for the next boundary (which does not notice changes
+	// to the system time).
+
+	self->timer_fd = timerfd_create( CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK );
+	if ( self->timer_fd >= 0 )
+	{
+		self->source_id = g_unix_fd_add( self->timer_fd, G_IO_IN, foobar_clock_service_handle_timer, self );
+	}
+	else
+	{
+		g_warning( "Unable to create timer for the clock: %s", g_strerror( errno ) );
+	}
+
+	foobar_clock_service_schedule( self );
 }
 
 //
@@ -94,6 +143,7 @@ void foobar_clock_service_finalize( GObject* object )
 
 	g_clear_pointer( &self->time, g_date_time_unref );
 	g_clear_handle_id( &self->source_id, g_source_remove );
+	if ( self->timer_fd >= 0 ) { close( self->timer_fd ); }
 
 	G_OBJECT_CLASS( foobar_clock_service_parent_class )->finalize( object );
 }
@@ -113,7 +163,8 @@ FoobarClockService* foobar_clock_service_new( void )
 //
 // Get the current snapshot of the timestamp.
 //
-// This may be a bit older than the value returned by g_date_time_new_now_local.
+// This is only updated at the boundaries of the finest granularity currently held, so it may be older than the value
+// returned by g_date_time_new_now_local by up to one unit of that granularity.
 //
 GDateTime* foobar_clock_service_get_time( FoobarClockService* self )
 {
@@ -122,20 +173,231 @@ GDateTime* foobar_clock_service_get_time( FoobarClockService* self )
 	return self->time;
 }
 
+//
+// Request the timestamp to be updated at least at every boundary of the given unit, until the hold is released again
+// using foobar_clock_service_release.
+//
+// Without any holds, the timestamp is only updated once per day.
+//
+void foobar_clock_service_hold(
+	FoobarClockService*    self,
+	FoobarClockGranularity granularity )
+{
+	g_return_if_fail( FOOBAR_IS_CLOCK_SERVICE( self ) );
+	g_return_if_fail( granularity <= FOOBAR_CLOCK_GRANULARITY_DAY );
+
+	++self->holds[granularity];
+	foobar_clock_service_update_hold( self );
+}
+
+//
+// Release a hold previously acquired using foobar_clock_service_hold.
+//
+void foobar_clock_service_release(
+	FoobarClockService*    self,
+	FoobarClockGranularity granularity )
+{
+	g_return_if_fail( FOOBAR_IS_CLOCK_SERVICE( self ) );
+	g_return_if_fail( granularity <= FOOBAR_CLOCK_GRANULARITY_DAY );
+	g_return_if_fail( self->holds[granularity] > 0 );
+
+	--self->holds[granularity];
+	foobar_clock_service_update_hold( self );
+}
+
+//
+// Determine the smallest unit of time that is displayed when formatting a timestamp using g_date_time_format with the
+// given format string.
+//
+FoobarClockGranularity foobar_clock_granularity_from_format( gchar const* format )
+{
+	FoobarClockGranularity result = FOOBAR_CLOCK_GRANULARITY_DAY;
+	if ( !format ) { return result; }
+
+	for ( gchar const* it = format; *it; ++it )
+	{
+		if ( *it != '%' ) { continue; }
+
+		// Skip padding, case and alternative digit modifiers to get to the actual conversion specifier.
+
+		++it;
+		while ( *it && strchr( "-_0^#:EO", *it ) ) { ++it; }
+		if ( !*it ) { break; }
+
+		FoobarClockGranularity granularity;
+		switch ( *it )
+		{
+			case 'S':
+			case 's':
+			case 'T':
+			case 'r':
+			case 'c':
+			case 'X':
+			case 'f':
+				granularity = FOOBAR_CLOCK_GRANULARITY_SECOND;
+				break;
+			case 'M':
+			case 'R':
+				granularity = FOOBAR_CLOCK_GRANULARITY_MINUTE;
+				break;
+			case 'H':
+			case 'I':
+			case 'k':
+			case 'l':
+			case 'p':
+			case 'P':
+				granularity = FOOBAR_CLOCK_GRANULARITY_HOUR;
+				break;
+			default:
+				granularity = FOOBAR_CLOCK_GRANULARITY_DAY;
+				break;
+		}
+
+		result = MIN( result, granularity );
+	}
+
+	return result;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Signal Handlers
 // ---------------------------------------------------------------------------------------------------------------------
 
 //
-// Called every time the update delay has elapsed to update the current timestamp value.
+// Called when the timerfd has expired at the next boundary, or when the system time was changed.
 //
-gboolean foobar_clock_service_handle_tick( gpointer userdata )
+gboolean foobar_clock_service_handle_timer(
+	gint         fd,
+	GIOCondition condition,
+	gpointer     userdata )
 {
+	(void)condition;
 	FoobarClockService* self = (FoobarClockService*)userdata;
 
+	// A read failing with ECANCELED means that the realtime clock was set, which requires an update as well.
+
+	guint64 expirations;
+	if ( read( fd, &expirations, sizeof( expirations ) ) < 0 && errno != ECANCELED ) { return G_SOURCE_CONTINUE; }
+
+	foobar_clock_service_update( self );
+	return G_SOURCE_CONTINUE;
+}
+
+//
+// Called when the fallback timeout for the next boundary has elapsed.
+//
+gboolean foobar_clock_service_handle_timeout( gpointer userdata )
+{
+	FoobarClockService* self = (FoobarClockService*)userdata;
+
+	self->source_id = 0;
+	foobar_clock_service_update( self );
+	return G_SOURCE_REMOVE;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Update the current timestamp value and schedule the next update.
+//
+void foobar_clock_service_update( FoobarClockService* self )
+{
 	g_clear_pointer( &self->time, g_date_time_unref );
 	self->time = g_date_time_new_now_local( );
 	g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_TIME] );
 
-	return G_SOURCE_CONTINUE;
+	foobar_clock_service_schedule( self );
+}
+
+//
+// Re-evaluate the effective granularity after a hold was acquired or released, rescheduling the next update if it
+// changed.
+//
+void foobar_clock_service_update_hold( FoobarClockService* self )
+{
+	FoobarClockGranularity granularity = FOOBAR_CLOCK_GRANULARITY_SECOND;
+	while ( granularity < FOOBAR_CLOCK_GRANULARITY_DAY && !self->holds[granularity] ) { ++granularity; }
+
+	if ( self->granularity != granularity )
+	{
+		self->granularity = granularity;
+		foobar_clock_service_update( self );
+	}
+}
+
+//
+// Arm the timer (or the fallback timeout) for the next boundary of the current granularity.
+//
+void foobar_clock_service_schedule( FoobarClockService* self )
+{
+	gint64 boundary = foobar_clock_service_get_next_boundary( self );
+
+	if ( self->timer_fd >= 0 )
+	{
+		struct itimerspec spec = { .it_value = { .tv_sec = boundary } };
+		if ( timerfd_settime( self->timer_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, NULL ) < 0 )
+		{
+			g_warning( "Unable to schedule clock update: %s", g_strerror( errno ) );
+		}
+	}
+	else
+	{
+		gint64 delay = MAX( boundary * G_USEC_PER_SEC - g_get_real_time( ), 0 );
+		g_clear_handle_id( &self->source_id, g_source_remove );
+		self->source_id = g_timeout_add(
+			(guint)( ( delay + 999 ) / 1000 ),
+			foobar_clock_service_handle_timeout,
+			self );
+	}
+}
+
+//
+// Get the unix timestamp (in seconds) of the next boundary of the current granularity in the local time zone.
+//
+gint64 foobar_clock_service_get_next_boundary( FoobarClockService* self )
+{
+	g_autoptr( GDateTime ) now = g_date_time_new_now_local( );
+	gint hour = g_date_time_get_hour( now );
+	gint minute = g_date_time_get_minute( now );
+	gint days = 0;
+	gint hours = 0;
+	gint minutes = 0;
+
+	switch ( self->granularity )
+	{
+		case FOOBAR_CLOCK_GRANULARITY_SECOND:
+			return g_date_time_to_unix( now ) + 1;
+		case FOOBAR_CLOCK_GRANULARITY_MINUTE:
+			minutes = 1;
+			break;
+		case FOOBAR_CLOCK_GRANULARITY_HOUR:
+			minute = 0;
+			hours = 1;
+			break;
+		case FOOBAR_CLOCK_GRANULARITY_DAY:
+			hour = 0;
+			minute = 0;
+			days = 1;
+			break;
+		default:
+			g_warn_if_reached( );
+			return g_date_time_to_unix( now ) + 1;
+	}
+
+	// Truncating may yield a time that does not exist in the local time zone (e.g. midnight skipped by a DST change),
+	// in which case the next second is used instead.
+
+	g_autoptr( GDateTime ) start = g_date_time_new_local(
+		g_date_time_get_year( now ),
+		g_date_time_get_month( now ),
+		g_date_time_get_day_of_month( now ),
+		hour,
+		minute,
+		0 );
+	if ( !start ) { return g_date_time_to_unix( now ) + 1; }
+
+	g_autoptr( GDateTime ) next = g_date_time_add_full( start, 0, 0, days, hours, minutes, 0 );
+	return g_date_time_to_unix( next );
 }
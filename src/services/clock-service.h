@@ -4,11 +4,27 @@
 
 G_BEGIN_DECLS
 
-#define FOOBAR_TYPE_CLOCK_SERVICE foobar_clock_service_get_type( )
+#define FOOBAR_TYPE_CLOCK_GRANULARITY foobar_clock_granularity_get_type( )
+#define FOOBAR_TYPE_CLOCK_SERVICE     foobar_clock_service_get_type( )
+
+typedef enum
+{
+	FOOBAR_CLOCK_GRANULARITY_SECOND = 0,
+	FOOBAR_CLOCK_GRANULARITY_MINUTE = 1,
+	FOOBAR_CLOCK_GRANULARITY_HOUR   = 2,
+	FOOBAR_CLOCK_GRANULARITY_DAY    = 3,
+} FoobarClockGranularity;
+
+GType                  foobar_clock_granularity_get_type   ( void );
+FoobarClockGranularity foobar_clock_granularity_from_format( gchar const* format );
 
 G_DECLARE_FINAL_TYPE( FoobarClockService, foobar_clock_service, FOOBAR, CLOCK_SERVICE, GObject )
 
 FoobarClockService* foobar_clock_service_new     ( void );
-GDateTime*          foobar_clock_service_get_time( FoobarClockService* self );
+GDateTime*          foobar_clock_service_get_time( FoobarClockService*    self );
+void                foobar_clock_service_hold    ( FoobarClockService*    self,
+                                                   FoobarClockGranularity granularity );
+void                foobar_clock_service_release ( FoobarClockService*    self,
+                                                   FoobarClockGranularity granularity );
 
 G_END_DECLS
@@ -1,7 +1,9 @@
 #include "services/configuration-service.h"
+#include "trace.h"
 #include <gio/gio.h>
 
-#define UPDATE_APPLY_DELAY           250
+#define UPDATE_APPLY_DELAY           ( 250 * G_TIME_SPAN_MILLISECOND )
+#define UPDATE_APPLY_SLACK           ( 50 * G_TIME_SPAN_MILLISECOND )
 #define CONFIGURATION_LOG_DOMAIN     "foobar.conf"
 #define CONFIGURATION_WARNING( ... ) g_log( CONFIGURATION_LOG_DOMAIN, G_LOG_LEVEL_WARNING, __VA_ARGS__ )
 
@@ -123,6 +125,23 @@ G_DEFINE_ENUM_TYPE(
 	G_DEFINE_ENUM_VALUE( FOOBAR_CONTROL_CENTER_ALIGNMENT_END, "end" ),
 	G_DEFINE_ENUM_VALUE( FOOBAR_CONTROL_CENTER_ALIGNMENT_FILL, "fill" ) )
 
+//
+// FoobarConfigurationSection:
+//
+// A section of the configuration file. The nick of each value is the name of its keyfile group, which is also used as
+// the detail for the "changed" signal of the configuration service.
+//
+
+G_STATIC_ASSERT( sizeof( FoobarConfigurationSection ) == sizeof( gint ) );
+G_DEFINE_FLAGS_TYPE(
+	FoobarConfigurationSection,
+	foobar_configuration_section,
+	G_DEFINE_ENUM_VALUE( FOOBAR_CONFIGURATION_SECTION_GENERAL, "general" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CONFIGURATION_SECTION_PANEL, "panel" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CONFIGURATION_SECTION_LAUNCHER, "launcher" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CONFIGURATION_SECTION_CONTROL_CENTER, "control-center" ),
+	G_DEFINE_ENUM_VALUE( FOOBAR_CONFIGURATION_SECTION_NOTIFICATIONS, "notifications" ) )
+
 //
 // FoobarGeneralConfiguration:
 //
@@ -293,7 +312,12 @@ struct _FoobarNotificationConfiguration
 	gint   min_height;
 	gint   spacing;
 	gint   close_button_inset;
-	gchar* time_format;
+	gchar*   time_format;
+	gboolean relative_time;
+	gint     max_popups;
+	gint   history_limit;
+	gint   history_max_age;
+	gint   history_max_size;
 };
 
 static void foobar_notification_configuration_load ( FoobarNotificationConfiguration*       self,
@@ -336,18 +360,22 @@ G_DEFINE_BOXED_TYPE( FoobarConfiguration, foobar_configuration, foobar_configura
 //
 // Service monitoring the configuration state of the application specified in its config file.
 //
+// Whenever the file was reloaded, the "changed" signal is emitted once for each section that actually changed, with the
+// section's name as its detail (e.g. "changed::panel"), so components only re-apply the sections they depend on.
+//
 
 struct _FoobarConfigurationService
 {
-	GObject              parent_instance;
-	gchar*               path;
-	char*                actual_path;
-	FoobarConfiguration* current;
-	GFileMonitor*        monitor;
-	GFileMonitor*        actual_monitor;
-	gulong               changed_handler_id;
-	gulong               actual_changed_handler_id;
-	guint                update_source_id;
+	GObject                 parent_instance;
+	gchar*                  path;
+	char*                   actual_path;
+	FoobarConfiguration*    current;
+	GFileMonitor*           monitor;
+	GFileMonitor*           actual_monitor;
+	FoobarSchedulerService* scheduler_service;
+	gulong                  changed_handler_id;
+	gulong                  actual_changed_handler_id;
+	guint                   update_id;
 };
 
 enum
@@ -358,6 +386,14 @@ enum
 
 static GParamSpec* props[N_PROPS] = { 0 };
 
+enum
+{
+	SIGNAL_CHANGED,
+	N_SIGNALS,
+};
+
+static guint signals[N_SIGNALS] = { 0 };
+
 static void          foobar_configuration_service_class_init           ( FoobarConfigurationServiceClass* klass );
 static void          foobar_configuration_service_init                 ( FoobarConfigurationService*      self );
 static void          foobar_configuration_service_get_property         ( GObject*                         object,
@@ -555,6 +591,11 @@ static FoobarNotificationConfiguration default_notification_configuration =
 		.spacing = 16,
 		.close_button_inset = -6,
 		.time_format = "%H:%M",
+		.relative_time = FALSE,
+		.max_popups = 5,
+		.history_limit = 500,
+		.history_max_age = 30,
+		.history_max_size = 32,
 	};
 
 static FoobarConfiguration default_configuration =
@@ -2301,6 +2342,11 @@ FoobarNotificationConfiguration* foobar_notification_configuration_copy( FoobarN
 	copy->spacing = self->spacing;
 	copy->close_button_inset = self->close_button_inset;
 	copy->time_format = g_strdup( self->time_format );
+	copy->relative_time = self->relative_time;
+	copy->max_popups = self->max_popups;
+	copy->history_limit = self->history_limit;
+	copy->history_max_age = self->history_max_age;
+	copy->history_max_size = self->history_max_size;
 	return copy;
 }
 
@@ -2330,6 +2376,11 @@ gboolean foobar_notification_configuration_equal(
 	if ( a->spacing != b->spacing ) { return FALSE; }
 	if ( a->close_button_inset != b->close_button_inset ) { return FALSE; }
 	if ( g_strcmp0( a->time_format, b->time_format ) ) { return FALSE; }
+	if ( a->relative_time != b->relative_time ) { return FALSE; }
+	if ( a->max_popups != b->max_popups ) { return FALSE; }
+	if ( a->history_limit != b->history_limit ) { return FALSE; }
+	if ( a->history_max_age != b->history_max_age ) { return FALSE; }
+	if ( a->history_max_size != b->history_max_size ) { return FALSE; }
 
 	return TRUE;
 }
@@ -2379,6 +2430,51 @@ gchar const* foobar_notification_configuration_get_time_format( FoobarNotificati
 	return self->time_format;
 }
 
+//
+// Whether timestamps are shown relative to the current time (e.g. "5 min") instead of using the time format.
+//
+gboolean foobar_notification_configuration_get_relative_time( FoobarNotificationConfiguration const* self )
+{
+	g_return_val_if_fail( self != NULL, FALSE );
+	return self->relative_time;
+}
+
+//
+// Maximum number of popups shown at the same time (0 for no limit).
+//
+gint foobar_notification_configuration_get_max_popups( FoobarNotificationConfiguration const* self )
+{
+	g_return_val_if_fail( self != NULL, 0 );
+	return self->max_popups;
+}
+
+//
+// Maximum number of notifications kept in the history (0 for no limit).
+//
+gint foobar_notification_configuration_get_history_limit( FoobarNotificationConfiguration const* self )
+{
+	g_return_val_if_fail( self != NULL, 0 );
+	return self->history_limit;
+}
+
+//
+// Maximum age of notifications kept in the history in days (0 for no limit).
+//
+gint foobar_notification_configuration_get_history_max_age( FoobarNotificationConfiguration const* self )
+{
+	g_return_val_if_fail( self != NULL, 0 );
+	return self->history_max_age;
+}
+
+//
+// Maximum total size of notifications kept in the history (including images) in MiB (0 for no limit).
+//
+gint foobar_notification_configuration_get_history_max_size( FoobarNotificationConfiguration const* self )
+{
+	g_return_val_if_fail( self != NULL, 0 );
+	return self->history_max_size;
+}
+
 //
 // Horizontal size of notifications in the notification area.
 //
@@ -2437,6 +2533,61 @@ void foobar_notification_configuration_set_time_format(
 	self->time_format = g_strdup( value );
 }
 
+//
+// Whether timestamps are shown relative to the current time (e.g. "5 min") instead of using the time format.
+//
+void foobar_notification_configuration_set_relative_time(
+	FoobarNotificationConfiguration* self,
+	gboolean                         value )
+{
+	g_return_if_fail( self != NULL );
+	self->relative_time = value;
+}
+
+//
+// Maximum number of popups shown at the same time (0 for no limit).
+//
+void foobar_notification_configuration_set_max_popups(
+	FoobarNotificationConfiguration* self,
+	gint                             value )
+{
+	g_return_if_fail( self != NULL );
+	self->max_popups = value;
+}
+
+//
+// Maximum number of notifications kept in the history (0 for no limit).
+//
+void foobar_notification_configuration_set_history_limit(
+	FoobarNotificationConfiguration* self,
+	gint                             value )
+{
+	g_return_if_fail( self != NULL );
+	self->history_limit = value;
+}
+
+//
+// Maximum age of notifications kept in the history in days (0 for no limit).
+//
+void foobar_notification_configuration_set_history_max_age(
+	FoobarNotificationConfiguration* self,
+	gint                             value )
+{
+	g_return_if_fail( self != NULL );
+	self->history_max_age = value;
+}
+
+//
+// Maximum total size of notifications kept in the history (including images) in MiB (0 for no limit).
+//
+void foobar_notification_configuration_set_history_max_size(
+	FoobarNotificationConfiguration* self,
+	gint                             value )
+{
+	g_return_if_fail( self != NULL );
+	self->history_max_size = value;
+}
+
 //
 // Populate a notification configuration structure from the "notifications" section of a keyfile.
 //
@@ -2473,6 +2624,36 @@ void foobar_notification_configuration_load(
 	{
 		foobar_notification_configuration_set_time_format( self, time_format );
 	}
+
+	gboolean relative_time;
+	if ( try_get_boolean_value( file, "notifications", "relative-time", VALIDATE_NONE, &relative_time ) )
+	{
+		foobar_notification_configuration_set_relative_time( self, relative_time );
+	}
+
+	gint max_popups;
+	if ( try_get_int_value( file, "notifications", "max-popups", VALIDATE_NON_NEGATIVE, &max_popups ) )
+	{
+		foobar_notification_configuration_set_max_popups( self, max_popups );
+	}
+
+	gint history_limit;
+	if ( try_get_int_value( file, "notifications", "history-limit", VALIDATE_NON_NEGATIVE, &history_limit ) )
+	{
+		foobar_notification_configuration_set_history_limit( self, history_limit );
+	}
+
+	gint history_max_age;
+	if ( try_get_int_value( file, "notifications", "history-max-age", VALIDATE_NON_NEGATIVE, &history_max_age ) )
+	{
+		foobar_notification_configuration_set_history_max_age( self, history_max_age );
+	}
+
+	gint history_max_size;
+	if ( try_get_int_value( file, "notifications", "history-max-size", VALIDATE_NON_NEGATIVE, &history_max_size ) )
+	{
+		foobar_notification_configuration_set_history_max_size( self, history_max_size );
+	}
 }
 
 //
@@ -2520,6 +2701,51 @@ void foobar_notification_configuration_store(
 		"time-format",
 		" The time format string as used by g_date_time_format.",
 		NULL );
+
+	gboolean relative_time = foobar_notification_configuration_get_relative_time( self );
+	g_key_file_set_boolean( file, "notifications", "relative-time", relative_time );
+	g_key_file_set_comment(
+		file,
+		"notifications",
+		"relative-time",
+		" Show timestamps relative to the current time (e.g. \"5 min\") instead of using the time format.",
+		NULL );
+
+	gint max_popups = foobar_notification_configuration_get_max_popups( self );
+	g_key_file_set_integer( file, "notifications", "max-popups", max_popups );
+	g_key_file_set_comment(
+		file,
+		"notifications",
+		"max-popups",
+		" Maximum number of popups shown at the same time (0 for no limit).",
+		NULL );
+
+	gint history_limit = foobar_notification_configuration_get_history_limit( self );
+	g_key_file_set_integer( file, "notifications", "history-limit", history_limit );
+	g_key_file_set_comment(
+		file,
+		"notifications",
+		"history-limit",
+		" Maximum number of notifications kept in the history (0 for no limit).",
+		NULL );
+
+	gint history_max_age = foobar_notification_configuration_get_history_max_age( self );
+	g_key_file_set_integer( file, "notifications", "history-max-age", history_max_age );
+	g_key_file_set_comment(
+		file,
+		"notifications",
+		"history-max-age",
+		" Maximum age of notifications kept in the history in days (0 for no limit).",
+		NULL );
+
+	gint history_max_size = foobar_notification_configuration_get_history_max_size( self );
+	g_key_file_set_integer( file, "notifications", "history-max-size", history_max_size );
+	g_key_file_set_comment(
+		file,
+		"notifications",
+		"history-max-size",
+		" Maximum total size of notifications kept in the history (including images) in MiB (0 for no limit).",
+		NULL );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -2584,6 +2810,41 @@ gboolean foobar_configuration_equal(
 	return TRUE;
 }
 
+//
+// Determine the sections which differ between two configuration structures.
+//
+FoobarConfigurationSection foobar_configuration_diff(
+	FoobarConfiguration const* a,
+	FoobarConfiguration const* b )
+{
+	g_return_val_if_fail( a != NULL, 0 );
+	g_return_val_if_fail( b != NULL, 0 );
+
+	FoobarConfigurationSection result = 0;
+	if ( !foobar_general_configuration_equal( a->general, b->general ) )
+	{
+		result |= FOOBAR_CONFIGURATION_SECTION_GENERAL;
+	}
+	if ( !foobar_panel_configuration_equal( a->panel, b->panel ) )
+	{
+		result |= FOOBAR_CONFIGURATION_SECTION_PANEL;
+	}
+	if ( !foobar_launcher_configuration_equal( a->launcher, b->launcher ) )
+	{
+		result |= FOOBAR_CONFIGURATION_SECTION_LAUNCHER;
+	}
+	if ( !foobar_control_center_configuration_equal( a->control_center, b->control_center ) )
+	{
+		result |= FOOBAR_CONFIGURATION_SECTION_CONTROL_CENTER;
+	}
+	if ( !foobar_notification_configuration_equal( a->notifications, b->notifications ) )
+	{
+		result |= FOOBAR_CONFIGURATION_SECTION_NOTIFICATIONS;
+	}
+
+	return result;
+}
+
 //
 // Get the general application configuration.
 //
@@ -2739,6 +3000,18 @@ void foobar_configuration_service_class_init( FoobarConfigurationServiceClass* k
 		FOOBAR_TYPE_CONFIGURATION,
 		G_PARAM_READABLE );
 	g_object_class_install_properties( object_klass, N_PROPS, props );
+
+	signals[SIGNAL_CHANGED] = g_signal_new(
+		"changed",
+		FOOBAR_TYPE_CONFIGURATION_SERVICE,
+		G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+		0,
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		FOOBAR_TYPE_CONFIGURATION_SECTION );
 }
 
 //
@@ -2754,7 +3027,7 @@ void foobar_configuration_service_init( FoobarConfigurationService* self )
 
 	if ( g_file_test( self->path, G_FILE_TEST_EXISTS ) )
 	{
-		foobar_configuration_load_from_file( self->current, self->path );
+		FOOBAR_TRACE_SPAN( "configuration", foobar_configuration_load_from_file( self->current, self->path ) );
 	}
 	else
 	{
@@ -2822,7 +3095,7 @@ void foobar_configuration_service_finalize( GObject* object )
 {
 	FoobarConfigurationService* self = (FoobarConfigurationService*)object;
 
-	g_clear_handle_id( &self->update_source_id, g_source_remove );
+	if ( self->scheduler_service ) { foobar_scheduler_service_clear( self->scheduler_service, &self->update_id ); }
 	g_clear_signal_handler( &self->changed_handler_id, self->monitor );
 	g_clear_signal_handler( &self->actual_changed_handler_id, self->actual_monitor );
 	g_clear_object( &self->monitor );
@@ -2830,6 +3103,7 @@ void foobar_configuration_service_finalize( GObject* object )
 	g_clear_pointer( &self->current, foobar_configuration_free );
 	g_clear_pointer( &self->path, g_free );
 	g_clear_pointer( &self->actual_path, free );
+	g_clear_object( &self->scheduler_service );
 
 	G_OBJECT_CLASS( foobar_configuration_service_parent_class )->finalize( object );
 }
@@ -2841,9 +3115,13 @@ void foobar_configuration_service_finalize( GObject* object )
 //
 // Create a new configuration service instance.
 //
-FoobarConfigurationService* foobar_configuration_service_new( void )
+FoobarConfigurationService* foobar_configuration_service_new( FoobarSchedulerService* scheduler_service )
 {
-	return g_object_new( FOOBAR_TYPE_CONFIGURATION_SERVICE, NULL );
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( scheduler_service ), NULL );
+
+	FoobarConfigurationService* self = g_object_new( FOOBAR_TYPE_CONFIGURATION_SERVICE, NULL );
+	self->scheduler_service = g_object_ref( scheduler_service );
+	return self;
 }
 
 //
@@ -2940,10 +3218,13 @@ void foobar_configuration_service_handle_actual_changed(
 //
 void foobar_configuration_service_update( FoobarConfigurationService* self )
 {
-	if ( !self->update_source_id )
+	if ( !self->update_id )
 	{
-		self->update_source_id = g_timeout_add(
-			UPDATE_APPLY_DELAY,
+		self->update_id = foobar_scheduler_service_add_deadline(
+			self->scheduler_service,
+			"configuration-reload",
+			g_get_monotonic_time( ) + UPDATE_APPLY_DELAY,
+			UPDATE_APPLY_SLACK,
 			foobar_configuration_service_update_cb,
 			self );
 	}
@@ -2958,16 +3239,30 @@ gboolean foobar_configuration_service_update_cb( gpointer userdata )
 
 	FoobarConfiguration* updated = foobar_configuration_new( );
 	foobar_configuration_load_from_file( updated, self->path );
-	if ( !foobar_configuration_equal( self->current, updated ) )
+	FoobarConfigurationSection changed = foobar_configuration_diff( self->current, updated );
+	if ( changed )
 	{
 		foobar_configuration_free( self->current );
 		self->current = g_steal_pointer( &updated );
 		g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_CURRENT] );
+
+		GFlagsClass* sections_class = g_type_class_ref( FOOBAR_TYPE_CONFIGURATION_SECTION );
+		for ( guint i = 0; i < sections_class->n_values; ++i )
+		{
+			GFlagsValue const* section = &sections_class->values[i];
+			if ( changed & section->value )
+			{
+				GQuark detail = g_quark_from_static_string( section->value_nick );
+				g_signal_emit( self, signals[SIGNAL_CHANGED], detail, section->value );
+			}
+		}
+		g_type_class_unref( sections_class );
+
 		g_info( "Config reloaded." );
 	}
 	g_clear_pointer( &updated, foobar_configuration_free );
 
-	self->update_source_id = 0;
+	self->update_id = 0;
 	return G_SOURCE_REMOVE;
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glib-object.h>
+#include "services/scheduler-service.h"
 
 G_BEGIN_DECLS
 
@@ -12,6 +13,7 @@ G_BEGIN_DECLS
 #define FOOBAR_TYPE_PANEL_ITEM_POSITION          foobar_panel_item_position_get_type( )
 #define FOOBAR_TYPE_CONTROL_CENTER_ROW           foobar_control_center_row_get_type( )
 #define FOOBAR_TYPE_CONTROL_CENTER_ALIGNMENT     foobar_control_center_alignment_get_type( )
+#define FOOBAR_TYPE_CONFIGURATION_SECTION        foobar_configuration_section_get_type( )
 #define FOOBAR_TYPE_GENERAL_CONFIGURATION        foobar_general_configuration_get_type( )
 #define FOOBAR_TYPE_PANEL_ITEM_CONFIGURATION     foobar_panel_item_configuration_get_type( )
 #define FOOBAR_TYPE_PANEL_CONFIGURATION          foobar_panel_configuration_get_type( )
@@ -99,6 +101,17 @@ typedef enum
 
 GType foobar_control_center_alignment_get_type( void );
 
+typedef enum
+{
+	FOOBAR_CONFIGURATION_SECTION_GENERAL        = 1 << 0,
+	FOOBAR_CONFIGURATION_SECTION_PANEL          = 1 << 1,
+	FOOBAR_CONFIGURATION_SECTION_LAUNCHER       = 1 << 2,
+	FOOBAR_CONFIGURATION_SECTION_CONTROL_CENTER = 1 << 3,
+	FOOBAR_CONFIGURATION_SECTION_NOTIFICATIONS  = 1 << 4,
+} FoobarConfigurationSection;
+
+GType foobar_configuration_section_get_type( void );
+
 typedef struct _FoobarGeneralConfiguration FoobarGeneralConfiguration;
 
 GType                       foobar_general_configuration_get_type      ( void );
@@ -266,6 +279,11 @@ gint                             foobar_notification_configuration_get_min_heigh
 gint                             foobar_notification_configuration_get_spacing           ( FoobarNotificationConfiguration const* self );
 gint                             foobar_notification_configuration_get_close_button_inset( FoobarNotificationConfiguration const* self );
 gchar const*                     foobar_notification_configuration_get_time_format       ( FoobarNotificationConfiguration const* self );
+gboolean                         foobar_notification_configuration_get_relative_time     ( FoobarNotificationConfiguration const* self );
+gint                             foobar_notification_configuration_get_max_popups        ( FoobarNotificationConfiguration const* self );
+gint                             foobar_notification_configuration_get_history_limit     ( FoobarNotificationConfiguration const* self );
+gint                             foobar_notification_configuration_get_history_max_age   ( FoobarNotificationConfiguration const* self );
+gint                             foobar_notification_configuration_get_history_max_size  ( FoobarNotificationConfiguration const* self );
 void                             foobar_notification_configuration_set_width             ( FoobarNotificationConfiguration*       self,
                                                                                            gint                                   value );
 void                             foobar_notification_configuration_set_min_height        ( FoobarNotificationConfiguration*       self,
@@ -276,6 +294,16 @@ void                             foobar_notification_configuration_set_close_but
                                                                                            gint                                   value );
 void                             foobar_notification_configuration_set_time_format       ( FoobarNotificationConfiguration*       self,
                                                                                            gchar const*                           value );
+void                             foobar_notification_configuration_set_relative_time     ( FoobarNotificationConfiguration*       self,
+                                                                                           gboolean                               value );
+void                             foobar_notification_configuration_set_max_popups        ( FoobarNotificationConfiguration*       self,
+                                                                                           gint                                   value );
+void                             foobar_notification_configuration_set_history_limit     ( FoobarNotificationConfiguration*       self,
+                                                                                           gint                                   value );
+void                             foobar_notification_configuration_set_history_max_age   ( FoobarNotificationConfiguration*       self,
+                                                                                           gint                                   value );
+void                             foobar_notification_configuration_set_history_max_size  ( FoobarNotificationConfiguration*       self,
+                                                                                           gint                                   value );
 
 typedef struct _FoobarConfiguration FoobarConfiguration;
 
@@ -285,6 +313,8 @@ FoobarConfiguration*                    foobar_configuration_copy
 void                                    foobar_configuration_free                  ( FoobarConfiguration*       self );
 gboolean                                foobar_configuration_equal                 ( FoobarConfiguration const* a,
                                                                                      FoobarConfiguration const* b );
+FoobarConfigurationSection              foobar_configuration_diff                  ( FoobarConfiguration const* a,
+                                                                                     FoobarConfiguration const* b );
 FoobarGeneralConfiguration const*       foobar_configuration_get_general           ( FoobarConfiguration const* self );
 FoobarGeneralConfiguration*             foobar_configuration_get_general_mut       ( FoobarConfiguration*       self );
 FoobarPanelConfiguration const*         foobar_configuration_get_panel             ( FoobarConfiguration const* self );
@@ -299,7 +329,7 @@ FoobarNotificationConfiguration*        foobar_configuration_get_notifications_m
 
 G_DECLARE_FINAL_TYPE( FoobarConfigurationService, foobar_configuration_service, FOOBAR, CONFIGURATION_SERVICE, GObject )
 
-FoobarConfigurationService* foobar_configuration_service_new        ( void );
+FoobarConfigurationService* foobar_configuration_service_new        ( FoobarSchedulerService*     scheduler_service );
 FoobarConfiguration const*  foobar_configuration_service_get_current( FoobarConfigurationService* self );
 
 G_END_DECLS
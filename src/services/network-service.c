@@ -5,7 +5,9 @@
 
 typedef struct _ApNetworkMembership ApNetworkMembership;
 
-#define SCAN_REFRESH_INTERVAL 10000
+// While scanning, a new scan is requested periodically. The scheduler may delay each scan by up to the slack.
+#define SCAN_REFRESH_INTERVAL ( 10 * G_TIME_SPAN_SECOND )
+#define SCAN_REFRESH_SLACK    ( 2 * G_TIME_SPAN_SECOND )
 
 //
 // FoobarNetwork:
@@ -157,21 +159,22 @@ G_DEFINE_FINAL_TYPE( FoobarNetworkAdapterWired, foobar_network_adapter_wired, FO
 
 struct _FoobarNetworkAdapterWifi
 {
-	FoobarNetworkAdapter parent_instance;
-	GHashTable*          ap_networks;
-	GHashTable*          named_networks;
-	GListStore*          networks;
-	GtkFilterListModel*  filtered_networks;
-	GtkSortListModel*    sorted_networks;
-	FoobarNetwork*       active;
-	gboolean             is_scanning;
-	NMClient*            client;
-	NMDeviceWifi*        device;
-	gulong               enabled_handler_id;
-	gulong               active_handler_id;
-	gulong               added_handler_id;
-	gulong               removed_handler_id;
-	guint                refresh_source_id;
+	FoobarNetworkAdapter    parent_instance;
+	GHashTable*             ap_networks;
+	GHashTable*             named_networks;
+	GListStore*             networks;
+	GtkFilterListModel*     filtered_networks;
+	GtkSortListModel*       sorted_networks;
+	FoobarNetwork*          active;
+	gboolean                is_scanning;
+	NMClient*               client;
+	NMDeviceWifi*           device;
+	FoobarSchedulerService* scheduler_service;
+	gulong                  enabled_handler_id;
+	gulong                  active_handler_id;
+	gulong                  added_handler_id;
+	gulong                  removed_handler_id;
+	guint                   refresh_id;
 };
 
 enum
@@ -197,7 +200,8 @@ static void                      foobar_network_adapter_wifi_set_property
                                                                                     GParamSpec*                    pspec );
 static void                      foobar_network_adapter_wifi_finalize             ( GObject*                       object );
 static FoobarNetworkAdapterWifi* foobar_network_adapter_wifi_new                  ( NMClient*                      client,
-                                                                                    NMDeviceWifi*                  device );
+                                                                                    NMDeviceWifi*                  device,
+                                                                                    FoobarSchedulerService*        scheduler_service );
 static void                      foobar_network_adapter_wifi_add_ap_to_network    ( FoobarNetworkAdapterWifi*      self,
                                                                                     NMAccessPoint*                 ap );
 static void                      foobar_network_adapter_wifi_update_active        ( FoobarNetworkAdapterWifi*      self );
@@ -251,9 +255,12 @@ struct _FoobarNetworkService
 {
 	GObject                    parent_instance;
 	NMClient*                  client;
+	FoobarSchedulerService*    scheduler_service;
 	FoobarNetworkAdapterWired* wired;
 	FoobarNetworkAdapterWifi*  wifi;
 	FoobarNetworkAdapter*      active;
+	gboolean                   is_started;
+	gboolean                   is_loading;
 	gulong                     primary_handler_id;
 	gulong                     activating_handler_id;
 };
@@ -263,6 +270,7 @@ enum
 	PROP_WIRED = 1,
 	PROP_WIFI,
 	PROP_ACTIVE,
+	PROP_IS_LOADING,
 	N_PROPS,
 };
 
@@ -275,6 +283,9 @@ static void foobar_network_service_get_property            ( GObject*
                                                              GValue*                    value,
                                                              GParamSpec*                pspec );
 static void foobar_network_service_finalize                ( GObject*                   object );
+static void foobar_network_service_handle_connect          ( GObject*                   object,
+                                                             GAsyncResult*              result,
+                                                             gpointer                   userdata );
 static void foobar_network_service_handle_connection_change( GObject*                   client,
                                                              GParamSpec*                pspec,
                                                              gpointer                   userdata );
@@ -977,13 +988,14 @@ void foobar_network_adapter_wifi_finalize( GObject* object )
 		g_signal_handlers_disconnect_by_data( ap, self );
 	}
 
-	g_clear_handle_id( &self->refresh_source_id, g_source_remove );
+	if ( self->scheduler_service ) { foobar_scheduler_service_clear( self->scheduler_service, &self->refresh_id ); }
 	g_clear_signal_handler( &self->enabled_handler_id, self->client );
 	g_clear_signal_handler( &self->active_handler_id, self->device );
 	g_clear_signal_handler( &self->added_handler_id, self->device );
 	g_clear_signal_handler( &self->removed_handler_id, self->device );
 	g_clear_object( &self->client );
 	g_clear_object( &self->device );
+	g_clear_object( &self->scheduler_service );
 	g_clear_object( &self->sorted_networks );
 	g_clear_object( &self->filtered_networks );
 	g_clear_object( &self->networks );
@@ -998,14 +1010,16 @@ void foobar_network_adapter_wifi_finalize( GObject* object )
 // Create a new wireless network adapter wrapping the provided NetworkManager device.
 //
 FoobarNetworkAdapterWifi* foobar_network_adapter_wifi_new(
-	NMClient*     client,
-	NMDeviceWifi* device )
+	NMClient*               client,
+	NMDeviceWifi*           device,
+	FoobarSchedulerService* scheduler_service )
 {
 	FoobarNetworkAdapterWifi* self = g_object_new( FOOBAR_TYPE_NETWORK_ADAPTER_WIFI, NULL );
 	foobar_network_adapter_set_device( FOOBAR_NETWORK_ADAPTER( self ), NM_DEVICE( device ) );
 
 	self->client = g_object_ref( client );
 	self->device = g_object_ref( device );
+	self->scheduler_service = g_object_ref( scheduler_service );
 	self->enabled_handler_id = g_signal_connect(
 		self->client,
 		"notify::wireless-enabled",
@@ -1113,12 +1127,15 @@ void foobar_network_adapter_wifi_set_scanning(
 
 		// Periodically start scans until "is-scanning" is disabled again.
 
-		g_clear_handle_id( &self->refresh_source_id, g_source_remove );
+		foobar_scheduler_service_clear( self->scheduler_service, &self->refresh_id );
 		if ( self->is_scanning )
 		{
 			foobar_network_adapter_wifi_refresh_list( self );
-			self->refresh_source_id = g_timeout_add(
+			self->refresh_id = foobar_scheduler_service_add_periodic(
+				self->scheduler_service,
+				"wifi-scan",
 				SCAN_REFRESH_INTERVAL,
+				SCAN_REFRESH_SLACK,
 				foobar_network_adapter_wifi_refresh_list,
 				self );
 		}
@@ -1384,57 +1401,24 @@ void foobar_network_service_class_init( FoobarNetworkServiceClass* klass )
 		"The network adapter currently in use.",
 		FOOBAR_TYPE_NETWORK_ADAPTER,
 		G_PARAM_READABLE );
+	props[PROP_IS_LOADING] = g_param_spec_boolean(
+		"is-loading",
+		"Is Loading",
+		"Indicates whether the NetworkManager client is still being initialized.",
+		TRUE,
+		G_PARAM_READABLE );
 	g_object_class_install_properties( object_klass, N_PROPS, props );
 }
 
 //
 // Instance initialization for the network service.
 //
+// The service does not connect to NetworkManager until it is started (see foobar_network_service_start). Until the
+// client is ready, no adapters are available and the service is marked as loading.
+//
 void foobar_network_service_init( FoobarNetworkService* self )
 {
-	g_autoptr( GError ) error = NULL;
-	self->client = nm_client_new( NULL, &error );
-	if ( !self->client )
-	{
-		g_warning( "Unable to connect to NetworkManager: %s", error->message );
-		return;
-	}
-
-	NMDeviceEthernet* device_wired = NULL;
-	NMDeviceWifi* device_wifi = NULL;
-	GPtrArray const* devices = nm_client_get_devices( self->client );
-	for ( guint i = 0; i < devices->len; ++i )
-	{
-		// XXX: Add support for multiple devices
-		NMDevice* device = g_ptr_array_index( devices, i );
-		if ( !device_wired && NM_IS_DEVICE_ETHERNET( device ) )
-		{
-			device_wired = NM_DEVICE_ETHERNET( device );
-		}
-		if ( !device_wifi && NM_IS_DEVICE_WIFI( device ) )
-		{
-			device_wifi = NM_DEVICE_WIFI( device );
-		}
-		if ( device_wired && device_wifi )
-		{
-			break;
-		}
-	}
-
-	self->wired = device_wired ? foobar_network_adapter_wired_new( device_wired ) : NULL;
-	self->wifi = device_wifi ? foobar_network_adapter_wifi_new( self->client, device_wifi ) : NULL;
-
-	foobar_network_service_update_active( self );
-	self->primary_handler_id = g_signal_connect(
-		self->client,
-		"notify::primary-connection",
-		G_CALLBACK( foobar_network_service_handle_connection_change ),
-		self );
-	self->activating_handler_id = g_signal_connect(
-		self->client,
-		"notify::activating-connection",
-		G_CALLBACK( foobar_network_service_handle_connection_change ),
-		self );
+	self->is_loading = TRUE;
 }
 
 //
@@ -1459,6 +1443,9 @@ void foobar_network_service_get_property(
 		case PROP_ACTIVE:
 			g_value_set_object( value, foobar_network_service_get_active( self ) );
 			break;
+		case PROP_IS_LOADING:
+			g_value_set_boolean( value, foobar_network_service_is_loading( self ) );
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
 			break;
@@ -1477,6 +1464,7 @@ void foobar_network_service_finalize( GObject* object )
 	g_clear_object( &self->wifi );
 	g_clear_object( &self->wired );
 	g_clear_object( &self->client );
+	g_clear_object( &self->scheduler_service );
 
 	G_OBJECT_CLASS( foobar_network_service_parent_class )->finalize( object );
 }
@@ -1488,9 +1476,29 @@ void foobar_network_service_finalize( GObject* object )
 //
 // Create a new network service instance.
 //
-FoobarNetworkService* foobar_network_service_new( void )
+FoobarNetworkService* foobar_network_service_new( FoobarSchedulerService* scheduler_service )
+{
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( scheduler_service ), NULL );
+
+	FoobarNetworkService* self = g_object_new( FOOBAR_TYPE_NETWORK_SERVICE, NULL );
+	self->scheduler_service = g_object_ref( scheduler_service );
+	return self;
+}
+
+//
+// Start connecting to NetworkManager, unless this already happened.
+//
+// The client is initialized asynchronously, so this does not block. The service is only started once a configured
+// widget uses it.
+//
+void foobar_network_service_start( FoobarNetworkService* self )
 {
-	return g_object_new( FOOBAR_TYPE_NETWORK_SERVICE, NULL );
+	g_return_if_fail( FOOBAR_IS_NETWORK_SERVICE( self ) );
+
+	if ( self->is_started ) { return; }
+
+	self->is_started = TRUE;
+	nm_client_new_async( NULL, foobar_network_service_handle_connect, g_object_ref( self ) );
 }
 
 //
@@ -1520,10 +1528,88 @@ FoobarNetworkAdapter* foobar_network_service_get_active( FoobarNetworkService* s
 	return self->active;
 }
 
+//
+// Check whether the NetworkManager client is still being initialized.
+//
+// While this is the case, the absence of adapters does not mean that there are none.
+//
+gboolean foobar_network_service_is_loading( FoobarNetworkService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NETWORK_SERVICE( self ), FALSE );
+	return self->is_loading;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Signal Handlers
 // ---------------------------------------------------------------------------------------------------------------------
 
+//
+// Called after asynchronous initialization of the NetworkManager client.
+//
+// This looks up the network devices and starts monitoring the active connection.
+//
+void foobar_network_service_handle_connect(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	(void)object;
+	g_autoptr( FoobarNetworkService ) self = (FoobarNetworkService*)userdata;
+
+	g_autoptr( GError ) error = NULL;
+	self->client = nm_client_new_finish( result, &error );
+	if ( !self->client )
+	{
+		g_warning( "Unable to connect to NetworkManager: %s", error->message );
+		self->is_loading = FALSE;
+		g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_IS_LOADING] );
+		return;
+	}
+
+	NMDeviceEthernet* device_wired = NULL;
+	NMDeviceWifi* device_wifi = NULL;
+	GPtrArray const* devices = nm_client_get_devices( self->client );
+	for ( guint i = 0; i < devices->len; ++i )
+	{
+		// XXX: Add support for multiple devices
+		NMDevice* device = g_ptr_array_index( devices, i );
+		if ( !device_wired && NM_IS_DEVICE_ETHERNET( device ) )
+		{
+			device_wired = NM_DEVICE_ETHERNET( device );
+		}
+		if ( !device_wifi && NM_IS_DEVICE_WIFI( device ) )
+		{
+			device_wifi = NM_DEVICE_WIFI( device );
+		}
+		if ( device_wired && device_wifi )
+		{
+			break;
+		}
+	}
+
+	self->wired = device_wired ? foobar_network_adapter_wired_new( device_wired ) : NULL;
+	self->wifi = device_wifi
+		? foobar_network_adapter_wifi_new( self->client, device_wifi, self->scheduler_service )
+		: NULL;
+	if ( self->wired ) { g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_WIRED] ); }
+	if ( self->wifi ) { g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_WIFI] ); }
+
+	foobar_network_service_update_active( self );
+	self->primary_handler_id = g_signal_connect(
+		self->client,
+		"notify::primary-connection",
+		G_CALLBACK( foobar_network_service_handle_connection_change ),
+		self );
+	self->activating_handler_id = g_signal_connect(
+		self->client,
+		"notify::activating-connection",
+		G_CALLBACK( foobar_network_service_handle_connection_change ),
+		self );
+
+	self->is_loading = FALSE;
+	g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_IS_LOADING] );
+}
+
 //
 // Called when either the primary connection or the activating connection of the client has changed.
 //
@@ -2,6 +2,7 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include "services/scheduler-service.h"
 
 G_BEGIN_DECLS
 
@@ -54,9 +55,11 @@ void           foobar_network_adapter_wifi_set_scanning( FoobarNetworkAdapterWif
 
 G_DECLARE_FINAL_TYPE( FoobarNetworkService, foobar_network_service, FOOBAR, NETWORK_SERVICE, GObject )
 
-FoobarNetworkService*      foobar_network_service_new       ( void );
-FoobarNetworkAdapterWired* foobar_network_service_get_wired ( FoobarNetworkService* self );
-FoobarNetworkAdapterWifi*  foobar_network_service_get_wifi  ( FoobarNetworkService* self );
-FoobarNetworkAdapter*      foobar_network_service_get_active( FoobarNetworkService* self );
+FoobarNetworkService*      foobar_network_service_new       ( FoobarSchedulerService* scheduler_service );
+void                       foobar_network_service_start     ( FoobarNetworkService*   self );
+FoobarNetworkAdapterWired* foobar_network_service_get_wired ( FoobarNetworkService*   self );
+FoobarNetworkAdapterWifi*  foobar_network_service_get_wifi  ( FoobarNetworkService*   self );
+FoobarNetworkAdapter*      foobar_network_service_get_active( FoobarNetworkService*   self );
+gboolean                   foobar_network_service_is_loading( FoobarNetworkService*   self );
 
 G_END_DECLS
@@ -1,10 +1,38 @@
 #include "services/notification-service.h"
+#include "services/notifications/image-store.h"
+#include "services/notifications/journal.h"
+#include "services/notifications/retention.h"
+#include "services/notifications/search-index.h"
+#include "services/notifications/timeouts.h"
 #include "dbus/notifications.h"
+#include "trace.h"
 #include "utils.h"
 #include <json-glib/json-glib.h>
 #include <gtk/gtk.h>
+#include <math.h>
+#include <string.h>
 
 #define DEFAULT_TIMEOUT 3000
+#define IMAGE_DATA_TYPE "(iiibiiay)"
+
+// Reasons for the "NotificationClosed" signal, as defined by the notification specification.
+#define CLOSED_REASON_EXPIRED 1
+#define CLOSED_REASON_CLOSED  3
+
+// New notifications are collected for roughly one frame (at 60 Hz) before they are added to the list in one batch.
+#define INGEST_INTERVAL 16
+
+// A notification arriving within this time span after the previous popup from the same application is grouped with it.
+#define GROUP_WINDOW ( 2 * G_TIME_SPAN_SECOND )
+
+// Time spans by which the scheduler may delay popup timeouts, minute ticks and retention checks to share wakeups.
+#define TIMEOUT_SLACK     ( 250 * G_TIME_SPAN_MILLISECOND )
+#define MINUTE_TICK_SLACK G_TIME_SPAN_SECOND
+#define RETENTION_SLACK   ( 10 * G_TIME_SPAN_SECOND )
+
+// Images are decoded at twice the icon size used by FoobarNotificationWidget (32px), so they stay sharp at a scale
+// factor of 2.
+#define IMAGE_SIZE 64
 
 //
 // FoobarNotificationUrgency:
@@ -62,27 +90,47 @@ G_DEFINE_FINAL_TYPE( FoobarNotificationAction, foobar_notification_action, G_TYP
 //
 // A notification received by the notification daemon (us).
 //
+// Notifications loaded from the journal's index start out as stubs, which only know the fields stored in the index
+// (ID, timestamp, dismissed flag, image hash, size and group key) and keep a reference to their unparsed record. The
+// remaining details are parsed the first time any of them is requested, which usually is when the notification's row
+// is bound in a list view.
+//
 
 struct _FoobarNotification
 {
-	GObject                    parent_instance;
-	guint                      timeout_id;
-	FoobarNotificationService* service;
-	guint                      id;
-	GPtrArray*                 actions;
-	gchar*                     app_entry;
-	gchar*                     app_name;
-	gchar*                     body;
-	gchar*                     summary;
-	GdkPixbuf*                 image;
-	gchar*                     image_path;
-	gchar*                     image_data;
-	gboolean                   is_dismissed;
-	gboolean                   is_resident;
-	gboolean                   is_transient;
-	GDateTime*                 time;
-	gint64                     timeout;
-	FoobarNotificationUrgency  urgency;
+	GObject                       parent_instance;
+	FoobarNotificationService*    service;
+	guint                         id;
+	GPtrArray*                    actions;
+	gchar*                        app_entry;
+	gchar*                        app_name;
+	gchar*                        body;
+	gchar*                        summary;
+	GdkTexture*                   image;
+	GCancellable*                 image_cancellable;
+	gchar*                        image_path;
+	gchar*                        image_hash;
+	GBytes*                       image_contents;
+	gsize                         image_size;
+	FoobarNotificationImageStore* image_store;
+	gboolean                      is_image_loaded;
+	gboolean                      is_dismissed;
+	gboolean                      is_resident;
+	gboolean                      is_transient;
+	GDateTime*                    time;
+	gint64                        timeout;
+	FoobarNotificationUrgency     urgency;
+	gint64                        arrival;
+	gboolean                      is_collapsed;
+	FoobarNotification*           group_leader;
+	GPtrArray*                    group;
+	gchar*                        group_key;
+	GBytes*                       record;
+	gsize                         indexed_size;
+	gchar*                        indexed_group_key;
+	gchar*                        search_text;
+	gboolean                      is_materialized;
+	FoobarNotificationGroup*      history_group;
 };
 
 enum
@@ -99,141 +147,377 @@ enum
 	NOTIFICATION_PROP_TIME,
 	NOTIFICATION_PROP_TIMEOUT,
 	NOTIFICATION_PROP_URGENCY,
+	NOTIFICATION_PROP_GROUP_SIZE,
 	N_NOTIFICATION_PROPS,
 };
 
 static GParamSpec* notification_props[N_NOTIFICATION_PROPS] = { 0 };
 
-static void                foobar_notification_class_init         ( FoobarNotificationClass*   klass );
-static void                foobar_notification_init               ( FoobarNotification*        self );
-static void                foobar_notification_get_property       ( GObject*                   object,
-                                                                    guint                      prop_id,
-                                                                    GValue*                    value,
-                                                                    GParamSpec*                pspec );
-static void                foobar_notification_finalize           ( GObject*                   object );
-static FoobarNotification* foobar_notification_new                ( FoobarNotificationService* service );
-static gchar const*        foobar_notification_get_image_path     ( FoobarNotification*        self );
-static gchar const*        foobar_notification_get_image_data     ( FoobarNotification*        self );
-static void                foobar_notification_set_id             ( FoobarNotification*        self,
-                                                                    guint                      value );
-static void                foobar_notification_set_app_entry      ( FoobarNotification*        self,
-                                                                    gchar const*               value );
-static void                foobar_notification_set_app_name       ( FoobarNotification*        self,
-                                                                    gchar const*               value );
-static void                foobar_notification_set_body           ( FoobarNotification*        self,
-                                                                    gchar const*               value );
-static void                foobar_notification_set_summary        ( FoobarNotification*        self,
-                                                                    gchar const*               value );
-static void                foobar_notification_set_image_from_path( FoobarNotification*        self,
-                                                                    gchar const*               value );
-static void                foobar_notification_set_image_from_data( FoobarNotification*        self,
-                                                                    gchar const*               value );
-static void                foobar_notification_set_image          ( FoobarNotification*        self,
-                                                                    GdkPixbuf*                 value );
-static void                foobar_notification_set_dismissed      ( FoobarNotification*        self,
-                                                                    gboolean                   value );
-static void                foobar_notification_set_resident       ( FoobarNotification*        self,
-                                                                    gboolean                   value );
-static void                foobar_notification_set_transient      ( FoobarNotification*        self,
-                                                                    gboolean                   value );
-static void                foobar_notification_set_time           ( FoobarNotification*        self,
-                                                                    GDateTime*                 value );
-static void                foobar_notification_set_timeout        ( FoobarNotification*        self,
-                                                                    gint64                     value );
-static void                foobar_notification_set_urgency        ( FoobarNotification*        self,
-                                                                    FoobarNotificationUrgency  value );
-static void                foobar_notification_add_action         ( FoobarNotification*        self,
-                                                                    FoobarNotificationAction*  action );
-static void                foobar_notification_free_action        ( gpointer                   action );
-static gboolean            foobar_notification_handle_timeout     ( gpointer                   userdata );
+//
+// ImageLoadJob:
+//
+// Task data for decoding a notification's image on a background thread.
+//
+
+typedef struct _ImageLoadJob ImageLoadJob;
+
+struct _ImageLoadJob
+{
+	gchar*                        path;
+	GBytes*                       contents;
+	FoobarNotificationImageStore* store;
+	gchar*                        hash;
+};
+
+static void                foobar_notification_class_init            ( FoobarNotificationClass*   klass );
+static void                foobar_notification_init                  ( FoobarNotification*        self );
+static void                foobar_notification_get_property          ( GObject*                   object,
+                                                                       guint                      prop_id,
+                                                                       GValue*                    value,
+                                                                       GParamSpec*                pspec );
+static void                foobar_notification_finalize              ( GObject*                   object );
+static FoobarNotification* foobar_notification_new                   ( FoobarNotificationService* service );
+static gchar const*        foobar_notification_get_image_path        ( FoobarNotification*        self );
+static gchar const*        foobar_notification_get_image_hash        ( FoobarNotification*        self );
+static gboolean            foobar_notification_has_image             ( FoobarNotification*        self );
+static void                foobar_notification_set_id                ( FoobarNotification*        self,
+                                                                       guint                      value );
+static void                foobar_notification_set_app_entry         ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_app_name          ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_body              ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_summary           ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_image_from_path   ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_image_from_data   ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_image_from_hash   ( FoobarNotification*        self,
+                                                                       gchar const*               value );
+static void                foobar_notification_set_image_from_variant( FoobarNotification*        self,
+                                                                       GVariant*                  value );
+static void                foobar_notification_persist_image_cb      ( GObject*                   object,
+                                                                       GAsyncResult*              result,
+                                                                       gpointer                   userdata );
+static void                foobar_notification_reset_image           ( FoobarNotification*        self );
+static void                foobar_notification_load_image_cb         ( GObject*                   object,
+                                                                       GAsyncResult*              result,
+                                                                       gpointer                   userdata );
+static void                foobar_notification_load_image_async      ( FoobarNotification*        self,
+                                                                       GCancellable*              cancellable,
+                                                                       GAsyncReadyCallback        callback,
+                                                                       gpointer                   userdata );
+static GdkTexture*         foobar_notification_load_image_finish     ( FoobarNotification*        self,
+                                                                       GAsyncResult*              result,
+                                                                       GError**                   error );
+static void                foobar_notification_load_image_thread     ( GTask*                     task,
+                                                                       gpointer                   source_object,
+                                                                       gpointer                   task_data,
+                                                                       GCancellable*              cancellable );
+static void                foobar_notification_set_dismissed         ( FoobarNotification*        self,
+                                                                       gboolean                   value );
+static void                foobar_notification_set_resident          ( FoobarNotification*        self,
+                                                                       gboolean                   value );
+static void                foobar_notification_set_transient         ( FoobarNotification*        self,
+                                                                       gboolean                   value );
+static void                foobar_notification_set_time              ( FoobarNotification*        self,
+                                                                       GDateTime*                 value );
+static void                foobar_notification_set_timeout           ( FoobarNotification*        self,
+                                                                       gint64                     value );
+static void                foobar_notification_set_urgency           ( FoobarNotification*        self,
+                                                                       FoobarNotificationUrgency  value );
+static void                foobar_notification_add_action            ( FoobarNotification*        self,
+                                                                       FoobarNotificationAction*  action );
+static void                foobar_notification_reset_hints           ( FoobarNotification*        self );
+static gchar const*        foobar_notification_get_group_key         ( FoobarNotification*        self );
+static gchar const*        foobar_notification_get_search_text       ( FoobarNotification*        self );
+static gsize               foobar_notification_get_retained_size     ( FoobarNotification*        self );
+static gint64              foobar_notification_get_unix_time         ( FoobarNotification*        self );
+static void                foobar_notification_materialize           ( FoobarNotification*        self );
+static void                foobar_notification_load_details          ( FoobarNotification*        self,
+                                                                       JsonObject*                notification_object );
+static void                foobar_notification_close_with_reason     ( FoobarNotification*        self,
+                                                                       guint                      reason );
+static void                foobar_notification_free_action           ( gpointer                   action );
+static gboolean            image_data_is_valid                       ( GVariant*                  value );
+static GdkPixbuf*          image_decode_file                         ( gchar const*               path,
+                                                                       GError**                   error );
+static gboolean            image_data_fits                           ( GVariant*                  value );
+static GdkTexture*         image_texture_new_for_variant             ( GVariant*                  value );
+static GdkTexture*         image_texture_new_for_contents            ( GBytes*                    contents,
+                                                                       GError**                   error );
+static void                image_handle_size_prepared                ( GdkPixbufLoader*           loader,
+                                                                       gint                       width,
+                                                                       gint                       height,
+                                                                       gpointer                   userdata );
+static GdkTexture*         image_texture_new_for_pixbuf              ( GdkPixbuf*                 pixbuf );
+static void                image_load_job_free                       ( ImageLoadJob*              job );
 
 G_DEFINE_FINAL_TYPE( FoobarNotification, foobar_notification, G_TYPE_OBJECT )
 
+//
+// FoobarNotificationGroup:
+//
+// All notifications in the history from the same application, sorted by timestamp in descending order. Groups are
+// created and updated by the notification service whenever a notification is added, replaced or removed.
+//
+// The service also stores the timestamp by which the group is currently sorted in its list of groups, so the group can
+// be found with a binary search even after its latest notification changed.
+//
+
+struct _FoobarNotificationGroup
+{
+	GObject             parent_instance;
+	gchar*              key;
+	GListStore*         notifications;
+	FoobarNotification* latest;
+	gint64              sorted_time;
+};
+
+enum
+{
+	GROUP_PROP_LATEST = 1,
+	GROUP_PROP_COUNT,
+	GROUP_PROP_NOTIFICATIONS,
+	N_GROUP_PROPS,
+};
+
+static GParamSpec* group_props[N_GROUP_PROPS] = { 0 };
+
+static void                     foobar_notification_group_class_init   ( FoobarNotificationGroupClass* klass );
+static void                     foobar_notification_group_init         ( FoobarNotificationGroup*      self );
+static void                     foobar_notification_group_get_property ( GObject*                      object,
+                                                                         guint                         prop_id,
+                                                                         GValue*                       value,
+                                                                         GParamSpec*                   pspec );
+static void                     foobar_notification_group_finalize     ( GObject*                      object );
+static FoobarNotificationGroup* foobar_notification_group_new          ( gchar const*                  key );
+static void                     foobar_notification_group_insert       ( FoobarNotificationGroup*      self,
+                                                                         FoobarNotification*           notification );
+static void                     foobar_notification_group_remove       ( FoobarNotificationGroup*      self,
+                                                                         FoobarNotification*           notification );
+static void                     foobar_notification_group_update_latest( FoobarNotificationGroup*      self );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationGroup, foobar_notification_group, G_TYPE_OBJECT )
+
 //
 // FoobarNotificationService:
 //
 // Service acting as the notification daemon, receiving incoming notifications from other applications. The service also
 // persistently saves previously received notifications until they are closed.
 //
+// Changes are recorded in an append-only journal (see FoobarNotificationJournal) instead of rewriting a snapshot of all
+// notifications every time one of them is added or removed.
+//
+// Notifications are looked up through an index mapping their IDs to their positions in the list, which is updated
+// alongside the list store by foobar_notification_service_append, foobar_notification_service_flush and
+// foobar_notification_service_remove. Removing a notification does not renumber the notifications after it. Instead,
+// all positions from the first removed one onwards are considered stale, and they are only recomputed in a single pass
+// once one of them is looked up. Closing several notifications at once (e.g. when enforcing the retention limits)
+// defers removing them from the list store, so contiguous ranges are removed with a single splice each.
+//
+// The history is limited by count, age and size (see FoobarNotificationRetention). The oldest notifications are closed
+// as soon as a limit is exceeded, and a single timeout fires once the oldest remaining notification becomes too old.
+//
+// Popup timeouts are kept in a deadline heap (see FoobarNotificationTimeouts) with a single scheduler task for the
+// earliest deadline. All notifications that expired by then are dismissed in one batch.
+//
+// New notifications are not added to the list right away, but collected for a frame and then inserted with a single
+// splice, so a burst of notifications only causes one update of the sorted and filtered models. While inserting the
+// batch, a popup arriving shortly after the previous popup of the same application takes over that popup's group: the
+// previous popup and its group are collapsed (hidden from the popup list) and only counted by the newest one.
+//
+// Independently of popups, the history is also partitioned into one FoobarNotificationGroup per application. The groups
+// are kept up to date incrementally alongside the list store, ordered by their latest notification, so views can show
+// one row per application instead of one per notification. Stubs are grouped by the key stored in the journal's index,
+// so grouping the history does not parse any records.
+//
+// Searching the history goes through an inverted index (see FoobarNotificationSearchIndex), which is only built on the
+// first search, because it needs the text of every notification. From then on, it is updated alongside the list store,
+// and the set of matches for the active query is updated for each added or replaced notification before it is inserted,
+// so the filter of the search results never re-checks the whole history unless the query changes.
+//
+// Views showing relative timestamps share a single "minute-tick" signal, which is emitted at the start of every minute
+// for as long as at least one of them holds it (see foobar_notification_service_hold_minute_tick).
+//
 
 struct _FoobarNotificationService
 {
-	GObject              parent_instance;
-	GListStore*          notifications;
-	GtkSortListModel*    sorted_notifications;
-	GtkFilterListModel*  popup_notifications;
-	FoobarNotifications* skeleton;
-	guint                bus_owner_id;
-	guint                next_id;
-	gchar*               cache_path;
-	GMutex               write_cache_mutex;
+	GObject                        parent_instance;
+	GListStore*                    notifications;
+	GHashTable*                    positions;
+	guint                          stale_position;
+	GArray*                        removed_positions;
+	GtkSortListModel*              sorted_notifications;
+	GtkFilterListModel*            popup_notifications;
+	FoobarNotifications*           skeleton;
+	guint                          bus_owner_id;
+	guint                          next_id;
+	FoobarNotificationJournal*     journal;
+	FoobarNotificationImageStore*  image_store;
+	FoobarNotificationRetention*   retention;
+	guint                          retention_id;
+	FoobarNotificationTimeouts*    timeouts;
+	guint                          timeouts_id;
+	gboolean                       is_dismissing_expired;
+	GPtrArray*                     pending;
+	guint                          ingest_id;
+	GHashTable*                    group_leaders;
+	GListStore*                    groups;
+	GHashTable*                    groups_by_key;
+	FoobarNotificationSearchIndex* search_index;
+	gchar*                         search_query;
+	GHashTable*                    search_matches;
+	GtkFilterListModel*            search_results;
+	guint                          minute_tick_holds;
+	guint                          minute_tick_id;
+	FoobarSchedulerService*        scheduler_service;
+};
+
+//
+// JournalReplay:
+//
+// State while replaying the journal at startup: serialized notifications from records appended since the last
+// compaction, and stubs created from the journal's index.
+//
+
+typedef struct _JournalReplay JournalReplay;
+
+struct _JournalReplay
+{
+	FoobarNotificationService* service;
+	GHashTable*                states;
+	GHashTable*                stubs;
 };
 
 enum
 {
 	PROP_NOTIFICATIONS = 1,
 	PROP_POPUP_NOTIFICATIONS,
+	PROP_GROUPS,
+	PROP_SEARCH_RESULTS,
 	N_PROPS,
 };
 
 static GParamSpec* props[N_PROPS] = { 0 };
 
-static void     foobar_notification_service_class_init                   ( FoobarNotificationServiceClass* klass );
-static void     foobar_notification_service_init                         ( FoobarNotificationService*      self );
-static void     foobar_notification_service_get_property                 ( GObject*                        object,
-                                                                           guint                           prop_id,
-                                                                           GValue*                         value,
-                                                                           GParamSpec*                     pspec );
-static void     foobar_notification_service_finalize                     ( GObject*                        object );
-static void     foobar_notification_service_read_cache                   ( FoobarNotificationService*      self );
-static void     foobar_notification_service_write_cache                  ( FoobarNotificationService*      self );
-static void     foobar_notification_service_write_cache_cb               ( GObject*                        object,
-                                                                           GAsyncResult*                   result,
-                                                                           gpointer                        userdata );
-static void     foobar_notification_service_write_cache_async            ( FoobarNotificationService*      self,
-                                                                           GPtrArray*                      notifications,
-                                                                           GCancellable*                   cancellable,
-                                                                           GAsyncReadyCallback             callback,
-                                                                           gpointer                        userdata );
-static gboolean foobar_notification_service_write_cache_finish           ( FoobarNotificationService*      self,
-                                                                           GAsyncResult*                   result,
-                                                                           GError**                        error );
-static void     foobar_notification_service_write_cache_thread           ( GTask*                          task,
-                                                                           gpointer                        source_object,
-                                                                           gpointer                        task_data,
-                                                                           GCancellable*                   cancellable );
-static void     foobar_notification_service_handle_bus_acquired          ( GDBusConnection*                connection,
-                                                                           gchar const*                    name,
-                                                                           gpointer                        userdata );
-static void     foobar_notification_service_handle_bus_lost              ( GDBusConnection*                connection,
-                                                                           gchar const*                    name,
-                                                                           gpointer                        userdata );
-static gboolean foobar_notification_service_handle_notify                ( FoobarNotifications*            iface,
-                                                                           GDBusMethodInvocation*          invocation,
-                                                                           gchar const*                    app_name,
-                                                                           guint                           replaces_id,
-                                                                           gchar const*                    image,
-                                                                           gchar const*                    summary,
-                                                                           gchar const*                    body,
-                                                                           gchar const* const*             actions,
-                                                                           GVariant*                       hints,
-                                                                           gint                            expiration,
-                                                                           gpointer                        userdata );
-static gboolean foobar_notification_service_handle_close_notification    ( FoobarNotifications*            iface,
-                                                                           GDBusMethodInvocation*          invocation,
-                                                                           guint                           id,
-                                                                           gpointer                        userdata );
-static gboolean foobar_notification_service_handle_get_capabilities      ( FoobarNotifications*            iface,
-                                                                           GDBusMethodInvocation*          invocation,
-                                                                           gpointer                        userdata );
-static gboolean foobar_notification_service_handle_get_server_information( FoobarNotifications*            iface,
-                                                                           GDBusMethodInvocation*          invocation,
-                                                                           gpointer                        userdata );
-static gboolean foobar_notification_service_popup_filter_func            ( gpointer                        item,
-                                                                           gpointer                        userdata );
-static gint     foobar_notification_service_sort_func                    ( gconstpointer                   item_a,
-                                                                           gconstpointer                   item_b,
-                                                                           gpointer                        userdata );
+enum
+{
+	SIGNAL_MINUTE_TICK,
+	N_SIGNALS,
+};
+
+static guint signals[N_SIGNALS] = { 0 };
+
+static void                foobar_notification_service_class_init                   ( FoobarNotificationServiceClass*     klass );
+static void                foobar_notification_service_init                         ( FoobarNotificationService*          self );
+static void                foobar_notification_service_get_property                 ( GObject*                            object,
+                                                                                      guint                               prop_id,
+                                                                                      GValue*                             value,
+                                                                                      GParamSpec*                         pspec );
+static void                foobar_notification_service_finalize                     ( GObject*                            object );
+static FoobarNotification* foobar_notification_service_lookup                       ( FoobarNotificationService*          self,
+                                                                                      guint                               id,
+                                                                                      guint*                              out_position );
+static void                foobar_notification_service_append                       ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_reindex                      ( FoobarNotificationService*          self );
+static gboolean            foobar_notification_service_remove                       ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_defer_removals               ( FoobarNotificationService*          self );
+static void                foobar_notification_service_commit_removals              ( FoobarNotificationService*          self );
+static void                foobar_notification_service_track                        ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_attach_group                 ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_detach_group                 ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_reorder_group                ( FoobarNotificationService*          self,
+                                                                                      FoobarNotificationGroup*            group );
+static gboolean            foobar_notification_service_find_group                   ( FoobarNotificationService*          self,
+                                                                                      FoobarNotificationGroup*            group,
+                                                                                      guint*                              out_position );
+static void                foobar_notification_service_index                        ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_build_search_index           ( FoobarNotificationService*          self );
+static void                foobar_notification_service_schedule_minute_tick         ( FoobarNotificationService*          self );
+static gboolean            foobar_notification_service_handle_minute_tick           ( gpointer                            userdata );
+static void                foobar_notification_service_enforce_retention            ( FoobarNotificationService*          self );
+static gboolean            foobar_notification_service_handle_retention_timeout     ( gpointer                            userdata );
+static void                foobar_notification_service_schedule_timeout             ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_cancel_timeout               ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_update_timeouts_task         ( FoobarNotificationService*          self );
+static gboolean            foobar_notification_service_handle_timeouts              ( gpointer                            userdata );
+static void                foobar_notification_service_enqueue                      ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_flush                        ( FoobarNotificationService*          self );
+static gboolean            foobar_notification_service_handle_ingest                ( gpointer                            userdata );
+static gboolean            foobar_notification_service_group                        ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 notification );
+static void                foobar_notification_service_ungroup                      ( FoobarNotificationService*          self,
+                                                                                      FoobarNotification*                 leader );
+static gint                foobar_notification_service_compare_position             ( gconstpointer                       item_a,
+                                                                                      gconstpointer                       item_b );
+static gint                foobar_notification_service_compare_time                 ( gconstpointer                       item_a,
+                                                                                      gconstpointer                       item_b );
+static void                foobar_notification_service_load_journal                 ( FoobarNotificationService*          self );
+static void                foobar_notification_service_import_legacy_cache          ( FoobarNotificationService*          self,
+                                                                                      gchar const*                        path );
+static void                foobar_notification_service_replay_entry                 ( FoobarNotificationJournalEntry*     entry,
+                                                                                      gpointer                            userdata );
+static void                foobar_notification_service_replay_record                ( FoobarNotificationJournalRecordType type,
+                                                                                      guint                               id,
+                                                                                      JsonObject*                         payload,
+                                                                                      gpointer                            userdata );
+static void                foobar_notification_service_record                       ( FoobarNotificationService*          self,
+                                                                                      FoobarNotificationJournalRecordType type,
+                                                                                      FoobarNotification*                 notification );
+static GPtrArray*          foobar_notification_service_snapshot_func                ( gpointer                            userdata );
+static JsonNode*           foobar_notification_service_serialize_func               ( gpointer                            item,
+                                                                                      FoobarNotificationJournalEntry*     out_entry );
+static FoobarNotification* foobar_notification_service_deserialize                  ( FoobarNotificationService*          self,
+                                                                                      JsonObject*                         notification_object );
+static void                foobar_notification_service_handle_bus_acquired          ( GDBusConnection*                    connection,
+                                                                                      gchar const*                        name,
+                                                                                      gpointer                            userdata );
+static void                foobar_notification_service_handle_bus_lost              ( GDBusConnection*                    connection,
+                                                                                      gchar const*                        name,
+                                                                                      gpointer                            userdata );
+static gboolean            foobar_notification_service_handle_notify                ( FoobarNotifications*                iface,
+                                                                                      GDBusMethodInvocation*              invocation,
+                                                                                      gchar const*                        app_name,
+                                                                                      guint                               replaces_id,
+                                                                                      gchar const*                        image,
+                                                                                      gchar const*                        summary,
+                                                                                      gchar const*                        body,
+                                                                                      gchar const* const*                 actions,
+                                                                                      GVariant*                           hints,
+                                                                                      gint                                expiration,
+                                                                                      gpointer                            userdata );
+static gboolean            foobar_notification_service_handle_close_notification    ( FoobarNotifications*                iface,
+                                                                                      GDBusMethodInvocation*              invocation,
+                                                                                      guint                               id,
+                                                                                      gpointer                            userdata );
+static gboolean            foobar_notification_service_handle_get_capabilities      ( FoobarNotifications*                iface,
+                                                                                      GDBusMethodInvocation*              invocation,
+                                                                                      gpointer                            userdata );
+static gboolean            foobar_notification_service_handle_get_server_information( FoobarNotifications*                iface,
+                                                                                      GDBusMethodInvocation*              invocation,
+                                                                                      gpointer                            userdata );
+static gboolean            foobar_notification_service_popup_filter_func            ( gpointer                            item,
+                                                                                      gpointer                            userdata );
+static gboolean            foobar_notification_service_search_filter_func           ( gpointer                            item,
+                                                                                      gpointer                            userdata );
+static gint                foobar_notification_service_sort_func                    ( gconstpointer                       item_a,
+                                                                                      gconstpointer                       item_b,
+                                                                                      gpointer                            userdata );
+static gint                foobar_notification_service_group_sort_func              ( gconstpointer                       item_a,
+                                                                                      gconstpointer                       item_b,
+                                                                                      gpointer                            userdata );
 
 G_DEFINE_FINAL_TYPE( FoobarNotificationService, foobar_notification_service, G_TYPE_OBJECT )
 
@@ -446,7 +730,7 @@ void foobar_notification_class_init( FoobarNotificationClass* klass )
 		"image",
 		"Image",
 		"An image icon for the notification.",
-		GDK_TYPE_PIXBUF,
+		GDK_TYPE_TEXTURE,
 		G_PARAM_READABLE );
 	notification_props[NOTIFICATION_PROP_IS_DISMISSED] = g_param_spec_boolean(
 		"is-dismissed",
@@ -487,6 +771,14 @@ void foobar_notification_class_init( FoobarNotificationClass* klass )
 		FOOBAR_TYPE_NOTIFICATION_URGENCY,
 		FOOBAR_NOTIFICATION_URGENCY_LOSS_OF_MONEY,
 		G_PARAM_READABLE );
+	notification_props[NOTIFICATION_PROP_GROUP_SIZE] = g_param_spec_uint(
+		"group-size",
+		"Group Size",
+		"Number of collapsed notifications from the same application that are grouped with this popup.",
+		0,
+		UINT_MAX,
+		0,
+		G_PARAM_READABLE );
 	g_object_class_install_properties( object_klass, N_NOTIFICATION_PROPS, notification_props );
 }
 
@@ -496,6 +788,8 @@ void foobar_notification_class_init( FoobarNotificationClass* klass )
 void foobar_notification_init( FoobarNotification* self )
 {
 	self->actions = g_ptr_array_new_with_free_func( foobar_notification_free_action );
+	self->image_cancellable = g_cancellable_new( );
+	self->is_materialized = TRUE;
 }
 
 //
@@ -547,6 +841,9 @@ void foobar_notification_get_property(
 		case NOTIFICATION_PROP_URGENCY:
 			g_value_set_enum( value, foobar_notification_get_urgency( self ) );
 			break;
+		case NOTIFICATION_PROP_GROUP_SIZE:
+			g_value_set_uint( value, foobar_notification_get_group_size( self ) );
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
 			break;
@@ -560,15 +857,28 @@ void foobar_notification_finalize( GObject* object )
 {
 	FoobarNotification* self = (FoobarNotification*)object;
 
-	g_clear_object( &self->image );
+	foobar_notification_reset_image( self );
+	g_clear_object( &self->image_cancellable );
 	g_clear_pointer( &self->actions, g_ptr_array_unref );
 	g_clear_pointer( &self->app_entry, g_free );
 	g_clear_pointer( &self->app_name, g_free );
 	g_clear_pointer( &self->body, g_free );
 	g_clear_pointer( &self->summary, g_free );
-	g_clear_pointer( &self->image_path, g_free );
-	g_clear_pointer( &self->image_data, g_free );
 	g_clear_pointer( &self->time, g_date_time_unref );
+	g_clear_pointer( &self->group_key, g_free );
+	g_clear_pointer( &self->record, g_bytes_unref );
+	g_clear_pointer( &self->indexed_group_key, g_free );
+	g_clear_pointer( &self->search_text, g_free );
+
+	if ( self->group )
+	{
+		for ( guint i = 0; i < self->group->len; ++i )
+		{
+			FoobarNotification* member = g_ptr_array_index( self->group, i );
+			member->group_leader = NULL;
+		}
+		g_clear_pointer( &self->group, g_ptr_array_unref );
+	}
 
 	G_OBJECT_CLASS( foobar_notification_parent_class )->finalize( object );
 }
@@ -600,6 +910,7 @@ FoobarNotificationAction** foobar_notification_get_actions(
 	guint*              out_count )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
 	if ( out_count ) { *out_count = self->actions->len; }
 	return (FoobarNotificationAction**)self->actions->pdata;
 }
@@ -610,6 +921,7 @@ FoobarNotificationAction** foobar_notification_get_actions(
 gchar const* foobar_notification_get_app_entry( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
 	return self->app_entry;
 }
 
@@ -619,6 +931,7 @@ gchar const* foobar_notification_get_app_entry( FoobarNotification* self )
 gchar const* foobar_notification_get_app_name( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
 	return self->app_name;
 }
 
@@ -628,6 +941,7 @@ gchar const* foobar_notification_get_app_name( FoobarNotification* self )
 gchar const* foobar_notification_get_body( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
 	return self->body;
 }
 
@@ -637,6 +951,7 @@ gchar const* foobar_notification_get_body( FoobarNotification* self )
 gchar const* foobar_notification_get_summary( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
 	return self->summary;
 }
 
@@ -646,24 +961,49 @@ gchar const* foobar_notification_get_summary( FoobarNotification* self )
 gchar const* foobar_notification_get_image_path( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
 	return self->image_path;
 }
 
 //
-// The base64-encoded data for the notification's image if it was loaded from data.
+// The hash of the notification's image in the image store if it was provided as raw data.
 //
-gchar const* foobar_notification_get_image_data( FoobarNotification* self )
+gchar const* foobar_notification_get_image_hash( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
-	return self->image_data;
+	return self->image_hash;
+}
+
+//
+// Check whether the notification has an image source, without loading the image.
+//
+gboolean foobar_notification_has_image( FoobarNotification* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), FALSE );
+	return self->image_path || self->image_hash || self->image_contents;
 }
 
 //
 // An image icon for the notification.
 //
-GdkPixbuf* foobar_notification_get_image( FoobarNotification* self )
+// The image is only decoded once it is requested for the first time (i.e. when a widget actually shows it). Decoding
+// happens on a background thread, so this returns NULL until the image is ready and "image" is notified.
+//
+GdkTexture* foobar_notification_get_image( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), NULL );
+	foobar_notification_materialize( self );
+
+	if ( !self->is_image_loaded && foobar_notification_has_image( self ) )
+	{
+		self->is_image_loaded = TRUE;
+		foobar_notification_load_image_async(
+			self,
+			self->image_cancellable,
+			foobar_notification_load_image_cb,
+			NULL );
+	}
+
 	return self->image;
 }
 
@@ -682,6 +1022,7 @@ gboolean foobar_notification_is_dismissed( FoobarNotification* self )
 gboolean foobar_notification_is_resident( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), FALSE );
+	foobar_notification_materialize( self );
 	return self->is_resident;
 }
 
@@ -709,6 +1050,7 @@ GDateTime* foobar_notification_get_time( FoobarNotification* self )
 gint64 foobar_notification_get_timeout( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), 0 );
+	foobar_notification_materialize( self );
 	return self->timeout;
 }
 
@@ -718,9 +1060,19 @@ gint64 foobar_notification_get_timeout( FoobarNotification* self )
 FoobarNotificationUrgency foobar_notification_get_urgency( FoobarNotification* self )
 {
 	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), FOOBAR_NOTIFICATION_URGENCY_LOSS_OF_MONEY );
+	foobar_notification_materialize( self );
 	return self->urgency;
 }
 
+//
+// Number of collapsed notifications from the same application that are grouped with this popup.
+//
+guint foobar_notification_get_group_size( FoobarNotification* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION( self ), 0 );
+	return self->group ? self->group->len : 0;
+}
+
 //
 // Numeric ID of the notification.
 //
@@ -766,6 +1118,7 @@ void foobar_notification_set_app_name(
 	if ( g_strcmp0( self->app_name, value ) )
 	{
 		g_clear_pointer( &self->app_name, g_free );
+		g_clear_pointer( &self->search_text, g_free );
 		self->app_name = g_strdup( value );
 		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_APP_NAME] );
 	}
@@ -783,6 +1136,7 @@ void foobar_notification_set_body(
 	if ( g_strcmp0( self->body, value ) )
 	{
 		g_clear_pointer( &self->body, g_free );
+		g_clear_pointer( &self->search_text, g_free );
 		self->body = g_strdup( value );
 		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_BODY] );
 	}
@@ -800,13 +1154,14 @@ void foobar_notification_set_summary(
 	if ( g_strcmp0( self->summary, value ) )
 	{
 		g_clear_pointer( &self->summary, g_free );
+		g_clear_pointer( &self->search_text, g_free );
 		self->summary = g_strdup( value );
 		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_SUMMARY] );
 	}
 }
 
 //
-// Update the notification's image by trying to load a file at the provided path.
+// Update the notification's image to be loaded from a file at the provided path.
 //
 void foobar_notification_set_image_from_path(
 	FoobarNotification* self,
@@ -816,18 +1171,9 @@ void foobar_notification_set_image_from_path(
 
 	if ( g_strcmp0( self->image_path, value ) )
 	{
-		g_clear_pointer( &self->image_path, g_free );
-		g_clear_pointer( &self->image_data, g_free );
-		g_clear_object( &self->image );
+		foobar_notification_reset_image( self );
 		self->image_path = g_strdup( value );
 
-		g_autoptr( GError ) error = NULL;
-		self->image = gdk_pixbuf_new_from_file( self->image_path, &error );
-		if ( !self->image )
-		{
-			g_warning( "Invalid image path for notification: %s", error->message );
-		}
-
 		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_IMAGE] );
 	}
 }
@@ -835,27 +1181,57 @@ void foobar_notification_set_image_from_path(
 //
 // Update the notification's image by trying to load base64-encoded data.
 //
+// This is only used for notifications cached by previous versions, which stored images as base64-encoded PNG files.
+// The image is converted to raw data and moved to the image store.
+//
 void foobar_notification_set_image_from_data(
 	FoobarNotification* self,
 	gchar const*        value )
 {
 	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
 
-	if ( g_strcmp0( self->image_data, value ) )
+	gsize   data_len;
+	guchar* data = g_base64_decode( value, &data_len );
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GInputStream ) input = g_memory_input_stream_new_from_data( data, (gssize)data_len, g_free );
+	g_autoptr( GdkPixbuf ) pixbuf = gdk_pixbuf_new_from_stream( input, NULL, &error );
+	if ( !pixbuf )
+	{
+		g_warning( "Invalid image data for notification: %s", error->message );
+		return;
+	}
+
+	g_autoptr( GBytes ) pixels = gdk_pixbuf_read_pixel_bytes( pixbuf );
+	g_autoptr( GVariant ) image_data = g_variant_ref_sink( g_variant_new(
+		"(iiibii@ay)",
+		gdk_pixbuf_get_width( pixbuf ),
+		gdk_pixbuf_get_height( pixbuf ),
+		gdk_pixbuf_get_rowstride( pixbuf ),
+		gdk_pixbuf_get_has_alpha( pixbuf ),
+		gdk_pixbuf_get_bits_per_sample( pixbuf ),
+		gdk_pixbuf_get_n_channels( pixbuf ),
+		g_variant_new_from_bytes( G_VARIANT_TYPE_BYTESTRING, pixels, TRUE ) ) );
+	foobar_notification_set_image_from_variant( self, image_data );
+}
+
+//
+// Update the notification's image to be loaded from the image store, acquiring a reference to the stored image.
+//
+void foobar_notification_set_image_from_hash(
+	FoobarNotification* self,
+	gchar const*        value )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
+
+	if ( g_strcmp0( self->image_hash, value ) )
 	{
-		g_clear_pointer( &self->image_path, g_free );
-		g_clear_pointer( &self->image_data, g_free );
-		g_clear_object( &self->image );
-		self->image_data = g_strdup( value );
+		foobar_notification_reset_image( self );
 
-		gsize   data_len;
-		guchar* data = g_base64_decode( self->image_data, &data_len );
-		g_autoptr( GError ) error = NULL;
-		g_autoptr( GInputStream ) input = g_memory_input_stream_new_from_data( data, (gssize)data_len, g_free );
-		self->image = gdk_pixbuf_new_from_stream( input, NULL, &error );
-		if ( !self->image )
+		if ( value && self->service )
 		{
-			g_warning( "Invalid image data for notification: %s", error->message );
+			self->image_store = g_object_ref( self->service->image_store );
+			self->image_hash = g_strdup( value );
+			foobar_notification_image_store_ref( self->image_store, self->image_hash );
 		}
 
 		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_IMAGE] );
@@ -863,39 +1239,209 @@ void foobar_notification_set_image_from_data(
 }
 
 //
-// Update the notification's image to a custom pixbuf.
+// Update the notification's image from raw data in the format of the "image-data" hint.
 //
-static void foobar_notification_set_image(
+// Images that are already small enough are displayed right away, wrapping the pixel data of the variant (which usually
+// points into the D-Bus message) without copying or converting it. Hashing and writing the data to the image store
+// happens in the background, after which an "update" record with the image's hash is added to the journal.
+//
+void foobar_notification_set_image_from_variant(
 	FoobarNotification* self,
-	GdkPixbuf*          value )
+	GVariant*           value )
 {
 	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
 
-	if ( self->image != value )
+	if ( !image_data_is_valid( value ) )
+	{
+		g_warning( "Invalid image data for notification." );
+		return;
+	}
+
+	if ( !self->service ) { return; }
+
+	foobar_notification_reset_image( self );
+	self->image_contents = g_variant_get_data_as_bytes( value );
+	self->image_size = g_bytes_get_size( self->image_contents );
+	self->image_store = g_object_ref( self->service->image_store );
+
+	if ( image_data_fits( value ) )
+	{
+		self->image = image_texture_new_for_variant( value );
+		self->is_image_loaded = TRUE;
+	}
+
+	foobar_notification_image_store_add_async(
+		self->image_store,
+		self->image_contents,
+		self->image_cancellable,
+		foobar_notification_persist_image_cb,
+		g_object_ref( self ) );
+
+	g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_IMAGE] );
+}
+
+//
+// Callback invoked when the notification's image was added to the image store or adding it failed.
+//
+// If the image was reset or replaced while it was being stored, the reference acquired for it is released again right
+// away, so its file is removed unless another notification uses the same image.
+//
+void foobar_notification_persist_image_cb(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	FoobarNotificationImageStore* store = (FoobarNotificationImageStore*)object;
+	g_autoptr( FoobarNotification ) self = (FoobarNotification*)userdata;
+
+	g_autoptr( GError ) error = NULL;
+	g_autofree gchar* hash = foobar_notification_image_store_add_finish( store, result, &error );
+	if ( !hash )
+	{
+		g_warning( "Unable to store image for notification: %s", error->message );
+		return;
+	}
+
+	GCancellable* cancellable = g_task_get_cancellable( G_TASK( result ) );
+	if ( cancellable != self->image_cancellable || g_cancellable_is_cancelled( cancellable ) )
+	{
+		foobar_notification_image_store_unref( store, hash );
+		return;
+	}
+
+	self->image_hash = g_steal_pointer( &hash );
+	g_clear_pointer( &self->image_contents, g_bytes_unref );
+
+	if ( self->service )
+	{
+		foobar_notification_service_record( self->service, FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE, self );
+	}
+}
+
+//
+// Clear the notification's image and its source, releasing the reference to a stored image.
+//
+void foobar_notification_reset_image( FoobarNotification* self )
+{
+	if ( self->image_hash && self->image_store )
 	{
-		g_clear_pointer( &self->image_path, g_free );
-		g_clear_pointer( &self->image_data, g_free );
-		g_clear_object( &self->image );
+		foobar_notification_image_store_unref( self->image_store, self->image_hash );
+	}
+
+	g_cancellable_cancel( self->image_cancellable );
+	g_clear_object( &self->image_cancellable );
+	self->image_cancellable = g_cancellable_new( );
+
+	g_clear_pointer( &self->image_path, g_free );
+	g_clear_pointer( &self->image_hash, g_free );
+	g_clear_pointer( &self->image_contents, g_bytes_unref );
+	g_clear_object( &self->image_store );
+	g_clear_object( &self->image );
+	self->image_size = 0;
+	self->is_image_loaded = FALSE;
+}
+
+//
+// Callback invoked when the notification's image was decoded or decoding failed.
+//
+void foobar_notification_load_image_cb(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	(void)userdata;
+	FoobarNotification* self = (FoobarNotification*)object;
 
-		if ( value )
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GdkTexture ) texture = foobar_notification_load_image_finish( self, result, &error );
+	if ( !texture )
+	{
+		if ( !g_error_matches( error, G_IO_ERROR, G_IO_ERROR_CANCELLED ) )
 		{
-			self->image = g_object_ref( value );
-			g_autoptr( GError ) error = NULL;
-			gchar* data;
-			gsize  data_len;
-			if ( gdk_pixbuf_save_to_buffer( self->image, &data, &data_len, "png", &error, NULL ) )
-			{
-				self->image_data = g_base64_encode( (guchar const*)data, data_len );
-			}
-			else
-			{
-				g_warning( "Unable to save image for notification: %s", error->message );
-				g_clear_object( &self->image );
-			}
+			g_warning( "Unable to load image for notification: %s", error->message );
 		}
+		return;
+	}
 
-		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_IMAGE] );
+	g_set_object( &self->image, texture );
+	g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_IMAGE] );
+}
+
+//
+// Asynchronously decode the notification's image from its current source, downscaling it to IMAGE_SIZE.
+//
+void foobar_notification_load_image_async(
+	FoobarNotification* self,
+	GCancellable*       cancellable,
+	GAsyncReadyCallback callback,
+	gpointer            userdata )
+{
+	ImageLoadJob* job = g_new0( ImageLoadJob, 1 );
+	job->path = g_strdup( self->image_path );
+	job->contents = self->image_contents ? g_bytes_ref( self->image_contents ) : NULL;
+	job->store = self->image_store ? g_object_ref( self->image_store ) : NULL;
+	job->hash = g_strdup( self->image_hash );
+
+	g_autoptr( GTask ) task = g_task_new( self, cancellable, callback, userdata );
+	g_task_set_name( task, "load-notification-image" );
+	g_task_set_task_data( task, job, (GDestroyNotify)image_load_job_free );
+	g_task_run_in_thread( task, foobar_notification_load_image_thread );
+}
+
+//
+// Get the asynchronous result for decoding the notification's image, returning NULL on error.
+//
+GdkTexture* foobar_notification_load_image_finish(
+	FoobarNotification* self,
+	GAsyncResult*       result,
+	GError**            error )
+{
+	(void)self;
+
+	return g_task_propagate_pointer( G_TASK( result ), error );
+}
+
+//
+// Task implementation for foobar_notification_load_image_async, invoked on a background thread.
+//
+void foobar_notification_load_image_thread(
+	GTask*        task,
+	gpointer      source_object,
+	gpointer      task_data,
+	GCancellable* cancellable )
+{
+	(void)source_object;
+	(void)cancellable;
+	ImageLoadJob* job = (ImageLoadJob*)task_data;
+
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GdkTexture ) texture = NULL;
+	if ( job->path )
+	{
+		g_autoptr( GdkPixbuf ) pixbuf = image_decode_file( job->path, &error );
+		if ( pixbuf ) { texture = image_texture_new_for_pixbuf( pixbuf ); }
 	}
+	else if ( job->contents )
+	{
+		texture = image_texture_new_for_contents( job->contents, &error );
+	}
+	else if ( job->store && job->hash )
+	{
+		g_autoptr( GBytes ) contents = foobar_notification_image_store_load( job->store, job->hash, &error );
+		if ( contents ) { texture = image_texture_new_for_contents( contents, &error ); }
+	}
+	else
+	{
+		g_set_error_literal( &error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "The notification has no image." );
+	}
+
+	if ( !texture )
+	{
+		g_task_return_error( task, g_steal_pointer( &error ) );
+		return;
+	}
+
+	g_task_return_pointer( task, g_steal_pointer( &texture ), g_object_unref );
 }
 
 //
@@ -913,7 +1459,9 @@ void foobar_notification_set_dismissed(
 		self->is_dismissed = value;
 		g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_IS_DISMISSED] );
 
-		if ( self->service )
+		// Collapsed notifications are hidden from the popup list either way.
+
+		if ( self->service && !self->service->is_dismissing_expired && !self->is_collapsed )
 		{
 			gtk_filter_changed(
 				gtk_filter_list_model_get_filter( self->service->popup_notifications ),
@@ -1020,318 +1568,1765 @@ void foobar_notification_add_action(
 }
 
 //
-// Block the notification from automatically being dismissed.
+// Reset all properties that are set from hints or actions of a "Notify" call, so that a replacement can be applied to
+// the notification in place.
 //
-void foobar_notification_block_timeout( FoobarNotification* self )
+void foobar_notification_reset_hints( FoobarNotification* self )
 {
 	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
 
-	g_clear_handle_id( &self->timeout_id, g_source_remove );
+	foobar_notification_set_app_entry( self, NULL );
+	foobar_notification_set_resident( self, FALSE );
+	foobar_notification_set_transient( self, FALSE );
+	foobar_notification_set_urgency( self, FOOBAR_NOTIFICATION_URGENCY_LOSS_OF_COMFORT );
+	foobar_notification_set_dismissed( self, FALSE );
+	g_ptr_array_set_size( self->actions, 0 );
 }
 
 //
-// If not already started, start the timeout to automatically dismiss the notification after it's timeout.
-//
-void foobar_notification_resume_timeout( FoobarNotification* self )
-{
-	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
-
-	if ( !self->is_dismissed && !self->timeout_id )
-	{
-		self->timeout_id = g_timeout_add_full(
-			G_NOTIFICATION_PRIORITY_NORMAL,
-			self->timeout,
-			foobar_notification_handle_timeout,
-			g_object_ref( self ),
-			g_object_unref );
-	}
-}
-
+// Get the key by which notifications from the same application are grouped, or NULL if the application is unknown.
 //
-// Manually dismiss the notification, setting "is-dismissed" to TRUE.
+// Stubs return the key stored in the journal's index, so they don't need to be materialized for grouping.
 //
-void foobar_notification_dismiss( FoobarNotification* self )
+gchar const* foobar_notification_get_group_key( FoobarNotification* self )
 {
-	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
+	if ( !self->is_materialized ) { return self->indexed_group_key; }
 
-	foobar_notification_set_dismissed( self, TRUE );
+	if ( self->app_entry && *self->app_entry ) { return self->app_entry; }
+	if ( self->app_name && *self->app_name ) { return self->app_name; }
+	return NULL;
 }
 
 //
-// Close the notification, removing it from the parent service's list.
+// Get the text of the notification that is searchable, i.e. its application name, summary and body without any markup.
 //
-void foobar_notification_close( FoobarNotification* self )
+// The text is cached until one of these fields changes. It is also stored in the notification's journal record, so
+// stubs only have to parse their record for it, without being materialized. This only happens once the search index is
+// built, so the text is not kept in memory for the whole history before the first search.
+//
+gchar const* foobar_notification_get_search_text( FoobarNotification* self )
 {
-	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
+	if ( self->search_text ) { return self->search_text; }
 
-	if ( self->service )
+	if ( !self->is_materialized )
 	{
-		FoobarNotificationService* service = self->service;
-		self->service = NULL;
-
-		guint id = foobar_notification_get_id( self );
-
-		for ( guint i = 0; i < g_list_model_get_n_items( G_LIST_MODEL( service->notifications ) ); ++i )
+		g_autoptr( JsonObject ) notification_object = foobar_notification_journal_parse_record( self->record, NULL );
+		gchar const* search_text = notification_object
+			? json_object_get_string_member_with_default( notification_object, "search-text", NULL )
+			: NULL;
+		if ( search_text )
 		{
-			if ( g_list_model_get_item( G_LIST_MODEL( service->notifications ), i ) == self )
-			{
-				g_list_store_remove( service->notifications, i );
-				foobar_notification_service_write_cache( service );
-				break;
-			}
+			self->search_text = g_strdup( search_text );
+			return self->search_text;
 		}
-
-		foobar_notifications_emit_notification_closed( service->skeleton, id, 3 );
 	}
+
+	gchar const* app_name = foobar_notification_get_app_name( self );
+	gchar const* summary = foobar_notification_get_summary( self );
+	gchar const* body = foobar_notification_get_body( self );
+
+	g_autofree gchar* body_text = NULL;
+	if ( body && !pango_parse_markup( body, -1, 0, NULL, &body_text, NULL, NULL ) ) { body_text = g_strdup( body ); }
+
+	self->search_text = g_strjoin(
+		" ",
+		app_name ? app_name : "",
+		summary ? summary : "",
+		body_text ? body_text : "",
+		NULL );
+	return self->search_text;
 }
 
 //
-// Called when an action is removed from a notification, resetting its weak reference to the notification.
+// Estimate the number of bytes kept for the notification in memory and in the journal, including its stored image.
 //
-void foobar_notification_free_action( gpointer action )
+gsize foobar_notification_get_retained_size( FoobarNotification* self )
 {
-	FoobarNotificationAction* object = (FoobarNotificationAction*)action;
-	object->notification = NULL;
-	g_object_unref( object );
+	if ( !self->is_materialized ) { return self->indexed_size; }
+
+	gsize size = self->image_size;
+	if ( self->app_entry ) { size += strlen( self->app_entry ); }
+	if ( self->app_name ) { size += strlen( self->app_name ); }
+	if ( self->body ) { size += strlen( self->body ); }
+	if ( self->summary ) { size += strlen( self->summary ); }
+	if ( self->image_path ) { size += strlen( self->image_path ); }
+	return size;
 }
 
 //
-// Called after the notification's timeout has elapsed.
+// Get the notification's timestamp in microseconds since the Unix epoch, as used by g_get_real_time.
 //
-gboolean foobar_notification_handle_timeout( gpointer userdata )
+gint64 foobar_notification_get_unix_time( FoobarNotification* self )
 {
-	FoobarNotification* notification = (FoobarNotification*)userdata;
+	if ( !self->time ) { return g_get_real_time( ); }
 
-	foobar_notification_dismiss( notification );
-	notification->timeout_id = 0;
-
-	return G_SOURCE_REMOVE;
+	return g_date_time_to_unix( self->time ) * G_USEC_PER_SEC + g_date_time_get_microsecond( self->time );
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
-// Service Implementation
-// ---------------------------------------------------------------------------------------------------------------------
-
 //
-// Static initialization for the notification service.
+// Parse the details of a notification that was loaded from the journal's index, if this didn't happen yet.
 //
-void foobar_notification_service_class_init( FoobarNotificationServiceClass* klass )
+void foobar_notification_materialize( FoobarNotification* self )
 {
-	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
-	object_klass->get_property = foobar_notification_service_get_property;
-	object_klass->finalize = foobar_notification_service_finalize;
+	if ( self->is_materialized ) { return; }
 
-	props[PROP_NOTIFICATIONS] = g_param_spec_object(
-		"notifications",
-		"Notifications",
-		"Sorted list of all notifications.",
-		G_TYPE_LIST_MODEL,
-		G_PARAM_READABLE );
-	props[PROP_POPUP_NOTIFICATIONS] = g_param_spec_object(
-		"popup-notifications",
-		"Popup Notifications",
-		"Sorted list of all visible notifications (i.e. notifications that are not dismissed).",
-		G_TYPE_LIST_MODEL,
-		G_PARAM_READABLE );
-	g_object_class_install_properties( object_klass, N_PROPS, props );
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( JsonObject ) notification_object = foobar_notification_journal_parse_record( self->record, &error );
+	if ( notification_object ) { foobar_notification_load_details( self, notification_object ); }
+	else { g_warning( "Unable to load notification #%u: %s", self->id, error->message ); }
+
+	self->is_materialized = TRUE;
 }
 
 //
-// Instance initialization for the notification service.
+// Assign all fields of a serialized notification that are not stored in the journal's index.
 //
-void foobar_notification_service_init( FoobarNotificationService* self )
+// Properties are not notified, because the notification is either new or a stub whose details were not observed yet.
+//
+void foobar_notification_load_details(
+	FoobarNotification* self,
+	JsonObject*         notification_object )
 {
-	self->notifications = g_list_store_new( FOOBAR_TYPE_NOTIFICATION );
-	self->cache_path = foobar_get_cache_path( "notifications.json" );
-	g_mutex_init( &self->write_cache_mutex );
+	g_free( self->app_entry );
+	self->app_entry = g_strdup( json_object_get_string_member_with_default( notification_object, "app-entry", NULL ) );
 
-	GtkCustomSorter* sorter = gtk_custom_sorter_new( foobar_notification_service_sort_func, NULL, NULL );
-	self->sorted_notifications = gtk_sort_list_model_new(
-		G_LIST_MODEL( g_object_ref( self->notifications ) ),
-		GTK_SORTER( sorter ) );
+	g_free( self->app_name );
+	self->app_name = g_strdup( json_object_get_string_member_with_default( notification_object, "app-name", NULL ) );
 
-	GtkCustomFilter* popup_filter = gtk_custom_filter_new( foobar_notification_service_popup_filter_func, NULL, NULL );
-	self->popup_notifications = gtk_filter_list_model_new(
-		G_LIST_MODEL( g_object_ref( self->sorted_notifications ) ),
-		GTK_FILTER( popup_filter ) );
+	g_free( self->body );
+	self->body = g_strdup( json_object_get_string_member_with_default( notification_object, "body", NULL ) );
 
-	foobar_notification_service_read_cache( self );
+	g_free( self->summary );
+	self->summary = g_strdup( json_object_get_string_member_with_default( notification_object, "summary", NULL ) );
 
-	self->bus_owner_id = g_bus_own_name(
-		G_BUS_TYPE_SESSION,
-		"org.freedesktop.Notifications",
-		G_BUS_NAME_OWNER_FLAGS_NONE,
-		foobar_notification_service_handle_bus_acquired,
-		NULL,
-		foobar_notification_service_handle_bus_lost,
-		self,
-		NULL );
+	gchar const* image_path = json_object_get_string_member_with_default( notification_object, "image-path", NULL );
+	if ( image_path && !foobar_notification_has_image( self ) ) { self->image_path = g_strdup( image_path ); }
+	if ( self->image_hash )
+	{
+		self->image_size = json_object_get_int_member_with_default( notification_object, "image-size", 0 );
+	}
+
+	self->is_resident = json_object_get_boolean_member_with_default( notification_object, "is-resident", FALSE );
+	self->timeout = MAX( json_object_get_int_member_with_default( notification_object, "timeout", 0 ), 0 );
+	self->urgency = json_object_get_int_member_with_default(
+		notification_object,
+		"urgency",
+		FOOBAR_NOTIFICATION_URGENCY_LOSS_OF_COMFORT );
+
+	JsonArray* actions_array = json_object_get_array_member( notification_object, "actions" );
+	for ( guint j = 0; j < json_array_get_length( actions_array ); ++j )
+	{
+		JsonObject* action_object = json_array_get_object_element( actions_array, j );
+		g_autoptr( FoobarNotificationAction ) action = foobar_notification_action_new( self );
+
+		gchar const* action_id = json_object_get_string_member_with_default( action_object, "id", NULL );
+		foobar_notification_action_set_id( action, action_id );
+
+		gchar const* label = json_object_get_string_member_with_default( action_object, "label", NULL );
+		foobar_notification_action_set_label( action, label );
+
+		foobar_notification_add_action( self, action );
+	}
 }
 
 //
-// Property getter implementation, mapping a property id to a method.
+// Block the notification from automatically being dismissed.
 //
-void foobar_notification_service_get_property( GObject* object, guint prop_id, GValue* value, GParamSpec* pspec )
+void foobar_notification_block_timeout( FoobarNotification* self )
 {
-	FoobarNotificationService* self = (FoobarNotificationService*)object;
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
 
-	switch ( prop_id )
+	if ( self->service ) { foobar_notification_service_cancel_timeout( self->service, self ); }
+}
+
+//
+// If not already started, start the timeout to automatically dismiss the notification after it's timeout.
+//
+void foobar_notification_resume_timeout( FoobarNotification* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
+
+	if ( !self->is_dismissed && !self->is_collapsed && self->service )
 	{
-		case PROP_NOTIFICATIONS:
-			g_value_set_object( value, foobar_notification_service_get_notifications( self ) );
-			break;
-		case PROP_POPUP_NOTIFICATIONS:
-			g_value_set_object( value, foobar_notification_service_get_popup_notifications( self ) );
-			break;
-		default:
-			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
-			break;
+		foobar_notification_service_schedule_timeout( self->service, self );
 	}
 }
 
 //
-// Instance cleanup for the notification service.
+// Manually dismiss the notification, setting "is-dismissed" to TRUE.
 //
-void foobar_notification_service_finalize( GObject* object )
+void foobar_notification_dismiss( FoobarNotification* self )
 {
-	FoobarNotificationService* self = (FoobarNotificationService*)object;
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
 
-	if ( self->skeleton ) { g_dbus_interface_skeleton_unexport( G_DBUS_INTERFACE_SKELETON( self->skeleton ) ); }
+	if ( !self->is_dismissed )
+	{
+		foobar_notification_block_timeout( self );
+		foobar_notification_set_dismissed( self, TRUE );
+		if ( self->service )
+		{
+			foobar_notification_service_record( self->service, FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS, self );
+		}
 
-	for ( guint i = 0; i < g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) ); ++i )
+		// Dismissing a group also dismisses the collapsed notifications, which are still collapsed at this point and
+		// therefore don't update the popup filter.
+
+		if ( self->group )
+		{
+			g_autoptr( GPtrArray ) members = g_steal_pointer( &self->group );
+			for ( guint i = 0; i < members->len; ++i )
+			{
+				FoobarNotification* member = g_ptr_array_index( members, i );
+				member->group_leader = NULL;
+				foobar_notification_dismiss( member );
+				member->is_collapsed = FALSE;
+			}
+			g_object_notify_by_pspec( G_OBJECT( self ), notification_props[NOTIFICATION_PROP_GROUP_SIZE] );
+		}
+	}
+}
+
+//
+// Show all notifications that were collapsed into this popup as separate popups again.
+//
+void foobar_notification_expand( FoobarNotification* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
+
+	if ( self->service ) { foobar_notification_service_ungroup( self->service, self ); }
+}
+
+//
+// Close the notification, removing it from the parent service's list.
+//
+void foobar_notification_close( FoobarNotification* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION( self ) );
+
+	foobar_notification_close_with_reason( self, CLOSED_REASON_CLOSED );
+}
+
+//
+// Close the notification, letting its sender know why it was closed.
+//
+void foobar_notification_close_with_reason(
+	FoobarNotification* self,
+	guint               reason )
+{
+	if ( self->service )
 	{
-		FoobarNotification* notification = g_list_model_get_item( G_LIST_MODEL( self->notifications ), i );
-		notification->service = NULL;
+		FoobarNotificationService* service = self->service;
+		self->service = NULL;
+
+		if ( foobar_notification_service_remove( service, self ) )
+		{
+			foobar_notification_service_record( service, FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE, self );
+		}
+
+		if ( service->skeleton )
+		{
+			foobar_notifications_emit_notification_closed( service->skeleton, foobar_notification_get_id( self ), reason );
+		}
 	}
+}
 
-	g_clear_object( &self->popup_notifications );
-	g_clear_object( &self->sorted_notifications );
-	g_clear_object( &self->notifications );
-	g_clear_object( &self->skeleton );
-	g_clear_handle_id( &self->bus_owner_id, g_bus_unown_name );
-	g_clear_pointer( &self->cache_path, g_free );
+//
+// Called when an action is removed from a notification, resetting its weak reference to the notification.
+//
+void foobar_notification_free_action( gpointer action )
+{
+	FoobarNotificationAction* object = (FoobarNotificationAction*)action;
+	object->notification = NULL;
+	g_object_unref( object );
+}
+
+//
+// Check whether a variant holds valid raw image data in the format of the "image-data" hint. Only 8-bit RGB(A) images
+// are supported, and the pixel data needs to cover all rows.
+//
+gboolean image_data_is_valid( GVariant* value )
+{
+	if ( !g_variant_is_of_type( value, G_VARIANT_TYPE( IMAGE_DATA_TYPE ) ) ) { return FALSE; }
 
-	g_mutex_clear( &self->write_cache_mutex );
+	gint32 width, height, row_stride, bits_per_sample, channels;
+	gboolean has_alpha;
+	g_autoptr( GVariant ) pixels_variant = NULL;
+	g_variant_get(
+		value,
+		"(iiibii@ay)",
+		&width,
+		&height,
+		&row_stride,
+		&has_alpha,
+		&bits_per_sample,
+		&channels,
+		&pixels_variant );
 
-	G_OBJECT_CLASS( foobar_notification_service_parent_class )->finalize( object );
+	if ( width <= 0 || height <= 0 || bits_per_sample != 8 || channels != ( has_alpha ? 4 : 3 ) ) { return FALSE; }
+	if ( row_stride / channels < width ) { return FALSE; }
+
+	gsize min_size = (gsize)row_stride * (gsize)( height - 1 ) + (gsize)width * (gsize)channels;
+	return g_variant_get_size( pixels_variant ) >= min_size;
 }
 
-// ---------------------------------------------------------------------------------------------------------------------
-// Public API
-// ---------------------------------------------------------------------------------------------------------------------
+//
+// Decode an image file, letting the loader downscale it to IMAGE_SIZE while decoding if it supports that.
+//
+GdkPixbuf* image_decode_file(
+	gchar const* path,
+	GError**     error )
+{
+	g_autoptr( GMappedFile ) file = g_mapped_file_new( path, FALSE, error );
+	if ( !file ) { return NULL; }
+
+	g_autoptr( GdkPixbufLoader ) loader = gdk_pixbuf_loader_new( );
+	g_signal_connect( loader, "size-prepared", G_CALLBACK( image_handle_size_prepared ), NULL );
+
+	guchar const* data = (guchar const*)g_mapped_file_get_contents( file );
+	gsize length = g_mapped_file_get_length( file );
+	if ( !gdk_pixbuf_loader_write( loader, data, length, error ) )
+	{
+		gdk_pixbuf_loader_close( loader, NULL );
+		return NULL;
+	}
+
+	if ( !gdk_pixbuf_loader_close( loader, error ) ) { return NULL; }
+
+	GdkPixbuf* pixbuf = gdk_pixbuf_loader_get_pixbuf( loader );
+	if ( !pixbuf )
+	{
+		g_set_error( error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED, "Unable to decode %s", path );
+		return NULL;
+	}
+
+	return g_object_ref( pixbuf );
+}
 
 //
-// Create a new notification service instance.
+// Check whether raw image data (which must be valid) can be displayed without downscaling it.
 //
-FoobarNotificationService* foobar_notification_service_new( void )
+gboolean image_data_fits( GVariant* value )
 {
-	return g_object_new( FOOBAR_TYPE_NOTIFICATION_SERVICE, NULL );
+	gint32 width, height;
+	g_variant_get_child( value, 0, "i", &width );
+	g_variant_get_child( value, 1, "i", &height );
+	return width <= IMAGE_SIZE && height <= IMAGE_SIZE;
 }
 
 //
-// Get a sorted list of all notifications.
+// Create a texture from valid raw image data, referencing the pixel data without copying it.
 //
-GListModel* foobar_notification_service_get_notifications( FoobarNotificationService* self )
+GdkTexture* image_texture_new_for_variant( GVariant* value )
 {
-	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ), NULL );
-	return G_LIST_MODEL( self->sorted_notifications );
+	gint32 width, height, row_stride, bits_per_sample, channels;
+	gboolean has_alpha;
+	g_autoptr( GVariant ) pixels_variant = NULL;
+	g_variant_get(
+		value,
+		"(iiibii@ay)",
+		&width,
+		&height,
+		&row_stride,
+		&has_alpha,
+		&bits_per_sample,
+		&channels,
+		&pixels_variant );
+
+	g_autoptr( GBytes ) pixels = g_variant_get_data_as_bytes( pixels_variant );
+	return gdk_memory_texture_new(
+		width,
+		height,
+		has_alpha ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8,
+		pixels,
+		row_stride );
 }
 
 //
-// Get a sorted list of all visible notifications (i.e. notifications that are not dismissed).
+// Create a texture from serialized raw image data in the format of the "image-data" hint, downscaling it to IMAGE_SIZE
+// if necessary.
 //
-GListModel* foobar_notification_service_get_popup_notifications( FoobarNotificationService* self )
+GdkTexture* image_texture_new_for_contents(
+	GBytes*  contents,
+	GError** error )
 {
-	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ), NULL );
-	return G_LIST_MODEL( self->popup_notifications );
+	g_autoptr( GVariant ) image_data = g_variant_ref_sink(
+		g_variant_new_from_bytes( G_VARIANT_TYPE( IMAGE_DATA_TYPE ), contents, FALSE ) );
+	if ( !image_data_is_valid( image_data ) )
+	{
+		g_set_error_literal( error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_CORRUPT_IMAGE, "Invalid raw image data." );
+		return NULL;
+	}
+
+	if ( image_data_fits( image_data ) ) { return image_texture_new_for_variant( image_data ); }
+
+	gint32 width, height, row_stride, bits_per_sample, channels;
+	gboolean has_alpha;
+	g_autoptr( GVariant ) pixels_variant = NULL;
+	g_variant_get(
+		image_data,
+		"(iiibii@ay)",
+		&width,
+		&height,
+		&row_stride,
+		&has_alpha,
+		&bits_per_sample,
+		&channels,
+		&pixels_variant );
+
+	g_autoptr( GBytes ) pixels = g_variant_get_data_as_bytes( pixels_variant );
+	g_autoptr( GdkPixbuf ) pixbuf = gdk_pixbuf_new_from_bytes(
+		pixels,
+		GDK_COLORSPACE_RGB,
+		has_alpha,
+		bits_per_sample,
+		width,
+		height,
+		row_stride );
+	return image_texture_new_for_pixbuf( pixbuf );
+}
+
+//
+// Called by the pixbuf loader once the image's size is known, requesting a smaller size if necessary.
+//
+void image_handle_size_prepared(
+	GdkPixbufLoader* loader,
+	gint             width,
+	gint             height,
+	gpointer         userdata )
+{
+	(void)userdata;
+
+	if ( width > IMAGE_SIZE || height > IMAGE_SIZE )
+	{
+		gdouble scale = MIN( (gdouble)IMAGE_SIZE / width, (gdouble)IMAGE_SIZE / height );
+		gdk_pixbuf_loader_set_size(
+			loader,
+			MAX( 1, (gint)round( width * scale ) ),
+			MAX( 1, (gint)round( height * scale ) ) );
+	}
+}
+
+//
+// Create a texture from a pixbuf, downscaling it to IMAGE_SIZE if it is still larger than that.
+//
+GdkTexture* image_texture_new_for_pixbuf( GdkPixbuf* pixbuf )
+{
+	gint width = gdk_pixbuf_get_width( pixbuf );
+	gint height = gdk_pixbuf_get_height( pixbuf );
+
+	g_autoptr( GdkPixbuf ) scaled = NULL;
+	if ( width > IMAGE_SIZE || height > IMAGE_SIZE )
+	{
+		gdouble scale = MIN( (gdouble)IMAGE_SIZE / width, (gdouble)IMAGE_SIZE / height );
+		width = MAX( 1, (gint)round( width * scale ) );
+		height = MAX( 1, (gint)round( height * scale ) );
+		scaled = gdk_pixbuf_scale_simple( pixbuf, width, height, GDK_INTERP_BILINEAR );
+		pixbuf = scaled;
+	}
+
+	g_autoptr( GBytes ) pixels = gdk_pixbuf_read_pixel_bytes( pixbuf );
+	return gdk_memory_texture_new(
+		width,
+		height,
+		gdk_pixbuf_get_has_alpha( pixbuf ) ? GDK_MEMORY_R8G8B8A8 : GDK_MEMORY_R8G8B8,
+		pixels,
+		gdk_pixbuf_get_rowstride( pixbuf ) );
+}
+
+//
+// Release the data associated with an image decoding task.
+//
+void image_load_job_free( ImageLoadJob* job )
+{
+	g_clear_pointer( &job->path, g_free );
+	g_clear_pointer( &job->contents, g_bytes_unref );
+	g_clear_object( &job->store );
+	g_clear_pointer( &job->hash, g_free );
+	g_free( job );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-// Signal Handlers
+// Notification Group
 // ---------------------------------------------------------------------------------------------------------------------
 
 //
-// Called after the process has asynchronously acquired the notification bus.
+// Static initialization for notification groups.
 //
-// This is where we can export notification daemon functionality using the corresponding DBus skeleton object.
+void foobar_notification_group_class_init( FoobarNotificationGroupClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->get_property = foobar_notification_group_get_property;
+	object_klass->finalize = foobar_notification_group_finalize;
+
+	group_props[GROUP_PROP_LATEST] = g_param_spec_object(
+		"latest",
+		"Latest",
+		"The most recent notification in the group.",
+		FOOBAR_TYPE_NOTIFICATION,
+		G_PARAM_READABLE );
+	group_props[GROUP_PROP_COUNT] = g_param_spec_uint(
+		"count",
+		"Count",
+		"Number of notifications in the group.",
+		0,
+		UINT_MAX,
+		0,
+		G_PARAM_READABLE );
+	group_props[GROUP_PROP_NOTIFICATIONS] = g_param_spec_object(
+		"notifications",
+		"Notifications",
+		"Sorted list of all notifications in the group.",
+		G_TYPE_LIST_MODEL,
+		G_PARAM_READABLE );
+	g_object_class_install_properties( object_klass, N_GROUP_PROPS, group_props );
+}
+
 //
-void foobar_notification_service_handle_bus_acquired(
-	GDBusConnection* connection,
-	gchar const*     name,
-	gpointer         userdata )
+// Instance initialization for notification groups.
+//
+void foobar_notification_group_init( FoobarNotificationGroup* self )
 {
-	(void)name;
-	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+	self->notifications = g_list_store_new( FOOBAR_TYPE_NOTIFICATION );
+}
 
-	self->skeleton = foobar_notifications_skeleton_new( );
-	g_signal_connect(
-		self->skeleton,
-		"handle-notify",
-		G_CALLBACK( foobar_notification_service_handle_notify ),
-		self );
-	g_signal_connect(
-		self->skeleton,
-		"handle-close-notification",
-		G_CALLBACK( foobar_notification_service_handle_close_notification ),
-		self );
-	g_signal_connect(
-		self->skeleton,
-		"handle-get-capabilities",
-		G_CALLBACK( foobar_notification_service_handle_get_capabilities ),
-		self );
-	g_signal_connect(
-		self->skeleton,
-		"handle-get-server-information",
-		G_CALLBACK( foobar_notification_service_handle_get_server_information ),
-		self );
+//
+// Property getter implementation, mapping a property id to a method.
+//
+void foobar_notification_group_get_property(
+	GObject*    object,
+	guint       prop_id,
+	GValue*     value,
+	GParamSpec* pspec )
+{
+	FoobarNotificationGroup* self = (FoobarNotificationGroup*)object;
+
+	switch ( prop_id )
+	{
+		case GROUP_PROP_LATEST:
+			g_value_set_object( value, foobar_notification_group_get_latest( self ) );
+			break;
+		case GROUP_PROP_COUNT:
+			g_value_set_uint( value, foobar_notification_group_get_count( self ) );
+			break;
+		case GROUP_PROP_NOTIFICATIONS:
+			g_value_set_object( value, foobar_notification_group_get_notifications( self ) );
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
+			break;
+	}
+}
+
+//
+// Instance cleanup for notification groups.
+//
+void foobar_notification_group_finalize( GObject* object )
+{
+	FoobarNotificationGroup* self = (FoobarNotificationGroup*)object;
+
+	self->latest = NULL;
+	g_clear_object( &self->notifications );
+	g_clear_pointer( &self->key, g_free );
+
+	G_OBJECT_CLASS( foobar_notification_group_parent_class )->finalize( object );
+}
+
+//
+// Create a new, empty group for notifications with the given group key.
+//
+FoobarNotificationGroup* foobar_notification_group_new( gchar const* key )
+{
+	FoobarNotificationGroup* self = g_object_new( FOOBAR_TYPE_NOTIFICATION_GROUP, NULL );
+	self->key = g_strdup( key );
+	return self;
+}
+
+//
+// The most recent notification in the group.
+//
+FoobarNotification* foobar_notification_group_get_latest( FoobarNotificationGroup* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_GROUP( self ), NULL );
+	return self->latest;
+}
+
+//
+// Number of notifications in the group.
+//
+guint foobar_notification_group_get_count( FoobarNotificationGroup* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_GROUP( self ), 0 );
+	return g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) );
+}
+
+//
+// Get a sorted list of all notifications in the group (newest first).
+//
+GListModel* foobar_notification_group_get_notifications( FoobarNotificationGroup* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_GROUP( self ), NULL );
+	return G_LIST_MODEL( self->notifications );
+}
+
+//
+// Close all notifications in the group, removing them from the parent service's list.
+//
+void foobar_notification_group_close( FoobarNotificationGroup* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_GROUP( self ) );
+
+	// Closing a notification removes it from the group, so the notifications are collected first.
+
+	guint count = foobar_notification_group_get_count( self );
+	if ( count == 0 ) { return; }
+
+	g_autoptr( GPtrArray ) notifications = g_ptr_array_new_full( count, g_object_unref );
+	for ( guint i = 0; i < count; ++i )
+	{
+		g_ptr_array_add( notifications, g_list_model_get_item( G_LIST_MODEL( self->notifications ), i ) );
+	}
+
+	// All notifications in a group belong to the same service.
+
+	FoobarNotificationService* service = ( (FoobarNotification*)g_ptr_array_index( notifications, 0 ) )->service;
+	if ( service ) { foobar_notification_service_defer_removals( service ); }
+
+	for ( guint i = 0; i < notifications->len; ++i )
+	{
+		foobar_notification_close( g_ptr_array_index( notifications, i ) );
+	}
+
+	if ( service ) { foobar_notification_service_commit_removals( service ); }
+}
+
+//
+// Insert a notification at its position in the group according to its timestamp.
+//
+void foobar_notification_group_insert(
+	FoobarNotificationGroup* self,
+	FoobarNotification*      notification )
+{
+	g_list_store_insert_sorted( self->notifications, notification, foobar_notification_service_sort_func, NULL );
+	g_object_notify_by_pspec( G_OBJECT( self ), group_props[GROUP_PROP_COUNT] );
+	foobar_notification_group_update_latest( self );
+}
+
+//
+// Remove a notification from the group, if it is part of it.
+//
+void foobar_notification_group_remove(
+	FoobarNotificationGroup* self,
+	FoobarNotification*      notification )
+{
+	guint position;
+	if ( !g_list_store_find( self->notifications, notification, &position ) ) { return; }
+
+	g_list_store_remove( self->notifications, position );
+	g_object_notify_by_pspec( G_OBJECT( self ), group_props[GROUP_PROP_COUNT] );
+	foobar_notification_group_update_latest( self );
+}
+
+//
+// Update the reference to the most recent notification after the list of notifications changed.
+//
+void foobar_notification_group_update_latest( FoobarNotificationGroup* self )
+{
+	// The list store keeps a reference to the notification, so the reference returned here can be released right away.
+
+	g_autoptr( FoobarNotification ) latest = g_list_model_get_item( G_LIST_MODEL( self->notifications ), 0 );
+	if ( self->latest != latest )
+	{
+		self->latest = latest;
+		g_object_notify_by_pspec( G_OBJECT( self ), group_props[GROUP_PROP_LATEST] );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Service Implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the notification service.
+//
+void foobar_notification_service_class_init( FoobarNotificationServiceClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->get_property = foobar_notification_service_get_property;
+	object_klass->finalize = foobar_notification_service_finalize;
+
+	props[PROP_NOTIFICATIONS] = g_param_spec_object(
+		"notifications",
+		"Notifications",
+		"Sorted list of all notifications.",
+		G_TYPE_LIST_MODEL,
+		G_PARAM_READABLE );
+	props[PROP_POPUP_NOTIFICATIONS] = g_param_spec_object(
+		"popup-notifications",
+		"Popup Notifications",
+		"Sorted list of all visible notifications (i.e. notifications that are not dismissed).",
+		G_TYPE_LIST_MODEL,
+		G_PARAM_READABLE );
+	props[PROP_GROUPS] = g_param_spec_object(
+		"groups",
+		"Groups",
+		"Sorted list of notification groups, one for each application.",
+		G_TYPE_LIST_MODEL,
+		G_PARAM_READABLE );
+	props[PROP_SEARCH_RESULTS] = g_param_spec_object(
+		"search-results",
+		"Search Results",
+		"Sorted list of all notifications matching the current search query.",
+		G_TYPE_LIST_MODEL,
+		G_PARAM_READABLE );
+	g_object_class_install_properties( object_klass, N_PROPS, props );
+
+	signals[SIGNAL_MINUTE_TICK] = g_signal_new(
+		"minute-tick",
+		FOOBAR_TYPE_NOTIFICATION_SERVICE,
+		G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+		0,
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		0 );
+}
+
+//
+// Instance initialization for the notification service.
+//
+void foobar_notification_service_init( FoobarNotificationService* self )
+{
+	self->notifications = g_list_store_new( FOOBAR_TYPE_NOTIFICATION );
+	self->positions = g_hash_table_new( g_direct_hash, g_direct_equal );
+	self->stale_position = G_MAXUINT;
+	self->retention = foobar_notification_retention_new( );
+	self->timeouts = foobar_notification_timeouts_new( );
+	self->pending = g_ptr_array_new_with_free_func( g_object_unref );
+	self->group_leaders = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+	self->groups = g_list_store_new( FOOBAR_TYPE_NOTIFICATION_GROUP );
+	self->groups_by_key = g_hash_table_new( g_str_hash, g_str_equal );
+
+	g_autofree gchar* image_directory = foobar_get_cache_path( "notification-images" );
+	self->image_store = foobar_notification_image_store_new( image_directory );
+
+	GtkCustomSorter* sorter = gtk_custom_sorter_new( foobar_notification_service_sort_func, NULL, NULL );
+	self->sorted_notifications = gtk_sort_list_model_new(
+		G_LIST_MODEL( g_object_ref( self->notifications ) ),
+		GTK_SORTER( sorter ) );
+
+	GtkCustomFilter* popup_filter = gtk_custom_filter_new( foobar_notification_service_popup_filter_func, NULL, NULL );
+	self->popup_notifications = gtk_filter_list_model_new(
+		G_LIST_MODEL( g_object_ref( self->sorted_notifications ) ),
+		GTK_FILTER( popup_filter ) );
+
+	GtkCustomFilter* search_filter = gtk_custom_filter_new( foobar_notification_service_search_filter_func, self, NULL );
+	self->search_results = gtk_filter_list_model_new(
+		G_LIST_MODEL( g_object_ref( self->sorted_notifications ) ),
+		GTK_FILTER( search_filter ) );
+}
+
+//
+// Property getter implementation, mapping a property id to a method.
+//
+void foobar_notification_service_get_property( GObject* object, guint prop_id, GValue* value, GParamSpec* pspec )
+{
+	FoobarNotificationService* self = (FoobarNotificationService*)object;
+
+	switch ( prop_id )
+	{
+		case PROP_NOTIFICATIONS:
+			g_value_set_object( value, foobar_notification_service_get_notifications( self ) );
+			break;
+		case PROP_POPUP_NOTIFICATIONS:
+			g_value_set_object( value, foobar_notification_service_get_popup_notifications( self ) );
+			break;
+		case PROP_GROUPS:
+			g_value_set_object( value, foobar_notification_service_get_groups( self ) );
+			break;
+		case PROP_SEARCH_RESULTS:
+			g_value_set_object( value, foobar_notification_service_get_search_results( self ) );
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
+			break;
+	}
+}
+
+//
+// Instance cleanup for the notification service.
+//
+void foobar_notification_service_finalize( GObject* object )
+{
+	FoobarNotificationService* self = (FoobarNotificationService*)object;
+
+	if ( self->skeleton ) { g_dbus_interface_skeleton_unexport( G_DBUS_INTERFACE_SKELETON( self->skeleton ) ); }
+	if ( self->journal ) { foobar_notification_journal_close( self->journal ); }
+	g_clear_handle_id( &self->ingest_id, g_source_remove );
+	if ( self->scheduler_service )
+	{
+		foobar_scheduler_service_clear( self->scheduler_service, &self->retention_id );
+		foobar_scheduler_service_clear( self->scheduler_service, &self->minute_tick_id );
+		foobar_scheduler_service_clear( self->scheduler_service, &self->timeouts_id );
+	}
+
+	for ( guint i = 0; i < self->pending->len; ++i )
+	{
+		FoobarNotification* notification = g_ptr_array_index( self->pending, i );
+		notification->service = NULL;
+	}
+
+	for ( guint i = 0; i < g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) ); ++i )
+	{
+		g_autoptr( FoobarNotification ) notification = g_list_model_get_item( G_LIST_MODEL( self->notifications ), i );
+		notification->service = NULL;
+		notification->history_group = NULL;
+	}
+
+	g_clear_object( &self->search_results );
+	g_clear_object( &self->popup_notifications );
+	g_clear_object( &self->sorted_notifications );
+	g_clear_object( &self->notifications );
+	g_clear_pointer( &self->positions, g_hash_table_unref );
+	g_clear_pointer( &self->removed_positions, g_array_unref );
+	g_clear_pointer( &self->pending, g_ptr_array_unref );
+	g_clear_pointer( &self->group_leaders, g_hash_table_unref );
+	g_clear_pointer( &self->groups_by_key, g_hash_table_unref );
+	g_clear_object( &self->groups );
+	g_clear_object( &self->search_index );
+	g_clear_pointer( &self->search_query, g_free );
+	g_clear_pointer( &self->search_matches, g_hash_table_unref );
+	g_clear_object( &self->skeleton );
+	g_clear_handle_id( &self->bus_owner_id, g_bus_unown_name );
+	g_clear_object( &self->journal );
+	g_clear_object( &self->image_store );
+	g_clear_object( &self->retention );
+	g_clear_object( &self->timeouts );
+	g_clear_object( &self->scheduler_service );
+
+	G_OBJECT_CLASS( foobar_notification_service_parent_class )->finalize( object );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Create a new notification service instance.
+//
+// The history is loaded and the service starts listening for notifications once the scheduler is available, because
+// restored popups immediately start their timeouts.
+//
+FoobarNotificationService* foobar_notification_service_new( FoobarSchedulerService* scheduler_service )
+{
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( scheduler_service ), NULL );
+
+	FoobarNotificationService* self = g_object_new( FOOBAR_TYPE_NOTIFICATION_SERVICE, NULL );
+	self->scheduler_service = g_object_ref( scheduler_service );
+
+	FOOBAR_TRACE_SPAN( "notification journal", foobar_notification_service_load_journal( self ) );
+	foobar_notification_image_store_prune( self->image_store );
+
+	self->bus_owner_id = g_bus_own_name(
+		G_BUS_TYPE_SESSION,
+		"org.freedesktop.Notifications",
+		G_BUS_NAME_OWNER_FLAGS_NONE,
+		foobar_notification_service_handle_bus_acquired,
+		NULL,
+		foobar_notification_service_handle_bus_lost,
+		self,
+		NULL );
+
+	return self;
+}
+
+//
+// Get a sorted list of all notifications.
+//
+GListModel* foobar_notification_service_get_notifications( FoobarNotificationService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ), NULL );
+	return G_LIST_MODEL( self->sorted_notifications );
+}
+
+//
+// Get a sorted list of all visible notifications (i.e. notifications that are not dismissed).
+//
+GListModel* foobar_notification_service_get_popup_notifications( FoobarNotificationService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ), NULL );
+	return G_LIST_MODEL( self->popup_notifications );
+}
+
+//
+// Get a list of all notification groups, sorted by the timestamp of their latest notification in descending order.
+//
+GListModel* foobar_notification_service_get_groups( FoobarNotificationService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ), NULL );
+	return G_LIST_MODEL( self->groups );
+}
+
+//
+// Get a sorted list of all notifications matching the current search query (see
+// foobar_notification_service_set_search_query).
+//
+GListModel* foobar_notification_service_get_search_results( FoobarNotificationService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ), NULL );
+	return G_LIST_MODEL( self->search_results );
+}
+
+//
+// Update the query for the list of search results. Notifications match if each word of the query is the prefix of a
+// word in their application name, summary or body. An empty query matches all notifications.
+//
+void foobar_notification_service_set_search_query(
+	FoobarNotificationService* self,
+	gchar const*               query )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ) );
+
+	if ( !g_strcmp0( self->search_query, query ) ) { return; }
+
+	g_autofree gchar* previous_query = g_steal_pointer( &self->search_query );
+	g_autoptr( GHashTable ) previous_matches = g_steal_pointer( &self->search_matches );
+	self->search_query = g_strdup( query );
+
+	if ( query && *query )
+	{
+		if ( !self->search_index ) { foobar_notification_service_build_search_index( self ); }
+		self->search_matches = foobar_notification_search_index_query( self->search_index, query );
+	}
+
+	// Typing more characters can only narrow down the results and deleting characters can only widen them, so the filter
+	// only needs to re-check the remaining results or the excluded notifications, respectively.
+
+	GtkFilterChange change;
+	if ( !previous_matches && !self->search_matches )
+	{
+		return;
+	}
+	else if ( !previous_matches || ( self->search_matches && g_str_has_prefix( query, previous_query ) ) )
+	{
+		change = GTK_FILTER_CHANGE_MORE_STRICT;
+	}
+	else if ( !self->search_matches || g_str_has_prefix( previous_query, query ) )
+	{
+		change = GTK_FILTER_CHANGE_LESS_STRICT;
+	}
+	else
+	{
+		change = GTK_FILTER_CHANGE_DIFFERENT;
+	}
+
+	gtk_filter_changed( gtk_filter_list_model_get_filter( self->search_results ), change );
+}
+
+//
+// Start emitting the "minute-tick" signal at the start of every minute, until a matching call to
+// foobar_notification_service_release_minute_tick.
+//
+// Views displaying relative timestamps hold the tick while they are mapped, so no timer runs while nothing is visible.
+//
+void foobar_notification_service_hold_minute_tick( FoobarNotificationService* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ) );
+
+	if ( !self->minute_tick_holds++ ) { foobar_notification_service_schedule_minute_tick( self ); }
+}
+
+//
+// Release a hold of the "minute-tick" signal acquired with foobar_notification_service_hold_minute_tick.
+//
+void foobar_notification_service_release_minute_tick( FoobarNotificationService* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ) );
+	g_return_if_fail( self->minute_tick_holds > 0 );
+
+	if ( !--self->minute_tick_holds )
+	{
+		foobar_scheduler_service_clear( self->scheduler_service, &self->minute_tick_id );
+	}
+}
+
+//
+// Update the limits for the notification history, closing the oldest notifications once the history contains more
+// than max_count notifications, notifications older than max_age or more than max_size bytes. A limit of zero disables
+// the respective check.
+//
+void foobar_notification_service_set_history_limits(
+	FoobarNotificationService* self,
+	guint                      max_count,
+	GTimeSpan                  max_age,
+	guint64                    max_size )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_SERVICE( self ) );
+
+	foobar_notification_retention_set_limits( self->retention, max_count, max_age, max_size );
+	foobar_notification_service_enforce_retention( self );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Signal Handlers
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Called after the process has asynchronously acquired the notification bus.
+//
+// This is where we can export notification daemon functionality using the corresponding DBus skeleton object.
+//
+void foobar_notification_service_handle_bus_acquired(
+	GDBusConnection* connection,
+	gchar const*     name,
+	gpointer         userdata )
+{
+	(void)name;
+	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+
+	self->skeleton = foobar_notifications_skeleton_new( );
+	g_signal_connect(
+		self->skeleton,
+		"handle-notify",
+		G_CALLBACK( foobar_notification_service_handle_notify ),
+		self );
+	g_signal_connect(
+		self->skeleton,
+		"handle-close-notification",
+		G_CALLBACK( foobar_notification_service_handle_close_notification ),
+		self );
+	g_signal_connect(
+		self->skeleton,
+		"handle-get-capabilities",
+		G_CALLBACK( foobar_notification_service_handle_get_capabilities ),
+		self );
+	g_signal_connect(
+		self->skeleton,
+		"handle-get-server-information",
+		G_CALLBACK( foobar_notification_service_handle_get_server_information ),
+		self );
+
+	g_autoptr( GError ) error = NULL;
+	if ( !g_dbus_interface_skeleton_export(
+			G_DBUS_INTERFACE_SKELETON( self->skeleton ),
+			connection,
+			"/org/freedesktop/Notifications",
+			&error ) )
+	{
+		g_warning( "Unable to export notifications interface: %s", error->message );
+	}
+}
+
+//
+// Called after the process has failed to acquire the notification bus.
+//
+void foobar_notification_service_handle_bus_lost(
+	GDBusConnection* connection,
+	gchar const*     name,
+	gpointer         userdata )
+{
+	(void)connection;
+	(void)name;
+	(void)userdata;
+
+	g_autofree gchar* other_name = NULL;
+	g_autoptr( FoobarNotifications ) proxy = foobar_notifications_proxy_new_for_bus_sync(
+		G_BUS_TYPE_SESSION,
+		G_DBUS_PROXY_FLAGS_NONE,
+		"org.freedesktop.Notifications",
+		"/org/freedesktop/Notifications",
+		NULL,
+		NULL );
+
+	if ( proxy )
+	{
+		foobar_notifications_call_get_server_information_sync(
+			proxy,
+			&other_name,
+			NULL,
+			NULL,
+			NULL,
+			NULL,
+			NULL );
+	}
+
+	g_warning(
+		"Unable to register notification daemon because %s is already running.",
+		other_name ? other_name : "(unknown)" );
+}
+
+//
+// Find the notification with the given ID using the index, optionally also returning its position in the list.
+//
+// Returns a new reference to the notification, or NULL if there is no notification with this ID.
+//
+FoobarNotification* foobar_notification_service_lookup(
+	FoobarNotificationService* self,
+	guint                      id,
+	guint*                     out_position )
+{
+	gpointer position;
+	if ( !g_hash_table_lookup_extended( self->positions, GUINT_TO_POINTER( id ), NULL, &position ) ) { return NULL; }
+
+	if ( GPOINTER_TO_UINT( position ) >= self->stale_position )
+	{
+		foobar_notification_service_reindex( self );
+		position = g_hash_table_lookup( self->positions, GUINT_TO_POINTER( id ) );
+	}
+
+	if ( out_position ) { *out_position = GPOINTER_TO_UINT( position ); }
+	return g_list_model_get_item( G_LIST_MODEL( self->notifications ), GPOINTER_TO_UINT( position ) );
+}
+
+//
+// Recompute the stale part of the index after notifications were removed from the list.
+//
+// Only notifications which are still in the index are updated, because notifications whose removal from the list store
+// was deferred are still part of the list at this point.
+//
+void foobar_notification_service_reindex( FoobarNotificationService* self )
+{
+	guint count = g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) );
+	for ( guint i = self->stale_position; i < count; ++i )
+	{
+		g_autoptr( FoobarNotification ) notification = g_list_model_get_item( G_LIST_MODEL( self->notifications ), i );
+		gpointer id = GUINT_TO_POINTER( foobar_notification_get_id( notification ) );
+		if ( g_hash_table_contains( self->positions, id ) )
+		{
+			g_hash_table_insert( self->positions, id, GUINT_TO_POINTER( i ) );
+		}
+	}
+
+	self->stale_position = G_MAXUINT;
+}
+
+//
+// Add a notification to the end of the list and the index.
+//
+void foobar_notification_service_append(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	guint position = g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) );
+	g_hash_table_insert(
+		self->positions,
+		GUINT_TO_POINTER( foobar_notification_get_id( notification ) ),
+		GUINT_TO_POINTER( position ) );
+	foobar_notification_service_index( self, notification );
+	g_list_store_append( self->notifications, notification );
+	foobar_notification_service_track( self, notification );
+	foobar_notification_service_attach_group( self, notification );
+}
+
+//
+// Remove a notification from the list and the index, returning FALSE if it is not part of the list.
+//
+gboolean foobar_notification_service_remove(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	guint position;
+	g_autoptr( FoobarNotification ) current = foobar_notification_service_lookup(
+		self,
+		foobar_notification_get_id( notification ),
+		&position );
+	if ( current != notification ) { return FALSE; }
+
+	// The index is updated before the list store because handlers of "items-changed" might already look up other
+	// notifications. Only the index entries are touched here, not the notifications themselves.
+
+	g_hash_table_remove( self->positions, GUINT_TO_POINTER( foobar_notification_get_id( notification ) ) );
+	foobar_notification_retention_untrack( self->retention, foobar_notification_get_id( notification ) );
+	foobar_notification_service_cancel_timeout( self, notification );
+	foobar_notification_service_detach_group( self, notification );
+	if ( self->search_index )
+	{
+		foobar_notification_search_index_remove( self->search_index, foobar_notification_get_id( notification ) );
+	}
+
+	// A removed group leader releases its collapsed notifications, and a removed member no longer counts for its group.
+
+	foobar_notification_service_ungroup( self, notification );
+	if ( notification->group_leader )
+	{
+		FoobarNotification* leader = notification->group_leader;
+		notification->group_leader = NULL;
+		notification->is_collapsed = FALSE;
+		g_ptr_array_remove( leader->group, notification );
+		g_object_notify_by_pspec( G_OBJECT( leader ), notification_props[NOTIFICATION_PROP_GROUP_SIZE] );
+	}
+
+	if ( self->removed_positions )
+	{
+		g_array_append_val( self->removed_positions, position );
+	}
+	else
+	{
+		self->stale_position = MIN( self->stale_position, position );
+		g_list_store_remove( self->notifications, position );
+	}
+
+	return TRUE;
+}
+
+//
+// Start deferring the removal of closed notifications from the list store until
+// foobar_notification_service_commit_removals is called.
+//
+// While removals are deferred, closed notifications are already removed from the index, but the list and therefore the
+// positions of the remaining notifications don't change.
+//
+void foobar_notification_service_defer_removals( FoobarNotificationService* self )
+{
+	g_return_if_fail( self->removed_positions == NULL );
+
+	self->removed_positions = g_array_new( FALSE, FALSE, sizeof( guint ) );
+}
+
+//
+// Remove all notifications that were closed since foobar_notification_service_defer_removals was called from the list
+// store, using a single splice for each contiguous range.
+//
+void foobar_notification_service_commit_removals( FoobarNotificationService* self )
+{
+	g_autoptr( GArray ) positions = g_steal_pointer( &self->removed_positions );
+	if ( !positions || positions->len == 0 ) { return; }
+
+	// Ranges are removed back to front, so the positions of the ranges before them remain valid.
+
+	g_array_sort( positions, foobar_notification_service_compare_position );
+	self->stale_position = MIN( self->stale_position, g_array_index( positions, guint, positions->len - 1 ) );
+
+	guint i = 0;
+	while ( i < positions->len )
+	{
+		guint end = g_array_index( positions, guint, i );
+		guint start = end;
+		for ( ++i; i < positions->len && g_array_index( positions, guint, i ) == start - 1; ++i ) { start -= 1; }
+
+		g_list_store_splice( self->notifications, start, end - start + 1, NULL, 0 );
+	}
+}
+
+//
+// Add a notification to the eviction index or update its timestamp and size.
+//
+void foobar_notification_service_track(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	foobar_notification_retention_track(
+		self->retention,
+		foobar_notification_get_id( notification ),
+		foobar_notification_get_unix_time( notification ),
+		foobar_notification_get_retained_size( notification ) );
+}
+
+//
+// Add a notification to the history group of its application, or update its position within the group after it was
+// replaced. A replacement from another application moves the notification to that application's group.
+//
+void foobar_notification_service_attach_group(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	gchar const* key = foobar_notification_get_group_key( notification );
+	if ( !key ) { key = ""; }
+
+	FoobarNotificationGroup* group = notification->history_group;
+	if ( group && !g_strcmp0( group->key, key ) )
+	{
+		foobar_notification_group_remove( group, notification );
+		foobar_notification_group_insert( group, notification );
+		foobar_notification_service_reorder_group( self, group );
+		return;
+	}
+
+	foobar_notification_service_detach_group( self, notification );
+
+	group = g_hash_table_lookup( self->groups_by_key, key );
+	if ( group )
+	{
+		notification->history_group = group;
+		foobar_notification_group_insert( group, notification );
+		foobar_notification_service_reorder_group( self, group );
+		return;
+	}
+
+	// The lookup table uses the group's own copy of the key, so it does not need to own anything.
+
+	g_autoptr( FoobarNotificationGroup ) new_group = foobar_notification_group_new( key );
+	notification->history_group = new_group;
+	foobar_notification_group_insert( new_group, notification );
+	g_hash_table_insert( self->groups_by_key, new_group->key, new_group );
+	new_group->sorted_time = foobar_notification_get_unix_time( new_group->latest );
+	g_list_store_insert_sorted( self->groups, new_group, foobar_notification_service_group_sort_func, NULL );
+}
+
+//
+// Remove a notification from its history group, removing the group itself once it is empty.
+//
+void foobar_notification_service_detach_group(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	FoobarNotificationGroup* group = notification->history_group;
+	if ( !group ) { return; }
+
+	notification->history_group = NULL;
+	foobar_notification_group_remove( group, notification );
+	if ( foobar_notification_group_get_count( group ) )
+	{
+		foobar_notification_service_reorder_group( self, group );
+		return;
+	}
+
+	guint position;
+	g_hash_table_remove( self->groups_by_key, group->key );
+	if ( foobar_notification_service_find_group( self, group, &position ) )
+	{
+		g_list_store_remove( self->groups, position );
+	}
+}
+
+//
+// Move a group to its new position in the list of groups after its latest notification changed.
+//
+void foobar_notification_service_reorder_group(
+	FoobarNotificationService* self,
+	FoobarNotificationGroup*   group )
+{
+	guint position;
+	if ( !foobar_notification_service_find_group( self, group, &position ) ) { return; }
+	group->sorted_time = foobar_notification_get_unix_time( group->latest );
+
+	// Most of the time, a new notification is added to the group that already is at the front, so nothing is moved.
+	// Moving a group collapses its row in a tree list model, so this is also avoided if the order is still correct.
+
+	GListModel* model = G_LIST_MODEL( self->groups );
+	guint count = g_list_model_get_n_items( model );
+	g_autoptr( FoobarNotificationGroup ) previous = position > 0 ? g_list_model_get_item( model, position - 1 ) : NULL;
+	g_autoptr( FoobarNotificationGroup ) next = position + 1 < count ? g_list_model_get_item( model, position + 1 ) : NULL;
+	if ( ( !previous || foobar_notification_service_group_sort_func( previous, group, NULL ) <= 0 ) &&
+		( !next || foobar_notification_service_group_sort_func( group, next, NULL ) <= 0 ) )
+	{
+		return;
+	}
+
+	g_object_ref( group );
+	g_list_store_remove( self->groups, position );
+	g_list_store_insert_sorted( self->groups, group, foobar_notification_service_group_sort_func, NULL );
+	g_object_unref( group );
+}
+
+//
+// Find the position of a group in the list of groups using a binary search for the timestamp it is sorted by.
+//
+gboolean foobar_notification_service_find_group(
+	FoobarNotificationService* self,
+	FoobarNotificationGroup*   group,
+	guint*                     out_position )
+{
+	GListModel* model = G_LIST_MODEL( self->groups );
+	guint count = g_list_model_get_n_items( model );
+	guint start = 0;
+	guint end = count;
+	while ( start < end )
+	{
+		guint middle = start + ( end - start ) / 2;
+		g_autoptr( FoobarNotificationGroup ) current = g_list_model_get_item( model, middle );
+		if ( current->sorted_time > group->sorted_time ) { start = middle + 1; }
+		else { end = middle; }
+	}
+
+	// Groups with the same timestamp are not in any particular order.
+
+	for ( guint i = start; i < count; ++i )
+	{
+		g_autoptr( FoobarNotificationGroup ) current = g_list_model_get_item( model, i );
+		if ( current == group )
+		{
+			*out_position = i;
+			return TRUE;
+		}
+
+		if ( current->sorted_time != group->sorted_time ) { break; }
+	}
+
+	return FALSE;
+}
+
+//
+// Add a notification to the search index or replace its text, if the index was already built.
+//
+// Before the notification is inserted into the list, it is also added to or removed from the matches for the current
+// query, so the search results filter it correctly without being notified of the change.
+//
+void foobar_notification_service_index(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	if ( !self->search_index ) { return; }
+
+	guint id = foobar_notification_get_id( notification );
+	foobar_notification_search_index_add( self->search_index, id, foobar_notification_get_search_text( notification ) );
+
+	if ( self->search_matches )
+	{
+		if ( foobar_notification_search_index_matches( self->search_index, id, self->search_query ) )
+		{
+			g_hash_table_add( self->search_matches, GUINT_TO_POINTER( id ) );
+		}
+		else
+		{
+			g_hash_table_remove( self->search_matches, GUINT_TO_POINTER( id ) );
+		}
+	}
+}
+
+//
+// Build the search index from all notifications in the history, once it is searched for the first time.
+//
+// Notifications that are only known from the journal's index are not materialized for this, because their journal
+// records already store their searchable text.
+//
+void foobar_notification_service_build_search_index( FoobarNotificationService* self )
+{
+	self->search_index = foobar_notification_search_index_new( );
+
+	GListModel* model = G_LIST_MODEL( self->notifications );
+	for ( guint i = 0; i < g_list_model_get_n_items( model ); ++i )
+	{
+		g_autoptr( FoobarNotification ) notification = g_list_model_get_item( model, i );
+		foobar_notification_service_index( self, notification );
+	}
+}
+
+//
+// Schedule the next "minute-tick" signal for the start of the next minute.
+//
+// The scheduler only ever runs tasks after their deadline, so the tick never fires before the minute has actually
+// changed.
+//
+void foobar_notification_service_schedule_minute_tick( FoobarNotificationService* self )
+{
+	GTimeSpan delay = G_TIME_SPAN_MINUTE - g_get_real_time( ) % G_TIME_SPAN_MINUTE;
+	self->minute_tick_id = foobar_scheduler_service_add_deadline(
+		self->scheduler_service,
+		"notification-minute-tick",
+		g_get_monotonic_time( ) + delay,
+		MINUTE_TICK_SLACK,
+		foobar_notification_service_handle_minute_tick,
+		self );
+}
+
+//
+// Called at the start of every minute while the "minute-tick" signal is held.
+//
+// The next tick is scheduled before the signal is emitted, because handlers may release their hold.
+//
+gboolean foobar_notification_service_handle_minute_tick( gpointer userdata )
+{
+	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+
+	self->minute_tick_id = 0;
+	foobar_notification_service_schedule_minute_tick( self );
+	g_signal_emit( self, signals[SIGNAL_MINUTE_TICK], 0 );
+
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Close the oldest notifications for as long as the history exceeds one of its limits, and schedule the next check for
+// the time at which the oldest remaining notification becomes too old.
+//
+void foobar_notification_service_enforce_retention( FoobarNotificationService* self )
+{
+	foobar_scheduler_service_clear( self->scheduler_service, &self->retention_id );
+
+	foobar_notification_service_defer_removals( self );
+
+	guint id;
+	while ( foobar_notification_retention_pop_evicted( self->retention, g_get_real_time( ), &id ) )
+	{
+		g_autoptr( FoobarNotification ) notification = foobar_notification_service_lookup( self, id, NULL );
+		if ( notification ) { foobar_notification_close_with_reason( notification, CLOSED_REASON_EXPIRED ); }
+	}
+
+	foobar_notification_service_commit_removals( self );
+
+	gint64 expiration = foobar_notification_retention_get_expiration( self->retention );
+	if ( expiration >= 0 )
+	{
+		GTimeSpan delay = MAX( expiration - g_get_real_time( ), 0 );
+		self->retention_id = foobar_scheduler_service_add_deadline(
+			self->scheduler_service,
+			"notification-retention",
+			g_get_monotonic_time( ) + delay,
+			RETENTION_SLACK,
+			foobar_notification_service_handle_retention_timeout,
+			self );
+	}
+}
+
+//
+// Called once the oldest notification in the history has exceeded the age limit.
+//
+gboolean foobar_notification_service_handle_retention_timeout( gpointer userdata )
+{
+	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+
+	self->retention_id = 0;
+	foobar_notification_service_enforce_retention( self );
+
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Start the popup timeout of a notification, unless it is already running.
+//
+void foobar_notification_service_schedule_timeout(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	guint id = foobar_notification_get_id( notification );
+	if ( foobar_notification_timeouts_contains( self->timeouts, id ) ) { return; }
+
+	gint64 deadline = g_get_monotonic_time( ) + foobar_notification_get_timeout( notification ) * G_TIME_SPAN_MILLISECOND;
+	foobar_notification_timeouts_schedule( self->timeouts, id, deadline );
+	foobar_notification_service_update_timeouts_task( self );
+}
+
+//
+// Stop the popup timeout of a notification, if it is running.
+//
+void foobar_notification_service_cancel_timeout(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	if ( foobar_notification_timeouts_cancel( self->timeouts, foobar_notification_get_id( notification ) ) )
+	{
+		foobar_notification_service_update_timeouts_task( self );
+	}
+}
+
+//
+// Schedule the timeouts task for the earliest deadline (or cancel it if there is none).
+//
+void foobar_notification_service_update_timeouts_task( FoobarNotificationService* self )
+{
+	foobar_scheduler_service_clear( self->scheduler_service, &self->timeouts_id );
+
+	gint64 deadline = foobar_notification_timeouts_get_next_deadline( self->timeouts );
+	if ( deadline >= 0 )
+	{
+		self->timeouts_id = foobar_scheduler_service_add_deadline(
+			self->scheduler_service,
+			"notification-timeouts",
+			deadline,
+			TIMEOUT_SLACK,
+			foobar_notification_service_handle_timeouts,
+			self );
+	}
+}
+
+//
+// Called once the earliest popup timeout has elapsed, dismissing all notifications whose timeouts have elapsed so far.
+//
+gboolean foobar_notification_service_handle_timeouts( gpointer userdata )
+{
+	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+
+	// The popup filter is only notified once for the whole batch instead of once per notification.
+
+	self->timeouts_id = 0;
+
+	gint64 now = g_get_monotonic_time( );
+	gboolean has_expired = FALSE;
+	guint id;
+	self->is_dismissing_expired = TRUE;
+	while ( foobar_notification_timeouts_pop_expired( self->timeouts, now, &id ) )
+	{
+		g_autoptr( FoobarNotification ) notification = foobar_notification_service_lookup( self, id, NULL );
+		if ( notification ) { foobar_notification_dismiss( notification ); }
+		has_expired = TRUE;
+	}
+	self->is_dismissing_expired = FALSE;
+
+	if ( has_expired )
+	{
+		gtk_filter_changed(
+			gtk_filter_list_model_get_filter( self->popup_notifications ),
+			GTK_FILTER_CHANGE_MORE_STRICT );
+	}
+
+	foobar_notification_service_update_timeouts_task( self );
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Queue a new notification for the next ingestion batch.
+//
+void foobar_notification_service_enqueue(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	g_ptr_array_add( self->pending, g_object_ref( notification ) );
+
+	if ( !self->ingest_id )
+	{
+		self->ingest_id = g_timeout_add( INGEST_INTERVAL, foobar_notification_service_handle_ingest, self );
+	}
+}
+
+//
+// Add all queued notifications to the list in a single splice, group them with earlier popups and start their
+// timeouts.
+//
+// This is also called synchronously whenever a queued notification might be looked up by its ID.
+//
+void foobar_notification_service_flush( FoobarNotificationService* self )
+{
+	g_clear_handle_id( &self->ingest_id, g_source_remove );
+	if ( !self->pending->len ) { return; }
+
+	g_autoptr( GPtrArray ) batch = g_steal_pointer( &self->pending );
+	self->pending = g_ptr_array_new_with_free_func( g_object_unref );
+
+	// Notifications are grouped before any of them is indexed, so only collapsing a popup that is already part of the
+	// list requires the popup filter to be updated.
+
+	gboolean has_collapsed = FALSE;
+	for ( guint i = 0; i < batch->len; ++i )
+	{
+		has_collapsed |= foobar_notification_service_group( self, g_ptr_array_index( batch, i ) );
+	}
+
+	guint position = g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) );
+	for ( guint i = 0; i < batch->len; ++i )
+	{
+		FoobarNotification* notification = g_ptr_array_index( batch, i );
+		g_hash_table_insert(
+			self->positions,
+			GUINT_TO_POINTER( foobar_notification_get_id( notification ) ),
+			GUINT_TO_POINTER( position + i ) );
+		foobar_notification_service_track( self, notification );
+		foobar_notification_service_attach_group( self, notification );
+		foobar_notification_service_index( self, notification );
+	}
+
+	g_list_store_splice( self->notifications, position, 0, batch->pdata, batch->len );
+
+	if ( has_collapsed )
+	{
+		gtk_filter_changed(
+			gtk_filter_list_model_get_filter( self->popup_notifications ),
+			GTK_FILTER_CHANGE_MORE_STRICT );
+	}
+
+	for ( guint i = 0; i < batch->len; ++i )
+	{
+		FoobarNotification* notification = g_ptr_array_index( batch, i );
+		foobar_notification_resume_timeout( notification );
+		foobar_notification_service_record( self, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, notification );
+	}
+
+	foobar_notification_service_enforce_retention( self );
+}
+
+//
+// Called once per frame while new notifications are queued.
+//
+gboolean foobar_notification_service_handle_ingest( gpointer userdata )
+{
+	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+
+	self->ingest_id = 0;
+	foobar_notification_service_flush( self );
+
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Let a new notification take over the group of the latest popup from the same application if it arrived within
+// GROUP_WINDOW, collapsing that popup. The new notification becomes the latest popup of its application either way.
+//
+// Returns TRUE if a popup that is already part of the list was collapsed.
+//
+gboolean foobar_notification_service_group(
+	FoobarNotificationService* self,
+	FoobarNotification*        notification )
+{
+	gchar const* key = foobar_notification_get_group_key( notification );
+	if ( !key || foobar_notification_get_urgency( notification ) == FOOBAR_NOTIFICATION_URGENCY_LOSS_OF_LIFE )
+	{
+		return FALSE;
+	}
 
-	g_autoptr( GError ) error = NULL;
-	if ( !g_dbus_interface_skeleton_export(
-			G_DBUS_INTERFACE_SKELETON( self->skeleton ),
-			connection,
-			"/org/freedesktop/Notifications",
-			&error ) )
+	gboolean was_listed = FALSE;
+	FoobarNotification* leader = g_hash_table_lookup( self->group_leaders, key );
+	if ( leader &&
+			!leader->is_dismissed &&
+			!leader->is_collapsed &&
+			foobar_notification_get_urgency( leader ) != FOOBAR_NOTIFICATION_URGENCY_LOSS_OF_LIFE &&
+			notification->arrival - leader->arrival < GROUP_WINDOW )
 	{
-		g_warning( "Unable to export notifications interface: %s", error->message );
+		was_listed = g_hash_table_contains( self->positions, GUINT_TO_POINTER( foobar_notification_get_id( leader ) ) );
+		foobar_notification_service_cancel_timeout( self, leader );
+		leader->is_collapsed = TRUE;
+
+		notification->group = g_steal_pointer( &leader->group );
+		if ( !notification->group ) { notification->group = g_ptr_array_new_with_free_func( g_object_unref ); }
+		g_ptr_array_add( notification->group, g_object_ref( leader ) );
+		for ( guint i = 0; i < notification->group->len; ++i )
+		{
+			FoobarNotification* member = g_ptr_array_index( notification->group, i );
+			member->group_leader = notification;
+		}
+
+		g_object_notify_by_pspec( G_OBJECT( leader ), notification_props[NOTIFICATION_PROP_GROUP_SIZE] );
+		g_object_notify_by_pspec( G_OBJECT( notification ), notification_props[NOTIFICATION_PROP_GROUP_SIZE] );
 	}
+
+	if ( leader ) { g_clear_pointer( &leader->group_key, g_free ); }
+	notification->group_key = g_strdup( key );
+	g_hash_table_replace( self->group_leaders, g_strdup( key ), notification );
+
+	return was_listed;
 }
 
 //
-// Called after the process has failed to acquire the notification bus.
+// Release all notifications collapsed into a popup, showing them as separate popups again, and stop grouping new
+// notifications with it.
 //
-void foobar_notification_service_handle_bus_lost(
-	GDBusConnection* connection,
-	gchar const*     name,
-	gpointer         userdata )
+void foobar_notification_service_ungroup(
+	FoobarNotificationService* self,
+	FoobarNotification*        leader )
 {
-	(void)connection;
-	(void)name;
-	(void)userdata;
+	if ( leader->group_key )
+	{
+		if ( g_hash_table_lookup( self->group_leaders, leader->group_key ) == leader )
+		{
+			g_hash_table_remove( self->group_leaders, leader->group_key );
+		}
+		g_clear_pointer( &leader->group_key, g_free );
+	}
 
-	g_autofree gchar* other_name = NULL;
-	g_autoptr( FoobarNotifications ) proxy = foobar_notifications_proxy_new_for_bus_sync(
-		G_BUS_TYPE_SESSION,
-		G_DBUS_PROXY_FLAGS_NONE,
-		"org.freedesktop.Notifications",
-		"/org/freedesktop/Notifications",
-		NULL,
-		NULL );
+	if ( !leader->group ) { return; }
 
-	if ( proxy )
+	g_autoptr( GPtrArray ) members = g_steal_pointer( &leader->group );
+	for ( guint i = 0; i < members->len; ++i )
 	{
-		foobar_notifications_call_get_server_information_sync(
-			proxy,
-			&other_name,
-			NULL,
-			NULL,
-			NULL,
-			NULL,
-			NULL );
+		FoobarNotification* member = g_ptr_array_index( members, i );
+		member->group_leader = NULL;
+		member->is_collapsed = FALSE;
+		foobar_notification_resume_timeout( member );
 	}
 
-	g_warning(
-		"Unable to register notification daemon because %s is already running.",
-		other_name ? other_name : "(unknown)" );
+	g_object_notify_by_pspec( G_OBJECT( leader ), notification_props[NOTIFICATION_PROP_GROUP_SIZE] );
+	gtk_filter_changed(
+		gtk_filter_list_model_get_filter( self->popup_notifications ),
+		GTK_FILTER_CHANGE_LESS_STRICT );
 }
 
 //
@@ -1352,15 +3347,46 @@ gboolean foobar_notification_service_handle_notify(
 {
 	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
 
+	// If the notification replaces an existing one, that instance is updated in place, so views only have to process a
+	// single change of the item instead of a removal followed by an insertion. The notification to replace might still
+	// be queued, so the current batch is added first.
+
+	if ( replaces_id ) { foobar_notification_service_flush( self ); }
+
+	guint position = 0;
+	g_autoptr( FoobarNotification ) notification =
+		replaces_id ? foobar_notification_service_lookup( self, replaces_id, &position ) : NULL;
+	gboolean is_replacement = notification != NULL;
+	gboolean was_transient = FALSE;
+	if ( is_replacement )
+	{
+		was_transient = foobar_notification_is_transient( notification );
+		foobar_notification_materialize( notification );
+		foobar_notification_block_timeout( notification );
+		foobar_notification_reset_hints( notification );
+	}
+	else
+	{
+		notification = foobar_notification_new( self );
+		foobar_notification_set_id( notification, replaces_id ? replaces_id : self->next_id++ );
+		notification->arrival = g_get_monotonic_time( );
+	}
+
+	// The image is only reset if the replacement doesn't have one, so an unchanged image path doesn't cause the image to
+	// be loaded again.
+
+	gboolean has_image = FALSE;
 	g_autoptr( GDateTime ) time = g_date_time_new_now_local( );
-	g_autoptr( FoobarNotification ) notification = foobar_notification_new( self );
-	foobar_notification_set_id( notification, replaces_id ? replaces_id : self->next_id++ );
 	foobar_notification_set_app_name( notification, app_name );
 	foobar_notification_set_summary( notification, summary );
 	foobar_notification_set_body( notification, body );
 	foobar_notification_set_time( notification, time );
 	foobar_notification_set_timeout( notification, expiration != -1 ? expiration : DEFAULT_TIMEOUT );
-	if ( image && *image ) { foobar_notification_set_image_from_path( notification, image ); }
+	if ( image && *image )
+	{
+		foobar_notification_set_image_from_path( notification, image );
+		has_image = TRUE;
+	}
 
 	if ( hints )
 	{
@@ -1392,44 +3418,20 @@ gboolean foobar_notification_service_handle_notify(
 				foobar_notification_set_urgency( notification, g_variant_get_byte( value ) );
 			}
 
-			if ( !foobar_notification_get_image( notification ) )
+			if ( !has_image )
 			{
 				if ( !g_strcmp0( key_str, "image-path" ) ||
 						!g_strcmp0( key_str, "image_path" ) )
 				{
 					foobar_notification_set_image_from_path( notification, g_variant_get_string( value, NULL ) );
+					has_image = TRUE;
 				}
 				else if ( !g_strcmp0( key_str, "image-data" ) ||
 						!g_strcmp0( key_str, "image_data" ) ||
 						!g_strcmp0( key_str, "icon_data" ) )
 				{
-					gint32 width, height, row_stride, bits_per_sample, channels;
-					gboolean has_alpha;
-					g_variant_get(
-						value,
-						"(iiibiiay)",
-						&width,
-						&height,
-						&row_stride,
-						&has_alpha,
-						&bits_per_sample,
-						&channels,
-						NULL );
-
-					g_autoptr( GVariant ) data_variant = g_variant_get_child_value( value, 6 );
-					gsize data_len;
-					guint8 const* data = g_variant_get_fixed_array( data_variant, &data_len, sizeof( guint8 ) );
-					g_autoptr( GBytes ) bytes = g_bytes_new( data, data_len );
-
-					g_autoptr( GdkPixbuf ) pixbuf = gdk_pixbuf_new_from_bytes(
-						bytes,
-						GDK_COLORSPACE_RGB,
-						has_alpha,
-						bits_per_sample,
-						width,
-						height,
-						row_stride );
-					foobar_notification_set_image( notification, pixbuf );
+					foobar_notification_set_image_from_variant( notification, value );
+					has_image = image_data_is_valid( value );
 				}
 			}
 		}
@@ -1456,11 +3458,48 @@ gboolean foobar_notification_service_handle_notify(
 		}
 	}
 
-	// Add the notification to the list and start the timeout.
+	if ( !has_image && foobar_notification_has_image( notification ) )
+	{
+		foobar_notification_reset_image( notification );
+		g_object_notify_by_pspec( G_OBJECT( notification ), notification_props[NOTIFICATION_PROP_IMAGE] );
+	}
+
+	// New notifications are queued for the next batch, which also records them and starts their timeouts. A
+	// replacement lets the list know that the notification changed and restarts its timeout right away.
 
-	g_list_store_append( self->notifications, notification );
-	foobar_notification_resume_timeout( notification );
-	foobar_notification_service_write_cache( self );
+	if ( !is_replacement )
+	{
+		foobar_notification_service_enqueue( self, notification );
+	}
+	else
+	{
+		foobar_notification_service_index( self, notification );
+		g_list_store_splice( self->notifications, position, 1, (gpointer*)&notification, 1 );
+		foobar_notification_service_track( self, notification );
+		foobar_notification_service_attach_group( self, notification );
+		foobar_notification_resume_timeout( notification );
+
+		if ( was_transient )
+		{
+			foobar_notification_service_record( self, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, notification );
+		}
+		else if ( foobar_notification_is_transient( notification ) )
+		{
+			// Transient notifications are skipped when recording, so the ID is removed from the journal directly.
+
+			foobar_notification_journal_append(
+				self->journal,
+				FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE,
+				foobar_notification_get_id( notification ),
+				NULL );
+		}
+		else
+		{
+			foobar_notification_service_record( self, FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE, notification );
+		}
+
+		foobar_notification_service_enforce_retention( self );
+	}
 
 	foobar_notifications_complete_notify( iface, invocation, foobar_notification_get_id( notification ) );
 	return G_DBUS_METHOD_INVOCATION_HANDLED;
@@ -1477,15 +3516,10 @@ gboolean foobar_notification_service_handle_close_notification(
 {
 	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
 
-	for ( guint i = 0; i < g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) ); ++i )
-	{
-		FoobarNotification* notification = g_list_model_get_item( G_LIST_MODEL( self->notifications ), i );
-		if ( foobar_notification_get_id( notification ) == id )
-		{
-			foobar_notification_close( notification );
-			break;
-		}
-	}
+	foobar_notification_service_flush( self );
+
+	g_autoptr( FoobarNotification ) notification = foobar_notification_service_lookup( self, id, NULL );
+	if ( notification ) { foobar_notification_close( notification ); }
 
 	foobar_notifications_complete_close_notification( iface, invocation );
 	return G_DBUS_METHOD_INVOCATION_HANDLED;
@@ -1541,263 +3575,386 @@ gboolean foobar_notification_service_handle_get_server_information(
 // ---------------------------------------------------------------------------------------------------------------------
 
 //
-// Synchronously read the cache file at self->cache_path, populating self->notifications and initializing self->next_id.
+// Synchronously replay the notification journal, populating self->notifications and initializing self->next_id.
 //
-void foobar_notification_service_read_cache( FoobarNotificationService* self )
+// If there is no journal yet, notifications are imported from the JSON cache written by previous versions instead.
+//
+void foobar_notification_service_load_journal( FoobarNotificationService* self )
 {
-	g_autoptr( GError ) error = NULL;
+	g_autofree gchar* journal_path = foobar_get_cache_path( "notifications.journal" );
+	self->journal = foobar_notification_journal_new(
+		journal_path,
+		foobar_notification_service_snapshot_func,
+		foobar_notification_service_serialize_func,
+		self );
 
-	if ( self->cache_path && g_file_test( self->cache_path, G_FILE_TEST_EXISTS ) )
+	if ( journal_path && !foobar_notification_journal_exists( self->journal ) )
 	{
-		g_autoptr( JsonParser ) parser = json_parser_new( );
-		if ( !json_parser_load_from_mapped_file( parser, self->cache_path, &error ) )
+		g_autofree gchar* legacy_path = foobar_get_cache_path( "notifications.json" );
+		if ( legacy_path && g_file_test( legacy_path, G_FILE_TEST_EXISTS ) )
 		{
-			g_warning( "Unable to read cached notifications: %s", error->message );
-			return;
+			foobar_notification_service_import_legacy_cache( self, legacy_path );
+			foobar_notification_journal_compact( self->journal );
 		}
+		return;
+	}
 
-		JsonNode* root_node = json_parser_get_root( parser );
-		JsonArray* root_array = json_node_get_array( root_node );
-		for ( guint i = 0; i < json_array_get_length( root_array ); ++i )
-		{
-			JsonObject* notification_object = json_array_get_object_element( root_array, i );
-			g_autoptr( FoobarNotification ) notification = foobar_notification_new( self );
+	// Records are folded into the latest state per notification before anything is added to the list, so the list
+	// model only has to process a single change. Notifications from the journal's index are only created as stubs, so
+	// the startup cost does not depend on the size of the history; only records appended since the last compaction are
+	// parsed.
+
+	g_autoptr( GHashTable ) states = g_hash_table_new_full(
+		g_direct_hash,
+		g_direct_equal,
+		NULL,
+		(GDestroyNotify)json_object_unref );
+	g_autoptr( GHashTable ) stubs = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, g_object_unref );
+	JournalReplay replay = { .service = self, .states = states, .stubs = stubs };
 
-			foobar_notification_set_dismissed( notification, TRUE );
+	g_autoptr( GError ) error = NULL;
+	if ( !foobar_notification_journal_replay_indexed(
+			self->journal,
+			foobar_notification_service_replay_entry,
+			foobar_notification_service_replay_record,
+			&replay,
+			&error ) )
+	{
+		g_warning( "Unable to read notification journal: %s", error->message );
+		return;
+	}
 
-			guint id = json_object_get_int_member( notification_object, "id" );
-			foobar_notification_set_id( notification, id );
+	guint count = g_hash_table_size( states ) + g_hash_table_size( stubs );
+	g_autoptr( GPtrArray ) notifications = g_ptr_array_new_full( count, g_object_unref );
+	GHashTableIter iter;
+	gpointer value;
+	g_hash_table_iter_init( &iter, states );
+	while ( g_hash_table_iter_next( &iter, NULL, &value ) )
+	{
+		g_ptr_array_add( notifications, foobar_notification_service_deserialize( self, value ) );
+	}
 
-			gchar const* app_entry = json_object_get_string_member_with_default( notification_object, "app-entry", NULL );
-			foobar_notification_set_app_entry( notification, app_entry );
+	g_hash_table_iter_init( &iter, stubs );
+	while ( g_hash_table_iter_next( &iter, NULL, &value ) )
+	{
+		g_ptr_array_add( notifications, g_object_ref( value ) );
+	}
 
-			gchar const* app_name = json_object_get_string_member_with_default( notification_object, "app-name", NULL );
-			foobar_notification_set_app_name( notification, app_name );
+	for ( guint i = 0; i < notifications->len; ++i )
+	{
+		FoobarNotification* notification = g_ptr_array_index( notifications, i );
+		self->next_id = MAX( self->next_id, foobar_notification_get_id( notification ) + 1 );
+	}
 
-			gchar const* body = json_object_get_string_member_with_default( notification_object, "body", NULL );
-			foobar_notification_set_body( notification, body );
+	// The eviction index expects notifications in chronological order, which also is the order they were received in.
+	// Like the previous cache, restored notifications are only shown in the history and never as popups again.
 
-			gchar const* summary = json_object_get_string_member_with_default( notification_object, "summary", NULL );
-			foobar_notification_set_summary( notification, summary );
+	g_ptr_array_sort_values( notifications, foobar_notification_service_compare_time );
 
-			gchar const* image_path = json_object_get_string_member_with_default( notification_object, "image-path", NULL );
-			gchar const* image_data = json_object_get_string_member_with_default( notification_object, "image-data", NULL );
-			if ( image_path ) { foobar_notification_set_image_from_path( notification, image_path ); }
-			else if ( image_data ) { foobar_notification_set_image_from_data( notification, image_data ); }
+	for ( guint i = 0; i < notifications->len; ++i )
+	{
+		FoobarNotification* notification = g_ptr_array_index( notifications, i );
+		foobar_notification_set_dismissed( notification, TRUE );
+		g_hash_table_insert(
+			self->positions,
+			GUINT_TO_POINTER( foobar_notification_get_id( notification ) ),
+			GUINT_TO_POINTER( i ) );
+		foobar_notification_service_track( self, notification );
+		foobar_notification_service_attach_group( self, notification );
+	}
 
-			gboolean is_resident = json_object_get_boolean_member( notification_object, "is-resident" );
-			foobar_notification_set_resident( notification, is_resident );
+	g_list_store_splice( self->notifications, 0, 0, notifications->pdata, notifications->len );
+}
 
-			gchar const* time_str = json_object_get_string_member_with_default( notification_object, "time", NULL );
-			GTimeZone* tz = g_time_zone_new_local( );
-			GDateTime* time = time_str ? g_date_time_new_from_iso8601( time_str, tz ) : NULL;
-			foobar_notification_set_time( notification, time );
-			g_time_zone_unref( tz );
-			if ( time ) { g_date_time_unref( time ); }
+//
+// Import notifications from the JSON cache file written by previous versions. All of them are marked as dismissed.
+//
+void foobar_notification_service_import_legacy_cache(
+	FoobarNotificationService* self,
+	gchar const*               path )
+{
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( JsonParser ) parser = json_parser_new( );
+	if ( !json_parser_load_from_mapped_file( parser, path, &error ) )
+	{
+		g_warning( "Unable to read cached notifications: %s", error->message );
+		return;
+	}
 
-			gint64 timeout = json_object_get_int_member( notification_object, "timeout" );
-			foobar_notification_set_timeout( notification, timeout );
+	JsonNode* root_node = json_parser_get_root( parser );
+	JsonArray* root_array = json_node_get_array( root_node );
+	for ( guint i = 0; i < json_array_get_length( root_array ); ++i )
+	{
+		JsonObject* notification_object = json_array_get_object_element( root_array, i );
+		g_autoptr( FoobarNotification ) notification = foobar_notification_service_deserialize( self, notification_object );
+		foobar_notification_set_dismissed( notification, TRUE );
 
-			FoobarNotificationUrgency urgency = json_object_get_int_member( notification_object, "urgency" );
-			foobar_notification_set_urgency( notification, urgency );
+		guint id = foobar_notification_get_id( notification );
+		if ( g_hash_table_contains( self->positions, GUINT_TO_POINTER( id ) ) ) { continue; }
 
-			JsonArray* actions_array = json_object_get_array_member( notification_object, "actions" );
-			for ( guint j = 0; j < json_array_get_length( actions_array ); ++j )
-			{
-				JsonObject* action_object = json_array_get_object_element( actions_array, j );
-				g_autoptr( FoobarNotificationAction ) action = foobar_notification_action_new( notification );
+		foobar_notification_service_append( self, notification );
+		self->next_id = MAX( self->next_id, foobar_notification_get_id( notification ) + 1 );
+	}
+}
 
-				gchar const* action_id = json_object_get_string_member_with_default( action_object, "id", NULL );
-				foobar_notification_action_set_id( action, action_id );
+//
+// Create a stub notification for an entry of the journal's index, without parsing its record.
+//
+void foobar_notification_service_replay_entry(
+	FoobarNotificationJournalEntry* entry,
+	gpointer                        userdata )
+{
+	JournalReplay* replay = (JournalReplay*)userdata;
 
-				gchar const* label = json_object_get_string_member_with_default( action_object, "label", NULL );
-				foobar_notification_action_set_label( action, label );
+	FoobarNotification* notification = foobar_notification_new( replay->service );
+	notification->id = entry->id;
+	notification->is_dismissed = entry->is_dismissed;
+	notification->record = g_bytes_ref( entry->record );
+	notification->indexed_size = entry->size;
+	notification->indexed_group_key = g_strdup( entry->group_key );
+	notification->is_materialized = FALSE;
 
-				foobar_notification_add_action( notification, action );
-			}
+	g_autoptr( GDateTime ) time = g_date_time_new_from_unix_local( entry->time / G_USEC_PER_SEC );
+	notification->time = g_date_time_add( time, entry->time % G_USEC_PER_SEC );
 
-			g_list_store_append( self->notifications, notification );
-			self->next_id = MAX( self->next_id, id + 1 );
-		}
-	}
+	// The image is referenced right away, so it isn't pruned from the image store before the stub is materialized.
+
+	foobar_notification_set_image_from_hash( notification, entry->image_hash );
+
+	g_hash_table_insert( replay->stubs, GUINT_TO_POINTER( entry->id ), notification );
 }
 
 //
-// Asynchronously start writing the cache file at self->cache_path.
+// Apply a single record from the journal to the table of notification states (mapping IDs to serialized
+// notifications) or the stubs created from the index.
 //
-void foobar_notification_service_write_cache( FoobarNotificationService* self )
+void foobar_notification_service_replay_record(
+	FoobarNotificationJournalRecordType type,
+	guint                               id,
+	JsonObject*                         payload,
+	gpointer                            userdata )
 {
-	guint count = g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) );
-	g_autoptr( GPtrArray ) notifications = g_ptr_array_new_full( count, g_object_unref );
-	for ( guint i = 0; i < count; ++i )
+	JournalReplay* replay = (JournalReplay*)userdata;
+
+	switch ( type )
 	{
-		FoobarNotification* notification = g_list_model_get_item( G_LIST_MODEL( self->notifications ), i );
-		if ( !foobar_notification_is_transient( notification ) )
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD:
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE:
+			if ( payload )
+			{
+				g_hash_table_insert( replay->states, GUINT_TO_POINTER( id ), json_object_ref( payload ) );
+				g_hash_table_remove( replay->stubs, GUINT_TO_POINTER( id ) );
+			}
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS:
 		{
-			g_ptr_array_add( notifications, g_object_ref( notification ) );
+			JsonObject* state = g_hash_table_lookup( replay->states, GUINT_TO_POINTER( id ) );
+			FoobarNotification* stub = g_hash_table_lookup( replay->stubs, GUINT_TO_POINTER( id ) );
+			if ( state ) { json_object_set_boolean_member( state, "is-dismissed", TRUE ); }
+			if ( stub ) { stub->is_dismissed = TRUE; }
+			break;
 		}
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE:
+			g_hash_table_remove( replay->states, GUINT_TO_POINTER( id ) );
+			g_hash_table_remove( replay->stubs, GUINT_TO_POINTER( id ) );
+			break;
+		default:
+			g_warn_if_reached( );
+			break;
 	}
-
-	foobar_notification_service_write_cache_async(
-		self,
-		g_steal_pointer( &notifications ),
-		NULL,
-		foobar_notification_service_write_cache_cb,
-		NULL );
 }
 
 //
-// Callback invoked when the cache was written successfully or failed.
+// Append a record for a change of the given notification to the journal. Transient notifications are not persisted.
 //
-void foobar_notification_service_write_cache_cb(
-	GObject*      object,
-	GAsyncResult* result,
-	gpointer      userdata )
+void foobar_notification_service_record(
+	FoobarNotificationService*          self,
+	FoobarNotificationJournalRecordType type,
+	FoobarNotification*                 notification )
 {
-	(void)userdata;
-	FoobarNotificationService* self = (FoobarNotificationService*)object;
+	if ( foobar_notification_is_transient( notification ) ) { return; }
 
-	g_autoptr( GError ) error = NULL;
-	if ( !foobar_notification_service_write_cache_finish( self, result, &error ) )
+	guint id = foobar_notification_get_id( notification );
+	FoobarNotificationJournalEntry entry;
+	g_autoptr( JsonNode ) payload = NULL;
+	switch ( type )
 	{
-		g_warning( "Unable to write cached notifications: %s", error->message );
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD:
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE:
+			payload = foobar_notification_service_serialize_func( notification, &entry );
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS:
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE:
+			break;
+		default:
+			g_warn_if_reached( );
+			return;
 	}
-}
 
-//
-// Asynchronously write the cache file at self->cache_path, using the provided snapshot of the list.
-//
-void foobar_notification_service_write_cache_async(
-	FoobarNotificationService* self,
-	GPtrArray*                 notifications,
-	GCancellable*              cancellable,
-	GAsyncReadyCallback        callback,
-	gpointer                   userdata )
-{
-	g_autoptr( GTask ) task = g_task_new( self, cancellable, callback, userdata );
-	g_task_set_name( task, "write-notification-cache" );
-	g_task_set_task_data( task, notifications, (GDestroyNotify)g_ptr_array_unref );
-	g_task_run_in_thread( task, foobar_notification_service_write_cache_thread );
+	foobar_notification_journal_append( self->journal, type, id, payload );
 }
 
 //
-// Get the asynchronous result for writing the cache file, returning TRUE on success, or FALSE on error.
+// Journal callback for capturing all notifications which should be kept when compacting the journal.
 //
-gboolean foobar_notification_service_write_cache_finish(
-	FoobarNotificationService* self,
-	GAsyncResult*              result,
-	GError**                   error )
+GPtrArray* foobar_notification_service_snapshot_func( gpointer userdata )
 {
-	(void)self;
+	FoobarNotificationService* self = (FoobarNotificationService*)userdata;
+
+	guint count = g_list_model_get_n_items( G_LIST_MODEL( self->notifications ) );
+	GPtrArray* notifications = g_ptr_array_new_full( count, g_object_unref );
+	for ( guint i = 0; i < count; ++i )
+	{
+		FoobarNotification* notification = g_list_model_get_item( G_LIST_MODEL( self->notifications ), i );
+		if ( !foobar_notification_is_transient( notification ) )
+		{
+			g_ptr_array_add( notifications, notification );
+		}
+		else
+		{
+			g_object_unref( notification );
+		}
+	}
 
-	return g_task_propagate_boolean( G_TASK( result ), error );
+	return notifications;
 }
 
 //
-// Task implementation for foobar_notification_service_write_cache_async, invoked on a background thread.
+// Journal callback for serializing a notification, also invoked for each notification in a snapshot when compacting the
+// journal. The entry's strings are owned by the notification, so they are only valid until it changes again.
 //
-void foobar_notification_service_write_cache_thread(
-	GTask*        task,
-	gpointer      source_object,
-	gpointer      task_data,
-	GCancellable* cancellable )
+// Stubs that were not materialized yet are not materialized here, because the history would have to be parsed in full
+// for every compaction. Their record is copied instead, with the current dismissed state.
+//
+JsonNode* foobar_notification_service_serialize_func(
+	gpointer                        item,
+	FoobarNotificationJournalEntry* out_entry )
 {
-	(void)cancellable;
-	FoobarNotificationService* self = (FoobarNotificationService*)source_object;
-	GPtrArray* notifications = (GPtrArray*)task_data;
+	FoobarNotification* notification = (FoobarNotification*)item;
+	out_entry->id = foobar_notification_get_id( notification );
+	out_entry->time = foobar_notification_get_unix_time( notification );
+	out_entry->is_dismissed = foobar_notification_is_dismissed( notification );
+	out_entry->size = foobar_notification_get_retained_size( notification );
+	out_entry->image_hash = foobar_notification_get_image_hash( notification );
+	out_entry->group_key = foobar_notification_get_group_key( notification );
 
-	if ( !self->cache_path )
+	if ( !notification->is_materialized )
 	{
-		g_task_return_boolean( task, TRUE );
-		return;
-	}
+		JsonObject* notification_object = foobar_notification_journal_parse_record( notification->record, NULL );
+		if ( !notification_object ) { return NULL; }
 
-	g_autoptr( GError ) error = NULL;
+		json_object_set_boolean_member( notification_object, "is-dismissed", out_entry->is_dismissed );
+		JsonNode* node = json_node_new( JSON_NODE_OBJECT );
+		json_node_take_object( node, notification_object );
+		return node;
+	}
 
 	g_autoptr( JsonBuilder ) builder = json_builder_new( );
-	json_builder_begin_array( builder );
-	for ( guint i = 0; i < notifications->len; ++i )
-	{
-		// Only init-only properties are read here so no extra synchronization is needed.
+	json_builder_begin_object( builder );
 
-		FoobarNotification* notification = g_ptr_array_index( notifications, i );
+	json_builder_set_member_name( builder, "id" );
+	json_builder_add_int_value( builder, foobar_notification_get_id( notification ) );
 
-		json_builder_begin_object( builder );
+	json_builder_set_member_name( builder, "app-entry" );
+	json_builder_add_string_value( builder, foobar_notification_get_app_entry( notification ) );
 
-		json_builder_set_member_name( builder, "id" );
-		json_builder_add_int_value( builder, foobar_notification_get_id( notification ) );
+	json_builder_set_member_name( builder, "app-name" );
+	json_builder_add_string_value( builder, foobar_notification_get_app_name( notification ) );
 
-		json_builder_set_member_name( builder, "app-entry" );
-		json_builder_add_string_value( builder, foobar_notification_get_app_entry( notification ) );
+	json_builder_set_member_name( builder, "body" );
+	json_builder_add_string_value( builder, foobar_notification_get_body( notification ) );
 
-		json_builder_set_member_name( builder, "app-name" );
-		json_builder_add_string_value( builder, foobar_notification_get_app_name( notification ) );
+	json_builder_set_member_name( builder, "summary" );
+	json_builder_add_string_value( builder, foobar_notification_get_summary( notification ) );
 
-		json_builder_set_member_name( builder, "body" );
-		json_builder_add_string_value( builder, foobar_notification_get_body( notification ) );
+	json_builder_set_member_name( builder, "search-text" );
+	json_builder_add_string_value( builder, foobar_notification_get_search_text( notification ) );
 
-		json_builder_set_member_name( builder, "summary" );
-		json_builder_add_string_value( builder, foobar_notification_get_summary( notification ) );
+	json_builder_set_member_name( builder, "image-path" );
+	json_builder_add_string_value( builder, foobar_notification_get_image_path( notification ) );
 
-		json_builder_set_member_name( builder, "image-path" );
-		json_builder_add_string_value( builder, foobar_notification_get_image_path( notification ) );
+	json_builder_set_member_name( builder, "image-hash" );
+	json_builder_add_string_value( builder, foobar_notification_get_image_hash( notification ) );
 
-		json_builder_set_member_name( builder, "image-data" );
-		json_builder_add_string_value( builder, foobar_notification_get_image_data( notification ) );
+	json_builder_set_member_name( builder, "image-size" );
+	json_builder_add_int_value( builder, notification->image_size );
 
-		json_builder_set_member_name( builder, "is-resident" );
-		json_builder_add_boolean_value( builder, foobar_notification_is_resident( notification ) );
+	json_builder_set_member_name( builder, "is-dismissed" );
+	json_builder_add_boolean_value( builder, foobar_notification_is_dismissed( notification ) );
 
-		GDateTime* time = foobar_notification_get_time( notification );
-		gchar* time_str = time ? g_date_time_format_iso8601( time ) : NULL;
-		json_builder_set_member_name( builder, "time" );
-		json_builder_add_string_value( builder, time_str );
-		g_free( time_str );
+	json_builder_set_member_name( builder, "is-resident" );
+	json_builder_add_boolean_value( builder, foobar_notification_is_resident( notification ) );
 
-		json_builder_set_member_name( builder, "timeout" );
-		json_builder_add_int_value( builder, foobar_notification_get_timeout( notification ) );
+	GDateTime* time = foobar_notification_get_time( notification );
+	gchar* time_str = time ? g_date_time_format_iso8601( time ) : NULL;
+	json_builder_set_member_name( builder, "time" );
+	json_builder_add_string_value( builder, time_str );
+	g_free( time_str );
 
-		json_builder_set_member_name( builder, "urgency" );
-		json_builder_add_int_value( builder, foobar_notification_get_urgency( notification ) );
+	json_builder_set_member_name( builder, "timeout" );
+	json_builder_add_int_value( builder, foobar_notification_get_timeout( notification ) );
 
-		guint action_count;
-		FoobarNotificationAction** actions = foobar_notification_get_actions( notification, &action_count );
-		json_builder_set_member_name( builder, "actions" );
-		json_builder_begin_array( builder );
-		for ( guint j = 0; j < action_count; ++j )
-		{
-			FoobarNotificationAction* action = actions[j];
+	json_builder_set_member_name( builder, "urgency" );
+	json_builder_add_int_value( builder, foobar_notification_get_urgency( notification ) );
 
-			json_builder_begin_object( builder );
+	guint action_count;
+	FoobarNotificationAction** actions = foobar_notification_get_actions( notification, &action_count );
+	json_builder_set_member_name( builder, "actions" );
+	json_builder_begin_array( builder );
+	for ( guint j = 0; j < action_count; ++j )
+	{
+		FoobarNotificationAction* action = actions[j];
 
-			json_builder_set_member_name( builder, "id" );
-			json_builder_add_string_value( builder, foobar_notification_action_get_id( action ) );
+		json_builder_begin_object( builder );
 
-			json_builder_set_member_name( builder, "label" );
-			json_builder_add_string_value( builder, foobar_notification_action_get_label( action ) );
+		json_builder_set_member_name( builder, "id" );
+		json_builder_add_string_value( builder, foobar_notification_action_get_id( action ) );
 
-			json_builder_end_object( builder );
-		}
-		json_builder_end_array( builder );
+		json_builder_set_member_name( builder, "label" );
+		json_builder_add_string_value( builder, foobar_notification_action_get_label( action ) );
 
 		json_builder_end_object( builder );
 	}
 	json_builder_end_array( builder );
 
-	g_autoptr( JsonNode ) root_node = json_builder_get_root( builder );
-	g_autoptr( JsonGenerator ) generator = json_generator_new( );
-	json_generator_set_root( generator, root_node );
+	json_builder_end_object( builder );
 
-	g_mutex_lock( &self->write_cache_mutex );
-	gboolean success = json_generator_to_file( generator, self->cache_path, &error );
-	g_mutex_unlock( &self->write_cache_mutex );
-	if ( !success )
-	{
-		g_task_return_error( task, g_steal_pointer( &error ) );
-		return;
-	}
+	return json_builder_get_root( builder );
+}
+
+//
+// Create a notification from its serialized representation.
+//
+FoobarNotification* foobar_notification_service_deserialize(
+	FoobarNotificationService* self,
+	JsonObject*                notification_object )
+{
+	FoobarNotification* notification = foobar_notification_new( self );
+
+	gboolean is_dismissed = json_object_get_boolean_member_with_default( notification_object, "is-dismissed", FALSE );
+	foobar_notification_set_dismissed( notification, is_dismissed );
 
-	g_task_return_boolean( task, TRUE );
+	guint id = json_object_get_int_member( notification_object, "id" );
+	foobar_notification_set_id( notification, id );
+
+	// An image path takes precedence and is assigned together with the other details.
+
+	gchar const* image_path = json_object_get_string_member_with_default( notification_object, "image-path", NULL );
+	gchar const* image_hash = json_object_get_string_member_with_default( notification_object, "image-hash", NULL );
+	gchar const* image_data = json_object_get_string_member_with_default( notification_object, "image-data", NULL );
+	if ( !image_path && image_hash ) { foobar_notification_set_image_from_hash( notification, image_hash ); }
+	else if ( !image_path && image_data ) { foobar_notification_set_image_from_data( notification, image_data ); }
+
+	gchar const* time_str = json_object_get_string_member_with_default( notification_object, "time", NULL );
+	GTimeZone* tz = g_time_zone_new_local( );
+	GDateTime* time = time_str ? g_date_time_new_from_iso8601( time_str, tz ) : NULL;
+	foobar_notification_set_time( notification, time );
+	g_time_zone_unref( tz );
+	if ( time ) { g_date_time_unref( time ); }
+
+	foobar_notification_load_details( notification, notification_object );
+
+	return notification;
 }
 
 //
@@ -1810,7 +3967,21 @@ gboolean foobar_notification_service_popup_filter_func(
 	(void)userdata;
 
 	FoobarNotification* notification = item;
-	return !foobar_notification_is_dismissed( notification );
+	return !foobar_notification_is_dismissed( notification ) && !notification->is_collapsed;
+}
+
+//
+// Filtering callback for the list of search results.
+//
+gboolean foobar_notification_service_search_filter_func(
+	gpointer item,
+	gpointer userdata )
+{
+	FoobarNotificationService* self = userdata;
+	FoobarNotification* notification = item;
+
+	if ( !self->search_matches ) { return TRUE; }
+	return g_hash_table_contains( self->search_matches, GUINT_TO_POINTER( foobar_notification_get_id( notification ) ) );
 }
 
 //
@@ -1831,3 +4002,44 @@ gint foobar_notification_service_sort_func(
 		foobar_notification_get_time( notification_a ),
 		foobar_notification_get_time( notification_b ) );
 }
+
+//
+// Comparison function for sorting positions in descending order.
+//
+gint foobar_notification_service_compare_position(
+	gconstpointer item_a,
+	gconstpointer item_b )
+{
+	guint position_a = *(guint const*)item_a;
+	guint position_b = *(guint const*)item_b;
+	return ( position_a < position_b ) - ( position_a > position_b );
+}
+
+//
+// Comparison function for sorting notifications chronologically (oldest first).
+//
+gint foobar_notification_service_compare_time(
+	gconstpointer item_a,
+	gconstpointer item_b )
+{
+	FoobarNotification* notification_a = (FoobarNotification*)item_a;
+	FoobarNotification* notification_b = (FoobarNotification*)item_b;
+	return g_date_time_compare(
+		foobar_notification_get_time( notification_a ),
+		foobar_notification_get_time( notification_b ) );
+}
+
+//
+// Sorting callback for the list of notification groups.
+//
+// Groups are sorted by the timestamp of their latest notification in descending order.
+//
+gint foobar_notification_service_group_sort_func(
+	gconstpointer item_a,
+	gconstpointer item_b,
+	gpointer      userdata )
+{
+	FoobarNotificationGroup* group_a = (FoobarNotificationGroup*)item_a;
+	FoobarNotificationGroup* group_b = (FoobarNotificationGroup*)item_b;
+	return foobar_notification_service_sort_func( group_a->latest, group_b->latest, userdata );
+}
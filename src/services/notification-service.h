@@ -2,12 +2,14 @@
 
 #include <glib-object.h>
 #include <gdk/gdk.h>
+#include "services/scheduler-service.h"
 
 G_BEGIN_DECLS
 
 #define FOOBAR_TYPE_NOTIFICATION_URGENCY foobar_notification_urgency_get_type( )
 #define FOOBAR_TYPE_NOTIFICATION_ACTION  foobar_notification_action_get_type( )
 #define FOOBAR_TYPE_NOTIFICATION         foobar_notification_get_type( )
+#define FOOBAR_TYPE_NOTIFICATION_GROUP   foobar_notification_group_get_type( )
 #define FOOBAR_TYPE_NOTIFICATION_SERVICE foobar_notification_service_get_type( )
 
 typedef enum
@@ -35,22 +37,41 @@ gchar const*               foobar_notification_get_app_entry ( FoobarNotificatio
 gchar const*               foobar_notification_get_app_name  ( FoobarNotification* self );
 gchar const*               foobar_notification_get_body      ( FoobarNotification* self );
 gchar const*               foobar_notification_get_summary   ( FoobarNotification* self );
-GdkPixbuf*                 foobar_notification_get_image     ( FoobarNotification* self );
+GdkTexture*                foobar_notification_get_image     ( FoobarNotification* self );
 gboolean                   foobar_notification_is_dismissed  ( FoobarNotification* self );
 gboolean                   foobar_notification_is_resident   ( FoobarNotification* self );
 gboolean                   foobar_notification_is_transient  ( FoobarNotification* self );
 GDateTime*                 foobar_notification_get_time      ( FoobarNotification* self );
 gint64                     foobar_notification_get_timeout   ( FoobarNotification* self );
 FoobarNotificationUrgency  foobar_notification_get_urgency   ( FoobarNotification* self );
+guint                      foobar_notification_get_group_size( FoobarNotification* self );
 void                       foobar_notification_block_timeout ( FoobarNotification* self );
 void                       foobar_notification_resume_timeout( FoobarNotification* self );
 void                       foobar_notification_dismiss       ( FoobarNotification* self );
 void                       foobar_notification_close         ( FoobarNotification* self );
+void                       foobar_notification_expand        ( FoobarNotification* self );
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationGroup, foobar_notification_group, FOOBAR, NOTIFICATION_GROUP, GObject )
+
+FoobarNotification* foobar_notification_group_get_latest       ( FoobarNotificationGroup* self );
+guint               foobar_notification_group_get_count        ( FoobarNotificationGroup* self );
+GListModel*         foobar_notification_group_get_notifications( FoobarNotificationGroup* self );
+void                foobar_notification_group_close            ( FoobarNotificationGroup* self );
 
 G_DECLARE_FINAL_TYPE( FoobarNotificationService, foobar_notification_service, FOOBAR, NOTIFICATION_SERVICE, GObject )
 
-FoobarNotificationService* foobar_notification_service_new                    ( void );
+FoobarNotificationService* foobar_notification_service_new                    ( FoobarSchedulerService*    scheduler_service );
 GListModel*                foobar_notification_service_get_notifications      ( FoobarNotificationService* self );
 GListModel*                foobar_notification_service_get_popup_notifications( FoobarNotificationService* self );
+GListModel*                foobar_notification_service_get_groups             ( FoobarNotificationService* self );
+GListModel*                foobar_notification_service_get_search_results     ( FoobarNotificationService* self );
+void                       foobar_notification_service_set_search_query       ( FoobarNotificationService* self,
+                                                                                gchar const*               query );
+void                       foobar_notification_service_hold_minute_tick       ( FoobarNotificationService* self );
+void                       foobar_notification_service_release_minute_tick    ( FoobarNotificationService* self );
+void                       foobar_notification_service_set_history_limits     ( FoobarNotificationService* self,
+                                                                                guint                      max_count,
+                                                                                GTimeSpan                  max_age,
+                                                                                guint64                    max_size );
 
 G_END_DECLS
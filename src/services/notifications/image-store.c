@@ -0,0 +1,469 @@
+#include "services/notifications/image-store.h"
+#include <glib/gstdio.h>
+#include <errno.h>
+
+#define HASH_LENGTH 64
+
+// Images are compressed on a background thread, but quickly enough to keep up with bursts of notifications. Raw pixel
+// data of application icons already shrinks to between a sixth and a third of its size at the fastest level, while
+// higher levels take two to three times as long for files that are only 10-20% smaller.
+#define COMPRESSION_LEVEL 1
+
+//
+// FoobarNotificationImageStore:
+//
+// A content-addressed directory of notification images. Each image is stored once as a file named after the SHA-256
+// hash of its contents, so notifications only need to remember the hash, no matter how often the same image is sent.
+//
+// Files are reference-counted by the notifications using them. Once an image is no longer referenced, its file is
+// removed from the next main loop iteration (so it can still be reused if a notification referencing it is created
+// right away). Files that were left behind by previous sessions are removed by foobar_notification_image_store_prune.
+//
+// Images usually arrive as raw pixel data, so each file is written as a single gzip frame. Files without a gzip header
+// were stored by previous versions and are loaded as they are.
+//
+
+struct _FoobarNotificationImageStore
+{
+	GObject     parent_instance;
+	gchar*      directory;
+	GHashTable* ref_counts;
+	GHashTable* unused;
+	guint       delete_id;
+};
+
+static void     foobar_notification_image_store_class_init   ( FoobarNotificationImageStoreClass* klass );
+static void     foobar_notification_image_store_init         ( FoobarNotificationImageStore*      self );
+static void     foobar_notification_image_store_finalize     ( GObject*                           object );
+static gboolean foobar_notification_image_store_handle_delete( gpointer                           userdata );
+static void     foobar_notification_image_store_add_thread   ( GTask*                             task,
+                                                               gpointer                           source_object,
+                                                               gpointer                           task_data,
+                                                               GCancellable*                      cancellable );
+static gboolean foobar_notification_image_store_write        ( FoobarNotificationImageStore*      self,
+                                                               gchar const*                       hash,
+                                                               GBytes*                            contents,
+                                                               GError**                           error );
+static gchar*   foobar_notification_image_store_get_path     ( FoobarNotificationImageStore*      self,
+                                                               gchar const*                       hash );
+static gboolean image_store_is_valid_hash                    ( gchar const*                       hash );
+static gboolean image_store_is_compressed                    ( GBytes*                            contents );
+static GBytes*  image_store_compress                         ( GBytes*                            contents,
+                                                               GError**                           error );
+static GBytes*  image_store_decompress                       ( GBytes*                            contents,
+                                                               GError**                           error );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationImageStore, foobar_notification_image_store, G_TYPE_OBJECT )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Image Store
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the image store.
+//
+void foobar_notification_image_store_class_init( FoobarNotificationImageStoreClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->finalize = foobar_notification_image_store_finalize;
+}
+
+//
+// Instance initialization for the image store.
+//
+void foobar_notification_image_store_init( FoobarNotificationImageStore* self )
+{
+	self->ref_counts = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+	self->unused = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+}
+
+//
+// Instance cleanup for the image store.
+//
+void foobar_notification_image_store_finalize( GObject* object )
+{
+	FoobarNotificationImageStore* self = (FoobarNotificationImageStore*)object;
+
+	g_clear_handle_id( &self->delete_id, g_source_remove );
+	g_clear_pointer( &self->directory, g_free );
+	g_clear_pointer( &self->ref_counts, g_hash_table_unref );
+	g_clear_pointer( &self->unused, g_hash_table_unref );
+
+	G_OBJECT_CLASS( foobar_notification_image_store_parent_class )->finalize( object );
+}
+
+//
+// Create a new image store, keeping its files in the given directory (which is created if necessary).
+//
+FoobarNotificationImageStore* foobar_notification_image_store_new( gchar const* directory )
+{
+	FoobarNotificationImageStore* self = g_object_new( FOOBAR_TYPE_NOTIFICATION_IMAGE_STORE, NULL );
+
+	if ( directory )
+	{
+		if ( g_mkdir_with_parents( directory, 0700 ) == 0 )
+		{
+			self->directory = g_strdup( directory );
+		}
+		else
+		{
+			g_warning( "Unable to create notification image directory: %s", g_strerror( errno ) );
+		}
+	}
+
+	return self;
+}
+
+//
+// Store an image (if it isn't stored already) and acquire a reference to it.
+//
+// Returns the hash identifying the image, or NULL if it could not be stored.
+//
+gchar* foobar_notification_image_store_add(
+	FoobarNotificationImageStore* self,
+	GBytes*                       contents )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ), NULL );
+	g_return_val_if_fail( contents != NULL, NULL );
+
+	if ( !self->directory ) { return NULL; }
+
+	gchar* hash = g_compute_checksum_for_bytes( G_CHECKSUM_SHA256, contents );
+	g_autofree gchar* path = foobar_notification_image_store_get_path( self, hash );
+
+	g_autoptr( GError ) error = NULL;
+	if ( !g_hash_table_contains( self->ref_counts, hash ) &&
+			!g_file_test( path, G_FILE_TEST_EXISTS ) &&
+			!foobar_notification_image_store_write( self, hash, contents, &error ) )
+	{
+		g_warning( "Unable to store notification image: %s", error->message );
+		g_free( hash );
+		return NULL;
+	}
+
+	foobar_notification_image_store_ref( self, hash );
+	return hash;
+}
+
+//
+// Asynchronously store an image (if it isn't stored already), hashing and writing it on a background thread.
+//
+// Cancelling the operation does not make it fail once the file was written. The hash is still returned (with a
+// reference acquired for it), so the caller can release the file again instead of leaving it behind until the next
+// prune.
+//
+void foobar_notification_image_store_add_async(
+	FoobarNotificationImageStore* self,
+	GBytes*                       contents,
+	GCancellable*                 cancellable,
+	GAsyncReadyCallback           callback,
+	gpointer                      userdata )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ) );
+	g_return_if_fail( contents != NULL );
+
+	g_autoptr( GTask ) task = g_task_new( self, cancellable, callback, userdata );
+	g_task_set_name( task, "add-notification-image" );
+	g_task_set_check_cancellable( task, FALSE );
+	g_task_set_task_data( task, g_bytes_ref( contents ), (GDestroyNotify)g_bytes_unref );
+
+	if ( !self->directory )
+	{
+		g_task_return_new_error( task, G_FILE_ERROR, G_FILE_ERROR_NOENT, "The image store is not available." );
+		return;
+	}
+
+	g_task_run_in_thread( task, foobar_notification_image_store_add_thread );
+}
+
+//
+// Get the asynchronous result for storing an image, acquiring a reference to it.
+//
+// Returns the hash identifying the image, or NULL on error.
+//
+gchar* foobar_notification_image_store_add_finish(
+	FoobarNotificationImageStore* self,
+	GAsyncResult*                 result,
+	GError**                      error )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ), NULL );
+
+	gchar* hash = g_task_propagate_pointer( G_TASK( result ), error );
+	if ( !hash ) { return NULL; }
+
+	// The file might have been removed in the meantime if the last reference to an identical image was released while
+	// the task was running. This is rare enough to just write it again.
+
+	if ( !g_hash_table_contains( self->ref_counts, hash ) )
+	{
+		g_autofree gchar* path = foobar_notification_image_store_get_path( self, hash );
+		GBytes* contents = g_task_get_task_data( G_TASK( result ) );
+		if ( !g_file_test( path, G_FILE_TEST_EXISTS ) &&
+				!foobar_notification_image_store_write( self, hash, contents, error ) )
+		{
+			g_free( hash );
+			return NULL;
+		}
+	}
+
+	foobar_notification_image_store_ref( self, hash );
+	return hash;
+}
+
+//
+// Acquire a reference to a stored image. Invalid hashes (e.g. from a corrupted journal) are ignored.
+//
+void foobar_notification_image_store_ref(
+	FoobarNotificationImageStore* self,
+	gchar const*                  hash )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ) );
+	g_return_if_fail( hash != NULL );
+
+	if ( !image_store_is_valid_hash( hash ) ) { return; }
+
+	gpointer key;
+	gpointer value;
+	if ( g_hash_table_lookup_extended( self->ref_counts, hash, &key, &value ) )
+	{
+		g_hash_table_insert( self->ref_counts, g_strdup( hash ), GUINT_TO_POINTER( GPOINTER_TO_UINT( value ) + 1 ) );
+	}
+	else
+	{
+		g_hash_table_insert( self->ref_counts, g_strdup( hash ), GUINT_TO_POINTER( 1 ) );
+		g_hash_table_remove( self->unused, hash );
+	}
+}
+
+//
+// Release a reference to a stored image, scheduling its file to be removed once it is no longer referenced.
+//
+void foobar_notification_image_store_unref(
+	FoobarNotificationImageStore* self,
+	gchar const*                  hash )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ) );
+	g_return_if_fail( hash != NULL );
+
+	if ( !image_store_is_valid_hash( hash ) ) { return; }
+
+	guint ref_count = GPOINTER_TO_UINT( g_hash_table_lookup( self->ref_counts, hash ) );
+	g_return_if_fail( ref_count > 0 );
+
+	if ( ref_count > 1 )
+	{
+		g_hash_table_insert( self->ref_counts, g_strdup( hash ), GUINT_TO_POINTER( ref_count - 1 ) );
+		return;
+	}
+
+	g_hash_table_remove( self->ref_counts, hash );
+	g_hash_table_add( self->unused, g_strdup( hash ) );
+
+	if ( !self->delete_id )
+	{
+		self->delete_id = g_idle_add_full(
+			G_PRIORITY_LOW,
+			foobar_notification_image_store_handle_delete,
+			g_object_ref( self ),
+			g_object_unref );
+	}
+}
+
+//
+// Get the (decompressed) contents of a stored image. The file is mapped into memory instead of being read.
+//
+// Unlike the other methods, this only accesses immutable state and may be called from any thread.
+//
+GBytes* foobar_notification_image_store_load(
+	FoobarNotificationImageStore* self,
+	gchar const*                  hash,
+	GError**                      error )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ), NULL );
+	g_return_val_if_fail( hash != NULL, NULL );
+
+	if ( !self->directory || !image_store_is_valid_hash( hash ) )
+	{
+		g_set_error( error, G_FILE_ERROR, G_FILE_ERROR_NOENT, "No stored image with hash %s", hash );
+		return NULL;
+	}
+
+	g_autofree gchar* path = foobar_notification_image_store_get_path( self, hash );
+	g_autoptr( GMappedFile ) file = g_mapped_file_new( path, FALSE, error );
+	if ( !file ) { return NULL; }
+
+	g_autoptr( GBytes ) contents = g_mapped_file_get_bytes( file );
+	if ( !image_store_is_compressed( contents ) ) { return g_steal_pointer( &contents ); }
+
+	return image_store_decompress( contents, error );
+}
+
+//
+// Remove all files in the store's directory that are not currently referenced.
+//
+// This should be called after all persisted notifications were loaded.
+//
+void foobar_notification_image_store_prune( FoobarNotificationImageStore* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_IMAGE_STORE( self ) );
+
+	if ( !self->directory ) { return; }
+
+	g_autoptr( GError ) error = NULL;
+	g_autoptr( GDir ) dir = g_dir_open( self->directory, 0, &error );
+	if ( !dir )
+	{
+		g_warning( "Unable to open notification image directory: %s", error->message );
+		return;
+	}
+
+	gchar const* name;
+	while ( ( name = g_dir_read_name( dir ) ) )
+	{
+		if ( !g_hash_table_contains( self->ref_counts, name ) )
+		{
+			g_autofree gchar* path = g_build_filename( self->directory, name, NULL );
+			g_unlink( path );
+		}
+	}
+}
+
+//
+// Task implementation for foobar_notification_image_store_add_async, invoked on a background thread.
+//
+void foobar_notification_image_store_add_thread(
+	GTask*        task,
+	gpointer      source_object,
+	gpointer      task_data,
+	GCancellable* cancellable )
+{
+	(void)cancellable;
+	FoobarNotificationImageStore* self = (FoobarNotificationImageStore*)source_object;
+	GBytes* contents = (GBytes*)task_data;
+
+	g_autofree gchar* hash = g_compute_checksum_for_bytes( G_CHECKSUM_SHA256, contents );
+	g_autofree gchar* path = foobar_notification_image_store_get_path( self, hash );
+
+	g_autoptr( GError ) error = NULL;
+	if ( !g_file_test( path, G_FILE_TEST_EXISTS ) &&
+			!foobar_notification_image_store_write( self, hash, contents, &error ) )
+	{
+		g_task_return_error( task, g_steal_pointer( &error ) );
+		return;
+	}
+
+	g_task_return_pointer( task, g_steal_pointer( &hash ), g_free );
+}
+
+//
+// Compress an image and write it to the file for the given hash, replacing it atomically.
+//
+gboolean foobar_notification_image_store_write(
+	FoobarNotificationImageStore* self,
+	gchar const*                  hash,
+	GBytes*                       contents,
+	GError**                      error )
+{
+	g_autoptr( GBytes ) compressed = image_store_compress( contents, error );
+	if ( !compressed ) { return FALSE; }
+
+	g_autofree gchar* path = foobar_notification_image_store_get_path( self, hash );
+	gsize size;
+	gchar const* data = g_bytes_get_data( compressed, &size );
+	return g_file_set_contents_full( path, data, (gssize)size, G_FILE_SET_CONTENTS_CONSISTENT, 0600, error );
+}
+
+//
+// Called from the main loop after the last reference to one or more images was released.
+//
+gboolean foobar_notification_image_store_handle_delete( gpointer userdata )
+{
+	FoobarNotificationImageStore* self = (FoobarNotificationImageStore*)userdata;
+
+	GHashTableIter iter;
+	gpointer key;
+	g_hash_table_iter_init( &iter, self->unused );
+	while ( g_hash_table_iter_next( &iter, &key, NULL ) )
+	{
+		g_autofree gchar* path = foobar_notification_image_store_get_path( self, key );
+		g_unlink( path );
+		g_hash_table_iter_remove( &iter );
+	}
+
+	self->delete_id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Get the path of the file for an image with the given hash.
+//
+gchar* foobar_notification_image_store_get_path(
+	FoobarNotificationImageStore* self,
+	gchar const*                  hash )
+{
+	return g_build_filename( self->directory, hash, NULL );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Check whether a string is a hex-encoded SHA-256 hash, so it can safely be used as a file name.
+//
+gboolean image_store_is_valid_hash( gchar const* hash )
+{
+	for ( gsize i = 0; i < HASH_LENGTH; ++i )
+	{
+		if ( !g_ascii_isxdigit( hash[i] ) ) { return FALSE; }
+	}
+
+	return hash[HASH_LENGTH] == '\0';
+}
+
+//
+// Check whether the contents of a file start with a gzip header (using the deflate method).
+//
+gboolean image_store_is_compressed( GBytes* contents )
+{
+	gsize size;
+	guint8 const* data = g_bytes_get_data( contents, &size );
+	return size >= 3 && data[0] == 0x1f && data[1] == 0x8b && data[2] == 0x08;
+}
+
+//
+// Compress data into a single gzip frame.
+//
+GBytes* image_store_compress(
+	GBytes*  contents,
+	GError** error )
+{
+	g_autoptr( GZlibCompressor ) compressor = g_zlib_compressor_new( G_ZLIB_COMPRESSOR_FORMAT_GZIP, COMPRESSION_LEVEL );
+	g_autoptr( GOutputStream ) memory_output = g_memory_output_stream_new_resizable( );
+	g_autoptr( GOutputStream ) output = g_converter_output_stream_new( memory_output, G_CONVERTER( compressor ) );
+
+	gsize size;
+	gconstpointer data = g_bytes_get_data( contents, &size );
+	if ( !g_output_stream_write_all( output, data, size, NULL, NULL, error ) ) { return NULL; }
+	if ( !g_output_stream_close( output, NULL, error ) ) { return NULL; }
+
+	return g_memory_output_stream_steal_as_bytes( G_MEMORY_OUTPUT_STREAM( memory_output ) );
+}
+
+//
+// Decompress a gzip frame, failing if it is truncated or its checksum doesn't match.
+//
+GBytes* image_store_decompress(
+	GBytes*  contents,
+	GError** error )
+{
+	g_autoptr( GZlibDecompressor ) decompressor = g_zlib_decompressor_new( G_ZLIB_COMPRESSOR_FORMAT_GZIP );
+	g_autoptr( GInputStream ) memory_input = g_memory_input_stream_new_from_bytes( contents );
+	g_autoptr( GInputStream ) input = g_converter_input_stream_new( memory_input, G_CONVERTER( decompressor ) );
+	g_autoptr( GOutputStream ) output = g_memory_output_stream_new_resizable( );
+
+	GOutputStreamSpliceFlags flags = G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET;
+	if ( g_output_stream_splice( output, input, flags, NULL, error ) < 0 ) { return NULL; }
+
+	return g_memory_output_stream_steal_as_bytes( G_MEMORY_OUTPUT_STREAM( output ) );
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_NOTIFICATION_IMAGE_STORE foobar_notification_image_store_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationImageStore, foobar_notification_image_store, FOOBAR, NOTIFICATION_IMAGE_STORE, GObject )
+
+FoobarNotificationImageStore* foobar_notification_image_store_new       ( gchar const*                  directory );
+gchar*                        foobar_notification_image_store_add       ( FoobarNotificationImageStore* self,
+                                                                          GBytes*                       contents );
+void                          foobar_notification_image_store_add_async ( FoobarNotificationImageStore* self,
+                                                                          GBytes*                       contents,
+                                                                          GCancellable*                 cancellable,
+                                                                          GAsyncReadyCallback           callback,
+                                                                          gpointer                      userdata );
+gchar*                        foobar_notification_image_store_add_finish( FoobarNotificationImageStore* self,
+                                                                          GAsyncResult*                 result,
+                                                                          GError**                      error );
+void                          foobar_notification_image_store_ref       ( FoobarNotificationImageStore* self,
+                                                                          gchar const*                  hash );
+void                          foobar_notification_image_store_unref     ( FoobarNotificationImageStore* self,
+                                                                          gchar const*                  hash );
+GBytes*                       foobar_notification_image_store_load      ( FoobarNotificationImageStore* self,
+                                                                          gchar const*                  hash,
+                                                                          GError**                      error );
+void                          foobar_notification_image_store_prune     ( FoobarNotificationImageStore* self );
+
+G_END_DECLS
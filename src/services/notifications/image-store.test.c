@@ -0,0 +1,346 @@
+#include "services/notifications/image-store.h"
+#include <glib/gstdio.h>
+#include <mutest.h>
+#include <string.h>
+
+//
+// StoreAddResult:
+//
+// Result of an asynchronous call to foobar_notification_image_store_add_async.
+//
+
+typedef struct _StoreAddResult StoreAddResult;
+
+struct _StoreAddResult
+{
+	gchar*   hash;
+	gboolean is_done;
+};
+
+static gchar* store_directory_new ( void );
+static void   store_directory_free( gchar*        directory );
+static guint  store_file_count    ( gchar const*  directory );
+static gsize  store_file_size     ( gchar const*  directory );
+static void   store_add_cb        ( GObject*      object,
+                                    GAsyncResult* result,
+                                    gpointer      userdata );
+
+static void deduplication_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	GBytes* contents = g_bytes_new_static( "avatar", 6 );
+	gchar* first = foobar_notification_image_store_add( store, contents );
+	gchar* second = foobar_notification_image_store_add( store, contents );
+	mutest_expect(
+		"same hash for same contents",
+		mutest_string_value( second ),
+		mutest_to_be,
+		first,
+		NULL );
+	mutest_expect(
+		"stored files",
+		mutest_int_value( store_file_count( directory ) ),
+		mutest_to_be,
+		1,
+		NULL );
+
+	GBytes* loaded = foobar_notification_image_store_load( store, first, NULL );
+	mutest_expect(
+		"loaded contents",
+		mutest_bool_value( loaded && g_bytes_equal( loaded, contents ) ),
+		mutest_to_be_true,
+		NULL );
+
+	g_bytes_unref( loaded );
+	g_bytes_unref( contents );
+	g_free( first );
+	g_free( second );
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+static void prune_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	GBytes* kept_contents = g_bytes_new_static( "kept", 4 );
+	GBytes* stale_contents = g_bytes_new_static( "stale", 5 );
+	gchar* kept = foobar_notification_image_store_add( store, kept_contents );
+	gchar* stale = foobar_notification_image_store_add( store, stale_contents );
+	g_object_unref( store );
+
+	// A new session only references one of the images.
+	store = foobar_notification_image_store_new( directory );
+	foobar_notification_image_store_ref( store, kept );
+	foobar_notification_image_store_prune( store );
+
+	mutest_expect(
+		"stored files",
+		mutest_int_value( store_file_count( directory ) ),
+		mutest_to_be,
+		1,
+		NULL );
+
+	GBytes* loaded = foobar_notification_image_store_load( store, stale, NULL );
+	mutest_expect(
+		"pruned image",
+		mutest_bool_value( loaded == NULL ),
+		mutest_to_be_true,
+		NULL );
+
+	g_bytes_unref( kept_contents );
+	g_bytes_unref( stale_contents );
+	g_free( kept );
+	g_free( stale );
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+static void compression_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	// Raw pixel data of a solid image, which compresses well.
+	gsize size = 64 * 64 * 4;
+	guint8* pixels = g_malloc( size );
+	for ( gsize i = 0; i < size; ++i ) { pixels[i] = i % 4 == 3 ? 0xff : 0x40; }
+	GBytes* contents = g_bytes_new_take( pixels, size );
+
+	gchar* hash = foobar_notification_image_store_add( store, contents );
+	gchar* path = g_build_filename( directory, hash, NULL );
+	gchar* stored;
+	gsize stored_size = 0;
+	g_file_get_contents( path, &stored, &stored_size, NULL );
+	mutest_expect(
+		"stored file is compressed",
+		mutest_bool_value( stored_size > 0 && stored_size < size / 4 ),
+		mutest_to_be_true,
+		NULL );
+
+	GBytes* loaded = foobar_notification_image_store_load( store, hash, NULL );
+	mutest_expect(
+		"loaded contents",
+		mutest_bool_value( loaded && g_bytes_equal( loaded, contents ) ),
+		mutest_to_be_true,
+		NULL );
+
+	g_bytes_unref( loaded );
+	g_bytes_unref( contents );
+	g_free( stored );
+	g_free( path );
+	g_free( hash );
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+static void history_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	// A history of 1000 notifications, each with its own 64x64 image.
+	guint count = 1000;
+	gsize size = 64 * 64 * 4;
+	guint8* pixels = g_malloc( size );
+	for ( gsize i = 0; i < size / 4; ++i )
+	{
+		pixels[i * 4] = ( i % 64 ) * 4;
+		pixels[i * 4 + 1] = ( i / 64 ) * 4;
+		pixels[i * 4 + 2] = ( i % 64 + i / 64 ) * 2;
+		pixels[i * 4 + 3] = 0xff;
+	}
+
+	gint64 start = g_get_monotonic_time( );
+	for ( guint i = 0; i < count; ++i )
+	{
+		memcpy( pixels, &i, sizeof( i ) );
+		GBytes* contents = g_bytes_new( pixels, size );
+		g_free( foobar_notification_image_store_add( store, contents ) );
+		g_bytes_unref( contents );
+	}
+	gint64 elapsed = g_get_monotonic_time( ) - start;
+
+	gsize stored_size = store_file_size( directory );
+	g_print(
+		"# %u images: %" G_GSIZE_FORMAT " -> %" G_GSIZE_FORMAT " bytes, written in %.1f ms\n",
+		count,
+		count * size,
+		stored_size,
+		elapsed / 1000.0 );
+	mutest_expect(
+		"stored files",
+		mutest_int_value( store_file_count( directory ) ),
+		mutest_to_be,
+		count,
+		NULL );
+	mutest_expect(
+		"stored history is compressed",
+		mutest_bool_value( stored_size < count * size ),
+		mutest_to_be_true,
+		NULL );
+
+	g_free( pixels );
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+static void uncompressed_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	// Previous versions stored the raw contents.
+	GBytes* contents = g_bytes_new_static( "legacy", 6 );
+	gchar* hash = g_compute_checksum_for_bytes( G_CHECKSUM_SHA256, contents );
+	gchar* path = g_build_filename( directory, hash, NULL );
+	g_file_set_contents( path, "legacy", 6, NULL );
+
+	GBytes* loaded = foobar_notification_image_store_load( store, hash, NULL );
+	mutest_expect(
+		"loaded contents",
+		mutest_bool_value( loaded && g_bytes_equal( loaded, contents ) ),
+		mutest_to_be_true,
+		NULL );
+
+	g_bytes_unref( loaded );
+	g_bytes_unref( contents );
+	g_free( path );
+	g_free( hash );
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+static void cancelled_add_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	// The operation is cancelled while the file is written, like when a notification's image is replaced.
+	GBytes* contents = g_bytes_new_static( "replaced", 8 );
+	GCancellable* cancellable = g_cancellable_new( );
+	StoreAddResult result = { 0 };
+	foobar_notification_image_store_add_async( store, contents, cancellable, store_add_cb, &result );
+	g_cancellable_cancel( cancellable );
+	while ( !result.is_done ) { g_main_context_iteration( NULL, TRUE ); }
+
+	mutest_expect(
+		"returned hash",
+		mutest_bool_value( result.hash != NULL ),
+		mutest_to_be_true,
+		NULL );
+
+	// Releasing the reference removes the file.
+	if ( result.hash ) { foobar_notification_image_store_unref( store, result.hash ); }
+	while ( g_main_context_iteration( NULL, FALSE ) ) { }
+	mutest_expect(
+		"stored files",
+		mutest_int_value( store_file_count( directory ) ),
+		mutest_to_be,
+		0,
+		NULL );
+
+	g_free( result.hash );
+	g_object_unref( cancellable );
+	g_bytes_unref( contents );
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+static void invalid_hash_spec( void )
+{
+	gchar* directory = store_directory_new( );
+	FoobarNotificationImageStore* store = foobar_notification_image_store_new( directory );
+
+	GBytes* loaded = foobar_notification_image_store_load( store, "../notifications.journal", NULL );
+	mutest_expect(
+		"rejected hash",
+		mutest_bool_value( loaded == NULL ),
+		mutest_to_be_true,
+		NULL );
+
+	g_object_unref( store );
+	store_directory_free( directory );
+}
+
+gchar* store_directory_new( void )
+{
+	gchar* parent = g_dir_make_tmp( "foobar-images-XXXXXX", NULL );
+	gchar* directory = g_build_filename( parent, "notification-images", NULL );
+	g_free( parent );
+	return directory;
+}
+
+void store_directory_free( gchar* directory )
+{
+	GDir* dir = g_dir_open( directory, 0, NULL );
+	gchar const* name;
+	while ( dir && ( name = g_dir_read_name( dir ) ) )
+	{
+		gchar* path = g_build_filename( directory, name, NULL );
+		g_unlink( path );
+		g_free( path );
+	}
+	if ( dir ) { g_dir_close( dir ); }
+
+	gchar* parent = g_path_get_dirname( directory );
+	g_rmdir( directory );
+	g_rmdir( parent );
+	g_free( parent );
+	g_free( directory );
+}
+
+guint store_file_count( gchar const* directory )
+{
+	guint count = 0;
+	GDir* dir = g_dir_open( directory, 0, NULL );
+	while ( dir && g_dir_read_name( dir ) ) { ++count; }
+	if ( dir ) { g_dir_close( dir ); }
+	return count;
+}
+
+void store_add_cb(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	FoobarNotificationImageStore* store = FOOBAR_NOTIFICATION_IMAGE_STORE( object );
+	StoreAddResult* add_result = (StoreAddResult*)userdata;
+
+	add_result->hash = foobar_notification_image_store_add_finish( store, result, NULL );
+	add_result->is_done = TRUE;
+}
+
+gsize store_file_size( gchar const* directory )
+{
+	gsize size = 0;
+	GDir* dir = g_dir_open( directory, 0, NULL );
+	gchar const* name;
+	while ( dir && ( name = g_dir_read_name( dir ) ) )
+	{
+		gchar* path = g_build_filename( directory, name, NULL );
+		GStatBuf stat_buf;
+		if ( g_stat( path, &stat_buf ) == 0 ) { size += (gsize)stat_buf.st_size; }
+		g_free( path );
+	}
+	if ( dir ) { g_dir_close( dir ); }
+	return size;
+}
+
+static void image_store_suite( void )
+{
+	mutest_it( "stores identical images once", deduplication_spec );
+	mutest_it( "prunes unreferenced images", prune_spec );
+	mutest_it( "compresses stored images", compression_spec );
+	mutest_it( "stores a history of 1000 images", history_spec );
+	mutest_it( "loads uncompressed images", uncompressed_spec );
+	mutest_it( "returns images stored after being cancelled", cancelled_add_spec );
+	mutest_it( "rejects invalid hashes", invalid_hash_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Image Store", image_store_suite );
+)
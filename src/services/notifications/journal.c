@@ -0,0 +1,1009 @@
+#include "services/notifications/journal.h"
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#define FLUSH_DELAY            150
+#define COMPACTION_MIN_GARBAGE 256
+#define INDEX_MAGIC            0x58444e49
+#define INDEX_VERSION          6
+#define INDEX_DIGEST_LENGTH    16
+#define INDEX_FLAG_DISMISSED   ( 1 << 0 )
+
+//
+// FoobarNotificationJournal:
+//
+// An append-only log of changes to the list of notifications, stored as one JSON object per line:
+//
+//   {"type":"add","id":1,"notification":{...}}
+//   {"type":"dismiss","id":1}
+//   {"type":"remove","id":1}
+//
+// Records are collected in memory and written in batches (followed by a single fsync) shortly after they were appended,
+// with at most one write in flight at a time. Once the number of superseded records exceeds a threshold, the journal is
+// compacted in the background by rewriting it from a snapshot of the live notifications, which is requested from the
+// owner through a callback and serialized right away, so the worker thread never accesses the owner's objects.
+//
+// Every compaction also writes a binary index next to the journal, containing a fixed-size entry (ID, timestamp,
+// dismissed flag, size and the location of its record) for each notification in the snapshot, followed by its image
+// hash and group key. At startup, the indexed part of the journal can be loaded without parsing any JSON, and only the
+// records appended after the last compaction are replayed in full.
+//
+
+struct _FoobarNotificationJournal
+{
+	GObject                                parent_instance;
+	gchar*                                 path;
+	gchar*                                 index_path;
+	FoobarNotificationJournalSnapshotFunc  snapshot_func;
+	FoobarNotificationJournalSerializeFunc serialize_func;
+	gpointer                               userdata;
+	GString*                               pending;
+	GHashTable*                            live_ids;
+	guint                                  record_count;
+	guint                                  flush_id;
+	gboolean                               is_writing;
+	gboolean                               needs_compaction;
+	GMutex                                 write_mutex;
+	GCond                                  write_cond;
+	gboolean                               is_write_running;
+};
+
+//
+// JournalWriteJob:
+//
+// Task data for writing to the journal on a background thread. Either a batch of serialized records to append, or the
+// serialized snapshot to replace the journal's contents with, together with the entries of its index.
+//
+
+typedef struct _JournalWriteJob JournalWriteJob;
+
+struct _JournalWriteJob
+{
+	GBytes*  records;
+	GBytes*  index_entries;
+	guint    index_count;
+	gboolean is_snapshot;
+};
+
+//
+// JournalIndexHeader:
+//
+// Header of the index file. The index only describes the journal file with the given inode number, up to the given
+// length, and only if the first and the last line of that part still have the given MD5 digest (inode numbers can be
+// reused once the journal was replaced). Only hashing these two lines keeps validation independent of the size of the
+// history, and together with the per-record checks, it still detects a journal that was rewritten in place. Everything
+// is stored in native byte order, because the index is just a cache and can always be rebuilt.
+//
+
+typedef struct _JournalIndexHeader JournalIndexHeader;
+
+struct _JournalIndexHeader
+{
+	guint32 magic;
+	guint32 version;
+	guint64 inode;
+	guint64 length;
+	guint32 count;
+	guint32 reserved;
+	guint8  digest[INDEX_DIGEST_LENGTH];
+};
+
+//
+// JournalIndexRecord:
+//
+// A single entry of the index file, followed by the image hash and the group key (both without a terminating null
+// character).
+//
+
+typedef struct _JournalIndexRecord JournalIndexRecord;
+
+struct _JournalIndexRecord
+{
+	guint32 id;
+	guint32 flags;
+	gint64  time;
+	guint64 size;
+	guint64 offset;
+	guint32 length;
+	guint32 image_hash_length;
+	guint32 group_key_length;
+	guint32 reserved;
+};
+
+G_STATIC_ASSERT( sizeof( JournalIndexHeader ) == 48 );
+G_STATIC_ASSERT( sizeof( JournalIndexRecord ) == 48 );
+
+static void         foobar_notification_journal_class_init        ( FoobarNotificationJournalClass*      klass );
+static void         foobar_notification_journal_init              ( FoobarNotificationJournal*           self );
+static void         foobar_notification_journal_finalize          ( GObject*                             object );
+static void         foobar_notification_journal_schedule_flush    ( FoobarNotificationJournal*           self );
+static gboolean     foobar_notification_journal_handle_flush      ( gpointer                             userdata );
+static void         foobar_notification_journal_start_write       ( FoobarNotificationJournal*           self );
+static void         foobar_notification_journal_write_cb          ( GObject*                             object,
+                                                                    GAsyncResult*                        result,
+                                                                    gpointer                             userdata );
+static void         foobar_notification_journal_write_thread      ( GTask*                               task,
+                                                                    gpointer                             source_object,
+                                                                    gpointer                             task_data,
+                                                                    GCancellable*                        cancellable );
+static gboolean     foobar_notification_journal_append_records    ( FoobarNotificationJournal*           self,
+                                                                    gchar const*                         data,
+                                                                    gsize                                length,
+                                                                    GError**                             error );
+static void         foobar_notification_journal_serialize_snapshot( FoobarNotificationJournal*           self,
+                                                                    GPtrArray*                           snapshot,
+                                                                    JournalWriteJob*                     job );
+static gboolean     foobar_notification_journal_replace_records   ( FoobarNotificationJournal*           self,
+                                                                    GBytes*                              records,
+                                                                    GBytes*                              index_entries,
+                                                                    guint                                index_count,
+                                                                    GError**                             error );
+static void         foobar_notification_journal_track_record      ( FoobarNotificationJournal*           self,
+                                                                    FoobarNotificationJournalRecordType  type,
+                                                                    guint                                id );
+static gboolean     foobar_notification_journal_replay_index      ( FoobarNotificationJournal*           self,
+                                                                    GMappedFile*                         file,
+                                                                    FoobarNotificationJournalIndexFunc   func,
+                                                                    gpointer                             userdata,
+                                                                    gsize*                               out_length );
+static gboolean     foobar_notification_journal_write_index       ( FoobarNotificationJournal*           self,
+                                                                    GBytes*                              entries,
+                                                                    guint                                count,
+                                                                    gchar const*                         data,
+                                                                    gsize                                length,
+                                                                    GError**                             error );
+static void         journal_write_record                          ( GString*                             output,
+                                                                    FoobarNotificationJournalRecordType  type,
+                                                                    guint                                id,
+                                                                    JsonNode*                            payload );
+static gchar const* journal_record_type_to_string                 ( FoobarNotificationJournalRecordType  type );
+static gboolean     journal_record_type_from_string               ( gchar const*                         value,
+                                                                    FoobarNotificationJournalRecordType* out_type );
+static void         journal_compute_digest                        ( gchar const*                         data,
+                                                                    gsize                                length,
+                                                                    guint8*                              out_digest );
+static void         journal_write_job_free                        ( JournalWriteJob*                     job );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationJournal, foobar_notification_journal, G_TYPE_OBJECT )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Journal
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the journal.
+//
+void foobar_notification_journal_class_init( FoobarNotificationJournalClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->finalize = foobar_notification_journal_finalize;
+}
+
+//
+// Instance initialization for the journal.
+//
+void foobar_notification_journal_init( FoobarNotificationJournal* self )
+{
+	self->pending = g_string_new( NULL );
+	self->live_ids = g_hash_table_new( g_direct_hash, g_direct_equal );
+	g_mutex_init( &self->write_mutex );
+	g_cond_init( &self->write_cond );
+}
+
+//
+// Instance cleanup for the journal.
+//
+// Records which were not written yet are flushed synchronously, after waiting for a running write to complete.
+//
+void foobar_notification_journal_finalize( GObject* object )
+{
+	FoobarNotificationJournal* self = (FoobarNotificationJournal*)object;
+
+	foobar_notification_journal_close( self );
+
+	g_clear_pointer( &self->path, g_free );
+	g_clear_pointer( &self->index_path, g_free );
+	g_clear_pointer( &self->live_ids, g_hash_table_unref );
+	if ( self->pending ) { g_string_free( g_steal_pointer( &self->pending ), TRUE ); }
+
+	g_mutex_clear( &self->write_mutex );
+	g_cond_clear( &self->write_cond );
+
+	G_OBJECT_CLASS( foobar_notification_journal_parent_class )->finalize( object );
+}
+
+//
+// Create a new journal stored at the given path.
+//
+// snapshot_func is invoked on the main thread when the journal is compacted and returns a new array of (referenced)
+// items to store. serialize_func converts such an item to a record payload and fills in its index entry, and it is
+// invoked right after the snapshot was taken, also on the main thread.
+//
+FoobarNotificationJournal* foobar_notification_journal_new(
+	gchar const*                           path,
+	FoobarNotificationJournalSnapshotFunc  snapshot_func,
+	FoobarNotificationJournalSerializeFunc serialize_func,
+	gpointer                               userdata )
+{
+	g_return_val_if_fail( snapshot_func != NULL, NULL );
+	g_return_val_if_fail( serialize_func != NULL, NULL );
+
+	FoobarNotificationJournal* self = g_object_new( FOOBAR_TYPE_NOTIFICATION_JOURNAL, NULL );
+	self->path = g_strdup( path );
+	self->index_path = path ? g_strconcat( path, ".index", NULL ) : NULL;
+	self->snapshot_func = snapshot_func;
+	self->serialize_func = serialize_func;
+	self->userdata = userdata;
+	return self;
+}
+
+//
+// Synchronously read all records from the journal, invoking func for each of them in order.
+//
+// Lines which cannot be parsed (e.g. a record that was only partially written before a crash) are skipped. A journal
+// that does not exist yet is treated as empty.
+//
+gboolean foobar_notification_journal_replay(
+	FoobarNotificationJournal*          self,
+	FoobarNotificationJournalReplayFunc func,
+	gpointer                            userdata,
+	GError**                            error )
+{
+	return foobar_notification_journal_replay_indexed( self, NULL, func, userdata, error );
+}
+
+//
+// Synchronously read the journal like foobar_notification_journal_replay, but use the index written by the last
+// compaction if it is still valid: index_func is invoked once for each indexed notification (in order), and func is
+// only invoked for the records appended afterwards.
+//
+// The entries passed to index_func reference their unparsed records, which can be parsed on demand using
+// foobar_notification_journal_parse_record. If there is no valid index yet, a compaction is scheduled to create one.
+//
+gboolean foobar_notification_journal_replay_indexed(
+	FoobarNotificationJournal*          self,
+	FoobarNotificationJournalIndexFunc  index_func,
+	FoobarNotificationJournalReplayFunc func,
+	gpointer                            userdata,
+	GError**                            error )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_JOURNAL( self ), FALSE );
+	g_return_val_if_fail( func != NULL, FALSE );
+
+	if ( !foobar_notification_journal_exists( self ) ) { return TRUE; }
+
+	g_autoptr( GMappedFile ) file = g_mapped_file_new( self->path, FALSE, error );
+	if ( !file ) { return FALSE; }
+
+	gchar const* contents = g_mapped_file_get_contents( file );
+	gsize length = g_mapped_file_get_length( file );
+	g_autoptr( JsonParser ) parser = json_parser_new( );
+
+	gsize position = 0;
+	if ( index_func && !foobar_notification_journal_replay_index( self, file, index_func, userdata, &position ) )
+	{
+		self->needs_compaction = length > 0;
+	}
+
+	while ( position < length )
+	{
+		gchar const* line = contents + position;
+		gchar const* line_end = memchr( line, '\n', length - position );
+		gsize line_length = line_end ? (gsize)( line_end - line ) : length - position;
+		position += line_length + 1;
+
+		if ( line_length == 0 ) { continue; }
+
+		g_autoptr( GError ) line_error = NULL;
+		if ( !json_parser_load_from_data( parser, line, (gssize)line_length, &line_error ) )
+		{
+			g_warning( "Skipping invalid notification journal record: %s", line_error->message );
+			continue;
+		}
+
+		JsonNode* root_node = json_parser_get_root( parser );
+		JsonObject* record = JSON_NODE_HOLDS_OBJECT( root_node ) ? json_node_get_object( root_node ) : NULL;
+		FoobarNotificationJournalRecordType type;
+		if ( !record || !journal_record_type_from_string( json_object_get_string_member_with_default( record, "type", NULL ), &type ) )
+		{
+			g_warning( "Skipping notification journal record with unknown type." );
+			continue;
+		}
+
+		guint id = json_object_get_int_member_with_default( record, "id", 0 );
+		JsonObject* payload = json_object_has_member( record, "notification" ) ?
+			json_object_get_object_member( record, "notification" ) :
+			NULL;
+
+		foobar_notification_journal_track_record( self, type, id );
+		func( type, id, payload, userdata );
+	}
+
+	if ( self->needs_compaction ) { foobar_notification_journal_schedule_flush( self ); }
+
+	return TRUE;
+}
+
+//
+// Parse a record referenced by an index entry, returning its notification payload.
+//
+JsonObject* foobar_notification_journal_parse_record(
+	GBytes*  record,
+	GError** error )
+{
+	g_return_val_if_fail( record != NULL, NULL );
+
+	gsize length;
+	gchar const* data = g_bytes_get_data( record, &length );
+	g_autoptr( JsonParser ) parser = json_parser_new( );
+	if ( !json_parser_load_from_data( parser, data, (gssize)length, error ) ) { return NULL; }
+
+	JsonNode* root_node = json_parser_get_root( parser );
+	JsonObject* object = JSON_NODE_HOLDS_OBJECT( root_node ) ? json_node_get_object( root_node ) : NULL;
+	JsonNode* payload_node = object ? json_object_get_member( object, "notification" ) : NULL;
+	if ( !payload_node || !JSON_NODE_HOLDS_OBJECT( payload_node ) )
+	{
+		g_set_error_literal( error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Notification journal record has no payload." );
+		return NULL;
+	}
+
+	return json_object_ref( json_node_get_object( payload_node ) );
+}
+
+//
+// Check whether the journal file was already created.
+//
+gboolean foobar_notification_journal_exists( FoobarNotificationJournal* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_JOURNAL( self ), FALSE );
+
+	return self->path && g_file_test( self->path, G_FILE_TEST_EXISTS );
+}
+
+//
+// Append a record to the journal. The payload (the serialized notification) is only used for "add" and "update"
+// records.
+//
+// The record is written asynchronously together with other records appended around the same time.
+//
+void foobar_notification_journal_append(
+	FoobarNotificationJournal*          self,
+	FoobarNotificationJournalRecordType type,
+	guint                               id,
+	JsonNode*                           payload )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_JOURNAL( self ) );
+
+	if ( !self->path ) { return; }
+
+	journal_write_record( self->pending, type, id, payload );
+	foobar_notification_journal_track_record( self, type, id );
+	foobar_notification_journal_schedule_flush( self );
+}
+
+//
+// Request the journal to be rewritten from a snapshot of the live notifications, regardless of the amount of garbage.
+//
+void foobar_notification_journal_compact( FoobarNotificationJournal* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_JOURNAL( self ) );
+
+	if ( !self->path || !self->snapshot_func ) { return; }
+
+	self->needs_compaction = TRUE;
+	foobar_notification_journal_schedule_flush( self );
+}
+
+//
+// Synchronously write all pending records to the journal and stop any further background work.
+//
+// A write that is still running is waited for first. Otherwise, a compaction could replace the journal with its older
+// snapshot after the pending records were appended, losing them.
+//
+// The owner must call this before it is destroyed, because the snapshot callback is not invoked afterwards.
+//
+void foobar_notification_journal_close( FoobarNotificationJournal* self )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_JOURNAL( self ) );
+
+	self->snapshot_func = NULL;
+	self->needs_compaction = FALSE;
+	g_clear_handle_id( &self->flush_id, g_source_remove );
+
+	g_mutex_lock( &self->write_mutex );
+	while ( self->is_write_running ) { g_cond_wait( &self->write_cond, &self->write_mutex ); }
+	g_mutex_unlock( &self->write_mutex );
+
+	if ( !self->path || self->pending->len == 0 ) { return; }
+
+	g_autoptr( GError ) error = NULL;
+	if ( !foobar_notification_journal_append_records( self, self->pending->str, self->pending->len, &error ) )
+	{
+		g_warning( "Unable to write notification journal: %s", error->message );
+	}
+
+	g_string_truncate( self->pending, 0 );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Start the timeout for writing the next batch, unless a write is already scheduled or running (in which case the
+// batch will be written once it has completed).
+//
+void foobar_notification_journal_schedule_flush( FoobarNotificationJournal* self )
+{
+	if ( self->flush_id || self->is_writing || !self->snapshot_func ) { return; }
+
+	self->flush_id = g_timeout_add_full(
+		G_PRIORITY_LOW,
+		FLUSH_DELAY,
+		foobar_notification_journal_handle_flush,
+		g_object_ref( self ),
+		g_object_unref );
+}
+
+//
+// Called once the flush delay has elapsed.
+//
+gboolean foobar_notification_journal_handle_flush( gpointer userdata )
+{
+	FoobarNotificationJournal* self = (FoobarNotificationJournal*)userdata;
+
+	self->flush_id = 0;
+	foobar_notification_journal_start_write( self );
+
+	return G_SOURCE_REMOVE;
+}
+
+//
+// Hand the pending records (or a compacted snapshot) to a background thread.
+//
+// A snapshot already reflects all changes that were recorded so far, so pending records are discarded in that case.
+//
+void foobar_notification_journal_start_write( FoobarNotificationJournal* self )
+{
+	if ( self->is_writing ) { return; }
+
+	JournalWriteJob* job = g_new0( JournalWriteJob, 1 );
+	if ( self->needs_compaction )
+	{
+		g_autoptr( GPtrArray ) snapshot = self->snapshot_func( self->userdata );
+		foobar_notification_journal_serialize_snapshot( self, snapshot, job );
+		self->record_count = snapshot->len;
+		self->needs_compaction = FALSE;
+		g_string_truncate( self->pending, 0 );
+	}
+	else if ( self->pending->len > 0 )
+	{
+		job->records = g_string_free_to_bytes( self->pending );
+		self->pending = g_string_new( NULL );
+	}
+	else
+	{
+		journal_write_job_free( job );
+		return;
+	}
+
+	// is_writing is only reset once the result was dispatched to the main thread, so the worker tracks whether it is still
+	// running separately for foobar_notification_journal_close.
+
+	self->is_writing = TRUE;
+	g_mutex_lock( &self->write_mutex );
+	self->is_write_running = TRUE;
+	g_mutex_unlock( &self->write_mutex );
+
+	g_autoptr( GTask ) task = g_task_new( self, NULL, foobar_notification_journal_write_cb, NULL );
+	g_task_set_name( task, "write-notification-journal" );
+	g_task_set_task_data( task, job, (GDestroyNotify)journal_write_job_free );
+	g_task_run_in_thread( task, foobar_notification_journal_write_thread );
+}
+
+//
+// Callback invoked when a batch was written successfully or failed, starting the next batch if necessary.
+//
+void foobar_notification_journal_write_cb(
+	GObject*      object,
+	GAsyncResult* result,
+	gpointer      userdata )
+{
+	(void)userdata;
+	FoobarNotificationJournal* self = (FoobarNotificationJournal*)object;
+
+	self->is_writing = FALSE;
+
+	g_autoptr( GError ) error = NULL;
+	if ( !g_task_propagate_boolean( G_TASK( result ), &error ) )
+	{
+		g_warning( "Unable to write notification journal: %s", error->message );
+	}
+
+	if ( self->pending->len > 0 || self->needs_compaction ) { foobar_notification_journal_schedule_flush( self ); }
+}
+
+//
+// Task implementation for writing a batch, invoked on a background thread.
+//
+void foobar_notification_journal_write_thread(
+	GTask*        task,
+	gpointer      source_object,
+	gpointer      task_data,
+	GCancellable* cancellable )
+{
+	(void)cancellable;
+	FoobarNotificationJournal* self = (FoobarNotificationJournal*)source_object;
+	JournalWriteJob* job = (JournalWriteJob*)task_data;
+
+	g_autoptr( GError ) error = NULL;
+	gboolean success;
+	if ( job->is_snapshot )
+	{
+		success = foobar_notification_journal_replace_records(
+			self,
+			job->records,
+			job->index_entries,
+			job->index_count,
+			&error );
+	}
+	else
+	{
+		gsize length;
+		gchar const* data = g_bytes_get_data( job->records, &length );
+		success = foobar_notification_journal_append_records( self, data, length, &error );
+	}
+
+	g_mutex_lock( &self->write_mutex );
+	self->is_write_running = FALSE;
+	g_cond_broadcast( &self->write_cond );
+	g_mutex_unlock( &self->write_mutex );
+
+	if ( !success )
+	{
+		g_task_return_error( task, g_steal_pointer( &error ) );
+		return;
+	}
+
+	g_task_return_boolean( task, TRUE );
+}
+
+//
+// Append serialized records to the end of the journal file and wait for them to reach the disk.
+//
+gboolean foobar_notification_journal_append_records(
+	FoobarNotificationJournal* self,
+	gchar const*               data,
+	gsize                      length,
+	GError**                   error )
+{
+	g_autoptr( GMutexLocker ) locker = g_mutex_locker_new( &self->write_mutex );
+
+	int fd = g_open( self->path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600 );
+	if ( fd < 0 )
+	{
+		int saved_errno = errno;
+		g_set_error(
+			error,
+			G_FILE_ERROR,
+			g_file_error_from_errno( saved_errno ),
+			"Unable to open %s: %s",
+			self->path,
+			g_strerror( saved_errno ) );
+		return FALSE;
+	}
+
+	while ( length > 0 )
+	{
+		gssize written = write( fd, data, length );
+		if ( written < 0 )
+		{
+			int saved_errno = errno;
+			if ( saved_errno == EINTR ) { continue; }
+
+			g_set_error(
+				error,
+				G_FILE_ERROR,
+				g_file_error_from_errno( saved_errno ),
+				"Unable to write %s: %s",
+				self->path,
+				g_strerror( saved_errno ) );
+			close( fd );
+			return FALSE;
+		}
+
+		data += written;
+		length -= (gsize)written;
+	}
+
+	if ( fsync( fd ) < 0 )
+	{
+		int saved_errno = errno;
+		g_set_error(
+			error,
+			G_FILE_ERROR,
+			g_file_error_from_errno( saved_errno ),
+			"Unable to sync %s: %s",
+			self->path,
+			g_strerror( saved_errno ) );
+		close( fd );
+		return FALSE;
+	}
+
+	return g_close( fd, error );
+}
+
+//
+// Serialize a snapshot into a write job, producing one "add" record per item and the corresponding index entries.
+//
+// This runs on the main thread, so the items may change again as soon as it returns.
+//
+void foobar_notification_journal_serialize_snapshot(
+	FoobarNotificationJournal* self,
+	GPtrArray*                 snapshot,
+	JournalWriteJob*           job )
+{
+	g_autoptr( GString ) output = g_string_new( NULL );
+	g_autoptr( GByteArray ) entries = g_byte_array_new( );
+	for ( guint i = 0; i < snapshot->len; ++i )
+	{
+		FoobarNotificationJournalEntry entry = { 0 };
+		g_autoptr( JsonNode ) payload = self->serialize_func( g_ptr_array_index( snapshot, i ), &entry );
+		gsize offset = output->len;
+		journal_write_record( output, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, entry.id, payload );
+
+		JournalIndexRecord index_record = {
+			.id = entry.id,
+			.flags = entry.is_dismissed ? INDEX_FLAG_DISMISSED : 0,
+			.time = entry.time,
+			.size = entry.size,
+			.offset = offset,
+			.length = (guint32)( output->len - offset - 1 ),
+			.image_hash_length = entry.image_hash ? (guint32)strlen( entry.image_hash ) : 0,
+			.group_key_length = entry.group_key ? (guint32)strlen( entry.group_key ) : 0,
+		};
+		g_byte_array_append( entries, (guint8 const*)&index_record, sizeof( index_record ) );
+		if ( entry.image_hash )
+		{
+			g_byte_array_append( entries, (guint8 const*)entry.image_hash, index_record.image_hash_length );
+		}
+		if ( entry.group_key )
+		{
+			g_byte_array_append( entries, (guint8 const*)entry.group_key, index_record.group_key_length );
+		}
+	}
+
+	job->records = g_string_free_to_bytes( g_steal_pointer( &output ) );
+	job->index_entries = g_byte_array_free_to_bytes( g_steal_pointer( &entries ) );
+	job->index_count = snapshot->len;
+	job->is_snapshot = TRUE;
+}
+
+//
+// Atomically replace the journal with a serialized snapshot, and write a new index for it.
+//
+// Failing to write the index is not an error, because the journal can still be replayed without it.
+//
+gboolean foobar_notification_journal_replace_records(
+	FoobarNotificationJournal* self,
+	GBytes*                    records,
+	GBytes*                    index_entries,
+	guint                      index_count,
+	GError**                   error )
+{
+	gsize length;
+	gchar const* data = g_bytes_get_data( records, &length );
+
+	g_autoptr( GMutexLocker ) locker = g_mutex_locker_new( &self->write_mutex );
+	gboolean success = g_file_set_contents_full(
+		self->path,
+		data,
+		(gssize)length,
+		G_FILE_SET_CONTENTS_CONSISTENT | G_FILE_SET_CONTENTS_DURABLE,
+		0600,
+		error );
+	if ( !success ) { return FALSE; }
+
+	g_autoptr( GError ) index_error = NULL;
+	if ( !foobar_notification_journal_write_index( self, index_entries, index_count, data, length, &index_error ) )
+	{
+		g_warning( "Unable to write notification journal index: %s", index_error->message );
+	}
+
+	return TRUE;
+}
+
+//
+// Write the index for a journal file that was just replaced, given the serialized index records and the contents of the
+// journal.
+//
+gboolean foobar_notification_journal_write_index(
+	FoobarNotificationJournal* self,
+	GBytes*                    entries,
+	guint                      count,
+	gchar const*               data,
+	gsize                      length,
+	GError**                   error )
+{
+	GStatBuf stat_buf;
+	if ( g_stat( self->path, &stat_buf ) < 0 )
+	{
+		int saved_errno = errno;
+		g_set_error(
+			error,
+			G_FILE_ERROR,
+			g_file_error_from_errno( saved_errno ),
+			"Unable to stat %s: %s",
+			self->path,
+			g_strerror( saved_errno ) );
+		return FALSE;
+	}
+
+	JournalIndexHeader header = {
+		.magic = INDEX_MAGIC,
+		.version = INDEX_VERSION,
+		.inode = stat_buf.st_ino,
+		.length = length,
+		.count = count,
+	};
+	journal_compute_digest( data, length, header.digest );
+
+	gsize entries_length;
+	guint8 const* entries_data = g_bytes_get_data( entries, &entries_length );
+	g_autoptr( GByteArray ) output = g_byte_array_sized_new( sizeof( header ) + entries_length );
+	g_byte_array_append( output, (guint8 const*)&header, sizeof( header ) );
+	g_byte_array_append( output, entries_data, entries_length );
+
+	return g_file_set_contents_full(
+		self->index_path,
+		(gchar const*)output->data,
+		(gssize)output->len,
+		G_FILE_SET_CONTENTS_CONSISTENT,
+		0600,
+		error );
+}
+
+//
+// Update the bookkeeping of live IDs after a record was appended or replayed, and decide whether the journal should be
+// compacted.
+//
+// The journal is compacted once the number of records that no longer describe a live notification exceeds both a fixed
+// threshold and the number of live notifications, so the file stays within a constant factor of its minimal size.
+//
+void foobar_notification_journal_track_record(
+	FoobarNotificationJournal*          self,
+	FoobarNotificationJournalRecordType type,
+	guint                               id )
+{
+	switch ( type )
+	{
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD:
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE:
+			g_hash_table_add( self->live_ids, GUINT_TO_POINTER( id ) );
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE:
+			g_hash_table_remove( self->live_ids, GUINT_TO_POINTER( id ) );
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS:
+			break;
+		default:
+			g_warn_if_reached( );
+			break;
+	}
+
+	self->record_count += 1;
+
+	guint live_count = g_hash_table_size( self->live_ids );
+	guint garbage_count = self->record_count > live_count ? self->record_count - live_count : 0;
+	if ( garbage_count > COMPACTION_MIN_GARBAGE && garbage_count > live_count ) { self->needs_compaction = TRUE; }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Index
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Invoke func for each entry of the index if it matches the mapped journal file and report the length of the indexed
+// part of the journal, returning FALSE if there is no valid index.
+//
+// All entries are validated before the first one is reported, so a corrupt index never results in a partial load.
+//
+gboolean foobar_notification_journal_replay_index(
+	FoobarNotificationJournal*         self,
+	GMappedFile*                       file,
+	FoobarNotificationJournalIndexFunc func,
+	gpointer                           userdata,
+	gsize*                             out_length )
+{
+	g_autofree gchar* index = NULL;
+	gsize data_length;
+	if ( !g_file_get_contents( self->index_path, &index, &data_length, NULL ) ) { return FALSE; }
+
+	GStatBuf stat_buf;
+	if ( g_stat( self->path, &stat_buf ) < 0 ) { return FALSE; }
+
+	JournalIndexHeader header;
+	if ( data_length < sizeof( header ) ) { return FALSE; }
+	memcpy( &header, index, sizeof( header ) );
+
+	gchar const* contents = g_mapped_file_get_contents( file );
+	gsize length = g_mapped_file_get_length( file );
+	if ( header.magic != INDEX_MAGIC ||
+		header.version != INDEX_VERSION ||
+		header.inode != (guint64)stat_buf.st_ino ||
+		header.length > length )
+	{
+		return FALSE;
+	}
+
+	guint8 digest[INDEX_DIGEST_LENGTH];
+	journal_compute_digest( contents, header.length, digest );
+	if ( memcmp( digest, header.digest, sizeof( digest ) ) ) { return FALSE; }
+
+	gsize position = sizeof( header );
+	for ( guint i = 0; i < header.count; ++i )
+	{
+		JournalIndexRecord record;
+		if ( data_length - position < sizeof( record ) ) { return FALSE; }
+		memcpy( &record, index + position, sizeof( record ) );
+		position += sizeof( record );
+
+		if ( data_length - position < record.image_hash_length ) { return FALSE; }
+		position += record.image_hash_length;
+		if ( data_length - position < record.group_key_length ) { return FALSE; }
+		position += record.group_key_length;
+
+		if ( record.offset >= header.length || header.length - record.offset <= record.length ) { return FALSE; }
+		if ( record.offset > 0 && contents[record.offset - 1] != '\n' ) { return FALSE; }
+		if ( contents[record.offset] != '{' || contents[record.offset + record.length] != '\n' ) { return FALSE; }
+	}
+
+	g_autoptr( GBytes ) bytes = g_mapped_file_get_bytes( file );
+	position = sizeof( header );
+	for ( guint i = 0; i < header.count; ++i )
+	{
+		JournalIndexRecord record;
+		memcpy( &record, index + position, sizeof( record ) );
+		position += sizeof( record );
+
+		g_autofree gchar* image_hash = record.image_hash_length ?
+			g_strndup( index + position, record.image_hash_length ) :
+			NULL;
+		position += record.image_hash_length;
+		g_autofree gchar* group_key = record.group_key_length ?
+			g_strndup( index + position, record.group_key_length ) :
+			NULL;
+		position += record.group_key_length;
+
+		g_autoptr( GBytes ) record_bytes = g_bytes_new_from_bytes( bytes, record.offset, record.length );
+		FoobarNotificationJournalEntry entry = {
+			.id = record.id,
+			.time = record.time,
+			.is_dismissed = ( record.flags & INDEX_FLAG_DISMISSED ) != 0,
+			.size = record.size,
+			.image_hash = image_hash,
+			.group_key = group_key,
+			.record = record_bytes,
+		};
+
+		foobar_notification_journal_track_record( self, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, record.id );
+		func( &entry, userdata );
+	}
+
+	*out_length = header.length;
+	return TRUE;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Serialize a single record as a line of JSON and append it to output.
+//
+void journal_write_record(
+	GString*                            output,
+	FoobarNotificationJournalRecordType type,
+	guint                               id,
+	JsonNode*                           payload )
+{
+	g_autoptr( JsonBuilder ) builder = json_builder_new( );
+	json_builder_begin_object( builder );
+
+	json_builder_set_member_name( builder, "type" );
+	json_builder_add_string_value( builder, journal_record_type_to_string( type ) );
+
+	json_builder_set_member_name( builder, "id" );
+	json_builder_add_int_value( builder, id );
+
+	if ( payload )
+	{
+		json_builder_set_member_name( builder, "notification" );
+		json_builder_add_value( builder, json_node_copy( payload ) );
+	}
+
+	json_builder_end_object( builder );
+
+	g_autoptr( JsonNode ) root_node = json_builder_get_root( builder );
+	g_autofree gchar* line = json_to_string( root_node, FALSE );
+	g_string_append( output, line );
+	g_string_append_c( output, '\n' );
+}
+
+//
+// Get the textual representation of a record type.
+//
+gchar const* journal_record_type_to_string( FoobarNotificationJournalRecordType type )
+{
+	switch ( type )
+	{
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD:
+			return "add";
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE:
+			return "update";
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS:
+			return "dismiss";
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE:
+			return "remove";
+		default:
+			g_warn_if_reached( );
+			return NULL;
+	}
+}
+
+//
+// Parse the textual representation of a record type, returning FALSE if it is unknown.
+//
+gboolean journal_record_type_from_string(
+	gchar const*                         value,
+	FoobarNotificationJournalRecordType* out_type )
+{
+	if ( !g_strcmp0( value, "add" ) ) { *out_type = FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD; }
+	else if ( !g_strcmp0( value, "update" ) ) { *out_type = FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE; }
+	else if ( !g_strcmp0( value, "dismiss" ) ) { *out_type = FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS; }
+	else if ( !g_strcmp0( value, "remove" ) ) { *out_type = FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE; }
+	else { return FALSE; }
+
+	return TRUE;
+}
+
+//
+// Compute the digest of the indexed part of the journal, which is stored in the index's header.
+//
+// Only the first and the last line are hashed, so the cost does not depend on the number of records.
+//
+void journal_compute_digest(
+	gchar const* data,
+	gsize        length,
+	guint8*      out_digest )
+{
+	g_autoptr( GChecksum ) checksum = g_checksum_new( G_CHECKSUM_MD5 );
+
+	gchar const* first_end = length > 0 ? memchr( data, '\n', length ) : NULL;
+	gsize first_length = first_end ? (gsize)( first_end - data ) + 1 : length;
+	g_checksum_update( checksum, (guchar const*)data, (gssize)first_length );
+
+	if ( first_length < length )
+	{
+		gsize last_start = length - 1;
+		while ( last_start > first_length && data[last_start - 1] != '\n' ) { last_start -= 1; }
+		g_checksum_update( checksum, (guchar const*)( data + last_start ), (gssize)( length - last_start ) );
+	}
+
+	gsize digest_length = INDEX_DIGEST_LENGTH;
+	g_checksum_get_digest( checksum, out_digest, &digest_length );
+}
+
+//
+// Release the data associated with a write task.
+//
+void journal_write_job_free( JournalWriteJob* job )
+{
+	g_clear_pointer( &job->records, g_bytes_unref );
+	g_clear_pointer( &job->index_entries, g_bytes_unref );
+	g_free( job );
+}
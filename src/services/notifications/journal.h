@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glib-object.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_NOTIFICATION_JOURNAL foobar_notification_journal_get_type( )
+
+typedef enum
+{
+	FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD,
+	FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE,
+	FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS,
+	FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE,
+} FoobarNotificationJournalRecordType;
+
+//
+// FoobarNotificationJournalEntry:
+//
+// Summary of a stored notification as kept in the journal's index, which is enough to sort, filter and group
+// notifications without parsing their records. The record itself is only set when the entry is read from the index.
+//
+
+typedef struct _FoobarNotificationJournalEntry FoobarNotificationJournalEntry;
+
+struct _FoobarNotificationJournalEntry
+{
+	guint        id;
+	gint64       time;
+	gboolean     is_dismissed;
+	guint64      size;
+	gchar const* image_hash;
+	gchar const* group_key;
+	GBytes*      record;
+};
+
+typedef void       ( *FoobarNotificationJournalReplayFunc )   ( FoobarNotificationJournalRecordType type,
+                                                                guint                               id,
+                                                                JsonObject*                         payload,
+                                                                gpointer                            userdata );
+typedef void       ( *FoobarNotificationJournalIndexFunc )    ( FoobarNotificationJournalEntry*     entry,
+                                                                gpointer                            userdata );
+typedef GPtrArray* ( *FoobarNotificationJournalSnapshotFunc ) ( gpointer                            userdata );
+typedef JsonNode*  ( *FoobarNotificationJournalSerializeFunc )( gpointer                            item,
+                                                                FoobarNotificationJournalEntry*     out_entry );
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationJournal, foobar_notification_journal, FOOBAR, NOTIFICATION_JOURNAL, GObject )
+
+FoobarNotificationJournal* foobar_notification_journal_new           ( gchar const*                           path,
+                                                                       FoobarNotificationJournalSnapshotFunc  snapshot_func,
+                                                                       FoobarNotificationJournalSerializeFunc serialize_func,
+                                                                       gpointer                               userdata );
+gboolean                   foobar_notification_journal_replay        ( FoobarNotificationJournal*             self,
+                                                                       FoobarNotificationJournalReplayFunc    func,
+                                                                       gpointer                               userdata,
+                                                                       GError**                               error );
+gboolean                   foobar_notification_journal_replay_indexed( FoobarNotificationJournal*             self,
+                                                                       FoobarNotificationJournalIndexFunc     index_func,
+                                                                       FoobarNotificationJournalReplayFunc    func,
+                                                                       gpointer                               userdata,
+                                                                       GError**                               error );
+JsonObject*                foobar_notification_journal_parse_record  ( GBytes*                                record,
+                                                                       GError**                               error );
+gboolean                   foobar_notification_journal_exists        ( FoobarNotificationJournal*             self );
+void                       foobar_notification_journal_append        ( FoobarNotificationJournal*             self,
+                                                                       FoobarNotificationJournalRecordType    type,
+                                                                       guint                                  id,
+                                                                       JsonNode*                              payload );
+void                       foobar_notification_journal_compact       ( FoobarNotificationJournal*             self );
+void                       foobar_notification_journal_close         ( FoobarNotificationJournal*             self );
+
+G_END_DECLS
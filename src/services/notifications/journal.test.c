@@ -0,0 +1,349 @@
+#include "services/notifications/journal.h"
+#include <glib/gstdio.h>
+#include <mutest.h>
+#include <stdio.h>
+#include <string.h>
+
+static GPtrArray* snapshot_func         ( gpointer                            userdata );
+static JsonNode*  serialize_func        ( gpointer                            item,
+                                          FoobarNotificationJournalEntry*     out_entry );
+static void       replay_func           ( FoobarNotificationJournalRecordType type,
+                                          guint                               id,
+                                          JsonObject*                         payload,
+                                          gpointer                            userdata );
+static void       index_func            ( FoobarNotificationJournalEntry*     entry,
+                                          gpointer                            userdata );
+static JsonNode*  payload_new           ( gchar const*                        summary );
+static gchar*     journal_path_new      ( void );
+static void       journal_path_free     ( gchar*                              path );
+static gchar*     journal_replay_path   ( gchar const*                        path );
+static gchar*     journal_replay_index  ( gchar const*                        path );
+static void       journal_wait_for_index( gchar const*                        path );
+
+static void round_trip_spec( void )
+{
+	gchar* path = journal_path_new( );
+
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, NULL );
+	JsonNode* first = payload_new( "first" );
+	JsonNode* second = payload_new( "second" );
+	foobar_notification_journal_append( journal, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, 1, first );
+	foobar_notification_journal_append( journal, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, 2, second );
+	foobar_notification_journal_append( journal, FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS, 1, NULL );
+	foobar_notification_journal_append( journal, FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE, 2, NULL );
+	foobar_notification_journal_close( journal );
+	g_object_unref( journal );
+	json_node_unref( first );
+	json_node_unref( second );
+
+	gchar* replayed = journal_replay_path( path );
+	mutest_expect(
+		"replayed records",
+		mutest_string_value( replayed ),
+		mutest_to_be,
+		"add:1:first,add:2:second,dismiss:1,remove:2,",
+		NULL );
+
+	g_free( replayed );
+	journal_path_free( path );
+}
+
+static void corrupt_record_spec( void )
+{
+	gchar* path = journal_path_new( );
+
+	gchar const* contents =
+		"{\"type\":\"add\",\"id\":1,\"notification\":{\"summary\":\"first\"}}\n"
+		"{\"type\":\"add\",\"id\":\n"
+		"{\"type\":\"unknown\",\"id\":3}\n"
+		"\n"
+		"{\"type\":\"remove\",\"id\":1}\n"
+		"{\"type\":\"add\",\"id\":4,\"notification\":{\"summary\":\"trunc";
+	g_file_set_contents( path, contents, -1, NULL );
+
+	gchar* replayed = journal_replay_path( path );
+	mutest_expect(
+		"replayed records",
+		mutest_string_value( replayed ),
+		mutest_to_be,
+		"add:1:first,remove:1,",
+		NULL );
+
+	g_free( replayed );
+	journal_path_free( path );
+}
+
+static void missing_journal_spec( void )
+{
+	gchar* path = journal_path_new( );
+
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, NULL );
+	mutest_expect(
+		"journal exists",
+		mutest_bool_value( foobar_notification_journal_exists( journal ) ),
+		mutest_to_be_false,
+		NULL );
+
+	gchar* replayed = journal_replay_path( path );
+	mutest_expect(
+		"replayed records",
+		mutest_string_value( replayed ),
+		mutest_to_be,
+		"",
+		NULL );
+
+	g_free( replayed );
+	g_object_unref( journal );
+	journal_path_free( path );
+}
+
+static void indexed_replay_spec( void )
+{
+	gchar* path = journal_path_new( );
+
+	GPtrArray* items = g_ptr_array_new( );
+	for ( guint id = 1; id <= 3; ++id ) { g_ptr_array_add( items, GUINT_TO_POINTER( id ) ); }
+
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, items );
+	foobar_notification_journal_compact( journal );
+	journal_wait_for_index( path );
+
+	// Records appended after the compaction are not covered by the index.
+	JsonNode* fourth = payload_new( "fourth" );
+	foobar_notification_journal_append( journal, FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS, 1, NULL );
+	foobar_notification_journal_append( journal, FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD, 4, fourth );
+	foobar_notification_journal_close( journal );
+	g_object_unref( journal );
+	json_node_unref( fourth );
+
+	gchar* replayed = journal_replay_index( path );
+	mutest_expect(
+		"replayed entries and records",
+		mutest_string_value( replayed ),
+		mutest_to_be,
+		"index:1:100:item1@app,index:2:200:item2@app:dismissed,index:3:300:item3,dismiss:1,add:4:fourth,",
+		NULL );
+
+	g_free( replayed );
+	g_ptr_array_unref( items );
+	journal_path_free( path );
+}
+
+static void stale_index_spec( void )
+{
+	gchar* path = journal_path_new( );
+
+	GPtrArray* items = g_ptr_array_new( );
+	g_ptr_array_add( items, GUINT_TO_POINTER( 1 ) );
+
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, items );
+	foobar_notification_journal_compact( journal );
+	journal_wait_for_index( path );
+	foobar_notification_journal_close( journal );
+	g_object_unref( journal );
+
+	// Replacing the journal leaves an index for a different file behind.
+	g_file_set_contents( path, "{\"type\":\"add\",\"id\":2,\"notification\":{\"summary\":\"second\"}}\n", -1, NULL );
+
+	gchar* replayed = journal_replay_index( path );
+	mutest_expect(
+		"replayed records",
+		mutest_string_value( replayed ),
+		mutest_to_be,
+		"add:2:second,",
+		NULL );
+
+	g_free( replayed );
+	g_ptr_array_unref( items );
+	journal_path_free( path );
+}
+
+static void rewritten_journal_spec( void )
+{
+	gchar* path = journal_path_new( );
+
+	GPtrArray* items = g_ptr_array_new( );
+	g_ptr_array_add( items, GUINT_TO_POINTER( 1 ) );
+
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, items );
+	foobar_notification_journal_compact( journal );
+	journal_wait_for_index( path );
+	foobar_notification_journal_close( journal );
+	g_object_unref( journal );
+
+	// Rewriting the journal in place keeps its inode, length and line structure, but not its contents.
+	gchar* contents;
+	gsize length;
+	g_file_get_contents( path, &contents, &length, NULL );
+	gchar* summary = strstr( contents, "item1" );
+	memcpy( summary, "other", 5 );
+	FILE* file = fopen( path, "r+" );
+	fwrite( contents, 1, length, file );
+	fclose( file );
+	g_free( contents );
+
+	gchar* replayed = journal_replay_index( path );
+	mutest_expect(
+		"replayed records",
+		mutest_string_value( replayed ),
+		mutest_to_be,
+		"add:1:other,",
+		NULL );
+
+	g_free( replayed );
+	g_ptr_array_unref( items );
+	journal_path_free( path );
+}
+
+GPtrArray* snapshot_func( gpointer userdata )
+{
+	GPtrArray* items = (GPtrArray*)userdata;
+
+	return items ? g_ptr_array_ref( items ) : g_ptr_array_new( );
+}
+
+JsonNode* serialize_func(
+	gpointer                        item,
+	FoobarNotificationJournalEntry* out_entry )
+{
+	guint id = GPOINTER_TO_UINT( item );
+	out_entry->id = id;
+	out_entry->time = id * 100;
+	out_entry->is_dismissed = id == 2;
+	out_entry->group_key = id != 3 ? "app" : NULL;
+
+	gchar* summary = g_strdup_printf( "item%u", id );
+	JsonNode* payload = payload_new( summary );
+	g_free( summary );
+	return payload;
+}
+
+void replay_func(
+	FoobarNotificationJournalRecordType type,
+	guint                               id,
+	JsonObject*                         payload,
+	gpointer                            userdata )
+{
+	GString* output = (GString*)userdata;
+
+	switch ( type )
+	{
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_ADD:
+			g_string_append_printf( output, "add:%u", id );
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_UPDATE:
+			g_string_append_printf( output, "update:%u", id );
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_DISMISS:
+			g_string_append_printf( output, "dismiss:%u", id );
+			break;
+		case FOOBAR_NOTIFICATION_JOURNAL_RECORD_REMOVE:
+			g_string_append_printf( output, "remove:%u", id );
+			break;
+		default:
+			g_string_append( output, "?" );
+			break;
+	}
+
+	if ( payload )
+	{
+		g_string_append_printf( output, ":%s", json_object_get_string_member_with_default( payload, "summary", "" ) );
+	}
+
+	g_string_append_c( output, ',' );
+}
+
+void index_func(
+	FoobarNotificationJournalEntry* entry,
+	gpointer                        userdata )
+{
+	GString* output = (GString*)userdata;
+
+	JsonObject* payload = foobar_notification_journal_parse_record( entry->record, NULL );
+	g_string_append_printf(
+		output,
+		"index:%u:%" G_GINT64_FORMAT ":%s%s%s%s,",
+		entry->id,
+		entry->time,
+		payload ? json_object_get_string_member_with_default( payload, "summary", "" ) : "?",
+		entry->group_key ? "@" : "",
+		entry->group_key ? entry->group_key : "",
+		entry->is_dismissed ? ":dismissed" : "" );
+	if ( payload ) { json_object_unref( payload ); }
+}
+
+JsonNode* payload_new( gchar const* summary )
+{
+	JsonObject* object = json_object_new( );
+	json_object_set_string_member( object, "summary", summary );
+
+	JsonNode* node = json_node_new( JSON_NODE_OBJECT );
+	json_node_take_object( node, object );
+	return node;
+}
+
+gchar* journal_path_new( void )
+{
+	gchar* directory = g_dir_make_tmp( "foobar-journal-XXXXXX", NULL );
+	gchar* path = g_build_filename( directory, "notifications.journal", NULL );
+	g_free( directory );
+	return path;
+}
+
+void journal_path_free( gchar* path )
+{
+	gchar* directory = g_path_get_dirname( path );
+	gchar* index_path = g_strconcat( path, ".index", NULL );
+	g_unlink( index_path );
+	g_unlink( path );
+	g_rmdir( directory );
+	g_free( index_path );
+	g_free( directory );
+	g_free( path );
+}
+
+gchar* journal_replay_path( gchar const* path )
+{
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, NULL );
+	GString* output = g_string_new( NULL );
+	foobar_notification_journal_replay( journal, replay_func, output, NULL );
+	foobar_notification_journal_close( journal );
+	g_object_unref( journal );
+	return g_string_free( output, FALSE );
+}
+
+gchar* journal_replay_index( gchar const* path )
+{
+	FoobarNotificationJournal* journal = foobar_notification_journal_new( path, snapshot_func, serialize_func, NULL );
+	GString* output = g_string_new( NULL );
+	foobar_notification_journal_replay_indexed( journal, index_func, replay_func, output, NULL );
+	foobar_notification_journal_close( journal );
+	g_object_unref( journal );
+	return g_string_free( output, FALSE );
+}
+
+void journal_wait_for_index( gchar const* path )
+{
+	gchar* index_path = g_strconcat( path, ".index", NULL );
+	gint64 deadline = g_get_monotonic_time( ) + 5 * G_TIME_SPAN_SECOND;
+	while ( !g_file_test( index_path, G_FILE_TEST_EXISTS ) && g_get_monotonic_time( ) < deadline )
+	{
+		g_main_context_iteration( NULL, FALSE );
+		g_usleep( 1000 );
+	}
+	g_free( index_path );
+}
+
+static void journal_suite( void )
+{
+	mutest_it( "replays appended records in order", round_trip_spec );
+	mutest_it( "skips corrupt and truncated records", corrupt_record_spec );
+	mutest_it( "treats a missing journal as empty", missing_journal_spec );
+	mutest_it( "replays indexed entries followed by newer records", indexed_replay_spec );
+	mutest_it( "ignores an index of a replaced journal", stale_index_spec );
+	mutest_it( "ignores an index of a journal rewritten in place", rewritten_journal_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Journal", journal_suite );
+)
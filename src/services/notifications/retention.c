@@ -0,0 +1,243 @@
+#include "services/notifications/retention.h"
+
+//
+// FoobarNotificationRetention:
+//
+// An eviction index for the notification history, deciding which notifications are removed once the history exceeds
+// its limits for the number of notifications, their age or their total size.
+//
+// Notifications are kept in a queue ordered by their timestamps, so the next candidate for eviction is always at its
+// head and enforcing the limits never requires a scan over all notifications. A limit of zero disables the respective
+// check.
+//
+
+struct _FoobarNotificationRetention
+{
+	GObject     parent_instance;
+	GQueue      entries;
+	GHashTable* links;
+	guint64     size;
+	guint       max_count;
+	GTimeSpan   max_age;
+	guint64     max_size;
+};
+
+//
+// RetentionEntry:
+//
+// A single notification tracked by the eviction index.
+//
+
+typedef struct _RetentionEntry RetentionEntry;
+
+struct _RetentionEntry
+{
+	guint  id;
+	gint64 time;
+	gsize  size;
+};
+
+static void     foobar_notification_retention_class_init ( FoobarNotificationRetentionClass* klass );
+static void     foobar_notification_retention_init       ( FoobarNotificationRetention*      self );
+static void     foobar_notification_retention_finalize   ( GObject*                          object );
+static void     foobar_notification_retention_remove_link( FoobarNotificationRetention*      self,
+                                                           GList*                            link );
+static gboolean foobar_notification_retention_is_exceeded( FoobarNotificationRetention*      self,
+                                                           gint64                            now );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationRetention, foobar_notification_retention, G_TYPE_OBJECT )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Retention
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the eviction index.
+//
+void foobar_notification_retention_class_init( FoobarNotificationRetentionClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->finalize = foobar_notification_retention_finalize;
+}
+
+//
+// Instance initialization for the eviction index.
+//
+void foobar_notification_retention_init( FoobarNotificationRetention* self )
+{
+	g_queue_init( &self->entries );
+	self->links = g_hash_table_new( g_direct_hash, g_direct_equal );
+}
+
+//
+// Instance cleanup for the eviction index.
+//
+void foobar_notification_retention_finalize( GObject* object )
+{
+	FoobarNotificationRetention* self = (FoobarNotificationRetention*)object;
+
+	g_queue_clear_full( &self->entries, g_free );
+	g_clear_pointer( &self->links, g_hash_table_unref );
+
+	G_OBJECT_CLASS( foobar_notification_retention_parent_class )->finalize( object );
+}
+
+//
+// Create a new eviction index without any limits.
+//
+FoobarNotificationRetention* foobar_notification_retention_new( void )
+{
+	return g_object_new( FOOBAR_TYPE_NOTIFICATION_RETENTION, NULL );
+}
+
+//
+// Number of notifications currently tracked.
+//
+guint foobar_notification_retention_get_count( FoobarNotificationRetention* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ), 0 );
+	return self->entries.length;
+}
+
+//
+// Total size of all notifications currently tracked in bytes.
+//
+guint64 foobar_notification_retention_get_size( FoobarNotificationRetention* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ), 0 );
+	return self->size;
+}
+
+//
+// Update the limits for the number of notifications, their age in microseconds and their total size in bytes.
+//
+// This does not evict anything by itself, foobar_notification_retention_pop_evicted needs to be called afterwards.
+//
+void foobar_notification_retention_set_limits(
+	FoobarNotificationRetention* self,
+	guint                        max_count,
+	GTimeSpan                    max_age,
+	guint64                      max_size )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ) );
+
+	self->max_count = max_count;
+	self->max_age = MAX( max_age, 0 );
+	self->max_size = max_size;
+}
+
+//
+// Start tracking a notification with the given ID, timestamp (as returned by g_get_real_time) and size, or update it
+// if it is already tracked. Notifications are expected to be tracked in chronological order, so a notification with an
+// updated timestamp is moved to the end of the queue.
+//
+void foobar_notification_retention_track(
+	FoobarNotificationRetention* self,
+	guint                        id,
+	gint64                       time,
+	gsize                        size )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ) );
+
+	// If only the size changed, the entry can keep its position in the queue.
+
+	GList* link = g_hash_table_lookup( self->links, GUINT_TO_POINTER( id ) );
+	if ( link && ( (RetentionEntry*)link->data )->time == time )
+	{
+		RetentionEntry* entry = link->data;
+		self->size = self->size - entry->size + size;
+		entry->size = size;
+		return;
+	}
+
+	if ( link ) { foobar_notification_retention_remove_link( self, link ); }
+
+	RetentionEntry* entry = g_new0( RetentionEntry, 1 );
+	entry->id = id;
+	entry->time = time;
+	entry->size = size;
+
+	g_queue_push_tail( &self->entries, entry );
+	g_hash_table_insert( self->links, GUINT_TO_POINTER( id ), self->entries.tail );
+	self->size += size;
+}
+
+//
+// Stop tracking the notification with the given ID, if it is tracked at all.
+//
+void foobar_notification_retention_untrack(
+	FoobarNotificationRetention* self,
+	guint                        id )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ) );
+
+	GList* link = g_hash_table_lookup( self->links, GUINT_TO_POINTER( id ) );
+	if ( link ) { foobar_notification_retention_remove_link( self, link ); }
+}
+
+//
+// If any of the limits is exceeded at the given time, stop tracking the oldest notification and return its ID.
+//
+// This should be called repeatedly until it returns FALSE, evicting one notification at a time.
+//
+gboolean foobar_notification_retention_pop_evicted(
+	FoobarNotificationRetention* self,
+	gint64                       now,
+	guint*                       out_id )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ), FALSE );
+	g_return_val_if_fail( out_id != NULL, FALSE );
+
+	if ( !foobar_notification_retention_is_exceeded( self, now ) ) { return FALSE; }
+
+	RetentionEntry* entry = g_queue_peek_head( &self->entries );
+	*out_id = entry->id;
+	foobar_notification_retention_remove_link( self, self->entries.head );
+	return TRUE;
+}
+
+//
+// Get the time at which the oldest notification exceeds the age limit, or -1 if there is no such time.
+//
+gint64 foobar_notification_retention_get_expiration( FoobarNotificationRetention* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_RETENTION( self ), -1 );
+
+	RetentionEntry* entry = g_queue_peek_head( &self->entries );
+	if ( !entry || !self->max_age ) { return -1; }
+
+	return entry->time + self->max_age;
+}
+
+//
+// Remove an entry from both the queue and the lookup table.
+//
+void foobar_notification_retention_remove_link(
+	FoobarNotificationRetention* self,
+	GList*                       link )
+{
+	RetentionEntry* entry = link->data;
+	g_hash_table_remove( self->links, GUINT_TO_POINTER( entry->id ) );
+	g_queue_delete_link( &self->entries, link );
+	self->size -= entry->size;
+	g_free( entry );
+}
+
+//
+// Check whether any of the limits is exceeded at the given time.
+//
+gboolean foobar_notification_retention_is_exceeded(
+	FoobarNotificationRetention* self,
+	gint64                       now )
+{
+	RetentionEntry* entry = g_queue_peek_head( &self->entries );
+	if ( !entry ) { return FALSE; }
+
+	// A single notification exceeding the size limit on its own is kept, so it can still be displayed.
+
+	if ( self->max_count && self->entries.length > self->max_count ) { return TRUE; }
+	if ( self->max_size && self->size > self->max_size && self->entries.length > 1 ) { return TRUE; }
+	if ( self->max_age && entry->time + self->max_age <= now ) { return TRUE; }
+
+	return FALSE;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_NOTIFICATION_RETENTION foobar_notification_retention_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationRetention, foobar_notification_retention, FOOBAR, NOTIFICATION_RETENTION, GObject )
+
+FoobarNotificationRetention* foobar_notification_retention_new            ( void );
+guint                        foobar_notification_retention_get_count      ( FoobarNotificationRetention* self );
+guint64                      foobar_notification_retention_get_size       ( FoobarNotificationRetention* self );
+void                         foobar_notification_retention_set_limits     ( FoobarNotificationRetention* self,
+                                                                            guint                        max_count,
+                                                                            GTimeSpan                    max_age,
+                                                                            guint64                      max_size );
+void                         foobar_notification_retention_track          ( FoobarNotificationRetention* self,
+                                                                            guint                        id,
+                                                                            gint64                       time,
+                                                                            gsize                        size );
+void                         foobar_notification_retention_untrack        ( FoobarNotificationRetention* self,
+                                                                            guint                        id );
+gboolean                     foobar_notification_retention_pop_evicted    ( FoobarNotificationRetention* self,
+                                                                            gint64                       now,
+                                                                            guint*                       out_id );
+gint64                       foobar_notification_retention_get_expiration ( FoobarNotificationRetention* self );
+
+G_END_DECLS
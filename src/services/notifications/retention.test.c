@@ -0,0 +1,170 @@
+#include "services/notifications/retention.h"
+#include <mutest.h>
+
+static GArray* retention_pop_all( FoobarNotificationRetention* retention,
+                                  gint64                       now );
+
+static void count_spec( void )
+{
+	FoobarNotificationRetention* retention = foobar_notification_retention_new( );
+	foobar_notification_retention_set_limits( retention, 2, 0, 0 );
+	foobar_notification_retention_track( retention, 1, 100, 10 );
+	foobar_notification_retention_track( retention, 2, 200, 10 );
+	foobar_notification_retention_track( retention, 3, 300, 10 );
+
+	GArray* evicted = retention_pop_all( retention, 300 );
+	mutest_expect(
+		"evicted notifications",
+		mutest_int_value( evicted->len ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"evicted oldest notification",
+		mutest_int_value( g_array_index( evicted, guint, 0 ) ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"remaining size",
+		mutest_int_value( foobar_notification_retention_get_size( retention ) ),
+		mutest_to_be,
+		20,
+		NULL );
+
+	g_array_unref( evicted );
+	g_object_unref( retention );
+}
+
+static void age_spec( void )
+{
+	FoobarNotificationRetention* retention = foobar_notification_retention_new( );
+	foobar_notification_retention_set_limits( retention, 0, 1000, 0 );
+	foobar_notification_retention_track( retention, 1, 100, 10 );
+	foobar_notification_retention_track( retention, 2, 600, 10 );
+
+	mutest_expect(
+		"expiration of oldest notification",
+		mutest_int_value( foobar_notification_retention_get_expiration( retention ) ),
+		mutest_to_be,
+		1100,
+		NULL );
+
+	GArray* evicted = retention_pop_all( retention, 1099 );
+	mutest_expect(
+		"nothing evicted before expiration",
+		mutest_int_value( evicted->len ),
+		mutest_to_be,
+		0,
+		NULL );
+	g_array_unref( evicted );
+
+	evicted = retention_pop_all( retention, 1100 );
+	mutest_expect(
+		"evicted notifications",
+		mutest_int_value( evicted->len ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"next expiration",
+		mutest_int_value( foobar_notification_retention_get_expiration( retention ) ),
+		mutest_to_be,
+		1600,
+		NULL );
+
+	g_array_unref( evicted );
+	g_object_unref( retention );
+}
+
+static void size_spec( void )
+{
+	FoobarNotificationRetention* retention = foobar_notification_retention_new( );
+	foobar_notification_retention_set_limits( retention, 0, 0, 100 );
+	foobar_notification_retention_track( retention, 1, 100, 40 );
+	foobar_notification_retention_track( retention, 2, 200, 40 );
+
+	// Growing an existing notification keeps its position in the queue.
+	foobar_notification_retention_track( retention, 1, 100, 70 );
+
+	GArray* evicted = retention_pop_all( retention, 200 );
+	mutest_expect(
+		"evicted notifications",
+		mutest_int_value( evicted->len ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"evicted grown notification",
+		mutest_int_value( g_array_index( evicted, guint, 0 ) ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"remaining size",
+		mutest_int_value( foobar_notification_retention_get_size( retention ) ),
+		mutest_to_be,
+		40,
+		NULL );
+
+	g_array_unref( evicted );
+	g_object_unref( retention );
+}
+
+static void replace_spec( void )
+{
+	FoobarNotificationRetention* retention = foobar_notification_retention_new( );
+	foobar_notification_retention_set_limits( retention, 2, 0, 0 );
+	foobar_notification_retention_track( retention, 1, 100, 10 );
+	foobar_notification_retention_track( retention, 2, 200, 10 );
+
+	// A replacement gets a new timestamp and moves to the end of the queue.
+	foobar_notification_retention_track( retention, 1, 300, 10 );
+	foobar_notification_retention_track( retention, 3, 400, 10 );
+	foobar_notification_retention_untrack( retention, 4 );
+
+	GArray* evicted = retention_pop_all( retention, 400 );
+	mutest_expect(
+		"evicted notifications",
+		mutest_int_value( evicted->len ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"evicted oldest notification",
+		mutest_int_value( g_array_index( evicted, guint, 0 ) ),
+		mutest_to_be,
+		2,
+		NULL );
+	mutest_expect(
+		"remaining notifications",
+		mutest_int_value( foobar_notification_retention_get_count( retention ) ),
+		mutest_to_be,
+		2,
+		NULL );
+
+	g_array_unref( evicted );
+	g_object_unref( retention );
+}
+
+GArray* retention_pop_all(
+	FoobarNotificationRetention* retention,
+	gint64                       now )
+{
+	GArray* evicted = g_array_new( FALSE, FALSE, sizeof( guint ) );
+	guint id;
+	while ( foobar_notification_retention_pop_evicted( retention, now, &id ) ) { g_array_append_val( evicted, id ); }
+	return evicted;
+}
+
+static void retention_suite( void )
+{
+	mutest_it( "evicts the oldest notifications beyond the count limit", count_spec );
+	mutest_it( "evicts notifications once they are too old", age_spec );
+	mutest_it( "evicts notifications beyond the size limit", size_spec );
+	mutest_it( "moves replaced notifications to the end", replace_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Retention", retention_suite );
+)
@@ -0,0 +1,260 @@
+#include "services/notifications/search-index.h"
+#include <string.h>
+
+//
+// FoobarNotificationSearchIndex:
+//
+// An inverted index over the text of notifications, mapping each term to the set of notification IDs containing it.
+//
+// Text is split into terms using g_str_tokenize_and_fold, so matching is case-insensitive and ASCII alternates of
+// accented terms are indexed as well. Terms are kept in a balanced tree, so all terms starting with a query token form
+// a contiguous range that is found in O(log n) -- every query token is treated as a prefix, which lets results update
+// while the user is still typing a word.
+//
+// Each notification's terms are remembered as well, so a notification can be replaced or removed without a scan over
+// the whole index.
+//
+
+struct _FoobarNotificationSearchIndex
+{
+	GObject     parent_instance;
+	GTree*      terms;
+	GHashTable* documents;
+};
+
+static void        foobar_notification_search_index_class_init( FoobarNotificationSearchIndexClass* klass );
+static void        foobar_notification_search_index_init      ( FoobarNotificationSearchIndex*      self );
+static void        foobar_notification_search_index_finalize  ( GObject*                            object );
+static GHashTable* foobar_notification_search_index_match     ( FoobarNotificationSearchIndex*      self,
+                                                                gchar const*                        prefix );
+static void        foobar_notification_search_index_intersect ( GHashTable*                         matches,
+                                                                GHashTable*                         other );
+static gint        foobar_notification_search_index_compare   ( gconstpointer                       term_a,
+                                                                gconstpointer                       term_b,
+                                                                gpointer                            userdata );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationSearchIndex, foobar_notification_search_index, G_TYPE_OBJECT )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Search Index
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the search index.
+//
+void foobar_notification_search_index_class_init( FoobarNotificationSearchIndexClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->finalize = foobar_notification_search_index_finalize;
+}
+
+//
+// Instance initialization for the search index.
+//
+void foobar_notification_search_index_init( FoobarNotificationSearchIndex* self )
+{
+	self->terms = g_tree_new_full(
+		foobar_notification_search_index_compare,
+		NULL,
+		g_free,
+		(GDestroyNotify)g_hash_table_unref );
+	self->documents = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_strfreev );
+}
+
+//
+// Instance cleanup for the search index.
+//
+void foobar_notification_search_index_finalize( GObject* object )
+{
+	FoobarNotificationSearchIndex* self = (FoobarNotificationSearchIndex*)object;
+
+	g_clear_pointer( &self->terms, g_tree_unref );
+	g_clear_pointer( &self->documents, g_hash_table_unref );
+
+	G_OBJECT_CLASS( foobar_notification_search_index_parent_class )->finalize( object );
+}
+
+//
+// Create a new, empty search index.
+//
+FoobarNotificationSearchIndex* foobar_notification_search_index_new( void )
+{
+	return g_object_new( FOOBAR_TYPE_NOTIFICATION_SEARCH_INDEX, NULL );
+}
+
+//
+// Number of notifications currently indexed.
+//
+guint foobar_notification_search_index_get_count( FoobarNotificationSearchIndex* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SEARCH_INDEX( self ), 0 );
+	return g_hash_table_size( self->documents );
+}
+
+//
+// Index the text of the notification with the given ID, replacing any text that was previously indexed for it.
+//
+void foobar_notification_search_index_add(
+	FoobarNotificationSearchIndex* self,
+	guint                          id,
+	gchar const*                   text )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_SEARCH_INDEX( self ) );
+
+	foobar_notification_search_index_remove( self, id );
+	if ( !text ) { return; }
+
+	g_auto( GStrv ) alternates = NULL;
+	g_auto( GStrv ) tokens = g_str_tokenize_and_fold( text, NULL, &alternates );
+
+	// Duplicate terms are only stored once per notification, so removing it later releases each term exactly once.
+
+	g_autoptr( GHashTable ) unique = g_hash_table_new( g_str_hash, g_str_equal );
+	for ( gchar** it = tokens; *it; ++it ) { g_hash_table_add( unique, *it ); }
+	for ( gchar** it = alternates; *it; ++it ) { g_hash_table_add( unique, *it ); }
+
+	guint count;
+	gchar const** terms = (gchar const**)g_hash_table_get_keys_as_array( unique, &count );
+	for ( guint i = 0; i < count; ++i )
+	{
+		GHashTable* postings = g_tree_lookup( self->terms, terms[i] );
+		if ( !postings )
+		{
+			postings = g_hash_table_new( g_direct_hash, g_direct_equal );
+			g_tree_insert( self->terms, g_strdup( terms[i] ), postings );
+		}
+		g_hash_table_add( postings, GUINT_TO_POINTER( id ) );
+	}
+
+	g_hash_table_insert( self->documents, GUINT_TO_POINTER( id ), g_strdupv( (gchar**)terms ) );
+	g_free( terms );
+}
+
+//
+// Remove the notification with the given ID from the index, if it is indexed at all.
+//
+void foobar_notification_search_index_remove(
+	FoobarNotificationSearchIndex* self,
+	guint                          id )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_SEARCH_INDEX( self ) );
+
+	gchar** terms = g_hash_table_lookup( self->documents, GUINT_TO_POINTER( id ) );
+	if ( !terms ) { return; }
+
+	for ( gchar** it = terms; *it; ++it )
+	{
+		GHashTable* postings = g_tree_lookup( self->terms, *it );
+		if ( !postings ) { continue; }
+
+		g_hash_table_remove( postings, GUINT_TO_POINTER( id ) );
+		if ( !g_hash_table_size( postings ) ) { g_tree_remove( self->terms, *it ); }
+	}
+
+	g_hash_table_remove( self->documents, GUINT_TO_POINTER( id ) );
+}
+
+//
+// Find all notifications matching every token of the query as a prefix of one of their terms.
+//
+// Returns a new set of notification IDs, or NULL if the query does not contain any tokens (i.e. nothing should be
+// filtered).
+//
+GHashTable* foobar_notification_search_index_query(
+	FoobarNotificationSearchIndex* self,
+	gchar const*                   query )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SEARCH_INDEX( self ), NULL );
+
+	if ( !query ) { return NULL; }
+
+	g_auto( GStrv ) tokens = g_str_tokenize_and_fold( query, NULL, NULL );
+	if ( !tokens[0] ) { return NULL; }
+
+	GHashTable* matches = foobar_notification_search_index_match( self, tokens[0] );
+	for ( gchar** it = tokens + 1; *it && g_hash_table_size( matches ); ++it )
+	{
+		g_autoptr( GHashTable ) other = foobar_notification_search_index_match( self, *it );
+		foobar_notification_search_index_intersect( matches, other );
+	}
+
+	return matches;
+}
+
+//
+// Check whether a single indexed notification matches every token of the query as a prefix of one of its terms.
+//
+// This avoids re-running the whole query when a notification is added or replaced while a search is active.
+//
+gboolean foobar_notification_search_index_matches(
+	FoobarNotificationSearchIndex* self,
+	guint                          id,
+	gchar const*                   query )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_SEARCH_INDEX( self ), FALSE );
+
+	gchar** terms = g_hash_table_lookup( self->documents, GUINT_TO_POINTER( id ) );
+	if ( !terms ) { return FALSE; }
+	if ( !query ) { return TRUE; }
+
+	g_auto( GStrv ) tokens = g_str_tokenize_and_fold( query, NULL, NULL );
+	for ( gchar** token = tokens; *token; ++token )
+	{
+		gboolean is_found = FALSE;
+		for ( gchar** it = terms; *it && !is_found; ++it ) { is_found = g_str_has_prefix( *it, *token ); }
+		if ( !is_found ) { return FALSE; }
+	}
+
+	return TRUE;
+}
+
+//
+// Collect the IDs of all notifications containing a term that starts with the given prefix.
+//
+GHashTable* foobar_notification_search_index_match(
+	FoobarNotificationSearchIndex* self,
+	gchar const*                   prefix )
+{
+	GHashTable* matches = g_hash_table_new( g_direct_hash, g_direct_equal );
+
+	for ( GTreeNode* node = g_tree_lower_bound( self->terms, prefix ); node; node = g_tree_node_next( node ) )
+	{
+		if ( !g_str_has_prefix( g_tree_node_key( node ), prefix ) ) { break; }
+
+		GHashTableIter iter;
+		gpointer id;
+		g_hash_table_iter_init( &iter, g_tree_node_value( node ) );
+		while ( g_hash_table_iter_next( &iter, &id, NULL ) ) { g_hash_table_add( matches, id ); }
+	}
+
+	return matches;
+}
+
+//
+// Remove all IDs from a set of matches that are not contained in another set.
+//
+void foobar_notification_search_index_intersect(
+	GHashTable* matches,
+	GHashTable* other )
+{
+	GHashTableIter iter;
+	gpointer id;
+	g_hash_table_iter_init( &iter, matches );
+	while ( g_hash_table_iter_next( &iter, &id, NULL ) )
+	{
+		if ( !g_hash_table_contains( other, id ) ) { g_hash_table_iter_remove( &iter ); }
+	}
+}
+
+//
+// Comparison function for terms in the tree. Terms are compared bytewise, so all terms sharing a prefix are adjacent.
+//
+gint foobar_notification_search_index_compare(
+	gconstpointer term_a,
+	gconstpointer term_b,
+	gpointer      userdata )
+{
+	(void)userdata;
+
+	return strcmp( term_a, term_b );
+}
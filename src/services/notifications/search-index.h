@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_NOTIFICATION_SEARCH_INDEX foobar_notification_search_index_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationSearchIndex, foobar_notification_search_index, FOOBAR, NOTIFICATION_SEARCH_INDEX, GObject )
+
+FoobarNotificationSearchIndex* foobar_notification_search_index_new      ( void );
+guint                          foobar_notification_search_index_get_count( FoobarNotificationSearchIndex* self );
+void                           foobar_notification_search_index_add      ( FoobarNotificationSearchIndex* self,
+                                                                           guint                          id,
+                                                                           gchar const*                   text );
+void                           foobar_notification_search_index_remove   ( FoobarNotificationSearchIndex* self,
+                                                                           guint                          id );
+GHashTable*                    foobar_notification_search_index_query    ( FoobarNotificationSearchIndex* self,
+                                                                           gchar const*                   query );
+gboolean                       foobar_notification_search_index_matches  ( FoobarNotificationSearchIndex* self,
+                                                                           guint                          id,
+                                                                           gchar const*                   query );
+
+G_END_DECLS
@@ -0,0 +1,174 @@
+#include "services/notifications/search-index.h"
+#include <mutest.h>
+
+static gchar* search_index_query      ( FoobarNotificationSearchIndex* index,
+                                       gchar const*                   query );
+static gint   search_index_compare_ids( gconstpointer                  id_a,
+                                       gconstpointer                  id_b );
+
+static void prefix_spec( void )
+{
+	FoobarNotificationSearchIndex* index = foobar_notification_search_index_new( );
+	foobar_notification_search_index_add( index, 1, "Firefox Download finished" );
+	foobar_notification_search_index_add( index, 2, "Discord New message from Finn" );
+	foobar_notification_search_index_add( index, 3, "Spotify Now playing" );
+
+	gchar* matches = search_index_query( index, "fi" );
+	mutest_expect(
+		"notifications with a term starting with the prefix",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"1,2",
+		NULL );
+	g_free( matches );
+
+	matches = search_index_query( index, "FIREFOX" );
+	mutest_expect(
+		"case-insensitive match",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"1",
+		NULL );
+	g_free( matches );
+
+	matches = search_index_query( index, "chrome" );
+	mutest_expect(
+		"no match",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"",
+		NULL );
+	g_free( matches );
+
+	g_object_unref( index );
+}
+
+static void tokens_spec( void )
+{
+	FoobarNotificationSearchIndex* index = foobar_notification_search_index_new( );
+	foobar_notification_search_index_add( index, 1, "Mail New message from Alice" );
+	foobar_notification_search_index_add( index, 2, "Mail New message from Bob" );
+	foobar_notification_search_index_add( index, 3, "Café opens at noon" );
+
+	gchar* matches = search_index_query( index, "message bo" );
+	mutest_expect(
+		"notifications matching all tokens",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"2",
+		NULL );
+	g_free( matches );
+
+	matches = search_index_query( index, "cafe" );
+	mutest_expect(
+		"match by ascii alternate",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"3",
+		NULL );
+	g_free( matches );
+
+	mutest_expect(
+		"empty query",
+		mutest_bool_value( foobar_notification_search_index_query( index, " " ) == NULL ),
+		mutest_to_be_true,
+		NULL );
+	mutest_expect(
+		"single notification matching",
+		mutest_bool_value( foobar_notification_search_index_matches( index, 1, "new ali" ) ),
+		mutest_to_be_true,
+		NULL );
+	mutest_expect(
+		"single notification not matching",
+		mutest_bool_value( foobar_notification_search_index_matches( index, 2, "new ali" ) ),
+		mutest_to_be_false,
+		NULL );
+
+	g_object_unref( index );
+}
+
+static void update_spec( void )
+{
+	FoobarNotificationSearchIndex* index = foobar_notification_search_index_new( );
+	foobar_notification_search_index_add( index, 1, "Download started" );
+	foobar_notification_search_index_add( index, 2, "Download started" );
+
+	// A replacement only keeps the terms of its new text.
+	foobar_notification_search_index_add( index, 1, "Upload finished" );
+	foobar_notification_search_index_remove( index, 2 );
+	foobar_notification_search_index_remove( index, 3 );
+
+	gchar* matches = search_index_query( index, "download" );
+	mutest_expect(
+		"no stale terms",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"",
+		NULL );
+	g_free( matches );
+
+	matches = search_index_query( index, "upload" );
+	mutest_expect(
+		"replaced notification",
+		mutest_string_value( matches ),
+		mutest_to_be,
+		"1",
+		NULL );
+	g_free( matches );
+
+	mutest_expect(
+		"indexed notifications",
+		mutest_int_value( foobar_notification_search_index_get_count( index ) ),
+		mutest_to_be,
+		1,
+		NULL );
+
+	g_object_unref( index );
+}
+
+gchar* search_index_query(
+	FoobarNotificationSearchIndex* index,
+	gchar const*                   query )
+{
+	GHashTable* matches = foobar_notification_search_index_query( index, query );
+	GArray* ids = g_array_new( FALSE, FALSE, sizeof( guint ) );
+	GHashTableIter iter;
+	gpointer id;
+	g_hash_table_iter_init( &iter, matches );
+	while ( g_hash_table_iter_next( &iter, &id, NULL ) )
+	{
+		guint value = GPOINTER_TO_UINT( id );
+		g_array_append_val( ids, value );
+	}
+
+	g_array_sort( ids, search_index_compare_ids );
+	GString* output = g_string_new( NULL );
+	for ( guint i = 0; i < ids->len; ++i )
+	{
+		g_string_append_printf( output, "%s%u", i ? "," : "", g_array_index( ids, guint, i ) );
+	}
+
+	g_array_unref( ids );
+	g_hash_table_unref( matches );
+	return g_string_free( output, FALSE );
+}
+
+gint search_index_compare_ids(
+	gconstpointer id_a,
+	gconstpointer id_b )
+{
+	guint a = *(guint const*)id_a;
+	guint b = *(guint const*)id_b;
+	return a < b ? -1 : a > b;
+}
+
+static void search_index_suite( void )
+{
+	mutest_it( "matches tokens as prefixes of terms", prefix_spec );
+	mutest_it( "matches notifications containing all tokens", tokens_spec );
+	mutest_it( "updates replaced and removed notifications", update_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Search Index", search_index_suite );
+)
@@ -0,0 +1,276 @@
+#include "services/notifications/timeouts.h"
+
+//
+// FoobarNotificationTimeouts:
+//
+// A binary min-heap of notification deadlines, so the notification service only needs a single timer for the earliest
+// deadline instead of one main loop source per notification.
+//
+// Each notification ID is contained at most once. A lookup table maps IDs to their positions in the heap, so deadlines
+// can be updated or cancelled in O(log n) when a notification is hovered or closed.
+//
+
+struct _FoobarNotificationTimeouts
+{
+	GObject     parent_instance;
+	GArray*     heap;
+	GHashTable* positions;
+};
+
+//
+// TimeoutEntry:
+//
+// A single deadline in the heap.
+//
+
+typedef struct _TimeoutEntry TimeoutEntry;
+
+struct _TimeoutEntry
+{
+	guint  id;
+	gint64 deadline;
+};
+
+static void  foobar_notification_timeouts_class_init( FoobarNotificationTimeoutsClass* klass );
+static void  foobar_notification_timeouts_init      ( FoobarNotificationTimeouts*      self );
+static void  foobar_notification_timeouts_finalize  ( GObject*                         object );
+static void  foobar_notification_timeouts_remove_at ( FoobarNotificationTimeouts*      self,
+                                                      guint                            position );
+static void  foobar_notification_timeouts_place     ( FoobarNotificationTimeouts*      self,
+                                                      guint                            position,
+                                                      TimeoutEntry                     entry );
+static guint foobar_notification_timeouts_sift_up   ( FoobarNotificationTimeouts*      self,
+                                                      guint                            position );
+static guint foobar_notification_timeouts_sift_down ( FoobarNotificationTimeouts*      self,
+                                                      guint                            position );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationTimeouts, foobar_notification_timeouts, G_TYPE_OBJECT )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Timeouts
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the deadline heap.
+//
+void foobar_notification_timeouts_class_init( FoobarNotificationTimeoutsClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->finalize = foobar_notification_timeouts_finalize;
+}
+
+//
+// Instance initialization for the deadline heap.
+//
+void foobar_notification_timeouts_init( FoobarNotificationTimeouts* self )
+{
+	self->heap = g_array_new( FALSE, FALSE, sizeof( TimeoutEntry ) );
+	self->positions = g_hash_table_new( g_direct_hash, g_direct_equal );
+}
+
+//
+// Instance cleanup for the deadline heap.
+//
+void foobar_notification_timeouts_finalize( GObject* object )
+{
+	FoobarNotificationTimeouts* self = (FoobarNotificationTimeouts*)object;
+
+	g_clear_pointer( &self->heap, g_array_unref );
+	g_clear_pointer( &self->positions, g_hash_table_unref );
+
+	G_OBJECT_CLASS( foobar_notification_timeouts_parent_class )->finalize( object );
+}
+
+//
+// Create a new, empty deadline heap.
+//
+FoobarNotificationTimeouts* foobar_notification_timeouts_new( void )
+{
+	return g_object_new( FOOBAR_TYPE_NOTIFICATION_TIMEOUTS, NULL );
+}
+
+//
+// Number of scheduled deadlines.
+//
+guint foobar_notification_timeouts_get_count( FoobarNotificationTimeouts* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_TIMEOUTS( self ), 0 );
+	return self->heap->len;
+}
+
+//
+// Check whether a deadline is scheduled for the notification with the given ID.
+//
+gboolean foobar_notification_timeouts_contains(
+	FoobarNotificationTimeouts* self,
+	guint                       id )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_TIMEOUTS( self ), FALSE );
+	return g_hash_table_contains( self->positions, GUINT_TO_POINTER( id ) );
+}
+
+//
+// Schedule a deadline (in the time base of g_get_monotonic_time) for the notification with the given ID, replacing any
+// deadline that was previously scheduled for it.
+//
+void foobar_notification_timeouts_schedule(
+	FoobarNotificationTimeouts* self,
+	guint                       id,
+	gint64                      deadline )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_TIMEOUTS( self ) );
+
+	TimeoutEntry entry = { .id = id, .deadline = deadline };
+
+	gpointer value;
+	if ( g_hash_table_lookup_extended( self->positions, GUINT_TO_POINTER( id ), NULL, &value ) )
+	{
+		guint position = GPOINTER_TO_UINT( value );
+		foobar_notification_timeouts_place( self, position, entry );
+		position = foobar_notification_timeouts_sift_up( self, position );
+		foobar_notification_timeouts_sift_down( self, position );
+		return;
+	}
+
+	g_array_set_size( self->heap, self->heap->len + 1 );
+	foobar_notification_timeouts_place( self, self->heap->len - 1, entry );
+	foobar_notification_timeouts_sift_up( self, self->heap->len - 1 );
+}
+
+//
+// Cancel the deadline for the notification with the given ID, returning FALSE if none was scheduled.
+//
+gboolean foobar_notification_timeouts_cancel(
+	FoobarNotificationTimeouts* self,
+	guint                       id )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_TIMEOUTS( self ), FALSE );
+
+	gpointer value;
+	if ( !g_hash_table_lookup_extended( self->positions, GUINT_TO_POINTER( id ), NULL, &value ) ) { return FALSE; }
+
+	foobar_notification_timeouts_remove_at( self, GPOINTER_TO_UINT( value ) );
+	return TRUE;
+}
+
+//
+// Get the earliest scheduled deadline, or -1 if there is none.
+//
+gint64 foobar_notification_timeouts_get_next_deadline( FoobarNotificationTimeouts* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_TIMEOUTS( self ), -1 );
+
+	if ( !self->heap->len ) { return -1; }
+	return g_array_index( self->heap, TimeoutEntry, 0 ).deadline;
+}
+
+//
+// If the earliest deadline has passed at the given time, remove it and return the ID of its notification.
+//
+// This should be called repeatedly until it returns FALSE to process all expired deadlines in one batch.
+//
+gboolean foobar_notification_timeouts_pop_expired(
+	FoobarNotificationTimeouts* self,
+	gint64                      now,
+	guint*                      out_id )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_TIMEOUTS( self ), FALSE );
+	g_return_val_if_fail( out_id != NULL, FALSE );
+
+	if ( !self->heap->len ) { return FALSE; }
+
+	TimeoutEntry* first = &g_array_index( self->heap, TimeoutEntry, 0 );
+	if ( first->deadline > now ) { return FALSE; }
+
+	*out_id = first->id;
+	foobar_notification_timeouts_remove_at( self, 0 );
+	return TRUE;
+}
+
+//
+// Remove the entry at the given position, moving the last entry into its place.
+//
+void foobar_notification_timeouts_remove_at(
+	FoobarNotificationTimeouts* self,
+	guint                       position )
+{
+	TimeoutEntry* removed = &g_array_index( self->heap, TimeoutEntry, position );
+	g_hash_table_remove( self->positions, GUINT_TO_POINTER( removed->id ) );
+
+	guint last = self->heap->len - 1;
+	if ( position != last )
+	{
+		TimeoutEntry moved = g_array_index( self->heap, TimeoutEntry, last );
+		foobar_notification_timeouts_place( self, position, moved );
+		g_array_set_size( self->heap, last );
+		position = foobar_notification_timeouts_sift_up( self, position );
+		foobar_notification_timeouts_sift_down( self, position );
+	}
+	else
+	{
+		g_array_set_size( self->heap, last );
+	}
+}
+
+//
+// Store an entry at the given position of the heap and update its position in the lookup table.
+//
+void foobar_notification_timeouts_place(
+	FoobarNotificationTimeouts* self,
+	guint                       position,
+	TimeoutEntry                entry )
+{
+	g_array_index( self->heap, TimeoutEntry, position ) = entry;
+	g_hash_table_insert( self->positions, GUINT_TO_POINTER( entry.id ), GUINT_TO_POINTER( position ) );
+}
+
+//
+// Move the entry at the given position towards the root until its parent's deadline is not later, returning its new
+// position.
+//
+guint foobar_notification_timeouts_sift_up(
+	FoobarNotificationTimeouts* self,
+	guint                       position )
+{
+	TimeoutEntry entry = g_array_index( self->heap, TimeoutEntry, position );
+	while ( position > 0 )
+	{
+		guint parent = ( position - 1 ) / 2;
+		TimeoutEntry parent_entry = g_array_index( self->heap, TimeoutEntry, parent );
+		if ( parent_entry.deadline <= entry.deadline ) { break; }
+
+		foobar_notification_timeouts_place( self, position, parent_entry );
+		position = parent;
+	}
+
+	foobar_notification_timeouts_place( self, position, entry );
+	return position;
+}
+
+//
+// Move the entry at the given position towards the leaves until no child's deadline is earlier, returning its new
+// position.
+//
+guint foobar_notification_timeouts_sift_down(
+	FoobarNotificationTimeouts* self,
+	guint                       position )
+{
+	TimeoutEntry entry = g_array_index( self->heap, TimeoutEntry, position );
+	for ( ;; )
+	{
+		guint child = position * 2 + 1;
+		if ( child >= self->heap->len ) { break; }
+
+		TimeoutEntry* children = &g_array_index( self->heap, TimeoutEntry, child );
+		if ( child + 1 < self->heap->len && children[1].deadline < children[0].deadline ) { ++child; }
+
+		TimeoutEntry child_entry = g_array_index( self->heap, TimeoutEntry, child );
+		if ( entry.deadline <= child_entry.deadline ) { break; }
+
+		foobar_notification_timeouts_place( self, position, child_entry );
+		position = child;
+	}
+
+	foobar_notification_timeouts_place( self, position, entry );
+	return position;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_NOTIFICATION_TIMEOUTS foobar_notification_timeouts_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationTimeouts, foobar_notification_timeouts, FOOBAR, NOTIFICATION_TIMEOUTS, GObject )
+
+FoobarNotificationTimeouts* foobar_notification_timeouts_new              ( void );
+guint                       foobar_notification_timeouts_get_count        ( FoobarNotificationTimeouts* self );
+gboolean                    foobar_notification_timeouts_contains         ( FoobarNotificationTimeouts* self,
+                                                                            guint                       id );
+void                        foobar_notification_timeouts_schedule         ( FoobarNotificationTimeouts* self,
+                                                                            guint                       id,
+                                                                            gint64                      deadline );
+gboolean                    foobar_notification_timeouts_cancel           ( FoobarNotificationTimeouts* self,
+                                                                            guint                       id );
+gint64                      foobar_notification_timeouts_get_next_deadline( FoobarNotificationTimeouts* self );
+gboolean                    foobar_notification_timeouts_pop_expired      ( FoobarNotificationTimeouts* self,
+                                                                            gint64                      now,
+                                                                            guint*                      out_id );
+
+G_END_DECLS
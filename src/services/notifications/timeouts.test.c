@@ -0,0 +1,152 @@
+#include "services/notifications/timeouts.h"
+#include <mutest.h>
+
+static GArray* timeouts_pop_all( FoobarNotificationTimeouts* timeouts,
+                                 gint64                      now );
+
+static void order_spec( void )
+{
+	FoobarNotificationTimeouts* timeouts = foobar_notification_timeouts_new( );
+	foobar_notification_timeouts_schedule( timeouts, 1, 500 );
+	foobar_notification_timeouts_schedule( timeouts, 2, 100 );
+	foobar_notification_timeouts_schedule( timeouts, 3, 300 );
+	foobar_notification_timeouts_schedule( timeouts, 4, 200 );
+
+	mutest_expect(
+		"earliest deadline",
+		mutest_int_value( foobar_notification_timeouts_get_next_deadline( timeouts ) ),
+		mutest_to_be,
+		100,
+		NULL );
+
+	GArray* expired = timeouts_pop_all( timeouts, 300 );
+	mutest_expect(
+		"expired notifications",
+		mutest_int_value( expired->len ),
+		mutest_to_be,
+		3,
+		NULL );
+	mutest_expect(
+		"expired in order",
+		mutest_bool_value(
+			g_array_index( expired, guint, 0 ) == 2 &&
+			g_array_index( expired, guint, 1 ) == 4 &&
+			g_array_index( expired, guint, 2 ) == 3 ),
+		mutest_to_be_true,
+		NULL );
+	mutest_expect(
+		"next deadline",
+		mutest_int_value( foobar_notification_timeouts_get_next_deadline( timeouts ) ),
+		mutest_to_be,
+		500,
+		NULL );
+
+	g_array_unref( expired );
+	g_object_unref( timeouts );
+}
+
+static void cancel_spec( void )
+{
+	FoobarNotificationTimeouts* timeouts = foobar_notification_timeouts_new( );
+	for ( guint id = 1; id <= 8; ++id ) { foobar_notification_timeouts_schedule( timeouts, id, id * 100 ); }
+
+	mutest_expect(
+		"cancelled scheduled deadline",
+		mutest_bool_value( foobar_notification_timeouts_cancel( timeouts, 1 ) ),
+		mutest_to_be_true,
+		NULL );
+	mutest_expect(
+		"cancelled unknown deadline",
+		mutest_bool_value( foobar_notification_timeouts_cancel( timeouts, 42 ) ),
+		mutest_to_be_false,
+		NULL );
+	foobar_notification_timeouts_cancel( timeouts, 5 );
+
+	mutest_expect(
+		"contains cancelled notification",
+		mutest_bool_value( foobar_notification_timeouts_contains( timeouts, 5 ) ),
+		mutest_to_be_false,
+		NULL );
+
+	GArray* expired = timeouts_pop_all( timeouts, G_MAXINT64 );
+	mutest_expect(
+		"expired notifications",
+		mutest_int_value( expired->len ),
+		mutest_to_be,
+		6,
+		NULL );
+
+	gboolean is_sorted = TRUE;
+	for ( guint i = 1; i < expired->len; ++i )
+	{
+		is_sorted &= g_array_index( expired, guint, i - 1 ) < g_array_index( expired, guint, i );
+	}
+	mutest_expect(
+		"expired in order",
+		mutest_bool_value( is_sorted ),
+		mutest_to_be_true,
+		NULL );
+	mutest_expect(
+		"no deadline left",
+		mutest_int_value( foobar_notification_timeouts_get_next_deadline( timeouts ) ),
+		mutest_to_be,
+		-1,
+		NULL );
+
+	g_array_unref( expired );
+	g_object_unref( timeouts );
+}
+
+static void reschedule_spec( void )
+{
+	FoobarNotificationTimeouts* timeouts = foobar_notification_timeouts_new( );
+	foobar_notification_timeouts_schedule( timeouts, 1, 100 );
+	foobar_notification_timeouts_schedule( timeouts, 2, 200 );
+
+	// Hovering a notification postpones its deadline.
+	foobar_notification_timeouts_schedule( timeouts, 1, 300 );
+
+	mutest_expect(
+		"scheduled deadlines",
+		mutest_int_value( foobar_notification_timeouts_get_count( timeouts ) ),
+		mutest_to_be,
+		2,
+		NULL );
+
+	guint id = 0;
+	foobar_notification_timeouts_pop_expired( timeouts, 250, &id );
+	mutest_expect(
+		"first expired notification",
+		mutest_int_value( id ),
+		mutest_to_be,
+		2,
+		NULL );
+	mutest_expect(
+		"postponed notification not expired",
+		mutest_bool_value( foobar_notification_timeouts_pop_expired( timeouts, 250, &id ) ),
+		mutest_to_be_false,
+		NULL );
+
+	g_object_unref( timeouts );
+}
+
+GArray* timeouts_pop_all(
+	FoobarNotificationTimeouts* timeouts,
+	gint64                      now )
+{
+	GArray* expired = g_array_new( FALSE, FALSE, sizeof( guint ) );
+	guint id;
+	while ( foobar_notification_timeouts_pop_expired( timeouts, now, &id ) ) { g_array_append_val( expired, id ); }
+	return expired;
+}
+
+static void timeouts_suite( void )
+{
+	mutest_it( "expires deadlines in order", order_spec );
+	mutest_it( "cancels deadlines", cancel_spec );
+	mutest_it( "reschedules deadlines", reschedule_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Timeouts", timeouts_suite );
+)
@@ -1,25 +1,32 @@
 #include "services/quick-answer-service.h"
 #include "services/quick-answers/math.h"
+#include "services/quick-answers/units.h"
 #include "launcher-item.h"
 #include <gdk/gdk.h>
+#include <math.h>
 
 //
 // FoobarQuickAnswer:
 //
 // A launcher item representing a quick, one-line answer to the query entered by the user.
 //
+// Answers for expressions in "x" additionally carry a list of samples (a packed array of doubles) which can be shown as
+// a small plot.
+//
 
 struct _FoobarQuickAnswer
 {
 	GObject parent_instance;
-	gchar* title;
-	gchar* value;
-	GIcon* icon;
+	gchar*  title;
+	gchar*  value;
+	GIcon*  icon;
+	GBytes* samples;
 };
 
 enum
 {
 	ANSWER_PROP_VALUE = 1,
+	ANSWER_PROP_SAMPLES,
 	ANSWER_PROP_TITLE,
 	ANSWER_PROP_DESCRIPTION,
 	ANSWER_PROP_ICON,
@@ -47,6 +54,8 @@ static void                   foobar_quick_answer_set_value                   (
                                                                                 gchar const*                 value );
 static void                   foobar_quick_answer_set_icon                    ( FoobarQuickAnswer*           self,
                                                                                 GIcon*                       value );
+static void                   foobar_quick_answer_set_samples                 ( FoobarQuickAnswer*           self,
+                                                                                GBytes*                      value );
 
 G_DEFINE_FINAL_TYPE_WITH_CODE(
 	FoobarQuickAnswer,
@@ -58,9 +67,13 @@ G_DEFINE_FINAL_TYPE_WITH_CODE(
 // FoobarQuickAnswerService:
 //
 // Service providing quick answers for search queries in the launcher (if available). This includes evaluating
-// mathematical expressions.
+// mathematical expressions and converting between units.
 //
 
+#define PLOT_SAMPLE_COUNT 256
+#define PLOT_RANGE_START  -10.
+#define PLOT_RANGE_END    10.
+
 struct _FoobarQuickAnswerService
 {
 	GObject parent_instance;
@@ -69,6 +82,9 @@ struct _FoobarQuickAnswerService
 static void               foobar_quick_answer_service_class_init( FoobarQuickAnswerServiceClass* klass );
 static void               foobar_quick_answer_service_init      ( FoobarQuickAnswerService*      self );
 static FoobarQuickAnswer* foobar_quick_answer_service_query_math( gchar const*                   query );
+static FoobarQuickAnswer* foobar_quick_answer_service_query_units( gchar const*                  query );
+static FoobarQuickAnswer* foobar_quick_answer_service_plot_math ( gchar const*                   query,
+                                                                  FoobarMathExpression const*    expr );
 
 G_DEFINE_FINAL_TYPE( FoobarQuickAnswerService, foobar_quick_answer_service, G_TYPE_OBJECT )
 
@@ -92,6 +108,12 @@ void foobar_quick_answer_class_init( FoobarQuickAnswerClass* klass )
 		"The raw value of the quick answer.",
 		NULL,
 		G_PARAM_READABLE );
+	answer_props[ANSWER_PROP_SAMPLES] = g_param_spec_boxed(
+		"samples",
+		"Samples",
+		"Sampled values of the expression to plot (or NULL).",
+		G_TYPE_BYTES,
+		G_PARAM_READABLE );
 	answer_props[ANSWER_PROP_TITLE] = g_param_spec_override(
 		"title",
 		g_object_interface_find_property( launcher_item_iface, "title" ) );
@@ -139,6 +161,9 @@ void foobar_quick_answer_get_property(
 		case ANSWER_PROP_VALUE:
 			g_value_set_string( value, foobar_quick_answer_get_value( self ) );
 			break;
+		case ANSWER_PROP_SAMPLES:
+			g_value_set_boxed( value, foobar_quick_answer_get_samples( self ) );
+			break;
 		case ANSWER_PROP_TITLE:
 			g_value_set_string( value, foobar_launcher_item_get_title( FOOBAR_LAUNCHER_ITEM ( self ) ) );
 			break;
@@ -164,6 +189,7 @@ void foobar_quick_answer_finalize( GObject* object )
 	g_clear_pointer( &self->title, g_free );
 	g_clear_pointer( &self->value, g_free );
 	g_clear_object( &self->icon );
+	g_clear_pointer( &self->samples, g_bytes_unref );
 
 	G_OBJECT_CLASS( foobar_quick_answer_parent_class )->finalize( object );
 }
@@ -185,6 +211,17 @@ gchar const* foobar_quick_answer_get_value( FoobarQuickAnswer* self )
 	return self->value;
 }
 
+//
+// Get the sampled values of the expression as a packed array of doubles, or NULL if there is nothing to plot.
+//
+// Samples may be NAN where the expression is undefined.
+//
+GBytes* foobar_quick_answer_get_samples( FoobarQuickAnswer* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_QUICK_ANSWER( self ), NULL );
+	return self->samples;
+}
+
 //
 // Get the title for the quick answer.
 //
@@ -276,6 +313,23 @@ void foobar_quick_answer_set_icon(
 	}
 }
 
+//
+// Update the sampled values of the expression.
+//
+void foobar_quick_answer_set_samples(
+	FoobarQuickAnswer* self,
+	GBytes*            value )
+{
+	g_return_if_fail( FOOBAR_IS_QUICK_ANSWER( self ) );
+
+	if ( self->samples != value )
+	{
+		g_clear_pointer( &self->samples, g_bytes_unref );
+		self->samples = value ? g_bytes_ref( value ) : NULL;
+		g_object_notify_by_pspec( G_OBJECT( self ), answer_props[ANSWER_PROP_SAMPLES] );
+	}
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Service Implementation
 // ---------------------------------------------------------------------------------------------------------------------
@@ -317,7 +371,12 @@ FoobarQuickAnswer* foobar_quick_answer_service_query(
 {
 	(void)self;
 
-	FoobarQuickAnswer* result = foobar_quick_answer_service_query_math( query );
+	// Unit conversions are checked first because rejecting a query is a lot cheaper than for mathematical expressions.
+
+	FoobarQuickAnswer* result = foobar_quick_answer_service_query_units( query );
+	if ( result ) { return result; }
+
+	result = foobar_quick_answer_service_query_math( query );
 	if ( result ) { return result; }
 
 	return NULL;
@@ -335,7 +394,12 @@ FoobarQuickAnswer* foobar_quick_answer_service_query_math( gchar const* query )
 	if ( tokens )
 	{
 		FoobarMathExpression* expr = foobar_math_parse( tokens, token_count );
-		if ( expr )
+		if ( expr && foobar_math_expression_has_variable( expr ) )
+		{
+			result = foobar_quick_answer_service_plot_math( query, expr );
+			foobar_math_expression_free( expr );
+		}
+		else if ( expr )
 		{
 			// foobar_math_expression_print( expr, 0 );
 
@@ -358,3 +422,69 @@ FoobarQuickAnswer* foobar_quick_answer_service_query_math( gchar const* query )
 
 	return result;
 }
+
+//
+// Try to parse the query as a unit conversion (e.g. "10 km in mi") and evaluate it.
+//
+FoobarQuickAnswer* foobar_quick_answer_service_query_units( gchar const* query )
+{
+	gdouble value;
+	FoobarUnit const* from;
+	FoobarUnit const* to;
+	if ( !foobar_unit_parse_conversion( query, strlen( query ), &value, &from, &to ) ) { return NULL; }
+
+	gdouble converted = foobar_unit_convert( value, from, to );
+	if ( isnan( converted ) || isinf( converted ) ) { return NULL; }
+
+	gchar value_buffer[G_ASCII_DTOSTR_BUF_SIZE];
+	g_ascii_formatd( value_buffer, sizeof( value_buffer ), "%.10g", converted );
+	g_autofree gchar* title = g_strdup_printf( "= %s %s", value_buffer, to->symbol );
+	g_autoptr( GIcon ) icon = g_themed_icon_new( "fluent-calculator-symbolic" );
+	FoobarQuickAnswer* result = foobar_quick_answer_new( );
+	foobar_quick_answer_set_value( result, value_buffer );
+	foobar_quick_answer_set_title( result, title );
+	foobar_quick_answer_set_icon( result, icon );
+	return result;
+}
+
+//
+// Sample an expression in "x" over a fixed range to be shown as a plot.
+//
+// If the expression is undefined over the entire range, this returns NULL.
+//
+FoobarQuickAnswer* foobar_quick_answer_service_plot_math(
+	gchar const*                query,
+	FoobarMathExpression const* expr )
+{
+	gdouble input[PLOT_SAMPLE_COUNT];
+	for ( gsize i = 0; i < PLOT_SAMPLE_COUNT; ++i )
+	{
+		input[i] = PLOT_RANGE_START + ( PLOT_RANGE_END - PLOT_RANGE_START ) * i / ( PLOT_SAMPLE_COUNT - 1 );
+	}
+
+	gdouble* samples = g_new( gdouble, PLOT_SAMPLE_COUNT );
+	foobar_math_evaluate_batch( expr, input, samples, PLOT_SAMPLE_COUNT );
+
+	gboolean any_defined = FALSE;
+	for ( gsize i = 0; i < PLOT_SAMPLE_COUNT && !any_defined; ++i )
+	{
+		any_defined = !isnan( samples[i] );
+	}
+
+	if ( !any_defined )
+	{
+		g_free( samples );
+		return NULL;
+	}
+
+	g_autoptr( GBytes ) samples_bytes = g_bytes_new_take( samples, PLOT_SAMPLE_COUNT * sizeof( *samples ) );
+	g_autofree gchar* value = g_strstrip( g_strdup( query ) );
+	g_autofree gchar* title = g_strdup_printf( "f(x) = %s", value );
+	g_autoptr( GIcon ) icon = g_themed_icon_new( "fluent-calculator-symbolic" );
+	FoobarQuickAnswer* result = foobar_quick_answer_new( );
+	foobar_quick_answer_set_value( result, value );
+	foobar_quick_answer_set_title( result, title );
+	foobar_quick_answer_set_icon( result, icon );
+	foobar_quick_answer_set_samples( result, samples_bytes );
+	return result;
+}
@@ -10,7 +10,8 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE( FoobarQuickAnswer, foobar_quick_answer, FOOBAR, QUICK_ANSWER, GObject )
 
-gchar const* foobar_quick_answer_get_value( FoobarQuickAnswer* self );
+gchar const* foobar_quick_answer_get_value  ( FoobarQuickAnswer* self );
+GBytes*      foobar_quick_answer_get_samples( FoobarQuickAnswer* self );
 
 G_DECLARE_FINAL_TYPE( FoobarQuickAnswerService, foobar_quick_answer_service, FOOBAR, QUICK_ANSWER_SERVICE, GObject )
 
@@ -164,7 +164,8 @@ FoobarMathExpression* parser_process_single(
 //
 // Parse an identifier.
 //
-// If the identifier is a function, this will expected parenthesis and an expression afterwards.
+// If the identifier is a function, this will expected parenthesis and an expression afterwards. The identifier "x" is
+// treated as the free variable.
 //
 FoobarMathExpression* parser_process_identifier( Parser* ctx )
 {
@@ -177,6 +178,10 @@ FoobarMathExpression* parser_process_identifier( Parser* ctx )
 	{
 		return foobar_math_expression_new_constant( FOOBAR_MATH_CONSTANT_E );
 	}
+	else if ( parser_match_identifier( token, "x" ) )
+	{
+		return foobar_math_expression_new_variable( );
+	}
 	else if ( parser_match_identifier( token, "exp" ) )
 	{
 		return parser_process_function( ctx, FOOBAR_MATH_FUNCTION_EXP );
@@ -12,6 +12,9 @@
 //      - Constant: PI
 //    - Value: 3
 //
+// Expressions may also reference the free variable "x". These can't be evaluated to a single value, but they can be
+// sampled over a range of inputs using foobar_math_evaluate_batch.
+//
 
 struct _FoobarMathExpression
 {
@@ -58,6 +61,13 @@ struct _FoobarMathExpression
 // should always be freed using foobar_math_value_free.
 //
 
+static gsize math_expression_batch_depth( FoobarMathExpression const* expr );
+static void  math_evaluate_batch        ( FoobarMathExpression const* expr,
+                                          gdouble const* restrict     input,
+                                          gdouble* restrict           out_values,
+                                          gdouble* restrict           scratch,
+                                          gsize                       count );
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Expressions
 // ---------------------------------------------------------------------------------------------------------------------
@@ -122,6 +132,39 @@ FoobarMathExpression* foobar_math_expression_new_operation(
 	return res;
 }
 
+//
+// Helper to allocate a new FoobarMathExpression representing the free variable "x".
+//
+FoobarMathExpression* foobar_math_expression_new_variable( void )
+{
+	FoobarMathExpression* res = g_new0( FoobarMathExpression, 1 );
+	res->type = FOOBAR_MATH_EXPRESSION_VARIABLE;
+	return res;
+}
+
+//
+// Check whether the expression (or any of its sub-expressions) references the free variable "x".
+//
+gboolean foobar_math_expression_has_variable( FoobarMathExpression const* expr )
+{
+	switch ( expr->type )
+	{
+		case FOOBAR_MATH_EXPRESSION_VALUE:
+		case FOOBAR_MATH_EXPRESSION_CONSTANT:
+			return FALSE;
+		case FOOBAR_MATH_EXPRESSION_FUNCTION:
+			return foobar_math_expression_has_variable( expr->function.input );
+		case FOOBAR_MATH_EXPRESSION_OPERATION:
+			return foobar_math_expression_has_variable( expr->operation.lhs ) ||
+				foobar_math_expression_has_variable( expr->operation.rhs );
+		case FOOBAR_MATH_EXPRESSION_VARIABLE:
+			return TRUE;
+		default:
+			g_warn_if_reached( );
+			return FALSE;
+	}
+}
+
 //
 // Release the memory associated with a mathematical expression, along with the expressions it owns.
 //
@@ -143,6 +186,8 @@ void foobar_math_expression_free( FoobarMathExpression* expression )
 				foobar_math_expression_free( expression->operation.lhs );
 				foobar_math_expression_free( expression->operation.rhs );
 				break;
+			case FOOBAR_MATH_EXPRESSION_VARIABLE:
+				break;
 			default:
 				g_warn_if_reached( );
 				break;
@@ -264,6 +309,9 @@ void foobar_math_expression_print(
 			foobar_math_expression_print( expr->operation.lhs, indentation + 1 );
 			foobar_math_expression_print( expr->operation.rhs, indentation + 1 );
 			break;
+        case FOOBAR_MATH_EXPRESSION_VARIABLE:
+			g_print( "x\n" );
+			break;
 		default:
 			g_warn_if_reached( );
 			break;
@@ -275,6 +323,8 @@ void foobar_math_expression_print(
 //
 // On success (indicated by the return value TRUE), the value should be freed using foobar_math_value_free.
 //
+// Expressions referencing the free variable "x" can't be evaluated this way and will always fail.
+//
 gboolean foobar_math_evaluate(
 	FoobarMathExpression const* expr,
 	FoobarMathValue*            out_value )
@@ -407,12 +457,211 @@ gboolean foobar_math_evaluate(
 
 			return success;
 		}
+        case FOOBAR_MATH_EXPRESSION_VARIABLE:
+			return FALSE;
 		default:
 			g_warn_if_reached( );
 			return FALSE;
 	}
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Batch Evaluation
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Evaluate an expression for each of the "count" values in "input", substituting them for the free variable "x".
+//
+// In contrast to foobar_math_evaluate, this works on plain doubles and visits each node of the expression tree only
+// once, applying it to the whole array in a tight loop. This is way cheaper than going through the GMP representation
+// for every single sample (and simple enough for the compiler to vectorize).
+//
+// Samples for which the expression is undefined (e.g. division by zero) are set to NAN. "input" and "out_values" must
+// not overlap.
+//
+void foobar_math_evaluate_batch(
+	FoobarMathExpression const* expr,
+	gdouble const*              input,
+	gdouble*                    out_values,
+	gsize                       count )
+{
+	if ( count == 0 ) { return; }
+
+	// Each nesting level of the right-hand side of an operation needs one intermediate buffer, so we allocate all of
+	// them at once up front.
+
+	gsize depth = math_expression_batch_depth( expr );
+	g_autofree gdouble* scratch = depth > 0 ? g_new( gdouble, depth * count ) : NULL;
+	math_evaluate_batch( expr, input, out_values, scratch, count );
+
+	for ( gsize i = 0; i < count; ++i )
+	{
+		if ( !isfinite( out_values[i] ) ) { out_values[i] = NAN; }
+	}
+}
+
+//
+// Get the number of intermediate buffers needed to evaluate an expression using math_evaluate_batch.
+//
+gsize math_expression_batch_depth( FoobarMathExpression const* expr )
+{
+	switch ( expr->type )
+	{
+		case FOOBAR_MATH_EXPRESSION_VALUE:
+		case FOOBAR_MATH_EXPRESSION_CONSTANT:
+		case FOOBAR_MATH_EXPRESSION_VARIABLE:
+			return 0;
+		case FOOBAR_MATH_EXPRESSION_FUNCTION:
+			return math_expression_batch_depth( expr->function.input );
+		case FOOBAR_MATH_EXPRESSION_OPERATION:
+			return MAX(
+				math_expression_batch_depth( expr->operation.lhs ),
+				math_expression_batch_depth( expr->operation.rhs ) + 1 );
+		default:
+			g_warn_if_reached( );
+			return 0;
+	}
+}
+
+//
+// Recursive implementation of foobar_math_evaluate_batch.
+//
+// The result of the left-hand side of an operation is computed directly into "out_values", while the right-hand side
+// uses the first "count" values of "scratch" (and passes the rest on to nested expressions).
+//
+void math_evaluate_batch(
+	FoobarMathExpression const* expr,
+	gdouble const* restrict     input,
+	gdouble* restrict           out_values,
+	gdouble* restrict           scratch,
+	gsize                       count )
+{
+	switch ( expr->type )
+	{
+		case FOOBAR_MATH_EXPRESSION_VALUE:
+		{
+			gdouble value = (gdouble)foobar_math_value_to_float( expr->value.v );
+			for ( gsize i = 0; i < count; ++i ) { out_values[i] = value; }
+			break;
+		}
+		case FOOBAR_MATH_EXPRESSION_CONSTANT:
+		{
+			gdouble value = NAN;
+			switch ( expr->constant.c )
+			{
+				case FOOBAR_MATH_CONSTANT_PI:
+					value = M_PI;
+					break;
+				case FOOBAR_MATH_CONSTANT_E:
+					value = M_E;
+					break;
+				default:
+					g_warn_if_reached( );
+					break;
+			}
+			for ( gsize i = 0; i < count; ++i ) { out_values[i] = value; }
+			break;
+		}
+		case FOOBAR_MATH_EXPRESSION_VARIABLE:
+			memcpy( out_values, input, count * sizeof( *out_values ) );
+			break;
+		case FOOBAR_MATH_EXPRESSION_FUNCTION:
+		{
+			math_evaluate_batch( expr->function.input, input, out_values, scratch, count );
+
+			gdouble* v = out_values;
+			switch ( expr->function.f )
+			{
+				case FOOBAR_MATH_FUNCTION_NEGATE:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = -v[i]; }
+					break;
+				case FOOBAR_MATH_FUNCTION_SIN:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = sin( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_COS:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = cos( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_SEC:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = 1. / cos( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_CSC:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = 1. / sin( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_TAN:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = tan( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_COT:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = 1. / tan( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_ARCSIN:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = asin( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_ARCCOS:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = acos( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_ARCSEC:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = acos( 1. / v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_ARCCSC:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = asin( 1. / v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_ARCTAN:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = atan( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_ARCCOT:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = atan( 1. / v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_EXP:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = exp( v[i] ); }
+					break;
+				case FOOBAR_MATH_FUNCTION_SQRT:
+					for ( gsize i = 0; i < count; ++i ) { v[i] = sqrt( v[i] ); }
+					break;
+				default:
+					g_warn_if_reached( );
+					for ( gsize i = 0; i < count; ++i ) { v[i] = NAN; }
+					break;
+			}
+			break;
+		}
+		case FOOBAR_MATH_EXPRESSION_OPERATION:
+		{
+			math_evaluate_batch( expr->operation.lhs, input, out_values, scratch, count );
+			math_evaluate_batch( expr->operation.rhs, input, scratch, scratch + count, count );
+
+			gdouble* lhs = out_values;
+			gdouble const* rhs = scratch;
+			switch ( expr->operation.o )
+			{
+				case FOOBAR_MATH_OPERATION_ADD:
+					for ( gsize i = 0; i < count; ++i ) { lhs[i] += rhs[i]; }
+					break;
+				case FOOBAR_MATH_OPERATION_SUB:
+					for ( gsize i = 0; i < count; ++i ) { lhs[i] -= rhs[i]; }
+					break;
+				case FOOBAR_MATH_OPERATION_MUL:
+					for ( gsize i = 0; i < count; ++i ) { lhs[i] *= rhs[i]; }
+					break;
+				case FOOBAR_MATH_OPERATION_DIV:
+					for ( gsize i = 0; i < count; ++i ) { lhs[i] /= rhs[i]; }
+					break;
+				case FOOBAR_MATH_OPERATION_POW:
+					for ( gsize i = 0; i < count; ++i ) { lhs[i] = pow( lhs[i], rhs[i] ); }
+					break;
+				default:
+					g_warn_if_reached( );
+					for ( gsize i = 0; i < count; ++i ) { lhs[i] = NAN; }
+					break;
+			}
+			break;
+		}
+		default:
+			g_warn_if_reached( );
+			for ( gsize i = 0; i < count; ++i ) { out_values[i] = NAN; }
+			break;
+	}
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Values
 // ---------------------------------------------------------------------------------------------------------------------
@@ -60,6 +60,7 @@ typedef enum
 	FOOBAR_MATH_EXPRESSION_FUNCTION,
 	FOOBAR_MATH_EXPRESSION_CONSTANT,
 	FOOBAR_MATH_EXPRESSION_OPERATION,
+	FOOBAR_MATH_EXPRESSION_VARIABLE,
 } FoobarMathExpressionType;
 
 typedef enum
@@ -110,10 +111,16 @@ FoobarMathExpression* foobar_math_expression_new_constant ( FoobarMathConstant
 FoobarMathExpression* foobar_math_expression_new_operation( FoobarMathOperation         operation,
                                                             FoobarMathExpression*       lhs,
                                                             FoobarMathExpression*       rhs );
+FoobarMathExpression* foobar_math_expression_new_variable ( void );
+gboolean              foobar_math_expression_has_variable ( FoobarMathExpression const* expr );
 void                  foobar_math_expression_print        ( FoobarMathExpression const* expr,
                                                             gint                        indentation );
 gboolean              foobar_math_evaluate                ( FoobarMathExpression const* expr,
                                                             FoobarMathValue*            out_value );
+void                  foobar_math_evaluate_batch          ( FoobarMathExpression const* expr,
+                                                            gdouble const*              input,
+                                                            gdouble*                    out_values,
+                                                            gsize                       count );
 void                  foobar_math_expression_free         ( FoobarMathExpression*       expression );
 void                  foobar_math_value_new_int           ( FoobarMathValue*            out_value );
 void                  foobar_math_value_from_float        ( long double                 value,
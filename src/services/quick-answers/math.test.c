@@ -1,5 +1,6 @@
 #include "services/quick-answers/math.h"
 #include <mutest.h>
+#include <math.h>
 
 #define SERIALIZATION_TEST( value, identifier )                                                  \
 	static void serialization_value_##identifier##_spec( void )                                  \
@@ -143,6 +144,73 @@ static void power_suite( void )
 	mutest_it( "calculate 4 ^ 0.5", operation_4_pow_0_5_spec );
 }
 
+#define BATCH_TEST( expression, x, value_res, identifier )                                         \
+	static void batch_##identifier##_spec( void )                                                  \
+	{                                                                                              \
+		gchar const input[] = expression;                                                          \
+		gsize token_count;                                                                         \
+		g_autofree FoobarMathToken* tokens = NULL;                                                 \
+		tokens = foobar_math_lex( input, sizeof(input) - 1, &token_count );                        \
+		FoobarMathExpression* expr = tokens ? foobar_math_parse( tokens, token_count ) : NULL;     \
+		mutest_expect(                                                                             \
+			"expression parsed",                                                                   \
+			mutest_bool_value( expr != NULL ),                                                     \
+			mutest_to_be_true,                                                                     \
+			NULL );                                                                                \
+		if ( !expr ) { return; }                                                                   \
+                                                                                                   \
+		gdouble xs[] = { x, x, x, x, x, x, x, x, x };                                              \
+		gdouble ys[G_N_ELEMENTS( xs )];                                                            \
+		foobar_math_evaluate_batch( expr, xs, ys, G_N_ELEMENTS( xs ) );                            \
+		for ( gsize i = 0; i < G_N_ELEMENTS( ys ); ++i )                                           \
+		{                                                                                          \
+			mutest_expect(                                                                         \
+				"result",                                                                          \
+				mutest_float_value( ys[i] ),                                                       \
+				mutest_to_be_close_to,                                                             \
+				(double)( value_res ),                                                             \
+				1e-9,                                                                              \
+				NULL );                                                                            \
+		}                                                                                          \
+                                                                                                   \
+		foobar_math_expression_free( expr );                                                       \
+	}
+
+BATCH_TEST( "x", 3, 3, x )
+BATCH_TEST( "x^2 + 1", 3, 10, x_squared_plus_1 )
+BATCH_TEST( "-x * 2.5", 2, -5, neg_x_times_2_5 )
+BATCH_TEST( "sin(x) * x^2", 2, sin( 2 ) * 4, sin_x_times_x_squared )
+BATCH_TEST( "(x - 1) / (x + 1) - 2 ^ x", 3, 0.5 - 8, nested )
+
+#undef BATCH_TEST
+
+static void batch_undefined_spec( void )
+{
+	gchar const input[] = "1 / x + sqrt(x)";
+	gsize token_count;
+	g_autofree FoobarMathToken* tokens = foobar_math_lex( input, sizeof(input) - 1, &token_count );
+	FoobarMathExpression* expr = foobar_math_parse( tokens, token_count );
+
+	gdouble xs[] = { -1, 0, 4 };
+	gdouble ys[G_N_ELEMENTS( xs )];
+	foobar_math_evaluate_batch( expr, xs, ys, G_N_ELEMENTS( xs ) );
+	mutest_expect( "negative input", mutest_bool_value( isnan( ys[0] ) ), mutest_to_be_true, NULL );
+	mutest_expect( "zero input", mutest_bool_value( isnan( ys[1] ) ), mutest_to_be_true, NULL );
+	mutest_expect( "positive input", mutest_float_value( ys[2] ), mutest_to_be_close_to, 2.25, 1e-9, NULL );
+
+	foobar_math_expression_free( expr );
+}
+
+static void batch_suite( void )
+{
+	mutest_it( "evaluate x", batch_x_spec );
+	mutest_it( "evaluate x^2 + 1", batch_x_squared_plus_1_spec );
+	mutest_it( "evaluate -x * 2.5", batch_neg_x_times_2_5_spec );
+	mutest_it( "evaluate sin(x) * x^2", batch_sin_x_times_x_squared_spec );
+	mutest_it( "evaluate (x - 1) / (x + 1) - 2 ^ x", batch_nested_spec );
+	mutest_it( "evaluate undefined samples", batch_undefined_spec );
+}
+
 MUTEST_MAIN(
 	mutest_describe( "Serialization", serialization_suite );
 	mutest_describe( "Addition", addition_suite );
@@ -150,4 +218,5 @@ MUTEST_MAIN(
 	mutest_describe( "Multiplication", multiplication_suite );
 	mutest_describe( "Division", division_suite );
 	mutest_describe( "Power", power_suite );
+	mutest_describe( "Batch Evaluation", batch_suite );
 )
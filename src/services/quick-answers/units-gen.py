@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# Generate the static unit tables used by units.c from a unit definition file (see units.txt for the format).
+#
+# Unit names are looked up using a perfect hash ("hash and displace"): a first hash assigns each name to a bucket, and
+# for every bucket we search for a displacement (the seed of a second hash) which maps all of the bucket's names to
+# distinct, unused slots. A lookup then needs exactly two hash computations and a single comparison.
+#
+# Usage: units-gen.py <input> <output>
+#
+
+import re
+import sys
+
+MAX_DISPLACEMENT = 0xffff
+NUMBER_EXPR = re.compile(r'^[0-9.eE+\-*/() ]+$')
+
+
+def fnv1a(name, seed):
+    # Keep in sync with unit_hash in units.c.
+    h = (0x811c9dc5 ^ seed) & 0xffffffff
+    for c in name:
+        h ^= c
+        h = (h * 0x01000193) & 0xffffffff
+    return h
+
+
+def evaluate(expr, line_number):
+    if not NUMBER_EXPR.match(expr):
+        sys.exit(f'line {line_number}: invalid number "{expr}"')
+    return float(eval(expr, {'__builtins__': {}}))
+
+
+def parse(path):
+    dimensions = []
+    units = []
+    names = {}
+    with open(path, encoding='utf-8') as f:
+        for line_number, line in enumerate(f, start=1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            fields = line.split()
+            if len(fields) < 4:
+                sys.exit(f'line {line_number}: expected "<dimension> <factor> <offset> <names...>"')
+            dimension, factor, offset, unit_names = fields[0], fields[1], fields[2], fields[3:]
+            if dimension not in dimensions:
+                dimensions.append(dimension)
+            for name in unit_names:
+                if name in names:
+                    sys.exit(f'line {line_number}: duplicate unit name "{name}"')
+                if len(name.encode('utf-8')) > 0xff:
+                    sys.exit(f'line {line_number}: unit name "{name}" is too long')
+                names[name] = len(units)
+            if len(units) > 0xff:
+                # UnitSlot.unit in units.c is a guint8.
+                sys.exit(f'line {line_number}: too many units (at most 256 are supported)')
+            units.append((unit_names[0], dimensions.index(dimension), evaluate(factor, line_number),
+                          evaluate(offset, line_number)))
+    return dimensions, units, names
+
+
+def build_hash(names):
+    keys = [name.encode('utf-8') for name in names]
+    bucket_count = max(1, (len(keys) + 3) // 4)
+    slot_count = 1
+    while slot_count < len(keys) * 5 // 4 + 1:
+        slot_count *= 2
+
+    buckets = [[] for _ in range(bucket_count)]
+    for key in keys:
+        buckets[fnv1a(key, 0) % bucket_count].append(key)
+
+    displacements = [0] * bucket_count
+    slots = [None] * slot_count
+    for index in sorted(range(bucket_count), key=lambda i: len(buckets[i]), reverse=True):
+        bucket = buckets[index]
+        if not bucket:
+            continue
+        for displacement in range(1, MAX_DISPLACEMENT + 1):
+            candidates = [fnv1a(key, displacement) & (slot_count - 1) for key in bucket]
+            if len(set(candidates)) == len(candidates) and all(slots[c] is None for c in candidates):
+                for key, candidate in zip(bucket, candidates):
+                    slots[candidate] = key
+                displacements[index] = displacement
+                break
+        else:
+            sys.exit('unable to find a perfect hash for the unit names')
+
+    return displacements, slots
+
+
+def c_string(value):
+    return '"' + ''.join(chr(b) if 0x20 <= b < 0x7f and chr(b) not in '"\\' else f'\\{b:03o}' for b in value) + '"'
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(f'usage: {sys.argv[0]} <input> <output>')
+
+    dimensions, units, names = parse(sys.argv[1])
+    displacements, slots = build_hash(names)
+
+    out = []
+    out.append('// Generated by units-gen.py, do not edit.')
+    out.append('')
+    out.append('#pragma once')
+    out.append('')
+    out.append(f'#define UNIT_BUCKET_COUNT {len(displacements)}')
+    out.append(f'#define UNIT_SLOT_COUNT   {len(slots)}')
+    out.append('')
+    out.append('static FoobarUnit const units[] =')
+    out.append('{')
+    for symbol, dimension, factor, offset in units:
+        out.append(f'\t{{ {c_string(symbol.encode("utf-8"))}, {dimension} /* {dimensions[dimension]} */, '
+                   f'{factor!r}, {offset!r} }},')
+    out.append('};')
+    out.append('')
+    out.append('static guint16 const unit_displacements[UNIT_BUCKET_COUNT] =')
+    out.append('{')
+    for i in range(0, len(displacements), 8):
+        out.append('\t' + ', '.join(str(d) for d in displacements[i:i + 8]) + ',')
+    out.append('};')
+    out.append('')
+    out.append('static UnitSlot const unit_slots[UNIT_SLOT_COUNT] =')
+    out.append('{')
+    for key in slots:
+        if key is None:
+            out.append('\t{ NULL, 0, 0 },')
+        else:
+            out.append(f'\t{{ {c_string(key)}, {len(key)}, {names[key.decode("utf-8")]} }},')
+    out.append('};')
+    out.append('')
+
+    with open(sys.argv[2], 'w', encoding='utf-8') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
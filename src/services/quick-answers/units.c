@@ -0,0 +1,238 @@
+#include "services/quick-answers/units.h"
+#include <string.h>
+
+//
+// FoobarUnit:
+//
+// A unit of measurement belonging to a dimension (e.g. length or temperature). A value in this unit is converted to the
+// dimension's base unit as "value * factor + offset".
+//
+// All units are defined in units.txt, which is compiled into static tables (including a perfect hash of all unit
+// names) at build time. This way, recognizing a conversion query never needs to allocate.
+//
+
+//
+// UnitSlot:
+//
+// An entry in the perfect hash table, mapping a unit name to its index in the unit table. Unused slots have a NULL name.
+//
+
+typedef struct _UnitSlot UnitSlot;
+
+struct _UnitSlot
+{
+	gchar const* name;
+	guint8       length;
+	guint8       unit;
+};
+
+#include "services/quick-answers/units-table.h"
+
+#define MAX_NUMBER_LENGTH 64
+
+static guint32  unit_hash         ( gchar const* name,
+                                    gsize        name_length,
+                                    guint32      seed );
+static gboolean char_is_whitespace( char         c );
+static gboolean char_is_digit     ( char         c );
+static gsize    skip_whitespace   ( gchar const* input,
+                                    gsize        input_length,
+                                    gsize        position );
+static gsize    scan_word         ( gchar const* input,
+                                    gsize        input_length,
+                                    gsize        position );
+static gsize    scan_number       ( gchar const* input,
+                                    gsize        input_length,
+                                    gsize        position );
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Units
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Find a unit by one of its (case-sensitive) names.
+//
+// The name need not be null-terminated. If there is no such unit, this will return NULL.
+//
+FoobarUnit const* foobar_unit_lookup(
+	gchar const* name,
+	gsize        name_length )
+{
+	if ( name_length == 0 || name_length > G_MAXUINT8 ) { return NULL; }
+
+	guint16 displacement = unit_displacements[unit_hash( name, name_length, 0 ) % UNIT_BUCKET_COUNT];
+	UnitSlot const* slot = &unit_slots[unit_hash( name, name_length, displacement ) & ( UNIT_SLOT_COUNT - 1 )];
+	if ( !slot->name || slot->length != name_length || memcmp( slot->name, name, name_length ) ) { return NULL; }
+
+	return &units[slot->unit];
+}
+
+//
+// Try to parse a conversion query like "10 km in mi" or "3.5 GiB to MB".
+//
+// On success, this will return TRUE and write the value and both units into the output parameters. Queries not looking
+// like a conversion are rejected as early as possible, and this never allocates memory.
+//
+gboolean foobar_unit_parse_conversion(
+	gchar const*       input,
+	gsize              input_length,
+	gdouble*           out_value,
+	FoobarUnit const** out_from,
+	FoobarUnit const** out_to )
+{
+	// The value comes first, so anything not starting with a number is rejected right away.
+
+	gsize number_start = skip_whitespace( input, input_length, 0 );
+	gsize number_end = scan_number( input, input_length, number_start );
+	if ( number_end == number_start || number_end - number_start >= MAX_NUMBER_LENGTH ) { return FALSE; }
+
+	gsize from_start = skip_whitespace( input, input_length, number_end );
+	gsize from_end = scan_word( input, input_length, from_start );
+	FoobarUnit const* from = foobar_unit_lookup( &input[from_start], from_end - from_start );
+	if ( !from ) { return FALSE; }
+
+	gsize keyword_start = skip_whitespace( input, input_length, from_end );
+	gsize keyword_end = scan_word( input, input_length, keyword_start );
+	if ( keyword_start == from_end || keyword_end - keyword_start != 2 ) { return FALSE; }
+	if ( strncmp( &input[keyword_start], "in", 2 ) && strncmp( &input[keyword_start], "to", 2 ) ) { return FALSE; }
+
+	gsize to_start = skip_whitespace( input, input_length, keyword_end );
+	gsize to_end = scan_word( input, input_length, to_start );
+	if ( to_start == keyword_end ) { return FALSE; }
+	FoobarUnit const* to = foobar_unit_lookup( &input[to_start], to_end - to_start );
+	if ( !to || to->dimension != from->dimension ) { return FALSE; }
+
+	if ( skip_whitespace( input, input_length, to_end ) != input_length ) { return FALSE; }
+
+	// g_ascii_strtod needs a null-terminated string, so copy the number onto the stack.
+
+	gchar number[MAX_NUMBER_LENGTH];
+	memcpy( number, &input[number_start], number_end - number_start );
+	number[number_end - number_start] = '\0';
+	gchar* parsed_end;
+	gdouble value = g_ascii_strtod( number, &parsed_end );
+	if ( *parsed_end != '\0' ) { return FALSE; }
+
+	*out_value = value;
+	*out_from = from;
+	*out_to = to;
+	return TRUE;
+}
+
+//
+// Convert a value between two units of the same dimension.
+//
+gdouble foobar_unit_convert(
+	gdouble           value,
+	FoobarUnit const* from,
+	FoobarUnit const* to )
+{
+	g_return_val_if_fail( from->dimension == to->dimension, 0 );
+
+	gdouble base_value = value * from->factor + from->offset;
+	return ( base_value - to->offset ) / to->factor;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Seeded 32-bit FNV-1a hash used for the perfect hash table.
+//
+// This needs to be kept in sync with the implementation in units-gen.py.
+//
+guint32 unit_hash(
+	gchar const* name,
+	gsize        name_length,
+	guint32      seed )
+{
+	guint32 hash = 0x811c9dc5 ^ seed;
+	for ( gsize i = 0; i < name_length; ++i )
+	{
+		hash ^= (guint8)name[i];
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+//
+// Check if a character is a whitespace character.
+//
+gboolean char_is_whitespace( char c )
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+//
+// Check if a character is a digit.
+//
+gboolean char_is_digit( char c )
+{
+	return c >= '0' && c <= '9';
+}
+
+//
+// Get the position of the first non-whitespace character at or after "position".
+//
+gsize skip_whitespace(
+	gchar const* input,
+	gsize        input_length,
+	gsize        position )
+{
+	while ( position < input_length && char_is_whitespace( input[position] ) ) { ++position; }
+	return position;
+}
+
+//
+// Get the end of a unit name or keyword starting at "position".
+//
+// Words consist of ASCII letters and slashes (for units like "km/h").
+//
+gsize scan_word(
+	gchar const* input,
+	gsize        input_length,
+	gsize        position )
+{
+	while ( position < input_length && ( g_ascii_isalpha( input[position] ) || input[position] == '/' ) )
+	{
+		++position;
+	}
+	return position;
+}
+
+//
+// Get the end of a number (an optional sign, followed by digits with an optional decimal separator) starting at
+// "position".
+//
+// If there is no number, this returns "position".
+//
+gsize scan_number(
+	gchar const* input,
+	gsize        input_length,
+	gsize        position )
+{
+	gsize start = position;
+	if ( position < input_length && ( input[position] == '-' || input[position] == '+' ) ) { ++position; }
+
+	gsize digits = 0;
+	gboolean has_separator = FALSE;
+	while ( position < input_length )
+	{
+		if ( char_is_digit( input[position] ) )
+		{
+			++digits;
+		}
+		else if ( input[position] == '.' && !has_separator )
+		{
+			has_separator = TRUE;
+		}
+		else
+		{
+			break;
+		}
+		++position;
+	}
+
+	return digits > 0 ? position : start;
+}
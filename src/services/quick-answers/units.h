@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FoobarUnit FoobarUnit;
+
+struct _FoobarUnit
+{
+	gchar const* symbol;
+	guint        dimension;
+	gdouble      factor;
+	gdouble      offset;
+};
+
+FoobarUnit const* foobar_unit_lookup          ( gchar const*       name,
+                                                gsize              name_length );
+gboolean          foobar_unit_parse_conversion( gchar const*       input,
+                                                gsize              input_length,
+                                                gdouble*           out_value,
+                                                FoobarUnit const** out_from,
+                                                FoobarUnit const** out_to );
+gdouble           foobar_unit_convert         ( gdouble            value,
+                                                FoobarUnit const*  from,
+                                                FoobarUnit const*  to );
+
+G_END_DECLS
@@ -0,0 +1,128 @@
+#include "services/quick-answers/units.h"
+#include <mutest.h>
+
+#define CONVERSION_TEST( query, value_res, symbol_res, identifier )                                 \
+	static void conversion_##identifier##_spec( void )                                              \
+	{                                                                                               \
+		gdouble value;                                                                              \
+		FoobarUnit const* from;                                                                     \
+		FoobarUnit const* to;                                                                       \
+                                                                                                    \
+		gchar const input[] = query;                                                                \
+		gboolean parsed;                                                                            \
+		parsed = foobar_unit_parse_conversion( input, sizeof(input) - 1, &value, &from, &to );      \
+		mutest_expect(                                                                              \
+			"parse result",                                                                         \
+			mutest_bool_value( parsed ),                                                            \
+			mutest_to_be_true,                                                                      \
+			NULL );                                                                                 \
+		if ( !parsed ) { return; }                                                                  \
+                                                                                                    \
+		mutest_expect(                                                                              \
+			"result",                                                                               \
+			mutest_float_value( foobar_unit_convert( value, from, to ) ),                           \
+			mutest_to_be_close_to,                                                                  \
+			(double)( value_res ),                                                                  \
+			1e-6,                                                                                   \
+			NULL );                                                                                 \
+		mutest_expect(                                                                              \
+			"target unit",                                                                          \
+			mutest_string_value( to->symbol ),                                                      \
+			mutest_to_be,                                                                           \
+			symbol_res,                                                                             \
+			NULL );                                                                                 \
+	}
+
+CONVERSION_TEST( "10 km in mi", 6.2137119224, "mi", 10_km_in_mi )
+CONVERSION_TEST( "3.5 GiB to MB", 3758.096384, "MB", 3_5_gib_to_mb )
+CONVERSION_TEST( "72 F in C", 22.2222222222, "C", 72_f_in_c )
+CONVERSION_TEST( "  -40 celsius to fahrenheit ", -40, "F", neg_40_c_in_f )
+CONVERSION_TEST( "100km/h in mph", 62.1371192237, "mph", 100_kmh_in_mph )
+CONVERSION_TEST( "12 in in cm", 30.48, "cm", 12_in_in_cm )
+
+#undef CONVERSION_TEST
+
+#define REJECTION_TEST( query, identifier )                                                         \
+	static void rejection_##identifier##_spec( void )                                               \
+	{                                                                                               \
+		gdouble value;                                                                              \
+		FoobarUnit const* from;                                                                     \
+		FoobarUnit const* to;                                                                       \
+                                                                                                    \
+		gchar const input[] = query;                                                                \
+		gboolean parsed;                                                                            \
+		parsed = foobar_unit_parse_conversion( input, sizeof(input) - 1, &value, &from, &to );      \
+		mutest_expect(                                                                              \
+			"parse result",                                                                         \
+			mutest_bool_value( parsed ),                                                            \
+			mutest_to_be_false,                                                                     \
+			NULL );                                                                                 \
+	}
+
+REJECTION_TEST( "firefox", app_name )
+REJECTION_TEST( "10 + 3", math )
+REJECTION_TEST( "10 km in kg", dimension_mismatch )
+REJECTION_TEST( "10 km as mi", unknown_keyword )
+REJECTION_TEST( "10 km in", missing_unit )
+REJECTION_TEST( "10 KM in mi", case_sensitive )
+REJECTION_TEST( "10 km in mi later", trailing_input )
+
+#undef REJECTION_TEST
+
+static void lookup_spec( void )
+{
+	mutest_expect(
+		"symbol lookup",
+		mutest_string_value( foobar_unit_lookup( "GiB", 3 )->symbol ),
+		mutest_to_be,
+		"GiB",
+		NULL );
+	mutest_expect(
+		"alias lookup",
+		mutest_string_value( foobar_unit_lookup( "kilometres", 10 )->symbol ),
+		mutest_to_be,
+		"km",
+		NULL );
+	mutest_expect(
+		"non-terminated lookup",
+		mutest_bool_value( foobar_unit_lookup( "kilometresx", 10 ) != NULL ),
+		mutest_to_be_true,
+		NULL );
+	mutest_expect(
+		"unknown lookup",
+		mutest_bool_value( foobar_unit_lookup( "parsec", 6 ) == NULL ),
+		mutest_to_be_true,
+		NULL );
+}
+
+static void conversion_suite( void )
+{
+	mutest_it( "convert 10 km in mi", conversion_10_km_in_mi_spec );
+	mutest_it( "convert 3.5 GiB to MB", conversion_3_5_gib_to_mb_spec );
+	mutest_it( "convert 72 F in C", conversion_72_f_in_c_spec );
+	mutest_it( "convert -40 celsius to fahrenheit", conversion_neg_40_c_in_f_spec );
+	mutest_it( "convert 100km/h in mph", conversion_100_kmh_in_mph_spec );
+	mutest_it( "convert 12 in in cm", conversion_12_in_in_cm_spec );
+}
+
+static void rejection_suite( void )
+{
+	mutest_it( "reject app names", rejection_app_name_spec );
+	mutest_it( "reject mathematical expressions", rejection_math_spec );
+	mutest_it( "reject mismatching dimensions", rejection_dimension_mismatch_spec );
+	mutest_it( "reject unknown keywords", rejection_unknown_keyword_spec );
+	mutest_it( "reject missing target units", rejection_missing_unit_spec );
+	mutest_it( "reject wrongly capitalized units", rejection_case_sensitive_spec );
+	mutest_it( "reject trailing input", rejection_trailing_input_spec );
+}
+
+static void lookup_suite( void )
+{
+	mutest_it( "look up units by name", lookup_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Conversion", conversion_suite );
+	mutest_describe( "Rejection", rejection_suite );
+	mutest_describe( "Lookup", lookup_suite );
+)
@@ -0,0 +1,349 @@
+#include "services/scheduler-service.h"
+
+//
+// FoobarSchedulerService:
+//
+// Service running timed work for other services from a single main loop source, so tasks that are due at roughly the
+// same time share one wakeup of the process.
+//
+// Each task has a deadline (in monotonic time) and a slack, i.e. the time span by which it may be delayed past its
+// deadline. The source becomes ready at the earliest time at which any task would be late, and then runs every task
+// whose deadline has passed, even if it could have waited longer. Periodic tasks are re-armed relative to their
+// previous deadline, so they do not drift when they are run late.
+//
+// The number of wakeups is counted in total and per task name, which makes the idle cost of every kind of task
+// measurable.
+//
+// Tasks are kept in a hash table which is scanned when the next wakeup is computed. This is cheap for the handful of
+// tasks the services register.
+//
+
+struct _FoobarSchedulerService
+{
+	GObject     parent_instance;
+	GHashTable* tasks;
+	GHashTable* task_wakeups;
+	GSource*    source;
+	guint       next_id;
+	guint       wakeups;
+};
+
+//
+// SchedulerTask:
+//
+// A single registered task. The interval is zero for tasks which only run once.
+//
+
+typedef struct _SchedulerTask SchedulerTask;
+
+struct _SchedulerTask
+{
+	gchar*      name;
+	gint64      deadline;
+	GTimeSpan   interval;
+	GTimeSpan   slack;
+	GSourceFunc func;
+	gpointer    userdata;
+};
+
+static void     foobar_scheduler_service_class_init   ( FoobarSchedulerServiceClass* klass );
+static void     foobar_scheduler_service_init         ( FoobarSchedulerService*      self );
+static void     foobar_scheduler_service_finalize     ( GObject*                     object );
+static gboolean foobar_scheduler_service_handle_wakeup( gpointer                     userdata );
+static guint    foobar_scheduler_service_add          ( FoobarSchedulerService*      self,
+                                                        gchar const*                 name,
+                                                        gint64                       deadline,
+                                                        GTimeSpan                    interval,
+                                                        GTimeSpan                    slack,
+                                                        GSourceFunc                  func,
+                                                        gpointer                     userdata );
+static void     foobar_scheduler_service_update_source( FoobarSchedulerService*      self );
+static void     scheduler_task_free                   ( gpointer                     data );
+static gboolean scheduler_source_dispatch             ( GSource*                     source,
+                                                        GSourceFunc                  callback,
+                                                        gpointer                     userdata );
+
+G_DEFINE_FINAL_TYPE( FoobarSchedulerService, foobar_scheduler_service, G_TYPE_OBJECT )
+
+static GSourceFuncs scheduler_source_funcs = { .dispatch = scheduler_source_dispatch };
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Service Implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for the scheduler service.
+//
+void foobar_scheduler_service_class_init( FoobarSchedulerServiceClass* klass )
+{
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->finalize = foobar_scheduler_service_finalize;
+}
+
+//
+// Instance initialization for the scheduler service.
+//
+void foobar_scheduler_service_init( FoobarSchedulerService* self )
+{
+	self->tasks = g_hash_table_new_full( g_direct_hash, g_direct_equal, NULL, scheduler_task_free );
+	self->task_wakeups = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, NULL );
+	self->next_id = 1;
+
+	self->source = g_source_new( &scheduler_source_funcs, sizeof( GSource ) );
+	g_source_set_name( self->source, "scheduler" );
+	g_source_set_callback( self->source, foobar_scheduler_service_handle_wakeup, self, NULL );
+	g_source_attach( self->source, NULL );
+}
+
+//
+// Instance cleanup for the scheduler service.
+//
+void foobar_scheduler_service_finalize( GObject* object )
+{
+	FoobarSchedulerService* self = (FoobarSchedulerService*)object;
+
+	if ( self->source ) { g_source_destroy( self->source ); }
+
+	g_clear_pointer( &self->source, g_source_unref );
+	g_clear_pointer( &self->tasks, g_hash_table_unref );
+	g_clear_pointer( &self->task_wakeups, g_hash_table_unref );
+
+	G_OBJECT_CLASS( foobar_scheduler_service_parent_class )->finalize( object );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Create a new scheduler service instance.
+//
+FoobarSchedulerService* foobar_scheduler_service_new( void )
+{
+	return g_object_new( FOOBAR_TYPE_SCHEDULER_SERVICE, NULL );
+}
+
+//
+// Run a function once, at some point between the deadline (in monotonic time) and the deadline plus the slack.
+//
+// The task is removed before the function is invoked, so its return value is ignored. The returned ID can be used to
+// cancel the task with foobar_scheduler_service_clear before it has run.
+//
+guint foobar_scheduler_service_add_deadline(
+	FoobarSchedulerService* self,
+	gchar const*            name,
+	gint64                  deadline,
+	GTimeSpan               slack,
+	GSourceFunc             func,
+	gpointer                userdata )
+{
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( self ), 0 );
+	g_return_val_if_fail( name != NULL, 0 );
+	g_return_val_if_fail( func != NULL, 0 );
+
+	return foobar_scheduler_service_add( self, name, deadline, 0, MAX( slack, 0 ), func, userdata );
+}
+
+//
+// Run a function every interval, allowing each run to be delayed by up to the slack, until it returns G_SOURCE_REMOVE
+// or is cancelled with foobar_scheduler_service_clear.
+//
+guint foobar_scheduler_service_add_periodic(
+	FoobarSchedulerService* self,
+	gchar const*            name,
+	GTimeSpan               interval,
+	GTimeSpan               slack,
+	GSourceFunc             func,
+	gpointer                userdata )
+{
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( self ), 0 );
+	g_return_val_if_fail( name != NULL, 0 );
+	g_return_val_if_fail( interval > 0, 0 );
+	g_return_val_if_fail( func != NULL, 0 );
+
+	gint64 deadline = g_get_monotonic_time( ) + interval;
+	return foobar_scheduler_service_add( self, name, deadline, interval, MAX( slack, 0 ), func, userdata );
+}
+
+//
+// Cancel the task with the ID stored in the given location (if it is non-zero and still scheduled) and reset it to
+// zero, similar to g_clear_handle_id.
+//
+void foobar_scheduler_service_clear(
+	FoobarSchedulerService* self,
+	guint*                  id )
+{
+	g_return_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( self ) );
+	g_return_if_fail( id != NULL );
+
+	if ( !*id ) { return; }
+
+	if ( g_hash_table_remove( self->tasks, GUINT_TO_POINTER( *id ) ) )
+	{
+		foobar_scheduler_service_update_source( self );
+	}
+	*id = 0;
+}
+
+//
+// Get the number of times the scheduler has woken up the process so far.
+//
+guint foobar_scheduler_service_get_wakeups( FoobarSchedulerService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( self ), 0 );
+
+	return self->wakeups;
+}
+
+//
+// Get a table mapping task names to the number of times a task with that name has run so far.
+//
+// Since tasks sharing a wakeup are counted individually, the counts may add up to more than the total wakeups.
+//
+GHashTable* foobar_scheduler_service_get_task_wakeups( FoobarSchedulerService* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_SCHEDULER_SERVICE( self ), NULL );
+
+	return self->task_wakeups;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Signal Handlers
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Called once the first task would be late, running all tasks whose deadline has passed.
+//
+gboolean foobar_scheduler_service_handle_wakeup( gpointer userdata )
+{
+	FoobarSchedulerService* self = (FoobarSchedulerService*)userdata;
+
+	++self->wakeups;
+
+	// Tasks may add or cancel other tasks, so only the IDs of due tasks are collected first, and each one is looked up
+	// again right before it is run.
+
+	gint64 now = g_get_monotonic_time( );
+	g_autoptr( GArray ) due = g_array_new( FALSE, FALSE, sizeof( guint ) );
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	g_hash_table_iter_init( &iter, self->tasks );
+	while ( g_hash_table_iter_next( &iter, &key, &value ) )
+	{
+		SchedulerTask* task = value;
+		if ( task->deadline <= now )
+		{
+			guint id = GPOINTER_TO_UINT( key );
+			g_array_append_val( due, id );
+		}
+	}
+
+	for ( guint i = 0; i < due->len; ++i )
+	{
+		guint id = g_array_index( due, guint, i );
+		SchedulerTask* task = g_hash_table_lookup( self->tasks, GUINT_TO_POINTER( id ) );
+		if ( !task ) { continue; }
+
+		guint count = GPOINTER_TO_UINT( g_hash_table_lookup( self->task_wakeups, task->name ) );
+		g_hash_table_replace( self->task_wakeups, g_strdup( task->name ), GUINT_TO_POINTER( count + 1 ) );
+
+		GSourceFunc func = task->func;
+		gpointer task_userdata = task->userdata;
+		if ( task->interval > 0 )
+		{
+			// If more than a whole interval was missed (e.g. during suspend), the missed runs are skipped.
+
+			task->deadline += task->interval;
+			if ( task->deadline <= now ) { task->deadline = now + task->interval; }
+			if ( func( task_userdata ) == G_SOURCE_REMOVE )
+			{
+				g_hash_table_remove( self->tasks, GUINT_TO_POINTER( id ) );
+			}
+		}
+		else
+		{
+			g_hash_table_remove( self->tasks, GUINT_TO_POINTER( id ) );
+			func( task_userdata );
+		}
+	}
+
+	foobar_scheduler_service_update_source( self );
+	return G_SOURCE_CONTINUE;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Register a new task and move the next wakeup if necessary.
+//
+guint foobar_scheduler_service_add(
+	FoobarSchedulerService* self,
+	gchar const*            name,
+	gint64                  deadline,
+	GTimeSpan               interval,
+	GTimeSpan               slack,
+	GSourceFunc             func,
+	gpointer                userdata )
+{
+	SchedulerTask* task = g_new0( SchedulerTask, 1 );
+	task->name = g_strdup( name );
+	task->deadline = deadline;
+	task->interval = interval;
+	task->slack = slack;
+	task->func = func;
+	task->userdata = userdata;
+
+	guint id = self->next_id++;
+	if ( !self->next_id ) { self->next_id = 1; }
+	g_hash_table_insert( self->tasks, GUINT_TO_POINTER( id ), task );
+	foobar_scheduler_service_update_source( self );
+
+	return id;
+}
+
+//
+// Let the source become ready at the earliest time at which a task would be late (or never if there are no tasks).
+//
+void foobar_scheduler_service_update_source( FoobarSchedulerService* self )
+{
+	gint64 ready_time = -1;
+
+	GHashTableIter iter;
+	gpointer value;
+	g_hash_table_iter_init( &iter, self->tasks );
+	while ( g_hash_table_iter_next( &iter, NULL, &value ) )
+	{
+		SchedulerTask* task = value;
+		gint64 latest = task->deadline + task->slack;
+		if ( ready_time < 0 || latest < ready_time ) { ready_time = latest; }
+	}
+
+	g_source_set_ready_time( self->source, ready_time );
+}
+
+//
+// Free the state of a task after it was removed from the table.
+//
+void scheduler_task_free( gpointer data )
+{
+	SchedulerTask* task = (SchedulerTask*)data;
+
+	g_free( task->name );
+	g_free( task );
+}
+
+//
+// Dispatch function for the scheduler source, which only becomes ready through its ready time.
+//
+gboolean scheduler_source_dispatch(
+	GSource*    source,
+	GSourceFunc callback,
+	gpointer    userdata )
+{
+	(void)source;
+
+	return callback( userdata );
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_SCHEDULER_SERVICE foobar_scheduler_service_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarSchedulerService, foobar_scheduler_service, FOOBAR, SCHEDULER_SERVICE, GObject )
+
+FoobarSchedulerService* foobar_scheduler_service_new             ( void );
+guint                   foobar_scheduler_service_add_deadline    ( FoobarSchedulerService* self,
+                                                                   gchar const*            name,
+                                                                   gint64                  deadline,
+                                                                   GTimeSpan               slack,
+                                                                   GSourceFunc             func,
+                                                                   gpointer                userdata );
+guint                   foobar_scheduler_service_add_periodic    ( FoobarSchedulerService* self,
+                                                                   gchar const*            name,
+                                                                   GTimeSpan               interval,
+                                                                   GTimeSpan               slack,
+                                                                   GSourceFunc             func,
+                                                                   gpointer                userdata );
+void                    foobar_scheduler_service_clear           ( FoobarSchedulerService* self,
+                                                                   guint*                  id );
+guint                   foobar_scheduler_service_get_wakeups     ( FoobarSchedulerService* self );
+GHashTable*             foobar_scheduler_service_get_task_wakeups( FoobarSchedulerService* self );
+
+G_END_DECLS
@@ -0,0 +1,288 @@
+#include "services/scheduler-service.h"
+#include <mutest.h>
+
+//
+// SchedulerTestState:
+//
+// State shared by the tasks of a single spec.
+//
+
+typedef struct _SchedulerTestState SchedulerTestState;
+
+struct _SchedulerTestState
+{
+	FoobarSchedulerService* scheduler;
+	guint                   runs;
+	guint                   max_runs;
+	guint                   first_id;
+	guint                   second_id;
+	guint                   added_id;
+};
+
+static gboolean count_func          ( gpointer                userdata );
+static gboolean cancel_other_func   ( gpointer                userdata );
+static gboolean cancel_self_func    ( gpointer                userdata );
+static gboolean add_task_func       ( gpointer                userdata );
+static guint    task_wakeups        ( FoobarSchedulerService* scheduler,
+                                      gchar const*            name );
+static void     scheduler_run_until ( guint*                  runs,
+                                      guint                   count );
+static void     scheduler_run_idle  ( void );
+
+static void coalesce_spec( void )
+{
+	FoobarSchedulerService* scheduler = foobar_scheduler_service_new( );
+	SchedulerTestState state = { .scheduler = scheduler };
+
+	// The third task cannot be delayed, and the others are already due by then.
+	gint64 now = g_get_monotonic_time( );
+	foobar_scheduler_service_add_deadline(
+		scheduler,
+		"first",
+		now + 10 * G_TIME_SPAN_MILLISECOND,
+		50 * G_TIME_SPAN_MILLISECOND,
+		count_func,
+		&state );
+	foobar_scheduler_service_add_deadline(
+		scheduler,
+		"second",
+		now + 30 * G_TIME_SPAN_MILLISECOND,
+		50 * G_TIME_SPAN_MILLISECOND,
+		count_func,
+		&state );
+	foobar_scheduler_service_add_deadline(
+		scheduler,
+		"third",
+		now + 40 * G_TIME_SPAN_MILLISECOND,
+		0,
+		count_func,
+		&state );
+	scheduler_run_until( &state.runs, 3 );
+
+	mutest_expect(
+		"tasks run",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		3,
+		NULL );
+	mutest_expect(
+		"wakeups",
+		mutest_int_value( foobar_scheduler_service_get_wakeups( scheduler ) ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"wakeups per task",
+		mutest_bool_value(
+			task_wakeups( scheduler, "first" ) == 1 &&
+			task_wakeups( scheduler, "second" ) == 1 &&
+			task_wakeups( scheduler, "third" ) == 1 ),
+		mutest_to_be_true,
+		NULL );
+
+	g_object_unref( scheduler );
+}
+
+static void periodic_spec( void )
+{
+	FoobarSchedulerService* scheduler = foobar_scheduler_service_new( );
+	SchedulerTestState state = { .scheduler = scheduler, .max_runs = 3 };
+
+	foobar_scheduler_service_add_periodic( scheduler, "tick", 100 * G_TIME_SPAN_MILLISECOND, 0, count_func, &state );
+	scheduler_run_until( &state.runs, 1 );
+
+	// Missing several intervals (e.g. during suspend) only results in a single catch-up run.
+	g_usleep( 350 * G_TIME_SPAN_MILLISECOND );
+	scheduler_run_idle( );
+	mutest_expect(
+		"runs after missed intervals",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		2,
+		NULL );
+
+	// The task is removed once it returns G_SOURCE_REMOVE.
+	scheduler_run_until( &state.runs, 3 );
+	g_usleep( 150 * G_TIME_SPAN_MILLISECOND );
+	scheduler_run_idle( );
+	mutest_expect(
+		"runs after removal",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		3,
+		NULL );
+	mutest_expect(
+		"wakeups per task",
+		mutest_int_value( task_wakeups( scheduler, "tick" ) ),
+		mutest_to_be,
+		3,
+		NULL );
+
+	g_object_unref( scheduler );
+}
+
+static void cancel_during_dispatch_spec( void )
+{
+	FoobarSchedulerService* scheduler = foobar_scheduler_service_new( );
+	SchedulerTestState state = { .scheduler = scheduler };
+
+	// Both tasks are due in the same wakeup, and whichever runs first cancels the other.
+	gint64 now = g_get_monotonic_time( );
+	state.first_id = foobar_scheduler_service_add_deadline( scheduler, "first", now, 0, cancel_other_func, &state );
+	state.second_id = foobar_scheduler_service_add_deadline( scheduler, "second", now, 0, cancel_other_func, &state );
+	scheduler_run_until( &state.runs, 1 );
+	scheduler_run_idle( );
+
+	mutest_expect(
+		"tasks run",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		1,
+		NULL );
+
+	// A periodic task may also cancel itself instead of returning G_SOURCE_REMOVE.
+	state.runs = 0;
+	state.first_id = foobar_scheduler_service_add_periodic(
+		scheduler,
+		"periodic",
+		10 * G_TIME_SPAN_MILLISECOND,
+		0,
+		cancel_self_func,
+		&state );
+	scheduler_run_until( &state.runs, 1 );
+	g_usleep( 30 * G_TIME_SPAN_MILLISECOND );
+	scheduler_run_idle( );
+
+	mutest_expect(
+		"periodic task runs",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"cleared ID",
+		mutest_int_value( state.first_id ),
+		mutest_to_be,
+		0,
+		NULL );
+
+	g_object_unref( scheduler );
+}
+
+static void add_during_dispatch_spec( void )
+{
+	FoobarSchedulerService* scheduler = foobar_scheduler_service_new( );
+	SchedulerTestState state = { .scheduler = scheduler };
+
+	// A task added while dispatching is not run as part of the same wakeup, even if it is already due.
+	foobar_scheduler_service_add_deadline( scheduler, "add", g_get_monotonic_time( ), 0, add_task_func, &state );
+	scheduler_run_until( &state.runs, 1 );
+
+	mutest_expect(
+		"tasks run in first wakeup",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		1,
+		NULL );
+	mutest_expect(
+		"added task",
+		mutest_bool_value( state.added_id != 0 ),
+		mutest_to_be_true,
+		NULL );
+
+	scheduler_run_until( &state.runs, 2 );
+	mutest_expect(
+		"tasks run",
+		mutest_int_value( state.runs ),
+		mutest_to_be,
+		2,
+		NULL );
+	mutest_expect(
+		"wakeups",
+		mutest_int_value( foobar_scheduler_service_get_wakeups( scheduler ) ),
+		mutest_to_be,
+		2,
+		NULL );
+	mutest_expect(
+		"wakeups per task",
+		mutest_bool_value( task_wakeups( scheduler, "add" ) == 1 && task_wakeups( scheduler, "added" ) == 1 ),
+		mutest_to_be_true,
+		NULL );
+
+	g_object_unref( scheduler );
+}
+
+gboolean count_func( gpointer userdata )
+{
+	SchedulerTestState* state = (SchedulerTestState*)userdata;
+
+	state->runs += 1;
+	return state->max_runs && state->runs >= state->max_runs ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+gboolean cancel_other_func( gpointer userdata )
+{
+	SchedulerTestState* state = (SchedulerTestState*)userdata;
+
+	state->runs += 1;
+	foobar_scheduler_service_clear( state->scheduler, &state->first_id );
+	foobar_scheduler_service_clear( state->scheduler, &state->second_id );
+	return G_SOURCE_REMOVE;
+}
+
+gboolean cancel_self_func( gpointer userdata )
+{
+	SchedulerTestState* state = (SchedulerTestState*)userdata;
+
+	state->runs += 1;
+	foobar_scheduler_service_clear( state->scheduler, &state->first_id );
+	return G_SOURCE_CONTINUE;
+}
+
+gboolean add_task_func( gpointer userdata )
+{
+	SchedulerTestState* state = (SchedulerTestState*)userdata;
+
+	state->runs += 1;
+	state->added_id = foobar_scheduler_service_add_deadline(
+		state->scheduler,
+		"added",
+		g_get_monotonic_time( ) - G_TIME_SPAN_MILLISECOND,
+		0,
+		count_func,
+		state );
+	return G_SOURCE_REMOVE;
+}
+
+guint task_wakeups(
+	FoobarSchedulerService* scheduler,
+	gchar const*            name )
+{
+	GHashTable* wakeups = foobar_scheduler_service_get_task_wakeups( scheduler );
+	return GPOINTER_TO_UINT( g_hash_table_lookup( wakeups, name ) );
+}
+
+void scheduler_run_until(
+	guint* runs,
+	guint  count )
+{
+	gint64 deadline = g_get_monotonic_time( ) + 5 * G_TIME_SPAN_SECOND;
+	while ( *runs < count && g_get_monotonic_time( ) < deadline ) { g_main_context_iteration( NULL, TRUE ); }
+}
+
+void scheduler_run_idle( void )
+{
+	while ( g_main_context_iteration( NULL, FALSE ) ) { }
+}
+
+static void scheduler_suite( void )
+{
+	mutest_it( "coalesces deadlines within their slack", coalesce_spec );
+	mutest_it( "re-arms periodic tasks and skips missed intervals", periodic_spec );
+	mutest_it( "skips tasks cancelled while dispatching", cancel_during_dispatch_spec );
+	mutest_it( "runs tasks added while dispatching in a later wakeup", add_during_dispatch_spec );
+}
+
+MUTEST_MAIN(
+	mutest_describe( "Scheduler", scheduler_suite );
+)
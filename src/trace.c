@@ -0,0 +1,275 @@
+#include "trace.h"
+#include <json-glib/json-glib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define TRACE_FLUSH_DELAY 1
+
+//
+// Startup tracing:
+//
+// If the FOOBAR_TRACE environment variable is set to a path, spans recorded using foobar_trace_begin/foobar_trace_end
+// (or FOOBAR_TRACE_SPAN) are written to that path in the Chrome trace event format, which can be opened using
+// chrome://tracing or Perfetto. The file is rewritten shortly after new spans were recorded and on exit.
+//
+// Without FOOBAR_TRACE, foobar_trace_begin does not even read the clock and all other functions return immediately, so
+// the spans can stay in place.
+//
+
+typedef struct _TraceEvent TraceEvent;
+typedef struct _TraceFrame TraceFrame;
+
+struct _TraceEvent
+{
+	gchar* name;
+	gint64 start;
+	gint64 duration;
+	gint64 thread_id;
+};
+
+struct _TraceFrame
+{
+	gchar*         name;
+	gint64         start;
+	gboolean       is_recorded;
+	GdkFrameClock* clock;
+	gulong         paint_handler_id;
+};
+
+static gchar*  trace_path     = NULL;
+static gint64  trace_origin   = 0;
+static GArray* trace_events   = NULL;
+static guint   trace_flush_id = 0;
+static GMutex  trace_mutex;
+
+static void     foobar_trace_record            ( gchar const*   name,
+                                                 gint64         start,
+                                                 gint64         end );
+static gboolean foobar_trace_handle_flush      ( gpointer       userdata );
+static void     foobar_trace_handle_map        ( GtkWidget*     widget,
+                                                 gpointer       userdata );
+static void     foobar_trace_handle_after_paint( GdkFrameClock* clock,
+                                                 gpointer       userdata );
+static void     foobar_trace_frame_free        ( gpointer       data,
+                                                 GClosure*      closure );
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Enable tracing if the FOOBAR_TRACE environment variable is set. All timestamps are relative to this call.
+//
+// This should be called once, when the primary instance is activated. Client invocations (which only forward commands
+// to the primary instance) must not enable tracing, because they would overwrite its trace file.
+//
+void foobar_trace_init( void )
+{
+	gchar const* path = g_getenv( "FOOBAR_TRACE" );
+	if ( !path || !*path ) { return; }
+
+	trace_path = g_strdup( path );
+	trace_origin = g_get_monotonic_time( );
+	trace_events = g_array_new( FALSE, FALSE, sizeof( TraceEvent ) );
+}
+
+//
+// Write all spans recorded so far to the trace file. Nothing is written if no spans were recorded.
+//
+void foobar_trace_flush( void )
+{
+	if ( !trace_path ) { return; }
+
+	g_mutex_lock( &trace_mutex );
+	gboolean is_empty = trace_events->len == 0;
+	g_mutex_unlock( &trace_mutex );
+	if ( is_empty ) { return; }
+
+	g_autoptr( JsonBuilder ) builder = json_builder_new( );
+	json_builder_begin_object( builder );
+	json_builder_set_member_name( builder, "traceEvents" );
+	json_builder_begin_array( builder );
+
+	g_mutex_lock( &trace_mutex );
+	g_clear_handle_id( &trace_flush_id, g_source_remove );
+	for ( guint i = 0; i < trace_events->len; ++i )
+	{
+		TraceEvent const* event = &g_array_index( trace_events, TraceEvent, i );
+		json_builder_begin_object( builder );
+		json_builder_set_member_name( builder, "name" );
+		json_builder_add_string_value( builder, event->name );
+		json_builder_set_member_name( builder, "cat" );
+		json_builder_add_string_value( builder, "foobar" );
+		json_builder_set_member_name( builder, "ph" );
+		json_builder_add_string_value( builder, "X" );
+		json_builder_set_member_name( builder, "ts" );
+		json_builder_add_int_value( builder, event->start - trace_origin );
+		json_builder_set_member_name( builder, "dur" );
+		json_builder_add_int_value( builder, event->duration );
+		json_builder_set_member_name( builder, "pid" );
+		json_builder_add_int_value( builder, getpid( ) );
+		json_builder_set_member_name( builder, "tid" );
+		json_builder_add_int_value( builder, event->thread_id );
+		json_builder_end_object( builder );
+	}
+	g_mutex_unlock( &trace_mutex );
+
+	json_builder_end_array( builder );
+	json_builder_set_member_name( builder, "displayTimeUnit" );
+	json_builder_add_string_value( builder, "ms" );
+	json_builder_end_object( builder );
+
+	g_autoptr( JsonNode ) root_node = json_builder_get_root( builder );
+	g_autoptr( JsonGenerator ) generator = json_generator_new( );
+	json_generator_set_root( generator, root_node );
+
+	g_autoptr( GError ) error = NULL;
+	if ( !json_generator_to_file( generator, trace_path, &error ) )
+	{
+		g_warning( "Unable to write trace file: %s", error->message );
+	}
+}
+
+//
+// Start a span, returning its start time which is later passed to foobar_trace_end.
+//
+gint64 foobar_trace_begin( void )
+{
+	return trace_path ? g_get_monotonic_time( ) : 0;
+}
+
+//
+// End a span which was started using foobar_trace_begin. This may be called from any thread.
+//
+void foobar_trace_end(
+	gint64       start,
+	gchar const* name )
+{
+	if ( !trace_path ) { return; }
+
+	foobar_trace_record( name, start, g_get_monotonic_time( ) );
+}
+
+//
+// Record a span from the moment the widget is first mapped until the first frame for it has been painted.
+//
+// The widget should be a window, and the span is only recorded once, even if the window is hidden and shown again.
+//
+void foobar_trace_first_frame(
+	GtkWidget*   widget,
+	gchar const* name )
+{
+	g_return_if_fail( GTK_IS_WIDGET( widget ) );
+
+	if ( !trace_path ) { return; }
+
+	TraceFrame* frame = g_new0( TraceFrame, 1 );
+	frame->name = g_strdup( name );
+	g_signal_connect_data(
+		widget,
+		"map",
+		G_CALLBACK( foobar_trace_handle_map ),
+		frame,
+		foobar_trace_frame_free,
+		G_CONNECT_DEFAULT );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Signal Handlers
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Called when the widget passed to foobar_trace_first_frame is mapped, starting to wait for its first frame.
+//
+void foobar_trace_handle_map(
+	GtkWidget* widget,
+	gpointer   userdata )
+{
+	TraceFrame* frame = (TraceFrame*)userdata;
+	if ( frame->is_recorded || frame->clock ) { return; }
+
+	GdkFrameClock* clock = gtk_widget_get_frame_clock( widget );
+	if ( !clock ) { return; }
+
+	frame->start = g_get_monotonic_time( );
+	frame->clock = g_object_ref( clock );
+	frame->paint_handler_id = g_signal_connect(
+		frame->clock,
+		"after-paint",
+		G_CALLBACK( foobar_trace_handle_after_paint ),
+		frame );
+}
+
+//
+// Called by the frame clock of the widget passed to foobar_trace_first_frame after it has painted the first frame.
+//
+void foobar_trace_handle_after_paint(
+	GdkFrameClock* clock,
+	gpointer       userdata )
+{
+	(void)clock;
+	TraceFrame* frame = (TraceFrame*)userdata;
+
+	foobar_trace_record( frame->name, frame->start, g_get_monotonic_time( ) );
+	frame->is_recorded = TRUE;
+	g_clear_signal_handler( &frame->paint_handler_id, frame->clock );
+	g_clear_object( &frame->clock );
+}
+
+//
+// Called after TRACE_FLUSH_DELAY seconds without new spans to write them to the trace file.
+//
+gboolean foobar_trace_handle_flush( gpointer userdata )
+{
+	(void)userdata;
+
+	g_mutex_lock( &trace_mutex );
+	trace_flush_id = 0;
+	g_mutex_unlock( &trace_mutex );
+
+	foobar_trace_flush( );
+	return G_SOURCE_REMOVE;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Store a completed span and schedule writing the trace file.
+//
+void foobar_trace_record(
+	gchar const* name,
+	gint64       start,
+	gint64       end )
+{
+	TraceEvent event =
+		{
+			.name = g_strdup( name ),
+			.start = start,
+			.duration = end - start,
+			.thread_id = syscall( SYS_gettid ),
+		};
+
+	g_mutex_lock( &trace_mutex );
+	g_array_append_val( trace_events, event );
+	g_clear_handle_id( &trace_flush_id, g_source_remove );
+	trace_flush_id = g_timeout_add_seconds( TRACE_FLUSH_DELAY, foobar_trace_handle_flush, NULL );
+	g_mutex_unlock( &trace_mutex );
+}
+
+//
+// Free the state for a first frame span once the widget it was registered for is destroyed.
+//
+void foobar_trace_frame_free(
+	gpointer  data,
+	GClosure* closure )
+{
+	(void)closure;
+	TraceFrame* frame = (TraceFrame*)data;
+
+	g_clear_signal_handler( &frame->paint_handler_id, frame->clock );
+	g_clear_object( &frame->clock );
+	g_free( frame->name );
+	g_free( frame );
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TRACE_SPAN( name, ... )                      \
+	G_STMT_START                                            \
+	{                                                       \
+		gint64 foobar_trace_start_ = foobar_trace_begin( ); \
+		__VA_ARGS__;                                        \
+		foobar_trace_end( foobar_trace_start_, name );      \
+	}                                                       \
+	G_STMT_END
+
+void   foobar_trace_init       ( void );
+void   foobar_trace_flush      ( void );
+gint64 foobar_trace_begin      ( void );
+void   foobar_trace_end        ( gint64       start,
+                                 gchar const* name );
+void   foobar_trace_first_frame( GtkWidget*   widget,
+                                 gchar const* name );
+
+G_END_DECLS
@@ -0,0 +1,486 @@
+#include "widgets/notification-group-widget.h"
+
+//
+// FoobarNotificationGroupWidget:
+//
+// Row widget for a tree list model of notification groups (see foobar_notification_service_get_groups). A group with
+// more than one notification is shown as a compact summary with its latest notification's summary and the number of
+// notifications in the group, which can be expanded to show all of them. Groups with a single notification as well as
+// the expanded child rows are shown using a regular FoobarNotificationWidget.
+//
+
+struct _FoobarNotificationGroupWidget
+{
+	GtkWidget                parent_instance;
+	GtkWidget*               summary;
+	GtkWidget*               notification_widget;
+	GtkTreeListRow*          row;
+	FoobarNotificationGroup* group;
+	gulong                   expanded_handler_id;
+	gulong                   count_handler_id;
+	gulong                   latest_handler_id;
+};
+
+enum
+{
+	PROP_ROW = 1,
+	PROP_GROUP,
+	N_PROPS,
+};
+
+static GParamSpec* props[N_PROPS] = { 0 };
+
+static void   foobar_notification_group_widget_class_init           ( FoobarNotificationGroupWidgetClass* klass );
+static void   foobar_notification_group_widget_init                 ( FoobarNotificationGroupWidget*      self );
+static void   foobar_notification_group_widget_get_property         ( GObject*                            object,
+                                                                      guint                               prop_id,
+                                                                      GValue*                             value,
+                                                                      GParamSpec*                         pspec );
+static void   foobar_notification_group_widget_set_property         ( GObject*                            object,
+                                                                      guint                               prop_id,
+                                                                      GValue const*                       value,
+                                                                      GParamSpec*                         pspec );
+static void   foobar_notification_group_widget_dispose              ( GObject*                            object );
+static void   foobar_notification_group_widget_handle_expand_clicked( GtkButton*                          button,
+                                                                      gpointer                            userdata );
+static void   foobar_notification_group_widget_handle_close_clicked ( GtkButton*                          button,
+                                                                      gpointer                            userdata );
+static void   foobar_notification_group_widget_handle_change        ( GObject*                            object,
+                                                                      GParamSpec*                         pspec,
+                                                                      gpointer                            userdata );
+static gchar* foobar_notification_group_widget_compute_count_label  ( GtkExpression*                      expression,
+                                                                      guint                               count,
+                                                                      gpointer                            userdata );
+static void   foobar_notification_group_widget_set_group            ( FoobarNotificationGroupWidget*      self,
+                                                                      FoobarNotificationGroup*            value );
+static void   foobar_notification_group_widget_update               ( FoobarNotificationGroupWidget*      self );
+
+G_DEFINE_FINAL_TYPE( FoobarNotificationGroupWidget, foobar_notification_group_widget, GTK_TYPE_WIDGET )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Widget Implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for notification group rows.
+//
+void foobar_notification_group_widget_class_init( FoobarNotificationGroupWidgetClass* klass )
+{
+	GtkWidgetClass* widget_klass = GTK_WIDGET_CLASS( klass );
+	gtk_widget_class_set_layout_manager_type( widget_klass, GTK_TYPE_BOX_LAYOUT );
+	gtk_widget_class_set_css_name( widget_klass, "notification-group" );
+
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->get_property = foobar_notification_group_widget_get_property;
+	object_klass->set_property = foobar_notification_group_widget_set_property;
+	object_klass->dispose = foobar_notification_group_widget_dispose;
+
+	props[PROP_ROW] = g_param_spec_object(
+		"row",
+		"Row",
+		"Row of the tree list model containing either a notification group or a notification.",
+		GTK_TYPE_TREE_LIST_ROW,
+		G_PARAM_READWRITE );
+	props[PROP_GROUP] = g_param_spec_object(
+		"group",
+		"Group",
+		"The notification group of the row, if it is a top-level row.",
+		FOOBAR_TYPE_NOTIFICATION_GROUP,
+		G_PARAM_READABLE );
+	g_object_class_install_properties( object_klass, N_PROPS, props );
+}
+
+//
+// Instance initialization for notification group rows.
+//
+void foobar_notification_group_widget_init( FoobarNotificationGroupWidget* self )
+{
+	// Set up the compact summary of a group.
+
+	GtkWidget* title = gtk_label_new( NULL );
+	gtk_label_set_ellipsize( GTK_LABEL( title ), PANGO_ELLIPSIZE_END );
+	gtk_label_set_wrap( GTK_LABEL( title ), FALSE );
+	gtk_widget_add_css_class( title, "title" );
+	gtk_widget_set_valign( title, GTK_ALIGN_BASELINE_CENTER );
+
+	GtkWidget* body = gtk_label_new( NULL );
+	gtk_label_set_ellipsize( GTK_LABEL( body ), PANGO_ELLIPSIZE_END );
+	gtk_label_set_wrap( GTK_LABEL( body ), FALSE );
+	gtk_label_set_xalign( GTK_LABEL( body ), 0 );
+	gtk_widget_add_css_class( body, "body" );
+	gtk_widget_set_valign( body, GTK_ALIGN_BASELINE_CENTER );
+	gtk_widget_set_hexpand( body, TRUE );
+
+	GtkWidget* count = gtk_label_new( NULL );
+	gtk_widget_add_css_class( count, "count" );
+	gtk_widget_set_valign( count, GTK_ALIGN_BASELINE_CENTER );
+
+	GtkWidget* expand_button = gtk_button_new_from_icon_name( "fluent-chevron-right-symbolic" );
+	gtk_widget_add_css_class( expand_button, "expand" );
+	gtk_widget_set_valign( expand_button, GTK_ALIGN_CENTER );
+	g_signal_connect(
+		expand_button,
+		"clicked",
+		G_CALLBACK( foobar_notification_group_widget_handle_expand_clicked ),
+		self );
+
+	GtkWidget* close_icon = gtk_image_new_from_icon_name( "fluent-dismiss-symbolic" );
+	gtk_image_set_pixel_size( GTK_IMAGE( close_icon ), 12 );
+
+	GtkWidget* close_button = gtk_button_new( );
+	gtk_button_set_child( GTK_BUTTON( close_button ), close_icon );
+	gtk_widget_add_css_class( close_button, "close-button" );
+	gtk_widget_set_valign( close_button, GTK_ALIGN_CENTER );
+	g_signal_connect( close_button, "clicked", G_CALLBACK( foobar_notification_group_widget_handle_close_clicked ), self );
+
+	GtkWidget* content = gtk_box_new( GTK_ORIENTATION_HORIZONTAL, 0 );
+	gtk_box_append( GTK_BOX( content ), title );
+	gtk_box_append( GTK_BOX( content ), body );
+	gtk_box_append( GTK_BOX( content ), count );
+	gtk_box_append( GTK_BOX( content ), expand_button );
+	gtk_box_append( GTK_BOX( content ), close_button );
+	gtk_widget_add_css_class( content, "content" );
+
+	self->summary = gtk_box_new( GTK_ORIENTATION_VERTICAL, 0 );
+	gtk_box_append( GTK_BOX( self->summary ), content );
+	gtk_widget_add_css_class( self->summary, "summary" );
+	gtk_widget_set_visible( self->summary, FALSE );
+
+	// Set up the widget for a single notification, whose insets are also used for the summary.
+
+	self->notification_widget = foobar_notification_widget_new( );
+	g_object_bind_property(
+		self->notification_widget,
+		"inset-start",
+		self->summary,
+		"margin-start",
+		G_BINDING_SYNC_CREATE );
+	g_object_bind_property(
+		self->notification_widget,
+		"inset-end",
+		self->summary,
+		"margin-end",
+		G_BINDING_SYNC_CREATE );
+	g_object_bind_property(
+		self->notification_widget,
+		"inset-top",
+		self->summary,
+		"margin-top",
+		G_BINDING_SYNC_CREATE );
+	g_object_bind_property(
+		self->notification_widget,
+		"inset-bottom",
+		self->summary,
+		"margin-bottom",
+		G_BINDING_SYNC_CREATE );
+
+	GtkLayoutManager* layout = gtk_widget_get_layout_manager( GTK_WIDGET( self ) );
+	gtk_orientable_set_orientation( GTK_ORIENTABLE( layout ), GTK_ORIENTATION_VERTICAL );
+	gtk_widget_insert_before( self->summary, GTK_WIDGET( self ), NULL );
+	gtk_widget_insert_before( self->notification_widget, GTK_WIDGET( self ), NULL );
+
+	// Set up bindings.
+
+	{
+		GtkExpression* group_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_GROUP_WIDGET, NULL, "group" );
+		GtkExpression* latest_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_GROUP, group_expr, "latest" );
+		GtkExpression* app_name_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION, latest_expr, "app-name" );
+		gtk_expression_bind( app_name_expr, title, "label", self );
+	}
+
+	{
+		GtkExpression* group_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_GROUP_WIDGET, NULL, "group" );
+		GtkExpression* latest_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_GROUP, group_expr, "latest" );
+		GtkExpression* summary_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION, latest_expr, "summary" );
+		gtk_expression_bind( summary_expr, body, "label", self );
+	}
+
+	{
+		GtkExpression* group_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_GROUP_WIDGET, NULL, "group" );
+		GtkExpression* count_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_GROUP, group_expr, "count" );
+		GtkExpression* label_params[] = { count_expr };
+		GtkExpression* label_expr = gtk_cclosure_expression_new(
+			G_TYPE_STRING,
+			NULL,
+			G_N_ELEMENTS( label_params ),
+			label_params,
+			G_CALLBACK( foobar_notification_group_widget_compute_count_label ),
+			NULL,
+			NULL );
+		gtk_expression_bind( label_expr, count, "label", self );
+	}
+}
+
+//
+// Property getter implementation, mapping a property id to a method.
+//
+void foobar_notification_group_widget_get_property(
+	GObject*    object,
+	guint       prop_id,
+	GValue*     value,
+	GParamSpec* pspec )
+{
+	FoobarNotificationGroupWidget* self = (FoobarNotificationGroupWidget*)object;
+
+	switch ( prop_id )
+	{
+		case PROP_ROW:
+			g_value_set_object( value, foobar_notification_group_widget_get_row( self ) );
+			break;
+		case PROP_GROUP:
+			g_value_set_object( value, foobar_notification_group_widget_get_group( self ) );
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
+			break;
+	}
+}
+
+//
+// Property setter implementation, mapping a property id to a method.
+//
+void foobar_notification_group_widget_set_property(
+	GObject*      object,
+	guint         prop_id,
+	GValue const* value,
+	GParamSpec*   pspec )
+{
+	FoobarNotificationGroupWidget* self = (FoobarNotificationGroupWidget*)object;
+
+	switch ( prop_id )
+	{
+		case PROP_ROW:
+			foobar_notification_group_widget_set_row( self, g_value_get_object( value ) );
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
+			break;
+	}
+}
+
+//
+// Instance de-initialization for notification group rows.
+//
+void foobar_notification_group_widget_dispose( GObject* object )
+{
+	FoobarNotificationGroupWidget* self = (FoobarNotificationGroupWidget*)object;
+
+	foobar_notification_group_widget_set_row( self, NULL );
+
+	GtkWidget* child;
+	while ( ( child = gtk_widget_get_first_child( GTK_WIDGET( self ) ) ) )
+	{
+		gtk_widget_unparent( child );
+	}
+
+	G_OBJECT_CLASS( foobar_notification_group_widget_parent_class )->dispose( object );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Create a new notification group row instance.
+//
+GtkWidget* foobar_notification_group_widget_new( void )
+{
+	return g_object_new( FOOBAR_TYPE_NOTIFICATION_GROUP_WIDGET, NULL );
+}
+
+//
+// Get the row of the tree list model currently displayed.
+//
+GtkTreeListRow* foobar_notification_group_widget_get_row( FoobarNotificationGroupWidget* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_GROUP_WIDGET( self ), NULL );
+	return self->row;
+}
+
+//
+// Get the notification group of the row, or NULL if the row is a single notification within an expanded group.
+//
+FoobarNotificationGroup* foobar_notification_group_widget_get_group( FoobarNotificationGroupWidget* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_GROUP_WIDGET( self ), NULL );
+	return self->group;
+}
+
+//
+// Get the widget used for displaying single notifications, e.g. to configure its time format and insets.
+//
+FoobarNotificationWidget* foobar_notification_group_widget_get_notification_widget( FoobarNotificationGroupWidget* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_GROUP_WIDGET( self ), NULL );
+	return FOOBAR_NOTIFICATION_WIDGET( self->notification_widget );
+}
+
+//
+// Update the row of the tree list model currently displayed.
+//
+void foobar_notification_group_widget_set_row(
+	FoobarNotificationGroupWidget* self,
+	GtkTreeListRow*                value )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_GROUP_WIDGET( self ) );
+
+	if ( self->row != value )
+	{
+		if ( self->row )
+		{
+			g_clear_signal_handler( &self->expanded_handler_id, self->row );
+			g_clear_object( &self->row );
+		}
+
+		if ( value )
+		{
+			self->row = g_object_ref( value );
+			self->expanded_handler_id = g_signal_connect(
+				self->row,
+				"notify::expanded",
+				G_CALLBACK( foobar_notification_group_widget_handle_change ),
+				self );
+		}
+
+		foobar_notification_group_widget_update( self );
+		g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_ROW] );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Signal Handlers
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Called when the user has clicked the "expand" button of a group's summary.
+//
+void foobar_notification_group_widget_handle_expand_clicked(
+	GtkButton* button,
+	gpointer   userdata )
+{
+	(void)button;
+	FoobarNotificationGroupWidget* self = (FoobarNotificationGroupWidget*)userdata;
+
+	if ( self->row ) { gtk_tree_list_row_set_expanded( self->row, !gtk_tree_list_row_get_expanded( self->row ) ); }
+}
+
+//
+// Called when the user has clicked the "close" button of a group's summary, removing all of its notifications.
+//
+void foobar_notification_group_widget_handle_close_clicked(
+	GtkButton* button,
+	gpointer   userdata )
+{
+	(void)button;
+	FoobarNotificationGroupWidget* self = (FoobarNotificationGroupWidget*)userdata;
+
+	if ( self->group ) { foobar_notification_group_close( self->group ); }
+}
+
+//
+// Called when the row was expanded or collapsed, or when the group's notifications have changed.
+//
+void foobar_notification_group_widget_handle_change(
+	GObject*    object,
+	GParamSpec* pspec,
+	gpointer    userdata )
+{
+	(void)object;
+	(void)pspec;
+	FoobarNotificationGroupWidget* self = (FoobarNotificationGroupWidget*)userdata;
+
+	foobar_notification_group_widget_update( self );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Value Converters
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Derive the label showing the number of notifications in the group.
+//
+gchar* foobar_notification_group_widget_compute_count_label(
+	GtkExpression* expression,
+	guint          count,
+	gpointer       userdata )
+{
+	(void)expression;
+	(void)userdata;
+
+	return g_strdup_printf( "%u", count );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Helper Methods
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Update the notification group of the row, observing changes to its notifications.
+//
+void foobar_notification_group_widget_set_group(
+	FoobarNotificationGroupWidget* self,
+	FoobarNotificationGroup*       value )
+{
+	if ( self->group == value ) { return; }
+
+	if ( self->group )
+	{
+		g_clear_signal_handler( &self->count_handler_id, self->group );
+		g_clear_signal_handler( &self->latest_handler_id, self->group );
+		g_clear_object( &self->group );
+	}
+
+	if ( value )
+	{
+		self->group = g_object_ref( value );
+		self->count_handler_id = g_signal_connect(
+			self->group,
+			"notify::count",
+			G_CALLBACK( foobar_notification_group_widget_handle_change ),
+			self );
+		self->latest_handler_id = g_signal_connect(
+			self->group,
+			"notify::latest",
+			G_CALLBACK( foobar_notification_group_widget_handle_change ),
+			self );
+	}
+
+	g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_GROUP] );
+}
+
+//
+// Show either the compact summary or a single notification, depending on the row's item and the size of its group.
+//
+// Only the summary is created for collapsed groups, so the number of notification widgets does not grow with the number
+// of notifications sent by a single application.
+//
+void foobar_notification_group_widget_update( FoobarNotificationGroupWidget* self )
+{
+	g_autoptr( GObject ) item = self->row ? gtk_tree_list_row_get_item( self->row ) : NULL;
+	FoobarNotificationGroup* group = FOOBAR_IS_NOTIFICATION_GROUP( item ) ? FOOBAR_NOTIFICATION_GROUP( item ) : NULL;
+	foobar_notification_group_widget_set_group( self, group );
+
+	FoobarNotification* notification = FOOBAR_IS_NOTIFICATION( item ) ? FOOBAR_NOTIFICATION( item ) : NULL;
+	gboolean is_summary = group && foobar_notification_group_get_count( group ) > 1;
+	if ( group && !is_summary ) { notification = foobar_notification_group_get_latest( group ); }
+
+	// A group that shrank to a single notification is shown as that notification, so it must not stay expanded.
+
+	gboolean is_expanded = self->row && gtk_tree_list_row_get_expanded( self->row );
+	if ( group && !is_summary && is_expanded )
+	{
+		gtk_tree_list_row_set_expanded( self->row, FALSE );
+		is_expanded = FALSE;
+	}
+
+	foobar_notification_widget_set_notification( FOOBAR_NOTIFICATION_WIDGET( self->notification_widget ), notification );
+	gtk_widget_set_visible( self->summary, is_summary );
+	gtk_widget_set_visible( self->notification_widget, !is_summary );
+
+	if ( is_expanded ) { gtk_widget_add_css_class( GTK_WIDGET( self ), "expanded" ); }
+	else { gtk_widget_remove_css_class( GTK_WIDGET( self ), "expanded" ); }
+
+	gboolean is_nested = self->row && gtk_tree_list_row_get_depth( self->row ) > 0;
+	if ( is_nested ) { gtk_widget_add_css_class( GTK_WIDGET( self ), "nested" ); }
+	else { gtk_widget_remove_css_class( GTK_WIDGET( self ), "nested" ); }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <gtk/gtk.h>
+#include "services/notification-service.h"
+#include "widgets/notification-widget.h"
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_NOTIFICATION_GROUP_WIDGET foobar_notification_group_widget_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarNotificationGroupWidget, foobar_notification_group_widget, FOOBAR, NOTIFICATION_GROUP_WIDGET, GtkWidget )
+
+GtkWidget*                foobar_notification_group_widget_new                    ( void );
+GtkTreeListRow*           foobar_notification_group_widget_get_row                ( FoobarNotificationGroupWidget* self );
+FoobarNotificationGroup*  foobar_notification_group_widget_get_group              ( FoobarNotificationGroupWidget* self );
+FoobarNotificationWidget* foobar_notification_group_widget_get_notification_widget( FoobarNotificationGroupWidget* self );
+void                      foobar_notification_group_widget_set_row                ( FoobarNotificationGroupWidget* self,
+                                                                                    GtkTreeListRow*                value );
+
+G_END_DECLS
@@ -19,6 +19,9 @@ G_DEFINE_ENUM_TYPE(
 // Shared widget for displaying a notification. The widget also manages an inset/margin -- this is done to allow the
 // "close" button to extend into the margin area.
 //
+// Relative timestamps are kept current through the notification service's shared "minute-tick" signal, which the
+// widget only holds while it is mapped. On every tick, the label is only updated if its text actually changed.
+//
 
 struct _FoobarNotificationWidget
 {
@@ -26,9 +29,13 @@ struct _FoobarNotificationWidget
 	GtkWidget*                    container;
 	GtkWidget*                    content;
 	GtkWidget*                    close_button;
+	GtkWidget*                    time;
 	FoobarNotification*           notification;
 	FoobarNotificationCloseAction close_action;
 	gchar*                        time_format;
+	gboolean                      relative_time;
+	FoobarNotificationService*    service;
+	gulong                        minute_tick_handler_id;
 	gint                          min_height;
 	gint                          close_button_inset;
 	gint                          inset_start;
@@ -42,6 +49,8 @@ enum
 	PROP_NOTIFICATION = 1,
 	PROP_CLOSE_ACTION,
 	PROP_TIME_FORMAT,
+	PROP_RELATIVE_TIME,
+	PROP_SERVICE,
 	PROP_MIN_HEIGHT,
 	PROP_CLOSE_BUTTON_INSET,
 	PROP_INSET_START,
@@ -65,6 +74,8 @@ static void     foobar_notification_widget_set_property        ( GObject*
                                                                  GParamSpec*                    pspec );
 static void     foobar_notification_widget_dispose             ( GObject*                       object );
 static void     foobar_notification_widget_finalize            ( GObject*                       object );
+static void     foobar_notification_widget_map                 ( GtkWidget*                     widget );
+static void     foobar_notification_widget_unmap               ( GtkWidget*                     widget );
 static void     foobar_notification_widget_handle_enter        ( GtkEventControllerMotion*      controller,
                                                                  gdouble                        x,
                                                                  gdouble                        y,
@@ -73,17 +84,34 @@ static void     foobar_notification_widget_handle_leave        ( GtkEventControl
                                                                  gpointer                       userdata );
 static void     foobar_notification_widget_handle_close_clicked( GtkButton*                     button,
                                                                  gpointer                       userdata );
+static void     foobar_notification_widget_handle_group_clicked( GtkButton*                     button,
+                                                                 gpointer                       userdata );
+static void     foobar_notification_widget_handle_minute_tick  ( FoobarNotificationService*     service,
+                                                                 gpointer                       userdata );
 static gchar*   foobar_notification_widget_compute_time_label  ( GtkExpression*                 expression,
                                                                  GDateTime*                     time,
                                                                  gchar const*                   format,
+                                                                 gboolean                       is_relative,
                                                                  gpointer                       userdata );
 static gboolean foobar_notification_widget_compute_icon_visible( GtkExpression*                 expression,
-                                                                 GIcon*                         icon,
+                                                                 GdkTexture*                    image,
                                                                  gpointer                       userdata );
 static gboolean foobar_notification_widget_compute_body_visible( GtkExpression*                 expression,
                                                                  gchar const*                   body,
                                                                  gpointer                       userdata );
+static gchar*   foobar_notification_widget_compute_group_label ( GtkExpression*                 expression,
+                                                                 guint                          group_size,
+                                                                 gpointer                       userdata );
+static gboolean foobar_notification_widget_compute_is_grouped  ( GtkExpression*                 expression,
+                                                                 guint                          group_size,
+                                                                 gpointer                       userdata );
 static void     foobar_notification_widget_update_margins      ( FoobarNotificationWidget*      self );
+static void     foobar_notification_widget_update_time_label   ( FoobarNotificationWidget*      self );
+static void     foobar_notification_widget_update_minute_tick  ( FoobarNotificationWidget*      self );
+static void     foobar_notification_widget_release_minute_tick ( FoobarNotificationWidget*      self );
+static gchar*   foobar_notification_widget_format_time         ( GDateTime*                     time,
+                                                                 gchar const*                   format,
+                                                                 gboolean                       is_relative );
 
 G_DEFINE_FINAL_TYPE( FoobarNotificationWidget, foobar_notification_widget, GTK_TYPE_WIDGET )
 
@@ -99,6 +127,8 @@ void foobar_notification_widget_class_init( FoobarNotificationWidgetClass* klass
 	GtkWidgetClass* widget_klass = GTK_WIDGET_CLASS( klass );
 	gtk_widget_class_set_layout_manager_type( widget_klass, GTK_TYPE_BIN_LAYOUT );
 	gtk_widget_class_set_css_name( widget_klass, "notification" );
+	widget_klass->map = foobar_notification_widget_map;
+	widget_klass->unmap = foobar_notification_widget_unmap;
 
 	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
 	object_klass->get_property = foobar_notification_widget_get_property;
@@ -125,6 +155,18 @@ void foobar_notification_widget_class_init( FoobarNotificationWidgetClass* klass
 		"Time format used to display the notification's timestamp.",
 		NULL,
 		G_PARAM_READWRITE );
+	props[PROP_RELATIVE_TIME] = g_param_spec_boolean(
+		"relative-time",
+		"Relative Time",
+		"Whether the timestamp is displayed relative to the current time instead of using the time format.",
+		FALSE,
+		G_PARAM_READWRITE );
+	props[PROP_SERVICE] = g_param_spec_object(
+		"service",
+		"Service",
+		"Notification service providing the minute tick for relative timestamps.",
+		FOOBAR_TYPE_NOTIFICATION_SERVICE,
+		G_PARAM_READWRITE );
 	props[PROP_MIN_HEIGHT] = g_param_spec_int(
 		"min-height",
 		"Minimum Height",
@@ -196,10 +238,10 @@ void foobar_notification_widget_init( FoobarNotificationWidget* self )
 	gtk_widget_set_valign( title, GTK_ALIGN_BASELINE_CENTER );
 	gtk_widget_set_hexpand( title, TRUE );
 
-	GtkWidget* time = gtk_label_new( NULL );
-	gtk_label_set_wrap( GTK_LABEL( time ), FALSE );
-	gtk_widget_add_css_class( time, "time" );
-	gtk_widget_set_valign( time, GTK_ALIGN_BASELINE_CENTER );
+	self->time = gtk_label_new( NULL );
+	gtk_label_set_wrap( GTK_LABEL( self->time ), FALSE );
+	gtk_widget_add_css_class( self->time, "time" );
+	gtk_widget_set_valign( self->time, GTK_ALIGN_BASELINE_CENTER );
 
 	GtkWidget* body = gtk_label_new( NULL );
 	gtk_label_set_use_markup( GTK_LABEL( body ), TRUE );
@@ -212,9 +254,15 @@ void foobar_notification_widget_init( FoobarNotificationWidget* self )
 	gtk_label_set_xalign( GTK_LABEL( body ), 0 );
 	gtk_widget_add_css_class( body, "body" );
 
+	GtkWidget* group_button = gtk_button_new( );
+	gtk_widget_add_css_class( group_button, "group-button" );
+	gtk_widget_set_valign( group_button, GTK_ALIGN_BASELINE_CENTER );
+	g_signal_connect( group_button, "clicked", G_CALLBACK( foobar_notification_widget_handle_group_clicked ), self );
+
 	GtkWidget* header = gtk_box_new( GTK_ORIENTATION_HORIZONTAL, 0 );
 	gtk_box_append( GTK_BOX( header ), title );
-	gtk_box_append( GTK_BOX( header ), time );
+	gtk_box_append( GTK_BOX( header ), group_button );
+	gtk_box_append( GTK_BOX( header ), self->time );
 
 	GtkWidget* row = gtk_box_new( GTK_ORIENTATION_VERTICAL, 0 );
 	gtk_box_append( GTK_BOX( row ), header );
@@ -255,7 +303,7 @@ void foobar_notification_widget_init( FoobarNotificationWidget* self )
 	{
 		GtkExpression* notification_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_WIDGET, NULL, "notification" );
 		GtkExpression* image_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION, notification_expr, "image" );
-		gtk_expression_bind( gtk_expression_ref( image_expr ), icon, "gicon", self );
+		gtk_expression_bind( gtk_expression_ref( image_expr ), icon, "paintable", self );
 		GtkExpression* visible_params[] = { image_expr };
 		GtkExpression* visible_expr = gtk_cclosure_expression_new(
 			G_TYPE_BOOLEAN,
@@ -294,7 +342,8 @@ void foobar_notification_widget_init( FoobarNotificationWidget* self )
 		GtkExpression* notification_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_WIDGET, NULL, "notification" );
 		GtkExpression* time_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION, notification_expr, "time" );
 		GtkExpression* format_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_WIDGET, NULL, "time-format" );
-		GtkExpression* str_params[] = { time_expr, format_expr };
+		GtkExpression* relative_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_WIDGET, NULL, "relative-time" );
+		GtkExpression* str_params[] = { time_expr, format_expr, relative_expr };
 		GtkExpression* str_expr = gtk_cclosure_expression_new(
 			G_TYPE_STRING,
 			NULL,
@@ -303,7 +352,32 @@ void foobar_notification_widget_init( FoobarNotificationWidget* self )
 			G_CALLBACK( foobar_notification_widget_compute_time_label ),
 			self,
 			NULL );
-		gtk_expression_bind( str_expr, time, "label", self );
+		gtk_expression_bind( str_expr, self->time, "label", self );
+	}
+
+	{
+		GtkExpression* notification_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION_WIDGET, NULL, "notification" );
+		GtkExpression* group_size_expr = gtk_property_expression_new( FOOBAR_TYPE_NOTIFICATION, notification_expr, "group-size" );
+		GtkExpression* label_params[] = { gtk_expression_ref( group_size_expr ) };
+		GtkExpression* label_expr = gtk_cclosure_expression_new(
+			G_TYPE_STRING,
+			NULL,
+			G_N_ELEMENTS( label_params ),
+			label_params,
+			G_CALLBACK( foobar_notification_widget_compute_group_label ),
+			NULL,
+			NULL );
+		gtk_expression_bind( label_expr, group_button, "label", self );
+		GtkExpression* visible_params[] = { group_size_expr };
+		GtkExpression* visible_expr = gtk_cclosure_expression_new(
+			G_TYPE_BOOLEAN,
+			NULL,
+			G_N_ELEMENTS( visible_params ),
+			visible_params,
+			G_CALLBACK( foobar_notification_widget_compute_is_grouped ),
+			NULL,
+			NULL );
+		gtk_expression_bind( visible_expr, group_button, "visible", self );
 	}
 }
 
@@ -329,6 +403,12 @@ void foobar_notification_widget_get_property(
 		case PROP_TIME_FORMAT:
 			g_value_set_string( value, foobar_notification_widget_get_time_format( self ) );
 			break;
+		case PROP_RELATIVE_TIME:
+			g_value_set_boolean( value, foobar_notification_widget_get_relative_time( self ) );
+			break;
+		case PROP_SERVICE:
+			g_value_set_object( value, foobar_notification_widget_get_service( self ) );
+			break;
 		case PROP_MIN_HEIGHT:
 			g_value_set_int( value, foobar_notification_widget_get_min_height( self ) );
 			break;
@@ -375,6 +455,12 @@ void foobar_notification_widget_set_property(
 		case PROP_TIME_FORMAT:
 			foobar_notification_widget_set_time_format( self, g_value_get_string( value ) );
 			break;
+		case PROP_RELATIVE_TIME:
+			foobar_notification_widget_set_relative_time( self, g_value_get_boolean( value ) );
+			break;
+		case PROP_SERVICE:
+			foobar_notification_widget_set_service( self, g_value_get_object( value ) );
+			break;
 		case PROP_MIN_HEIGHT:
 			foobar_notification_widget_set_min_height( self, g_value_get_int( value ) );
 			break;
@@ -406,6 +492,9 @@ void foobar_notification_widget_dispose( GObject* object )
 {
 	FoobarNotificationWidget* self = (FoobarNotificationWidget*)object;
 
+	foobar_notification_widget_release_minute_tick( self );
+	g_clear_object( &self->service );
+
 	GtkWidget* child;
 	while ( ( child = gtk_widget_get_first_child( GTK_WIDGET( self ) ) ) )
 	{
@@ -428,6 +517,28 @@ void foobar_notification_widget_finalize( GObject* object )
 	G_OBJECT_CLASS( foobar_notification_widget_parent_class )->finalize( object );
 }
 
+//
+// Called when the widget is about to be shown on screen.
+//
+void foobar_notification_widget_map( GtkWidget* widget )
+{
+	FoobarNotificationWidget* self = (FoobarNotificationWidget*)widget;
+
+	GTK_WIDGET_CLASS( foobar_notification_widget_parent_class )->map( widget );
+	foobar_notification_widget_update_minute_tick( self );
+}
+
+//
+// Called when the widget is no longer shown on screen.
+//
+void foobar_notification_widget_unmap( GtkWidget* widget )
+{
+	FoobarNotificationWidget* self = (FoobarNotificationWidget*)widget;
+
+	GTK_WIDGET_CLASS( foobar_notification_widget_parent_class )->unmap( widget );
+	foobar_notification_widget_update_minute_tick( self );
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Public API
 // ---------------------------------------------------------------------------------------------------------------------
@@ -467,6 +578,25 @@ gchar const* foobar_notification_widget_get_time_format( FoobarNotificationWidge
 	return self->time_format;
 }
 
+//
+// Check whether the notification's timestamp is displayed relative to the current time instead of using the time
+// format.
+//
+gboolean foobar_notification_widget_get_relative_time( FoobarNotificationWidget* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_WIDGET( self ), FALSE );
+	return self->relative_time;
+}
+
+//
+// Get the notification service providing the minute tick for relative timestamps.
+//
+FoobarNotificationService* foobar_notification_widget_get_service( FoobarNotificationWidget* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_NOTIFICATION_WIDGET( self ), NULL );
+	return self->service;
+}
+
 //
 // Get the minimum height of the notification (excluding the inset).
 //
@@ -571,6 +701,45 @@ void foobar_notification_widget_set_time_format(
 	}
 }
 
+//
+// Update whether the notification's timestamp is displayed relative to the current time instead of using the time
+// format.
+//
+void foobar_notification_widget_set_relative_time(
+	FoobarNotificationWidget* self,
+	gboolean                  value )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_WIDGET( self ) );
+
+	value = !!value;
+	if ( self->relative_time != value )
+	{
+		self->relative_time = value;
+		g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_RELATIVE_TIME] );
+		foobar_notification_widget_update_minute_tick( self );
+	}
+}
+
+//
+// Update the notification service providing the minute tick for relative timestamps.
+//
+void foobar_notification_widget_set_service(
+	FoobarNotificationWidget*  self,
+	FoobarNotificationService* value )
+{
+	g_return_if_fail( FOOBAR_IS_NOTIFICATION_WIDGET( self ) );
+	g_return_if_fail( value == NULL || FOOBAR_IS_NOTIFICATION_SERVICE( value ) );
+
+	if ( self->service != value )
+	{
+		foobar_notification_widget_release_minute_tick( self );
+		g_clear_object( &self->service );
+		if ( value ) { self->service = g_object_ref( value ); }
+		g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_SERVICE] );
+		foobar_notification_widget_update_minute_tick( self );
+	}
+}
+
 //
 // Update the minimum height of the notification (excluding the inset).
 //
@@ -747,6 +916,34 @@ void foobar_notification_widget_handle_close_clicked(
 	}
 }
 
+//
+// Called when the user has clicked the button showing the number of grouped notifications.
+//
+// This shows the collapsed notifications as separate popups again.
+//
+void foobar_notification_widget_handle_group_clicked(
+	GtkButton* button,
+	gpointer   userdata )
+{
+	(void)button;
+	FoobarNotificationWidget* self = (FoobarNotificationWidget*)userdata;
+
+	if ( self->notification ) { foobar_notification_expand( self->notification ); }
+}
+
+//
+// Called at the start of every minute while the widget displays a relative timestamp and is mapped.
+//
+void foobar_notification_widget_handle_minute_tick(
+	FoobarNotificationService* service,
+	gpointer                   userdata )
+{
+	(void)service;
+	FoobarNotificationWidget* self = (FoobarNotificationWidget*)userdata;
+
+	foobar_notification_widget_update_time_label( self );
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Value Converters
 // ---------------------------------------------------------------------------------------------------------------------
@@ -758,12 +955,13 @@ gchar* foobar_notification_widget_compute_time_label(
 	GtkExpression* expression,
 	GDateTime*     time,
 	gchar const*   format,
+	gboolean       is_relative,
 	gpointer       userdata )
 {
 	(void)expression;
 	(void)userdata;
 
-	return format != NULL ? g_date_time_format( time, format ) : NULL;
+	return foobar_notification_widget_format_time( time, format, is_relative );
 }
 
 //
@@ -771,13 +969,13 @@ gchar* foobar_notification_widget_compute_time_label(
 //
 gboolean foobar_notification_widget_compute_icon_visible(
 	GtkExpression* expression,
-	GIcon*         icon,
+	GdkTexture*    image,
 	gpointer       userdata )
 {
 	(void)expression;
 	(void)userdata;
 
-	return icon != NULL;
+	return image != NULL;
 }
 
 //
@@ -794,6 +992,34 @@ gboolean foobar_notification_widget_compute_body_visible(
 	return body != NULL && g_strcmp0( body, "" );
 }
 
+//
+// Derive the label of the group button from the number of grouped notifications.
+//
+gchar* foobar_notification_widget_compute_group_label(
+	GtkExpression* expression,
+	guint          group_size,
+	gpointer       userdata )
+{
+	(void)expression;
+	(void)userdata;
+
+	return g_strdup_printf( "+%u", group_size );
+}
+
+//
+// Derive the visibility of the group button from the number of grouped notifications.
+//
+gboolean foobar_notification_widget_compute_is_grouped(
+	GtkExpression* expression,
+	guint          group_size,
+	gpointer       userdata )
+{
+	(void)expression;
+	(void)userdata;
+
+	return group_size > 0;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Helper Methods
 // ---------------------------------------------------------------------------------------------------------------------
@@ -819,3 +1045,94 @@ void foobar_notification_widget_update_margins( FoobarNotificationWidget* self )
 	gtk_widget_set_margin_end( self->close_button, inset );
 	gtk_widget_set_margin_top( self->close_button, inset );
 }
+
+//
+// Refresh the timestamp label after the current time has changed, leaving it untouched if its text is still the same.
+//
+void foobar_notification_widget_update_time_label( FoobarNotificationWidget* self )
+{
+	GDateTime* time = self->notification ? foobar_notification_get_time( self->notification ) : NULL;
+	g_autofree gchar* label = foobar_notification_widget_format_time( time, self->time_format, self->relative_time );
+	if ( g_strcmp0( label ? label : "", gtk_label_get_label( GTK_LABEL( self->time ) ) ) )
+	{
+		gtk_label_set_label( GTK_LABEL( self->time ), label );
+	}
+}
+
+//
+// Hold the notification service's minute tick while a relative timestamp is displayed on screen, and release it
+// otherwise.
+//
+void foobar_notification_widget_update_minute_tick( FoobarNotificationWidget* self )
+{
+	gboolean needs_tick = self->relative_time && self->service && gtk_widget_get_mapped( GTK_WIDGET( self ) );
+	if ( needs_tick && !self->minute_tick_handler_id )
+	{
+		foobar_notification_service_hold_minute_tick( self->service );
+		self->minute_tick_handler_id = g_signal_connect(
+			self->service,
+			"minute-tick",
+			G_CALLBACK( foobar_notification_widget_handle_minute_tick ),
+			self );
+
+		// The label was not updated while the widget was unmapped.
+		foobar_notification_widget_update_time_label( self );
+	}
+	else if ( !needs_tick )
+	{
+		foobar_notification_widget_release_minute_tick( self );
+	}
+}
+
+//
+// Stop receiving the notification service's minute tick, if it is currently held.
+//
+void foobar_notification_widget_release_minute_tick( FoobarNotificationWidget* self )
+{
+	if ( !self->minute_tick_handler_id ) { return; }
+
+	g_clear_signal_handler( &self->minute_tick_handler_id, self->service );
+	foobar_notification_service_release_minute_tick( self->service );
+}
+
+//
+// Format a timestamp either using a g_date_time_format string or relative to the current time (e.g. "now", "5 min",
+// "yesterday").
+//
+// Relative differences are computed between whole minutes and calendar days, so the text only ever changes at the start
+// of a minute.
+//
+gchar* foobar_notification_widget_format_time(
+	GDateTime*   time,
+	gchar const* format,
+	gboolean     is_relative )
+{
+	if ( !time ) { return NULL; }
+	if ( !is_relative ) { return format != NULL ? g_date_time_format( time, format ) : NULL; }
+
+	g_autoptr( GDateTime ) now = g_date_time_new_now( g_date_time_get_timezone( time ) );
+	gint64 minutes = g_date_time_to_unix( now ) / 60 - g_date_time_to_unix( time ) / 60;
+	if ( minutes < 1 ) { return g_strdup( "now" ); }
+	if ( minutes < 60 ) { return g_strdup_printf( "%" G_GINT64_FORMAT " min", minutes ); }
+
+	GDate today;
+	GDate day;
+	g_date_clear( &today, 1 );
+	g_date_clear( &day, 1 );
+	g_date_set_dmy(
+		&today,
+		g_date_time_get_day_of_month( now ),
+		g_date_time_get_month( now ),
+		g_date_time_get_year( now ) );
+	g_date_set_dmy(
+		&day,
+		g_date_time_get_day_of_month( time ),
+		g_date_time_get_month( time ),
+		g_date_time_get_year( time ) );
+
+	gint days = g_date_days_between( &day, &today );
+	if ( days < 1 ) { return g_strdup_printf( "%" G_GINT64_FORMAT " h", minutes / 60 ); }
+	if ( days < 2 ) { return g_strdup( "yesterday" ); }
+	if ( days < 7 ) { return g_date_time_format( time, "%A" ); }
+	return g_date_time_format( time, "%x" );
+}
@@ -22,6 +22,8 @@ GtkWidget*                    foobar_notification_widget_new                   (
 FoobarNotification*           foobar_notification_widget_get_notification      ( FoobarNotificationWidget*     self );
 FoobarNotificationCloseAction foobar_notification_widget_get_close_action      ( FoobarNotificationWidget*     self );
 gchar const*                  foobar_notification_widget_get_time_format       ( FoobarNotificationWidget*     self );
+gboolean                      foobar_notification_widget_get_relative_time     ( FoobarNotificationWidget*     self );
+FoobarNotificationService*    foobar_notification_widget_get_service           ( FoobarNotificationWidget*     self );
 gint                          foobar_notification_widget_get_min_height        ( FoobarNotificationWidget*     self );
 gint                          foobar_notification_widget_get_close_button_inset( FoobarNotificationWidget*     self );
 gint                          foobar_notification_widget_get_inset_start       ( FoobarNotificationWidget*     self );
@@ -34,6 +36,10 @@ void                          foobar_notification_widget_set_close_action      (
                                                                                  FoobarNotificationCloseAction value );
 void                          foobar_notification_widget_set_time_format       ( FoobarNotificationWidget*     self,
                                                                                  gchar const*                  value );
+void                          foobar_notification_widget_set_relative_time     ( FoobarNotificationWidget*     self,
+                                                                                 gboolean                      value );
+void                          foobar_notification_widget_set_service           ( FoobarNotificationWidget*     self,
+                                                                                 FoobarNotificationService*    value );
 void                          foobar_notification_widget_set_min_height        ( FoobarNotificationWidget*     self,
                                                                                  gint                          value );
 void                          foobar_notification_widget_set_close_button_inset( FoobarNotificationWidget*     self,
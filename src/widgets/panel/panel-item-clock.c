@@ -8,12 +8,13 @@
 
 struct _FoobarPanelItemClock
 {
-	FoobarPanelItem       parent_instance;
-	gchar*                format;
-	FoobarPanelItemAction action;
-	GtkWidget*            label;
-	GtkWidget*            button;
-	FoobarClockService*   clock_service;
+	FoobarPanelItem        parent_instance;
+	gchar*                 format;
+	FoobarClockGranularity granularity;
+	FoobarPanelItemAction  action;
+	GtkWidget*             label;
+	GtkWidget*             button;
+	FoobarClockService*    clock_service;
 };
 
 static void   foobar_panel_item_clock_class_init    ( FoobarPanelItemClockClass* klass );
@@ -70,6 +71,7 @@ void foobar_panel_item_clock_finalize( GObject* object )
 {
 	FoobarPanelItemClock* self = (FoobarPanelItemClock*)object;
 
+	if ( self->clock_service ) { foobar_clock_service_release( self->clock_service, self->granularity ); }
 	g_clear_pointer( &self->format, g_free );
 	g_clear_object( &self->clock_service );
 
@@ -94,7 +96,9 @@ FoobarPanelItem* foobar_panel_item_clock_new(
 	FoobarPanelItemClock* self = g_object_new( FOOBAR_TYPE_PANEL_ITEM_CLOCK, NULL );
 	self->format = g_strdup( foobar_panel_item_clock_configuration_get_format( config ) );
 	self->action = foobar_panel_item_configuration_get_action( config );
+	self->granularity = foobar_clock_granularity_from_format( self->format );
 	self->clock_service = g_object_ref( clock_service );
+	foobar_clock_service_hold( self->clock_service, self->granularity );
 
 	gtk_widget_set_sensitive( self->button, self->action != FOOBAR_PANEL_ITEM_ACTION_NONE );
 
@@ -22,7 +22,9 @@ struct _FoobarPanelItemStatus
 	GtkWidget*                 network_icon;
 	GtkWidget*                 network_label;
 	GtkExpression*             network_icon_expr;
+	FoobarNetworkAdapterWifi*  wifi_adapter;
 	FoobarNetwork*             network;
+	gulong                     wifi_handler_id;
 	gulong                     network_handler_id;
 	gulong                     network_strength_handler_id;
 };
@@ -46,6 +48,12 @@ static void       foobar_panel_item_status_set_property                  ( GObje
                                                                            GValue const*               value,
                                                                            GParamSpec*                 pspec );
 static void       foobar_panel_item_status_finalize                      ( GObject*                    object );
+static void       foobar_panel_item_status_handle_wifi_change            ( FoobarNetworkService*       service,
+                                                                           GParamSpec*                 pspec,
+                                                                           gpointer                    userdata );
+static void       foobar_panel_item_status_handle_loading_change         ( GObject*                    service,
+                                                                           GParamSpec*                 pspec,
+                                                                           gpointer                    userdata );
 static void       foobar_panel_item_status_handle_network_change         ( FoobarNetworkAdapterWifi*   adapter,
                                                                            GParamSpec*                 pspec,
                                                                            gpointer                    userdata );
@@ -200,9 +208,10 @@ void foobar_panel_item_status_finalize( GObject* object )
 {
 	FoobarPanelItemStatus* self = (FoobarPanelItemStatus*)object;
 
-	FoobarNetworkAdapterWifi* adapter = foobar_network_service_get_wifi( self->network_service );
-	g_clear_signal_handler( &self->network_handler_id, adapter );
+	g_clear_signal_handler( &self->wifi_handler_id, self->network_service );
+	g_clear_signal_handler( &self->network_handler_id, self->wifi_adapter );
 	g_clear_signal_handler( &self->network_strength_handler_id, self->network );
+	g_clear_object( &self->wifi_adapter );
 	g_clear_object( &self->network );
 	g_clear_object( &self->battery_service );
 	g_clear_object( &self->brightness_service );
@@ -273,6 +282,64 @@ FoobarPanelItem* foobar_panel_item_status_new(
 // Signal Handlers
 // ---------------------------------------------------------------------------------------------------------------------
 
+//
+// Called when the wi-fi adapter of the network service changes, which happens once the service has connected to
+// NetworkManager.
+//
+// This subscribes to changes of the adapter's active network (see foobar_panel_item_status_handle_network_change).
+//
+void foobar_panel_item_status_handle_wifi_change(
+	FoobarNetworkService* service,
+	GParamSpec*           pspec,
+	gpointer              userdata )
+{
+	(void)pspec;
+	FoobarPanelItemStatus* self = (FoobarPanelItemStatus*)userdata;
+
+	FoobarNetworkAdapterWifi* adapter = foobar_network_service_get_wifi( service );
+	if ( self->wifi_adapter == adapter ) { return; }
+
+	g_clear_signal_handler( &self->network_handler_id, self->wifi_adapter );
+	g_clear_object( &self->wifi_adapter );
+
+	if ( adapter )
+	{
+		self->wifi_adapter = g_object_ref( adapter );
+		self->network_handler_id = g_signal_connect(
+			self->wifi_adapter,
+			"notify::active",
+			G_CALLBACK( foobar_panel_item_status_handle_network_change ),
+			self );
+		foobar_panel_item_status_handle_network_change( self->wifi_adapter, NULL, self );
+	}
+}
+
+//
+// Called when the network or bluetooth service has started or finished loading.
+//
+// The widget passed as userdata is marked with the "loading" CSS class until the service is ready, so it can be told
+// apart from a missing adapter.
+//
+void foobar_panel_item_status_handle_loading_change(
+	GObject*    service,
+	GParamSpec* pspec,
+	gpointer    userdata )
+{
+	(void)pspec;
+	GtkWidget* widget = GTK_WIDGET( userdata );
+
+	gboolean is_loading;
+	g_object_get( service, "is-loading", &is_loading, NULL );
+	if ( is_loading )
+	{
+		gtk_widget_add_css_class( widget, "loading" );
+	}
+	else
+	{
+		gtk_widget_remove_css_class( widget, "loading" );
+	}
+}
+
 //
 // Called when the wi-fi adapter's active network changes.
 //
@@ -676,33 +743,24 @@ GtkWidget* foobar_panel_item_status_create_item(
 				gtk_box_append( GTK_BOX( box ), self->network_label );
 			}
 
-			// Manually subscribe to network (/strength) because evaluation might fail.
+			// Manually subscribe to network (/strength) because evaluation might fail. The wi-fi adapter may only become
+			// available later, once the network service has connected to NetworkManager.
 
-			FoobarNetworkAdapterWifi* adapter = foobar_network_service_get_wifi( self->network_service );
-			if ( adapter )
-			{
-				self->network_handler_id = g_signal_connect(
-					adapter,
-					"notify::active",
-					G_CALLBACK( foobar_panel_item_status_handle_network_change ),
-					self );
-				if ( foobar_network_adapter_wifi_get_active( adapter ) )
-				{
-					self->network = g_object_ref( foobar_network_adapter_wifi_get_active( adapter ) );
-					self->network_strength_handler_id = g_signal_connect(
-						self->network,
-						"notify::strength",
-						G_CALLBACK( foobar_panel_item_status_handle_network_strength_change ),
-						self );
-				}
-				if ( self->network_label )
-				{
-					gtk_label_set_label(
-						GTK_LABEL( self->network_label ),
-						self->network ? foobar_network_get_name( self->network ) : NULL );
-					gtk_widget_set_visible( GTK_WIDGET( self->network_label ), self->network != NULL );
-				}
-			}
+			if ( self->network_label ) { gtk_widget_set_visible( GTK_WIDGET( self->network_label ), FALSE ); }
+			self->wifi_handler_id = g_signal_connect(
+				self->network_service,
+				"notify::wifi",
+				G_CALLBACK( foobar_panel_item_status_handle_wifi_change ),
+				self );
+			foobar_panel_item_status_handle_wifi_change( self->network_service, NULL, self );
+
+			g_signal_connect_object(
+				self->network_service,
+				"notify::is-loading",
+				G_CALLBACK( foobar_panel_item_status_handle_loading_change ),
+				box,
+				0 );
+			foobar_panel_item_status_handle_loading_change( G_OBJECT( self->network_service ), NULL, box );
 
 			return box;
 		}
@@ -737,6 +795,14 @@ GtkWidget* foobar_panel_item_status_create_item(
 				NULL );
 			gtk_expression_bind( icon_expr, icon, "icon-name", NULL );
 
+			g_signal_connect_object(
+				self->bluetooth_service,
+				"notify::is-loading",
+				G_CALLBACK( foobar_panel_item_status_handle_loading_change ),
+				icon,
+				0 );
+			foobar_panel_item_status_handle_loading_change( G_OBJECT( self->bluetooth_service ), NULL, icon );
+
 			return icon;
 		}
 		case FOOBAR_STATUS_ITEM_BATTERY:
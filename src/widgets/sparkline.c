@@ -0,0 +1,244 @@
+#include "widgets/sparkline.h"
+#include <math.h>
+
+//
+// FoobarSparkline:
+//
+// A small, axis-less line plot of a list of samples (a packed array of doubles), scaled to fill the widget. Samples
+// which are NAN leave a gap in the line.
+//
+// The line is drawn using the widget's foreground color, so it can be styled through CSS like a label.
+//
+
+#define LINE_WIDTH 1.5
+
+struct _FoobarSparkline
+{
+	GtkWidget parent_instance;
+	GBytes*   samples;
+};
+
+enum
+{
+	PROP_SAMPLES = 1,
+	N_PROPS,
+};
+
+static GParamSpec* props[N_PROPS] = { 0 };
+
+static void foobar_sparkline_class_init  ( FoobarSparklineClass* klass );
+static void foobar_sparkline_init        ( FoobarSparkline*      self );
+static void foobar_sparkline_get_property( GObject*              object,
+                                           guint                 prop_id,
+                                           GValue*               value,
+                                           GParamSpec*           pspec );
+static void foobar_sparkline_set_property( GObject*              object,
+                                           guint                 prop_id,
+                                           GValue const*         value,
+                                           GParamSpec*           pspec );
+static void foobar_sparkline_finalize    ( GObject*              object );
+static void foobar_sparkline_snapshot    ( GtkWidget*            widget,
+                                           GtkSnapshot*          snapshot );
+
+G_DEFINE_FINAL_TYPE( FoobarSparkline, foobar_sparkline, GTK_TYPE_WIDGET )
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Widget Implementation
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Static initialization for sparklines.
+//
+void foobar_sparkline_class_init( FoobarSparklineClass* klass )
+{
+	GtkWidgetClass* widget_klass = GTK_WIDGET_CLASS( klass );
+	widget_klass->snapshot = foobar_sparkline_snapshot;
+	gtk_widget_class_set_css_name( widget_klass, "sparkline" );
+
+	GObjectClass* object_klass = G_OBJECT_CLASS( klass );
+	object_klass->get_property = foobar_sparkline_get_property;
+	object_klass->set_property = foobar_sparkline_set_property;
+	object_klass->finalize = foobar_sparkline_finalize;
+
+	props[PROP_SAMPLES] = g_param_spec_boxed(
+		"samples",
+		"Samples",
+		"Packed array of doubles to plot.",
+		G_TYPE_BYTES,
+		G_PARAM_READWRITE );
+	g_object_class_install_properties( object_klass, N_PROPS, props );
+}
+
+//
+// Instance initialization for sparklines.
+//
+void foobar_sparkline_init( FoobarSparkline* self )
+{
+	(void)self;
+}
+
+//
+// Property getter implementation, mapping a property id to a method.
+//
+void foobar_sparkline_get_property(
+	GObject*    object,
+	guint       prop_id,
+	GValue*     value,
+	GParamSpec* pspec )
+{
+	FoobarSparkline* self = (FoobarSparkline*)object;
+
+	switch ( prop_id )
+	{
+		case PROP_SAMPLES:
+			g_value_set_boxed( value, foobar_sparkline_get_samples( self ) );
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
+			break;
+	}
+}
+
+//
+// Property setter implementation, mapping a property id to a method.
+//
+void foobar_sparkline_set_property(
+	GObject*      object,
+	guint         prop_id,
+	GValue const* value,
+	GParamSpec*   pspec )
+{
+	FoobarSparkline* self = (FoobarSparkline*)object;
+
+	switch ( prop_id )
+	{
+		case PROP_SAMPLES:
+			foobar_sparkline_set_samples( self, g_value_get_boxed( value ) );
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID( object, prop_id, pspec );
+			break;
+	}
+}
+
+//
+// Instance cleanup for sparklines.
+//
+void foobar_sparkline_finalize( GObject* object )
+{
+	FoobarSparkline* self = (FoobarSparkline*)object;
+
+	g_clear_pointer( &self->samples, g_bytes_unref );
+
+	G_OBJECT_CLASS( foobar_sparkline_parent_class )->finalize( object );
+}
+
+//
+// Draw the plot, mapping the range of defined sample values to the widget's height.
+//
+void foobar_sparkline_snapshot(
+	GtkWidget*   widget,
+	GtkSnapshot* snapshot )
+{
+	FoobarSparkline* self = (FoobarSparkline*)widget;
+	if ( !self->samples ) { return; }
+
+	gsize size;
+	gdouble const* samples = g_bytes_get_data( self->samples, &size );
+	gsize count = size / sizeof( *samples );
+	if ( count < 2 ) { return; }
+
+	gdouble min = INFINITY;
+	gdouble max = -INFINITY;
+	for ( gsize i = 0; i < count; ++i )
+	{
+		if ( isnan( samples[i] ) ) { continue; }
+		min = MIN( min, samples[i] );
+		max = MAX( max, samples[i] );
+	}
+	if ( min > max ) { return; }
+
+	gint width = gtk_widget_get_width( widget );
+	gint height = gtk_widget_get_height( widget );
+	if ( width <= 0 || height <= 0 ) { return; }
+
+	// Inset the plot by half the line width so the extreme values aren't clipped, and center constant functions.
+
+	gdouble inset = LINE_WIDTH / 2;
+	gdouble plot_width = width - 2 * inset;
+	gdouble plot_height = height - 2 * inset;
+	gdouble range = max - min;
+
+	GdkRGBA color;
+	gtk_widget_get_color( widget, &color );
+
+	cairo_t* cr = gtk_snapshot_append_cairo( snapshot, &GRAPHENE_RECT_INIT( 0, 0, width, height ) );
+	cairo_set_line_width( cr, LINE_WIDTH );
+	cairo_set_line_join( cr, CAIRO_LINE_JOIN_ROUND );
+	cairo_set_line_cap( cr, CAIRO_LINE_CAP_ROUND );
+	gdk_cairo_set_source_rgba( cr, &color );
+
+	gboolean in_segment = FALSE;
+	for ( gsize i = 0; i < count; ++i )
+	{
+		if ( isnan( samples[i] ) )
+		{
+			in_segment = FALSE;
+			continue;
+		}
+
+		gdouble x = inset + plot_width * i / ( count - 1 );
+		gdouble y = range > 0 ? inset + plot_height * ( max - samples[i] ) / range : height / 2.;
+		if ( in_segment )
+		{
+			cairo_line_to( cr, x, y );
+		}
+		else
+		{
+			cairo_move_to( cr, x, y );
+			in_segment = TRUE;
+		}
+	}
+
+	cairo_stroke( cr );
+	cairo_destroy( cr );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------------------------------------------------
+
+//
+// Create a new sparkline instance.
+//
+GtkWidget* foobar_sparkline_new( void )
+{
+	return g_object_new( FOOBAR_TYPE_SPARKLINE, NULL );
+}
+
+//
+// Get the samples currently plotted as a packed array of doubles.
+//
+GBytes* foobar_sparkline_get_samples( FoobarSparkline* self )
+{
+	g_return_val_if_fail( FOOBAR_IS_SPARKLINE( self ), NULL );
+	return self->samples;
+}
+
+//
+// Update the samples to plot as a packed array of doubles.
+//
+void foobar_sparkline_set_samples(
+	FoobarSparkline* self,
+	GBytes*          value )
+{
+	g_return_if_fail( FOOBAR_IS_SPARKLINE( self ) );
+
+	if ( self->samples != value )
+	{
+		g_clear_pointer( &self->samples, g_bytes_unref );
+		self->samples = value ? g_bytes_ref( value ) : NULL;
+		gtk_widget_queue_draw( GTK_WIDGET( self ) );
+		g_object_notify_by_pspec( G_OBJECT( self ), props[PROP_SAMPLES] );
+	}
+}
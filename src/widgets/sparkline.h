@@ -0,0 +1,16 @@
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define FOOBAR_TYPE_SPARKLINE foobar_sparkline_get_type( )
+
+G_DECLARE_FINAL_TYPE( FoobarSparkline, foobar_sparkline, FOOBAR, SPARKLINE, GtkWidget )
+
+GtkWidget* foobar_sparkline_new        ( void );
+GBytes*    foobar_sparkline_get_samples( FoobarSparkline* self );
+void       foobar_sparkline_set_samples( FoobarSparkline* self,
+                                         GBytes*          value );
+
+G_END_DECLS